@@ -38,6 +38,7 @@ set(WITH_IMAGE_WEBP          OFF CACHE BOOL "" FORCE)
 set(WITH_INPUT_NDOF          OFF CACHE BOOL "" FORCE)
 set(WITH_INTERNATIONAL       OFF CACHE BOOL "" FORCE)
 set(WITH_IO_STL              OFF CACHE BOOL "" FORCE)
+set(WITH_IO_PLY              OFF CACHE BOOL "" FORCE)
 set(WITH_IO_WAVEFRONT_OBJ    OFF CACHE BOOL "" FORCE)
 set(WITH_IO_GPENCIL          OFF CACHE BOOL "" FORCE)
 set(WITH_JACK                OFF CACHE BOOL "" FORCE)
@@ -215,6 +215,38 @@ template<class T> class MEM_CacheLimiter {
     }
   }
 
+  /**
+   * Destroy elements with a priority lower than \a max_priority, least priority first, until at
+   * least \a size memory has been freed. Only used with an item priority callback.
+   *
+   * \return The amount of memory which has been freed.
+   */
+  size_t free_lower_priority(int max_priority, size_t size)
+  {
+    size_t freed = 0;
+
+    if (item_priority_func == NULL || data_size_func == NULL) {
+      return 0;
+    }
+
+    while (!queue.empty() && freed < size) {
+      int priority = 0;
+      MEM_CacheElementPtr elem = get_least_priority_destroyable_element(&priority);
+
+      if (!elem || priority >= max_priority)
+        break;
+
+      size_t cur_size = data_size_func(elem->get()->get_data());
+
+      if (!elem->destroy_if_possible())
+        break;
+
+      freed += cur_size;
+    }
+
+    return freed;
+  }
+
   void touch(MEM_CacheLimiterHandle<T> *handle)
   {
     /* If we're using custom priority callback re-arranging the queue
@@ -259,7 +291,7 @@ template<class T> class MEM_CacheLimiter {
     return true;
   }
 
-  MEM_CacheElementPtr get_least_priority_destroyable_element(void)
+  MEM_CacheElementPtr get_least_priority_destroyable_element(int *r_priority = NULL)
   {
     if (queue.empty())
       return NULL;
@@ -296,6 +328,10 @@ template<class T> class MEM_CacheLimiter {
           best_match_elem = elem;
         }
       }
+
+      if (r_priority) {
+        *r_priority = best_match_priority;
+      }
     }
 
     return best_match_elem;
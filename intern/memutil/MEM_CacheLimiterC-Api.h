@@ -76,6 +76,18 @@ MEM_CacheLimiterHandleC *MEM_CacheLimiter_insert(MEM_CacheLimiterC *This, void *
 
 void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This);
 
+/**
+ * Free objects with a priority lower than max_priority, least priority first,
+ * until at least size memory was freed (requires an item priority function)
+ *
+ * \param This: "This" pointer.
+ * \return Amount of memory freed.
+ */
+
+size_t MEM_CacheLimiter_free_lower_priority(MEM_CacheLimiterC *This,
+                                            int max_priority,
+                                            size_t size);
+
 /**
  * Unmanage object previously inserted object.
  * Does _not_ delete managed object!
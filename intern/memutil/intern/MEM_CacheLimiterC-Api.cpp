@@ -167,6 +167,13 @@ void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This)
   cast(This)->get_cache()->enforce_limits();
 }
 
+size_t MEM_CacheLimiter_free_lower_priority(MEM_CacheLimiterC *This,
+                                            int max_priority,
+                                            size_t size)
+{
+  return cast(This)->get_cache()->free_lower_priority(max_priority, size);
+}
+
 void MEM_CacheLimiter_unmanage(MEM_CacheLimiterHandleC *handle)
 {
   cast(handle)->unmanage();
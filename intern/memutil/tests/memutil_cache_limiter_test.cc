@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <climits>
+
+#include "MEM_CacheLimiter.h"
+
+namespace {
+
+struct TestItem {
+  size_t size;
+  int priority;
+  bool *destroyed;
+
+  ~TestItem()
+  {
+    *destroyed = true;
+  }
+
+  void *get_data()
+  {
+    return this;
+  }
+};
+
+size_t test_item_size(void *item)
+{
+  return static_cast<TestItem *>(item)->size;
+}
+
+int test_item_priority(void *item, int /*default_priority*/)
+{
+  return static_cast<TestItem *>(item)->priority;
+}
+
+const int ITEMS_NUM = 5;
+
+class CacheLimiterTest : public testing::Test {
+ protected:
+  MEM_CacheLimiter<TestItem> limiter{test_item_size};
+  MEM_CacheLimiterHandle<TestItem> *handles[ITEMS_NUM];
+  bool destroyed[ITEMS_NUM] = {false};
+
+  void SetUp() override
+  {
+    limiter.set_item_priority_func(test_item_priority);
+    limiter.set_item_destroyable_func(nullptr);
+    /* Priorities in another order than the insertion order. */
+    const int priorities[ITEMS_NUM] = {30, 10, 50, 20, 40};
+    for (int i = 0; i < ITEMS_NUM; i++) {
+      handles[i] = limiter.insert(new TestItem{100, priorities[i], &destroyed[i]});
+    }
+  }
+
+  void TearDown() override
+  {
+    for (int i = 0; i < ITEMS_NUM; i++) {
+      if (!destroyed[i]) {
+        handles[i]->destroy_if_possible();
+      }
+    }
+  }
+
+  void expect_destroyed(const bool expected[ITEMS_NUM])
+  {
+    for (int i = 0; i < ITEMS_NUM; i++) {
+      EXPECT_EQ(destroyed[i], expected[i]) << "item " << i;
+    }
+  }
+};
+
+TEST_F(CacheLimiterTest, free_lower_priority_least_first)
+{
+  /* Stops once enough memory has been freed. */
+  EXPECT_EQ(limiter.free_lower_priority(INT_MAX, 150), 200);
+  const bool expected[ITEMS_NUM] = {false, true, false, true, false};
+  expect_destroyed(expected);
+}
+
+TEST_F(CacheLimiterTest, free_lower_priority_below_max)
+{
+  /* Items with the given priority or a higher one are kept, even when more memory is needed. */
+  EXPECT_EQ(limiter.free_lower_priority(30, 1000), 200);
+  const bool expected[ITEMS_NUM] = {false, true, false, true, false};
+  expect_destroyed(expected);
+}
+
+TEST_F(CacheLimiterTest, free_lower_priority_skip_referenced)
+{
+  handles[1]->ref();
+  EXPECT_EQ(limiter.free_lower_priority(INT_MAX, 100), 100);
+  const bool expected[ITEMS_NUM] = {false, false, false, true, false};
+  expect_destroyed(expected);
+  handles[1]->unref();
+}
+
+TEST_F(CacheLimiterTest, free_lower_priority_without_priority_func)
+{
+  limiter.set_item_priority_func(nullptr);
+  EXPECT_EQ(limiter.free_lower_priority(INT_MAX, 1000), 0);
+  const bool expected[ITEMS_NUM] = {false, false, false, false, false};
+  expect_destroyed(expected);
+}
+
+}  // namespace
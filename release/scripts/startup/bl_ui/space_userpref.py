@@ -624,6 +624,7 @@ class USERPREF_PT_system_memory(SystemPanel, CenterAlignMixIn, Panel):
         col = layout.column()
         col.prop(edit, "undo_steps", text="Undo Steps")
         col.prop(edit, "undo_memory_limit", text="Undo Memory Limit")
+        col.prop(edit, "undo_uncompressed_steps", text="Uncompressed Steps")
         col.prop(edit, "use_global_undo")
 
         layout.separator()
@@ -734,6 +735,7 @@ class USERPREF_PT_viewport_textures(ViewportPanel, CenterAlignMixIn, Panel):
         col.prop(system, "anisotropic_filter")
         col.prop(system, "gl_clip_alpha", slider=True)
         col.prop(system, "image_draw_method", text="Image Display Method")
+        col.prop(system, "use_image_display_lut")
 
 
 class USERPREF_PT_viewport_selection(ViewportPanel, CenterAlignMixIn, Panel):
@@ -1444,12 +1446,14 @@ class USERPREF_PT_saveload_blend(SaveLoadPanel, CenterAlignMixIn, Panel):
 
         col = layout.column(heading="Save")
         col.prop(view, "use_save_prompt")
+        col.prop(paths, "use_save_background")
         col.prop(paths, "file_preview_type")
 
         col = layout.column(heading="Default To")
         col.prop(paths, "use_relative_paths")
         col.prop(paths, "use_file_compression")
         col.prop(paths, "use_load_ui")
+        col.prop(paths, "use_load_packed_on_demand")
 
         col = layout.column(heading="Text Files")
         col.prop(paths, "use_tabs_as_spaces")
@@ -130,6 +130,15 @@ enum ePF_FileCompare BKE_packedfile_compare_to_file(const char *ref_file_name,
 int BKE_packedfile_seek(struct PackedFile *pf, int offset, int whence);
 void BKE_packedfile_rewind(struct PackedFile *pf);
 int BKE_packedfile_read(struct PackedFile *pf, void *data, int size);
+/**
+ * Access the data of the packed file, it may not be read from the blend file yet
+ * (see #BLO_READ_SKIP_LARGE_DATA). Use this instead of #PackedFile.data directly.
+ * Can be used from any thread.
+ *
+ * \return The data, or NULL (with an error in \a reports) when the blend file it is read from
+ * was modified or removed.
+ */
+void *BKE_packedfile_data_ensure(struct PackedFile *pf, struct ReportList *reports);
 
 /**
  * ID should be not NULL, return true if there's a packed file.
@@ -130,6 +130,8 @@ MemFileUndoData *BKE_memfile_undo_encode(Main *bmain, MemFileUndoData *mfu_prev)
     }
     /* success = */ /* UNUSED */ BLO_write_file_mem(bmain, prevfile, &mfu->memfile, fileflags);
     mfu->undo_size = mfu->memfile.size;
+
+    BLO_memfile_compress_old_chunks(U.undo_uncompressed_steps);
   }
 
   bmain->is_memfile_undo_written = true;
@@ -3996,9 +3996,11 @@ static ImBuf *load_image_single(Image *ima,
 
     LISTBASE_FOREACH (ImagePackedFile *, imapf, &ima->packedfiles) {
       if (imapf->view == view_id && imapf->tile_number == tile_number) {
-        if (imapf->packedfile) {
-          ibuf = IMB_ibImageFromMemory((unsigned char *)imapf->packedfile->data,
-                                       imapf->packedfile->size,
+        PackedFile *pf = imapf->packedfile;
+        const void *mem = pf ? BKE_packedfile_data_ensure(pf, nullptr) : nullptr;
+        if (mem) {
+          ibuf = IMB_ibImageFromMemory(static_cast<const unsigned char *>(mem),
+                                       pf->size,
                                        flag,
                                        ima->colorspace_settings.name,
                                        "<packed data>");
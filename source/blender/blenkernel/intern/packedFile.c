@@ -25,6 +25,7 @@
 #include "DNA_volume_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_image.h"
@@ -41,6 +42,44 @@
 
 #include "BLO_read_write.h"
 
+#include "atomic_ops.h"
+
+/**
+ * Serializes reading deferred data, packed files can be used from multiple threads.
+ * #PackedFile.data is only set once the data is read, other threads load it without the lock.
+ */
+static ThreadMutex packedfile_data_mutex = BLI_MUTEX_INITIALIZER;
+
+void *BKE_packedfile_data_ensure(PackedFile *pf, ReportList *reports)
+{
+  void *data = atomic_load_ptr(&pf->data);
+  if (data != NULL) {
+    return data;
+  }
+
+  BLI_mutex_lock(&packedfile_data_mutex);
+  data = pf->data;
+  if (data == NULL) {
+    BLI_assert(pf->deferred != NULL);
+    data = BLO_deferred_data_read(pf->deferred, "PackedFile.data");
+    if (data == NULL) {
+      /* Keep the reference, the file may only be temporarily unavailable. */
+      BKE_reportf(reports,
+                  RPT_ERROR,
+                  "Unable to read packed data from '%s', it was modified or removed",
+                  pf->deferred->filepath);
+    }
+    else {
+      MEM_freeN(pf->deferred);
+      pf->deferred = NULL;
+      atomic_store_ptr(&pf->data, data);
+    }
+  }
+  BLI_mutex_unlock(&packedfile_data_mutex);
+
+  return data;
+}
+
 int BKE_packedfile_seek(PackedFile *pf, int offset, int whence)
 {
   int oldseek = -1, seek = 0;
@@ -85,8 +124,13 @@ int BKE_packedfile_read(PackedFile *pf, void *data, int size)
       size = pf->size - pf->seek;
     }
 
+    const char *pf_data = BKE_packedfile_data_ensure(pf, NULL);
+    if (pf_data == NULL) {
+      return -1;
+    }
+
     if (size > 0) {
-      memcpy(data, ((char *)pf->data) + pf->seek, size);
+      memcpy(data, pf_data + pf->seek, size);
     }
     else {
       size = 0;
@@ -140,9 +184,10 @@ int BKE_packedfile_count_all(Main *bmain)
 void BKE_packedfile_free(PackedFile *pf)
 {
   if (pf) {
-    BLI_assert(pf->data != NULL);
+    BLI_assert(pf->data != NULL || pf->deferred != NULL);
 
     MEM_SAFE_FREE(pf->data);
+    MEM_SAFE_FREE(pf->deferred);
     MEM_freeN(pf);
   }
   else {
@@ -153,12 +198,16 @@ void BKE_packedfile_free(PackedFile *pf)
 PackedFile *BKE_packedfile_duplicate(const PackedFile *pf_src)
 {
   BLI_assert(pf_src != NULL);
-  BLI_assert(pf_src->data != NULL);
+  BLI_assert(pf_src->data != NULL || pf_src->deferred != NULL);
 
   PackedFile *pf_dst;
 
+  BLI_mutex_lock(&packedfile_data_mutex);
   pf_dst = MEM_dupallocN(pf_src);
-  pf_dst->data = MEM_dupallocN(pf_src->data);
+  /* Data that is not read yet stays in the file for the copy too. */
+  pf_dst->data = pf_src->data ? MEM_dupallocN(pf_src->data) : NULL;
+  pf_dst->deferred = pf_src->deferred ? MEM_dupallocN(pf_src->deferred) : NULL;
+  BLI_mutex_unlock(&packedfile_data_mutex);
 
   return pf_dst;
 }
@@ -323,7 +372,8 @@ int BKE_packedfile_write_to_file(ReportList *reports,
     ret_value = RET_ERROR;
   }
   else {
-    if (write(file, pf->data, pf->size) != pf->size) {
+    const void *data = BKE_packedfile_data_ensure(pf, reports);
+    if (data == NULL || write(file, data, pf->size) != pf->size) {
       BKE_reportf(reports, RPT_ERROR, "Error writing file '%s'", name);
       ret_value = RET_ERROR;
     }
@@ -383,9 +433,10 @@ enum ePF_FileCompare BKE_packedfile_compare_to_file(const char *ref_file_name,
       ret_val = PF_CMP_NOFILE;
     }
     else {
-      ret_val = PF_CMP_EQUAL;
+      const char *data = BKE_packedfile_data_ensure(pf, NULL);
+      ret_val = data ? PF_CMP_EQUAL : PF_CMP_DIFFERS;
 
-      for (int i = 0; i < pf->size; i += sizeof(buf)) {
+      for (int i = 0; data && i < pf->size; i += sizeof(buf)) {
         int len = pf->size - i;
         if (len > sizeof(buf)) {
           len = sizeof(buf);
@@ -397,7 +448,7 @@ enum ePF_FileCompare BKE_packedfile_compare_to_file(const char *ref_file_name,
           break;
         }
 
-        if (memcmp(buf, ((char *)pf->data) + i, len) != 0) {
+        if (memcmp(buf, data + i, len) != 0) {
           ret_val = PF_CMP_DIFFERS;
           break;
         }
@@ -503,8 +554,10 @@ static void unpack_generate_paths(const char *name,
       Image *ima = (Image *)id;
       ImagePackedFile *imapf = ima->packedfiles.last;
       if (imapf != NULL && imapf->packedfile != NULL) {
-        const PackedFile *pf = imapf->packedfile;
-        enum eImbFileType ftype = IMB_ispic_type_from_memory((const uchar *)pf->data, pf->size);
+        PackedFile *pf = imapf->packedfile;
+        const uchar *data = BKE_packedfile_data_ensure(pf, NULL);
+        enum eImbFileType ftype = data ? IMB_ispic_type_from_memory(data, pf->size) :
+                                         IMB_FTYPE_NONE;
         if (ima->source == IMA_SRC_TILED) {
           char tile_number[6];
           BLI_snprintf(tile_number, sizeof(tile_number), ".%d", imapf->tile_number);
@@ -857,8 +910,27 @@ void BKE_packedfile_blend_write(BlendWriter *writer, PackedFile *pf)
   if (pf == NULL) {
     return;
   }
-  BLO_write_struct(writer, PackedFile, pf);
-  BLO_write_raw(writer, pf->size, pf->data);
+  /* Undo steps only need a reference to data that is still in the file it was read from. */
+  if (!BLO_write_is_undo(writer)) {
+    BKE_packedfile_data_ensure(pf, NULL);
+  }
+
+  /* The data may be read by another thread meanwhile. */
+  BLI_mutex_lock(&packedfile_data_mutex);
+  const bool use_deferred = pf->data == NULL && BLO_write_is_undo(writer);
+  PackedFile pf_write = *pf;
+  if (!use_deferred) {
+    /* Data that can't be read is not written, the packed file is removed on load. */
+    pf_write.deferred = NULL;
+  }
+  BLO_write_struct_at_address(writer, PackedFile, pf, &pf_write);
+  if (use_deferred) {
+    BLO_write_raw(writer, sizeof(*pf->deferred), pf->deferred);
+  }
+  else {
+    BLO_write_raw(writer, pf->size, pf->data);
+  }
+  BLI_mutex_unlock(&packedfile_data_mutex);
 }
 
 void BKE_packedfile_blend_read(BlendDataReader *reader, PackedFile **pf_p)
@@ -869,6 +941,28 @@ void BKE_packedfile_blend_read(BlendDataReader *reader, PackedFile **pf_p)
     return;
   }
 
+  if (pf->deferred != NULL && BLO_read_data_is_undo(reader)) {
+    /* Undo step, see #BKE_packedfile_blend_write. */
+    BLO_read_data_address(reader, &pf->deferred);
+  }
+  else {
+    /* Large data may be left in the file until it is needed, see #BKE_packedfile_data_ensure.
+     * Files on disk never reference data in another file. */
+    pf->deferred = BLO_read_data_defer(reader, pf->data);
+  }
+  if (pf->deferred != NULL) {
+    /* Blocks are written with a size aligned to 4 bytes. */
+    if (pf->size < 0 || pf->deferred->size != (((uint64_t)pf->size + 3) & ~(uint64_t)3)) {
+      printf("%s: packedfile data size mismatch, cleaning up...\n", __func__);
+      MEM_freeN(pf->deferred);
+      MEM_freeN(pf);
+      *pf_p = NULL;
+      return;
+    }
+    pf->data = NULL;
+    return;
+  }
+
   BLO_read_packed_address(reader, &pf->data);
   if (pf->data == NULL) {
     /* We cannot allow a PackedFile with a NULL data field,
@@ -556,7 +556,8 @@ static void sound_load_audio(Main *bmain, bSound *sound, bool free_waveform)
 
     /* but we need a packed file then */
     if (pf) {
-      sound->handle = AUD_Sound_bufferFile((unsigned char *)pf->data, pf->size);
+      unsigned char *mem = BKE_packedfile_data_ensure(pf, NULL);
+      sound->handle = mem ? AUD_Sound_bufferFile(mem, pf->size) : NULL;
     }
     else {
       /* or else load it from disk */
@@ -27,6 +27,8 @@
 #include "BKE_main.h"
 #include "BKE_undo_system.h"
 
+#include "BLO_undofile.h"
+
 #include "MEM_guardedalloc.h"
 
 #define undo_stack _wm_undo_stack_disallow /* pass in as a variable always. */
@@ -969,6 +971,15 @@ void BKE_undosys_print(UndoStack *ustack)
            us->name);
     index++;
   }
+
+  MemFileStats stats;
+  BLO_memfile_stats_get(&stats);
+  printf("Global undo chunks: %zu buffers, %zu bytes; %zu compressed: %zu bytes (%zu raw)\n",
+         stats.buffers_num,
+         stats.size_uncompressed + stats.size_compressed,
+         stats.buffers_compressed_num,
+         stats.size_compressed,
+         stats.size_compressed_original);
 }
 
 /** \} */
@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 
 #include "BKE_curve.h"
+#include "BKE_packedFile.h"
 #include "BKE_vfontdata.h"
 
 #include "DNA_curve_types.h"
@@ -248,8 +249,9 @@ static VChar *objchr_to_ftvfontdata(VFont *vfont, FT_ULong charcode)
   FT_Face face;
 
   /* Load the font to memory */
-  if (vfont->temp_pf) {
-    err = FT_New_Memory_Face(library, vfont->temp_pf->data, vfont->temp_pf->size, 0, &face);
+  const FT_Byte *mem = vfont->temp_pf ? BKE_packedfile_data_ensure(vfont->temp_pf, NULL) : NULL;
+  if (mem) {
+    err = FT_New_Memory_Face(library, mem, vfont->temp_pf->size, 0, &face);
     if (err) {
       return NULL;
     }
@@ -276,7 +278,11 @@ static VFontData *objfnt_to_ftvfontdata(PackedFile *pf)
   VFontData *vfd;
 
   /* load the freetype font */
-  err = FT_New_Memory_Face(library, pf->data, pf->size, 0, &face);
+  const FT_Byte *mem = BKE_packedfile_data_ensure(pf, NULL);
+  if (mem == NULL) {
+    return NULL;
+  }
+  err = FT_New_Memory_Face(library, mem, pf->size, 0, &face);
 
   if (err) {
     return NULL;
@@ -361,7 +367,11 @@ static bool check_freetypefont(PackedFile *pf)
   FT_UInt glyph_index = 0;
   bool success = false;
 
-  err = FT_New_Memory_Face(library, pf->data, pf->size, 0, &face);
+  const FT_Byte *mem = BKE_packedfile_data_ensure(pf, NULL);
+  if (mem == NULL) {
+    return false;
+  }
+  err = FT_New_Memory_Face(library, mem, pf->size, 0, &face);
   if (err) {
     return false;
     // XXX error("This is not a valid font");
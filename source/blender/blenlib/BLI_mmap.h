@@ -33,6 +33,18 @@ bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length
 
 void *BLI_mmap_get_pointer(BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT;
 
+/* Length of the mapped region, which is the size of the file at the time it was mapped. */
+size_t BLI_mmap_get_length(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+
+/* Returns whether any IO errors occurred while accessing the mapped memory. Code that reads
+ * from the pointer returned by #BLI_mmap_get_pointer directly has to check this once it is
+ * done: on POSIX systems, failed reads are replaced with zeroes.
+ *
+ * NOTE: only #BLI_mmap_read is protected against IO errors on Windows, direct reads from the
+ * pointer crash there instead. Only use the pointer directly where that is acceptable, or on
+ * other systems. */
+bool BLI_mmap_any_io_error(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+
 void BLI_mmap_free(BLI_mmap_file *file) ATTR_NONNULL(1);
 
 #ifdef __cplusplus
@@ -207,6 +207,16 @@ void *BLI_mmap_get_pointer(BLI_mmap_file *file)
   return file->memory;
 }
 
+size_t BLI_mmap_get_length(const BLI_mmap_file *file)
+{
+  return file->length;
+}
+
+bool BLI_mmap_any_io_error(const BLI_mmap_file *file)
+{
+  return file->io_error;
+}
+
 void BLI_mmap_free(BLI_mmap_file *file)
 {
 #ifndef WIN32
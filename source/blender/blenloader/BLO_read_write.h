@@ -243,6 +243,46 @@ void BLO_read_data_globmap_add(BlendDataReader *reader, void *oldaddr, void *new
 void BLO_read_glob_list(BlendDataReader *reader, struct ListBase *list);
 struct BlendFileReadReport *BLO_read_data_reports(BlendDataReader *reader);
 
+/* Deferred data. */
+
+/**
+ * Reference to a buffer that was left in the file it was read from (see
+ * #BLO_READ_SKIP_LARGE_DATA), to read it only once it is needed.
+ */
+typedef struct BlendDeferredData {
+  char filepath[1024]; /* FILE_MAX */
+  /** Location of the buffer in the file. */
+  uint64_t offset;
+  uint64_t size;
+  /** Modification time and size of the file, the buffer can't be read once it changed. */
+  int64_t file_mtime;
+  uint64_t file_size;
+} BlendDeferredData;
+
+/**
+ * Use instead of #BLO_read_data_address for buffers that can stay in the file until they are
+ * needed. Must be called before any other read of the buffer.
+ *
+ * \return A new reference to the buffer (to be read with #BLO_deferred_data_read),
+ * or NULL when the buffer was read and its address should be read as usual.
+ */
+BlendDeferredData *BLO_read_data_defer(BlendDataReader *reader, const void *old_address);
+/**
+ * Read a buffer referenced by #BLO_read_data_defer, can be used from any thread.
+ *
+ * \return The buffer, or NULL when the file can't be read or was modified.
+ */
+void *BLO_deferred_data_read(const BlendDeferredData *deferred, const char *allocname);
+/**
+ * Pass a buffer referenced by #BLO_read_data_defer to \a write_fn in pieces, without reading all
+ * of it in memory.
+ *
+ * \return False when the file can't be read or \a write_fn failed.
+ */
+bool BLO_deferred_data_copy(const BlendDeferredData *deferred,
+                            bool (*write_fn)(void *userdata, const void *data, size_t size),
+                            void *userdata);
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -68,7 +68,7 @@ typedef struct BlendFileData {
 } BlendFileData;
 
 struct BlendFileReadParams {
-  uint skip_flags : 3; /* #eBLOReadSkip */
+  uint skip_flags : 5; /* #eBLOReadSkip */
   uint is_startup : 1;
 
   /** Whether we are reading the memfile for an undo or a redo. */
@@ -123,6 +123,14 @@ typedef enum eBLOReadSkip {
   BLO_READ_SKIP_DATA = (1 << 1),
   /** Do not attempt to re-use IDs from old bmain for unchanged ones in case of undo. */
   BLO_READ_SKIP_UNDO_OLD_MAIN = (1 << 2),
+  /**
+   * Leave large buffers in the file instead of reading them, they are read when they are first
+   * needed (only used for packed files, see #BLO_read_data_defer).
+   * Only has an effect for uncompressed files.
+   */
+  BLO_READ_SKIP_LARGE_DATA = (1 << 3),
+  /** Reconstruct blocks for the current DNA one by one when they are read, on this thread. */
+  BLO_READ_SKIP_PARALLEL_DECODE = (1 << 4),
 } eBLOReadSkip;
 #define BLO_READ_SKIP_ALL (BLO_READ_SKIP_USERDEF | BLO_READ_SKIP_DATA)
 
@@ -173,6 +181,15 @@ BlendFileData *BLO_read_from_memfile(struct Main *oldmain,
  */
 void BLO_blendfiledata_free(BlendFileData *bfd);
 
+/**
+ * Call before \a filepath is replaced. When data was left in it (see #BLO_READ_SKIP_LARGE_DATA),
+ * the file is copied to the session temporary directory, so undo steps that reference the data
+ * can still read it.
+ */
+void BLO_deferred_data_file_keep(const char *filepath);
+/** Remove the copies made by #BLO_deferred_data_file_keep, on exit. */
+void BLO_deferred_data_files_free(void);
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -11,14 +11,20 @@
 #include "BLI_filereader.h"
 
 struct GHash;
+struct MemFileChunkBuf;
 struct Scene;
 
 typedef struct {
   void *next, *prev;
-  const char *buf;
+  /**
+   * Content of the chunk. Buffers with the same content are shared by the chunks of all IDs in
+   * all undo steps, and freed with their last chunk. Only accessed in `undofile.c`, as the content
+   * of old steps may be compressed.
+   */
+  struct MemFileChunkBuf *buf;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** When true, this chunk is identical to the one at the same position in the previous step. */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -31,6 +37,10 @@ typedef struct {
 
 typedef struct MemFile {
   ListBase chunks;
+  /**
+   * Memory used by the chunk buffers this memfile added (or took over when merging), smaller once
+   * they are compressed, see #BLO_memfile_memory_size_get.
+   */
   size_t size;
 } MemFile;
 
@@ -51,6 +61,18 @@ typedef struct MemFileUndoData {
   size_t undo_size;
 } MemFileUndoData;
 
+/** Memory used by the chunks of all undo steps, see #BLO_memfile_stats_get. */
+typedef struct MemFileStats {
+  /** Number of chunk buffers (shared by any number of chunks), and how many are compressed. */
+  size_t buffers_num;
+  size_t buffers_compressed_num;
+  /** Memory used by the uncompressed buffers. */
+  size_t size_uncompressed;
+  /** Memory used by the compressed buffers, and their size once decompressed. */
+  size_t size_compressed;
+  size_t size_compressed_original;
+} MemFileStats;
+
 /* FileReader-compatible wrapper for reading MemFiles */
 typedef struct {
   FileReader reader;
@@ -83,10 +105,33 @@ extern void BLO_memfile_free(MemFile *memfile);
  * to keep list of memfiles consistent, 'first' is always first in list.
  */
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+/**
+ * Get the content of a chunk, decompressing it if needed (main thread only).
+ */
+extern const char *BLO_memfile_chunk_data_get(MemFileChunk *chunk);
 /**
  * Clear is_identical_future before adding next memfile.
  */
 extern void BLO_memfile_clear_future(MemFile *memfile);
+/**
+ * Compress the chunks that are not used by any of the last \a uncompressed_steps written
+ * memfiles with zstd, on a background thread. Compressed chunks are decompressed transparently
+ * when their undo step is read or used by a new step.
+ *
+ * \param uncompressed_steps: Zero disables compression
+ * (chunks that are already compressed stay so until they are used again).
+ */
+extern void BLO_memfile_compress_old_chunks(int uncompressed_steps);
+/**
+ * Wait for the compression started by #BLO_memfile_compress_old_chunks to finish
+ * (instead of canceling it as other functions using the chunks do).
+ */
+extern void BLO_memfile_compress_wait(void);
+/**
+ * Current #MemFile.size, which changes while old chunks are compressed in the background.
+ */
+extern size_t BLO_memfile_memory_size_get(MemFile *memfile);
+extern void BLO_memfile_stats_get(MemFileStats *r_stats);
 
 /* Utilities. */
 
@@ -100,4 +145,18 @@ extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
  */
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filepath);
 
+/** Set the next piece of a memfile, return false at its end. */
+typedef bool (*MemFileSegmentNextFn)(void *userdata, const char **r_data, size_t *r_size);
+typedef bool (*MemFileWriteFn)(void *userdata, const void *data, size_t size);
+/**
+ * Pass a memfile (or a copy of it, in any number of pieces) to \a write_fn as a regular file:
+ * packed data referenced in the file it was read from is copied from that file.
+ *
+ * \return success.
+ */
+extern bool BLO_memfile_write_stream(MemFileSegmentNextFn next_fn,
+                                     void *next_userdata,
+                                     MemFileWriteFn write_fn,
+                                     void *write_userdata);
+
 FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction);
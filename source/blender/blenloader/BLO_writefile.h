@@ -57,6 +57,49 @@ extern bool BLO_write_file(struct Main *mainvar,
                            const struct BlendFileWriteParams *params,
                            struct ReportList *reports);
 
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BLO Write File Snapshot API
+ *
+ * Serialize the file in memory on the main thread, and write it to disk later from any thread
+ * (used to save in the background). The paths of \a mainvar are remapped like #BLO_write_file.
+ * \{ */
+
+typedef struct BlendFileWriteSnapshot BlendFileWriteSnapshot;
+
+/**
+ * \return The snapshot, or NULL on failure.
+ */
+extern BlendFileWriteSnapshot *BLO_write_file_snapshot(struct Main *mainvar,
+                                                       const char *filepath,
+                                                       int write_flags,
+                                                       const struct BlendFileWriteParams *params,
+                                                       struct ReportList *reports);
+/**
+ * Copy an undo memfile (already a valid blend file) to a snapshot, used for auto-save.
+ */
+extern BlendFileWriteSnapshot *BLO_write_file_snapshot_from_memfile(struct MemFile *memfile,
+                                                                    const char *filepath);
+extern size_t BLO_write_file_snapshot_size(const BlendFileWriteSnapshot *snapshot);
+/**
+ * Write the snapshot to its file path (through a temporary file, keeping versions like
+ * #BLO_write_file). Can be called from any thread.
+ *
+ * \param progress: Optional, set between 0 and 1 while writing.
+ * \return Success.
+ */
+extern bool BLO_write_file_snapshot_store(const BlendFileWriteSnapshot *snapshot,
+                                          float *progress,
+                                          struct ReportList *reports);
+extern void BLO_write_file_snapshot_free(BlendFileWriteSnapshot *snapshot);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BLO Write Memory File API
+ * \{ */
+
 /**
  * \return Success.
  */
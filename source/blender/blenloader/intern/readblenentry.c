@@ -110,6 +110,29 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh,
   BHead *bhead;
   int tot = 0;
 
+  int entries_num;
+  const BHeadIndexEntry *entries = blo_bhead_index_entries(fd, &entries_num);
+  if (entries) {
+    for (int i = 0; i < entries_num; i++) {
+      if (entries[i].code != ofblocktype) {
+        continue;
+      }
+      if (use_assets_only) {
+        /* Asset data is only known from the ID block. */
+        bhead = blo_bhead_index_bhead(fd, i);
+        if (bhead == NULL || blo_bhead_id_asset_data_address(fd, bhead) == NULL) {
+          continue;
+        }
+      }
+
+      BLI_linklist_prepend(&names, BLI_strdup(entries[i].name + 2));
+      tot++;
+    }
+
+    *r_tot_names = tot;
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == ofblocktype) {
       const char *idname = blo_bhead_id_name(fd, bhead);
@@ -129,6 +152,43 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh,
   return names;
 }
 
+/**
+ * Add the info of an ID block to \a infos.
+ * \return The block before the next block to check.
+ */
+static BHead *blo_blendhandle_datablock_info_add(FileData *fd,
+                                                 BHead *bhead,
+                                                 const bool use_assets_only,
+                                                 LinkNode **infos,
+                                                 int *tot)
+{
+  const char *name = blo_bhead_id_name(fd, bhead) + 2;
+  AssetMetaData *asset_meta_data = blo_bhead_id_asset_data_address(fd, bhead);
+
+  const bool is_asset = asset_meta_data != NULL;
+  const bool skip_datablock = use_assets_only && !is_asset;
+  if (skip_datablock) {
+    return bhead;
+  }
+  struct BLODataBlockInfo *info = MEM_mallocN(sizeof(*info), __func__);
+
+  /* Lastly, read asset data from the following blocks. */
+  if (asset_meta_data) {
+    bhead = blo_read_asset_data_block(fd, bhead, &asset_meta_data);
+    /* blo_read_asset_data_block() reads all DATA heads and already advances bhead to the
+     * next non-DATA one. Go back, so the loop doesn't skip the non-DATA head. */
+    bhead = blo_bhead_prev(fd, bhead);
+  }
+
+  STRNCPY(info->name, name);
+  info->asset_data = asset_meta_data;
+
+  BLI_linklist_prepend(infos, info);
+  (*tot)++;
+
+  return bhead;
+}
+
 LinkNode *BLO_blendhandle_get_datablock_info(BlendHandle *bh,
                                              int ofblocktype,
                                              const bool use_assets_only,
@@ -139,34 +199,25 @@ LinkNode *BLO_blendhandle_get_datablock_info(BlendHandle *bh,
   BHead *bhead;
   int tot = 0;
 
+  int entries_num;
+  const BHeadIndexEntry *entries = blo_bhead_index_entries(fd, &entries_num);
+  if (entries) {
+    for (int i = 0; i < entries_num; i++) {
+      if (entries[i].code == ofblocktype && (bhead = blo_bhead_index_bhead(fd, i))) {
+        blo_blendhandle_datablock_info_add(fd, bhead, use_assets_only, &infos, &tot);
+      }
+    }
+
+    *r_tot_info_items = tot;
+    return infos;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == ENDB) {
       break;
     }
     if (bhead->code == ofblocktype) {
-      const char *name = blo_bhead_id_name(fd, bhead) + 2;
-      AssetMetaData *asset_meta_data = blo_bhead_id_asset_data_address(fd, bhead);
-
-      const bool is_asset = asset_meta_data != NULL;
-      const bool skip_datablock = use_assets_only && !is_asset;
-      if (skip_datablock) {
-        continue;
-      }
-      struct BLODataBlockInfo *info = MEM_mallocN(sizeof(*info), __func__);
-
-      /* Lastly, read asset data from the following blocks. */
-      if (asset_meta_data) {
-        bhead = blo_read_asset_data_block(fd, bhead, &asset_meta_data);
-        /* blo_read_asset_data_block() reads all DATA heads and already advances bhead to the
-         * next non-DATA one. Go back, so the loop doesn't skip the non-DATA head. */
-        bhead = blo_bhead_prev(fd, bhead);
-      }
-
-      STRNCPY(info->name, name);
-      info->asset_data = asset_meta_data;
-
-      BLI_linklist_prepend(&infos, info);
-      tot++;
+      bhead = blo_blendhandle_datablock_info_add(fd, bhead, use_assets_only, &infos, &tot);
     }
   }
 
@@ -223,8 +274,27 @@ PreviewImage *BLO_blendhandle_get_preview_for_id(BlendHandle *bh,
   FileData *fd = (FileData *)bh;
   bool looking = false;
   const int sdna_preview_image = DNA_struct_find_nr(fd->filesdna, "PreviewImage");
+  BHead *bhead_first = NULL;
+
+  int entries_num;
+  const BHeadIndexEntry *entries = blo_bhead_index_entries(fd, &entries_num);
+  if (entries) {
+    /* Start at the block of the ID, the preview is stored in the following blocks. */
+    for (int i = 0; i < entries_num; i++) {
+      if (entries[i].code == ofblocktype && STREQ(entries[i].name + 2, name)) {
+        bhead_first = blo_bhead_index_bhead(fd, i);
+        break;
+      }
+    }
+    if (bhead_first == NULL) {
+      return NULL;
+    }
+  }
+  else {
+    bhead_first = blo_bhead_first(fd);
+  }
 
-  for (BHead *bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+  for (BHead *bhead = bhead_first; bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == DATA) {
       if (looking && bhead->SDNAnr == sdna_preview_image) {
         PreviewImage *preview_from_file = BLO_library_read_struct(fd, bhead, "PreviewImage");
@@ -315,6 +385,19 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *r_
   return previews;
 }
 
+static void blo_blendhandle_linkable_group_add(const int code, GSet *gathered, LinkNode **names)
+{
+  if (BKE_idtype_idcode_is_valid(code)) {
+    if (BKE_idtype_idcode_is_linkable(code)) {
+      const char *str = BKE_idtype_idcode_to_name(code);
+
+      if (BLI_gset_add(gathered, (void *)str)) {
+        BLI_linklist_prepend(names, BLI_strdup(str));
+      }
+    }
+  }
+}
+
 LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
 {
   FileData *fd = (FileData *)bh;
@@ -322,18 +405,18 @@ LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
   LinkNode *names = NULL;
   BHead *bhead;
 
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
-    if (bhead->code == ENDB) {
-      break;
-    }
-    if (BKE_idtype_idcode_is_valid(bhead->code)) {
-      if (BKE_idtype_idcode_is_linkable(bhead->code)) {
-        const char *str = BKE_idtype_idcode_to_name(bhead->code);
+  int entries_num;
+  const BHeadIndexEntry *entries = blo_bhead_index_entries(fd, &entries_num);
+  for (int i = 0; i < entries_num; i++) {
+    blo_blendhandle_linkable_group_add(entries[i].code, gathered, &names);
+  }
 
-        if (BLI_gset_add(gathered, (void *)str)) {
-          BLI_linklist_prepend(&names, BLI_strdup(str));
-        }
+  if (entries == NULL) {
+    for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+      if (bhead->code == ENDB) {
+        break;
       }
+      blo_blendhandle_linkable_group_add(bhead->code, gathered, &names);
     }
   }
 
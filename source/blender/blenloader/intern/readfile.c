@@ -53,6 +53,7 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "PIL_time.h"
@@ -61,6 +62,7 @@
 
 #include "BKE_anim_data.h"
 #include "BKE_animsys.h"
+#include "BKE_appdir.h"
 #include "BKE_asset.h"
 #include "BKE_collection.h"
 #include "BKE_global.h" /* for G */
@@ -168,6 +170,13 @@
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
+/**
+ * When reading a whole file, convert the blocks that need DNA reconstruction or endian switching
+ * on multiple threads before reading the data-blocks, see #read_file_decode_structs.
+ * Depends on #USE_BHEAD_READ_ON_DEMAND.
+ */
+#define USE_PARALLEL_STRUCT_DECODE
+
 /** Use #GHash for restoring pointers by name. */
 #define USE_GHASH_RESTORE_POINTER
 
@@ -179,6 +188,10 @@ static void read_libraries(FileData *basefd, ListBase *mainlist);
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name);
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname);
+static BHead *bhead_index_bhead_at(FileData *fd, uint64_t offset);
+#ifdef USE_PARALLEL_STRUCT_DECODE
+static void read_file_decode_structs_free(FileData *fd);
+#endif
 
 typedef struct BHeadN {
   struct BHeadN *next, *prev;
@@ -187,18 +200,44 @@ typedef struct BHeadN {
   off64_t file_offset;
   /** When set, the remainder of this allocation is the data, otherwise it needs to be read. */
   bool has_data;
+#endif
+#ifdef USE_PARALLEL_STRUCT_DECODE
+  /** Result of #read_struct computed in advance, owned by the block until it is read. */
+  void *decoded_data;
 #endif
   bool is_memchunk_identical;
+  /** Offset of the block in the file, used to find read blocks when using #BHeadIndex. */
+  off64_t bhead_offset;
   struct BHead bhead;
 } BHeadN;
 
 #define BHEADN_FROM_BHEAD(bh) ((BHeadN *)POINTER_OFFSET(bh, -(int)offsetof(BHeadN, bhead)))
 
+/**
+ * Index of the ID blocks of a file (see #BHeadIndexEntry), used to only read the blocks that are
+ * needed when linking from the file or listing its data-blocks, instead of all of them.
+ */
+typedef struct BHeadIndex {
+  /** Data of the #INDX block, the entries follow the header. */
+  BHeadIndexHeader *header;
+  BHeadIndexEntry *entries;
+  /** Blocks of the entries, once they have been read. */
+  BHeadN **bheads;
+  /** Entries of linkable IDs by name (see #USE_GHASH_BHEAD). */
+  GHash *idname_hash;
+  /** Entries by #BHead.old. */
+  GHash *old_hash;
+} BHeadIndex;
+
 /**
  * We could change this in the future, for now it's simplest if only data is delayed
  * because ID names are used in lookup tables.
+ * The #INDX block is read separately, see #read_file_bhead_index.
  */
-#define BHEAD_USE_READ_ON_DEMAND(bhead) ((bhead)->code == DATA)
+#define BHEAD_USE_READ_ON_DEMAND(bhead) ELEM((bhead)->code, DATA, INDX)
+
+/** Minimum size of the data blocks left in the file with #BLO_READ_SKIP_LARGE_DATA. */
+#define BHEAD_DEFER_MIN_SIZE (256 << 10)
 
 void BLO_reportf_wrap(BlendFileReadReport *reports, eReportType type, const char *format, ...)
 {
@@ -528,9 +567,16 @@ void blo_split_main(ListBase *mainlist, Main *main)
 
 static void read_file_version(FileData *fd, Main *main)
 {
-  BHead *bhead;
+  BHead *bhead = NULL;
 
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+  if (fd->bhead_index) {
+    bhead = bhead_index_bhead_at(fd, fd->bhead_index->header->glob_offset);
+  }
+  if (bhead == NULL || bhead->code != GLOB) {
+    bhead = blo_bhead_first(fd);
+  }
+
+  for (; bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == GLOB) {
       FileGlobal *fg = read_struct(fd, bhead, "Global");
       if (fg) {
@@ -539,9 +585,11 @@ static void read_file_version(FileData *fd, Main *main)
         main->minsubversionfile = fg->minsubversion;
         MEM_freeN(fg);
       }
-      else if (bhead->code == ENDB) {
-        break;
-      }
+      /* There is only one #GLOB block. */
+      break;
+    }
+    if (bhead->code == ENDB) {
+      break;
     }
   }
   if (main->curlib) {
@@ -572,6 +620,11 @@ static void read_file_bhead_idname_map_create(FileData *fd)
 {
   BHead *bhead;
 
+  if (fd->bhead_index) {
+    /* The index is used for lookups instead, avoiding to read all blocks. */
+    return;
+  }
+
   /* dummy values */
   bool is_link = false;
   int code_prev = ENDB;
@@ -748,13 +801,18 @@ static void bh8_from_bh4(BHead *bhead, BHead4 *bhead4)
   }
 }
 
-static BHeadN *get_bhead(FileData *fd)
+/**
+ * Read the block at the current file position and insert it in #FileData.bhead_list after \a prev
+ * (at the start of the list when NULL).
+ */
+static BHeadN *get_bhead(FileData *fd, BHeadN *prev)
 {
   BHeadN *new_bhead = NULL;
   ssize_t readsize;
 
   if (fd) {
     if (!fd->is_eof) {
+      const off64_t bhead_offset = fd->file->offset;
       /* initializing to zero isn't strictly needed but shuts valgrind up
        * since uninitialized memory gets compared */
       BHead8 bhead8 = {0};
@@ -835,6 +893,10 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->file_offset = fd->file->offset;
           new_bhead->has_data = false;
           new_bhead->is_memchunk_identical = false;
+          new_bhead->bhead_offset = bhead_offset;
+#  ifdef USE_PARALLEL_STRUCT_DECODE
+          new_bhead->decoded_data = NULL;
+#  endif
           new_bhead->bhead = bhead;
           off64_t seek_new = fd->file->seek(fd->file, bhead.len, SEEK_CUR);
           if (seek_new == -1) {
@@ -856,8 +918,12 @@ static BHeadN *get_bhead(FileData *fd)
 #ifdef USE_BHEAD_READ_ON_DEMAND
           new_bhead->file_offset = 0; /* don't seek. */
           new_bhead->has_data = true;
+#endif
+#ifdef USE_PARALLEL_STRUCT_DECODE
+          new_bhead->decoded_data = NULL;
 #endif
           new_bhead->is_memchunk_identical = false;
+          new_bhead->bhead_offset = bhead_offset;
           new_bhead->bhead = bhead;
 
           readsize = fd->file->read(fd->file, new_bhead + 1, (size_t)bhead.len);
@@ -883,12 +949,50 @@ static BHeadN *get_bhead(FileData *fd)
    * of blocks.
    */
   if (new_bhead) {
-    BLI_addtail(&fd->bhead_list, new_bhead);
+    BLI_insertlinkafter(&fd->bhead_list, prev, new_bhead);
   }
 
   return new_bhead;
 }
 
+/** Size of a block in the file, including its #BHead. */
+static off64_t bhead_file_size(const FileData *fd, const BHead *bhead)
+{
+  const size_t bhead_size = (fd->flags & FD_FLAGS_FILE_POINTSIZE_IS_4) ? sizeof(BHead4) :
+                                                                         sizeof(BHead8);
+  return (off64_t)bhead_size + bhead->len;
+}
+
+/**
+ * Get the block at a file offset when only part of the blocks are read (see #BHeadIndex),
+ * reading it if it wasn't yet.
+ *
+ * \param prev: The block preceding the offset in the file when known, to avoid searching the list.
+ */
+static BHeadN *bhead_index_get_bhead_at(FileData *fd, BHeadN *prev, const off64_t offset)
+{
+  if (prev == NULL) {
+    /* The list is sorted by offset, blocks are usually needed in file order. */
+    for (prev = fd->bhead_list.last; prev && prev->bhead_offset > offset; prev = prev->prev) {
+      /* pass */
+    }
+    if (prev && prev->bhead_offset == offset) {
+      return prev;
+    }
+  }
+
+  BHeadN *next = prev ? prev->next : fd->bhead_list.first;
+  if (next && next->bhead_offset == offset) {
+    return next;
+  }
+
+  if (fd->file->seek(fd->file, offset, SEEK_SET) != offset) {
+    return NULL;
+  }
+  fd->is_eof = false;
+  return get_bhead(fd, prev);
+}
+
 BHead *blo_bhead_first(FileData *fd)
 {
   BHeadN *new_bhead;
@@ -897,9 +1001,14 @@ BHead *blo_bhead_first(FileData *fd)
   /* Rewind the file
    * Read in a new block if necessary
    */
-  new_bhead = fd->bhead_list.first;
-  if (new_bhead == NULL) {
-    new_bhead = get_bhead(fd);
+  if (fd->bhead_index) {
+    new_bhead = bhead_index_get_bhead_at(fd, NULL, SIZEOFBLENDERHEADER);
+  }
+  else {
+    new_bhead = fd->bhead_list.first;
+    if (new_bhead == NULL) {
+      new_bhead = get_bhead(fd, NULL);
+    }
   }
 
   if (new_bhead) {
@@ -909,11 +1018,17 @@ BHead *blo_bhead_first(FileData *fd)
   return bhead;
 }
 
-BHead *blo_bhead_prev(FileData *UNUSED(fd), BHead *thisblock)
+BHead *blo_bhead_prev(FileData *fd, BHead *thisblock)
 {
   BHeadN *bheadn = BHEADN_FROM_BHEAD(thisblock);
   BHeadN *prev = bheadn->prev;
 
+  if (fd->bhead_index && prev &&
+      prev->bhead_offset + bhead_file_size(fd, &prev->bhead) != bheadn->bhead_offset) {
+    /* The previous block in the file was not read, its offset is unknown. */
+    return NULL;
+  }
+
   return (prev) ? &prev->bhead : NULL;
 }
 
@@ -928,9 +1043,15 @@ BHead *blo_bhead_next(FileData *fd, BHead *thisblock)
     new_bhead = BHEADN_FROM_BHEAD(thisblock);
 
     /* get the next BHeadN. If it doesn't exist we read in the next one */
-    new_bhead = new_bhead->next;
-    if (new_bhead == NULL) {
-      new_bhead = get_bhead(fd);
+    if (fd->bhead_index) {
+      new_bhead = bhead_index_get_bhead_at(
+          fd, new_bhead, new_bhead->bhead_offset + bhead_file_size(fd, thisblock));
+    }
+    else if (new_bhead->next) {
+      new_bhead = new_bhead->next;
+    }
+    else {
+      new_bhead = get_bhead(fd, new_bhead);
     }
   }
 
@@ -973,8 +1094,12 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   BHeadN *new_bhead_data = MEM_mallocN(sizeof(BHeadN) + new_bhead->bhead.len, "new_bhead");
   new_bhead_data->bhead = new_bhead->bhead;
   new_bhead_data->file_offset = new_bhead->file_offset;
+  new_bhead_data->bhead_offset = new_bhead->bhead_offset;
   new_bhead_data->has_data = true;
   new_bhead_data->is_memchunk_identical = false;
+#  ifdef USE_PARALLEL_STRUCT_DECODE
+  new_bhead_data->decoded_data = NULL;
+#  endif
   if (!blo_bhead_read_data(fd, thisblock, new_bhead_data + 1)) {
     MEM_freeN(new_bhead_data);
     return NULL;
@@ -1036,6 +1161,226 @@ static void decode_blender_header(FileData *fd)
   }
 }
 
+static void bhead_index_free(BHeadIndex *index)
+{
+  BLI_ghash_free(index->idname_hash, NULL, NULL);
+  BLI_ghash_free(index->old_hash, NULL, NULL);
+  MEM_SAFE_FREE(index->bheads);
+  MEM_freeN(index->header);
+  MEM_freeN(index);
+}
+
+/**
+ * Read the data of the #INDX block, located through the #BHeadIndexTrailer at the end of the file.
+ * \return NULL when the file has no index.
+ */
+static BHeadIndexHeader *read_file_bhead_index_data(FileData *fd)
+{
+  BHeadIndexTrailer trailer;
+  const off64_t trailer_offset = fd->file->seek(fd->file, -(off64_t)sizeof(trailer), SEEK_END);
+  if (trailer_offset < 0 ||
+      fd->file->read(fd->file, &trailer, sizeof(trailer)) != sizeof(trailer) ||
+      memcmp(trailer.magic, BHEAD_INDEX_MAGIC, sizeof(trailer.magic)) != 0) {
+    return NULL;
+  }
+
+  /* The pointer size and byte order match (see #read_file_bhead_index),
+   * so the #BHead in the file is the same as in memory. The #INDX block is directly followed by
+   * the trailer. */
+  BHead bhead;
+  const uint64_t index_offset = trailer.index_offset;
+  if (index_offset <= SIZEOFBLENDERHEADER ||
+      index_offset + sizeof(bhead) + sizeof(BHeadIndexHeader) > (uint64_t)trailer_offset ||
+      fd->file->seek(fd->file, (off64_t)index_offset, SEEK_SET) != (off64_t)index_offset ||
+      fd->file->read(fd->file, &bhead, sizeof(bhead)) != sizeof(bhead) || bhead.code != INDX ||
+      bhead.len < (int)sizeof(BHeadIndexHeader) ||
+      index_offset + sizeof(bhead) + (uint64_t)bhead.len != (uint64_t)trailer_offset) {
+    return NULL;
+  }
+
+  BHeadIndexHeader *header = MEM_mallocN((size_t)bhead.len, __func__);
+  bool is_valid = fd->file->read(fd->file, header, (size_t)bhead.len) == bhead.len &&
+                  header->entries_num >= 0 &&
+                  (size_t)header->entries_num <=
+                      ((size_t)bhead.len - sizeof(*header)) / sizeof(BHeadIndexEntry);
+
+  /* All blocks are before the index. A corrupt index is ignored, the file is read as usual. */
+  if (is_valid) {
+    is_valid = header->glob_offset >= SIZEOFBLENDERHEADER &&
+               header->glob_offset < index_offset &&
+               header->dna_offset >= SIZEOFBLENDERHEADER && header->dna_offset < index_offset;
+  }
+  const BHeadIndexEntry *entries = (const BHeadIndexEntry *)(header + 1);
+  for (int i = 0; is_valid && i < header->entries_num; i++) {
+    is_valid = entries[i].bhead_offset >= SIZEOFBLENDERHEADER &&
+               entries[i].bhead_offset < index_offset && entries[i].lib_offset < index_offset;
+  }
+
+  if (!is_valid) {
+    MEM_freeN(header);
+    return NULL;
+  }
+  return header;
+}
+
+/**
+ * Use the ID block index of the file when it has one, so that blocks are read only when needed.
+ */
+static void read_file_bhead_index(FileData *fd)
+{
+  /* Entries store the pointers and values of the file as is, and reading only part of the file is
+   * only worth it when seeking is possible. */
+  if (fd->file->seek == NULL ||
+      (fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS | FD_FLAGS_IS_MEMFILE))) {
+    return;
+  }
+
+  const off64_t offset_backup = fd->file->offset;
+  BHeadIndexHeader *header = read_file_bhead_index_data(fd);
+  if (fd->file->seek(fd->file, offset_backup, SEEK_SET) != offset_backup) {
+    /* Reading the file as usual is not possible either. */
+    fd->is_eof = true;
+  }
+  if (header == NULL) {
+    return;
+  }
+
+  BHeadIndex *index = MEM_callocN(sizeof(*index), __func__);
+  const int entries_num = header->entries_num;
+  index->header = header;
+  index->entries = (BHeadIndexEntry *)(header + 1);
+  if (entries_num > 0) {
+    index->bheads = MEM_calloc_arrayN((size_t)entries_num, sizeof(*index->bheads), __func__);
+  }
+  index->idname_hash = BLI_ghash_str_new_ex(__func__, (uint)entries_num);
+  index->old_hash = BLI_ghash_ptr_new_ex(__func__, (uint)entries_num);
+
+  for (int i = 0; i < entries_num; i++) {
+    BHeadIndexEntry *entry = &index->entries[i];
+    entry->name[sizeof(entry->name) - 1] = '\0';
+
+    const BHead bhead = {.code = entry->code};
+    if (blo_bhead_is_id_valid_type(&bhead) && BKE_idtype_idcode_is_linkable((short)entry->code)) {
+      void **val;
+      if (!BLI_ghash_ensure_p(index->idname_hash, entry->name, &val)) {
+        *val = entry;
+      }
+    }
+    if (entry->old != 0) {
+      void **val;
+      if (!BLI_ghash_ensure_p(index->old_hash, POINTER_FROM_UINT(entry->old), &val)) {
+        *val = entry;
+      }
+    }
+  }
+
+  fd->bhead_index = index;
+}
+
+const BHeadIndexEntry *blo_bhead_index_entries(const FileData *fd, int *r_entries_num)
+{
+  if (fd->bhead_index == NULL) {
+    *r_entries_num = 0;
+    return NULL;
+  }
+  *r_entries_num = fd->bhead_index->header->entries_num;
+  return fd->bhead_index->entries;
+}
+
+BHead *blo_bhead_index_bhead(FileData *fd, const int entry_index)
+{
+  BHeadIndex *index = fd->bhead_index;
+  BLI_assert(entry_index >= 0 && entry_index < index->header->entries_num);
+
+  if (index->bheads[entry_index] == NULL) {
+    const BHeadIndexEntry *entry = &index->entries[entry_index];
+    BHeadN *bheadn = bhead_index_get_bhead_at(fd, NULL, (off64_t)entry->bhead_offset);
+    if (bheadn == NULL || bheadn->bhead.code != entry->code) {
+      return NULL;
+    }
+    index->bheads[entry_index] = bheadn;
+  }
+  return &index->bheads[entry_index]->bhead;
+}
+
+static BHead *bhead_index_bhead_at(FileData *fd, const uint64_t offset)
+{
+  BHeadN *bheadn = bhead_index_get_bhead_at(fd, NULL, (off64_t)offset);
+  return bheadn ? &bheadn->bhead : NULL;
+}
+
+static BHead *bhead_index_find_entry_bhead(FileData *fd, const BHeadIndexEntry *entry)
+{
+  return entry ? blo_bhead_index_bhead(fd, (int)(entry - fd->bhead_index->entries)) : NULL;
+}
+
+static BHead *bhead_index_find_idname(FileData *fd, const char *idname)
+{
+  return bhead_index_find_entry_bhead(fd, BLI_ghash_lookup(fd->bhead_index->idname_hash, idname));
+}
+
+static BHead *bhead_index_find_old(FileData *fd, const void *old)
+{
+  return bhead_index_find_entry_bhead(fd, BLI_ghash_lookup(fd->bhead_index->old_hash, old));
+}
+
+/**
+ * Find the #ID_LI block of the library a #ID_LINK_PLACEHOLDER block belongs to.
+ */
+static BHead *bhead_index_find_lib(FileData *fd, const BHead *bhead)
+{
+  const BHeadIndexEntry *entry = BLI_ghash_lookup(fd->bhead_index->old_hash, bhead->old);
+  if (entry == NULL || entry->lib_offset == 0) {
+    return NULL;
+  }
+  BHead *bheadlib = bhead_index_bhead_at(fd, entry->lib_offset);
+  return (bheadlib && bheadlib->code == ID_LI) ? bheadlib : NULL;
+}
+
+/**
+ * Read the subversion from the #GLOB block, before 'DNA1' is decoded.
+ */
+static int read_file_dna_subversion(const FileData *fd, const BHead *bhead)
+{
+  /* Before this, the subversion didn't exist in 'FileGlobal' so the subversion
+   * value isn't accessible for the purpose of DNA versioning in this case. */
+  if (fd->fileversion <= 242) {
+    return 0;
+  }
+  /* We can't use read_global because this needs 'DNA1' to be decoded,
+   * however the first 4 chars are _always_ the subversion. */
+  const FileGlobal *fg = (const void *)&bhead[1];
+  BLI_STATIC_ASSERT(offsetof(FileGlobal, subvstr) == 0, "Must be first: subvstr")
+  char num[5];
+  memcpy(num, fg->subvstr, 4);
+  num[4] = 0;
+  return atoi(num);
+}
+
+static bool read_file_dna_decode(FileData *fd,
+                                 const BHead *bhead,
+                                 const int subversion,
+                                 const char **r_error_message)
+{
+  const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
+
+  fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+  if (fd->filesdna) {
+    blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
+    fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
+    fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
+    /* used to retrieve ID names from (bhead+1) */
+    fd->id_name_offset = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
+    BLI_assert(fd->id_name_offset != -1);
+    fd->id_asset_data_offset = DNA_elem_offset(
+        fd->filesdna, "ID", "AssetMetaData", "*asset_data");
+
+    return true;
+  }
+
+  return false;
+}
+
 /**
  * \return Success if the file is read correctly, else set \a r_error_message.
  */
@@ -1044,42 +1389,22 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
   BHead *bhead;
   int subversion = 0;
 
+  if (fd->bhead_index) {
+    /* Jump to the blocks directly, 'DNA1' is written at the end of the file. */
+    BHead *bhead_glob = bhead_index_bhead_at(fd, fd->bhead_index->header->glob_offset);
+    BHead *bhead_dna = bhead_index_bhead_at(fd, fd->bhead_index->header->dna_offset);
+    if (bhead_glob && bhead_glob->code == GLOB && bhead_dna && bhead_dna->code == DNA1) {
+      subversion = read_file_dna_subversion(fd, bhead_glob);
+      return read_file_dna_decode(fd, bhead_dna, subversion, r_error_message);
+    }
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == GLOB) {
-      /* Before this, the subversion didn't exist in 'FileGlobal' so the subversion
-       * value isn't accessible for the purpose of DNA versioning in this case. */
-      if (fd->fileversion <= 242) {
-        continue;
-      }
-      /* We can't use read_global because this needs 'DNA1' to be decoded,
-       * however the first 4 chars are _always_ the subversion. */
-      FileGlobal *fg = (void *)&bhead[1];
-      BLI_STATIC_ASSERT(offsetof(FileGlobal, subvstr) == 0, "Must be first: subvstr")
-      char num[5];
-      memcpy(num, fg->subvstr, 4);
-      num[4] = 0;
-      subversion = atoi(num);
+      subversion = read_file_dna_subversion(fd, bhead);
     }
     else if (bhead->code == DNA1) {
-      const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-
-      fd->filesdna = DNA_sdna_from_data(
-          &bhead[1], bhead->len, do_endian_swap, true, r_error_message);
-      if (fd->filesdna) {
-        blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
-        fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-        fd->reconstruct_info = DNA_reconstruct_info_create(
-            fd->filesdna, fd->memsdna, fd->compflags);
-        /* used to retrieve ID names from (bhead+1) */
-        fd->id_name_offset = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
-        BLI_assert(fd->id_name_offset != -1);
-        fd->id_asset_data_offset = DNA_elem_offset(
-            fd->filesdna, "ID", "AssetMetaData", "*asset_data");
-
-        return true;
-      }
-
-      return false;
+      return read_file_dna_decode(fd, bhead, subversion, r_error_message);
     }
     else if (bhead->code == ENDB) {
       break;
@@ -1158,6 +1483,8 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
   decode_blender_header(fd);
 
   if (fd->flags & FD_FLAGS_FILE_OK) {
+    read_file_bhead_index(fd);
+
     const char *error_message = NULL;
     if (read_file_dna(fd, &error_message) == false) {
       BKE_reportf(
@@ -1205,7 +1532,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   rawfile->seek(rawfile, 0, SEEK_SET);
 
   /* Check if we have a regular file. */
-  if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
+  const bool is_uncompressed = memcmp(header, "BLENDER", sizeof(header)) == 0;
+  if (is_uncompressed) {
     /* Try opening the file with memory-mapped IO. */
     file = BLI_filereader_new_mmap(filedes);
     if (file == NULL) {
@@ -1238,6 +1566,9 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   FileData *fd = filedata_new(reports);
   fd->file = file;
+  if (is_uncompressed) {
+    fd->flags |= FD_FLAGS_FILE_IS_UNCOMPRESSED;
+  }
 
   return fd;
 }
@@ -1264,6 +1595,12 @@ FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *repo
     /* needed for library_append and read_libraries */
     BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
 
+    BLI_stat_t st;
+    if (BLI_stat(filepath, &st) != -1) {
+      fd->file_mtime = (int64_t)st.st_mtime;
+      fd->file_size = (uint64_t)st.st_size;
+    }
+
     return blo_decode_and_check(fd, reports->reports);
   }
   return NULL;
@@ -1337,6 +1674,11 @@ void blo_filedata_free(FileData *fd)
 {
   if (fd) {
 
+#ifdef USE_PARALLEL_STRUCT_DECODE
+    /* Blocks decoded in advance but never read. */
+    read_file_decode_structs_free(fd);
+#endif
+
     /* Free all BHeadN data blocks */
 #ifndef NDEBUG
     BLI_freelistN(&fd->bhead_list);
@@ -1364,6 +1706,9 @@ void blo_filedata_free(FileData *fd)
     if (fd->datamap) {
       oldnewmap_free(fd->datamap);
     }
+    if (fd->deferredmap) {
+      oldnewmap_free(fd->deferredmap);
+    }
     if (fd->globmap) {
       oldnewmap_free(fd->globmap);
     }
@@ -1386,6 +1731,9 @@ void blo_filedata_free(FileData *fd)
       BLI_ghash_free(fd->bhead_idname_hash, NULL, NULL);
     }
 #endif
+    if (fd->bhead_index) {
+      bhead_index_free(fd->bhead_index);
+    }
 
     MEM_freeN(fd);
   }
@@ -1499,15 +1847,33 @@ BlendThumbnail *BLO_thumbnail_from_file(const char *filepath)
 /** \name Old/New Pointer Map
  * \{ */
 
+/* Read a block that was left in the file by #read_data_into_datamap, when it is used anyway. */
+static void read_deferred_data_into_datamap(FileData *fd, const void *adr)
+{
+  if (fd->deferredmap == NULL || adr == NULL || oldnewmap_lookup_entry(fd->datamap, adr)) {
+    return;
+  }
+  BHead *bhead = oldnewmap_lookup_and_inc(fd->deferredmap, adr, false);
+  if (bhead == NULL) {
+    return;
+  }
+  void *data = read_struct(fd, bhead, "deferred data");
+  if (data) {
+    oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+  }
+}
+
 /* Only direct data-blocks. */
 static void *newdataadr(FileData *fd, const void *adr)
 {
+  read_deferred_data_into_datamap(fd, adr);
   return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
 /* Only direct data-blocks. */
 static void *newdataadr_no_us(FileData *fd, const void *adr)
 {
+  read_deferred_data_into_datamap(fd, adr);
   return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
 }
 
@@ -1523,7 +1889,7 @@ static void *newpackedadr(FileData *fd, const void *adr)
     return oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
   }
 
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return newdataadr(fd, adr);
 }
 
 /* only lib data */
@@ -1856,10 +2222,168 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
   }
 }
 
+#ifdef USE_PARALLEL_STRUCT_DECODE
+
+/** Maximum size of the file data read in memory for one batch of #read_file_decode_structs. */
+#  define DECODE_STRUCTS_BATCH_SIZE (64 << 20)
+
+typedef struct DecodeStructTask {
+  /** The block in #FileData.bhead_list, storing the result. */
+  BHeadN *bheadn;
+  /** The block with its data, a temporary copy when the data was not read yet. */
+  BHead *bhead_data;
+} DecodeStructTask;
+
+/**
+ * Blocks decoded in advance when reading a whole file, see #read_file_decode_structs.
+ * Only the results of the last batch are kept.
+ */
+typedef struct DecodeStructs {
+  DecodeStructTask *tasks;
+  int tasks_num, tasks_num_alloc;
+} DecodeStructs;
+
+typedef struct DecodeStructsData {
+  FileData *fd;
+  DecodeStructTask *tasks;
+} DecodeStructsData;
+
+/**
+ * Whether #read_struct reconstructs the block for the current DNA, only data-blocks and their data
+ * are decoded in advance. Blocks that only need a copy (or endian switching) are read as usual,
+ * so their memory keeps the name given to #read_struct.
+ */
+static bool read_file_decode_struct_is_needed(const FileData *fd, const BHead *bhead)
+{
+  if (bhead->len == 0 || !(bhead->code == DATA || blo_bhead_is_id(bhead))) {
+    return false;
+  }
+  return fd->compflags[bhead->SDNAnr] == SDNA_CMP_NOT_EQUAL;
+}
+
+static void read_file_decode_struct_cb(void *__restrict userdata,
+                                       const int index,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DecodeStructsData *data = userdata;
+  const FileData *fd = data->fd;
+  DecodeStructTask *task = &data->tasks[index];
+  BHead *bh = task->bhead_data;
+
+  /* Same as #read_struct. */
+  if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN)) {
+    switch_endian_structs(fd->filesdna, bh);
+  }
+  task->bheadn->decoded_data = DNA_struct_reconstruct(
+      fd->reconstruct_info, bh->SDNAnr, bh->nr, (bh + 1));
+}
+
+/** Free the results of the last batch that were not used by #read_struct. */
+static void read_file_decode_structs_clear(DecodeStructs *decode)
+{
+  for (int i = 0; i < decode->tasks_num; i++) {
+    MEM_SAFE_FREE(decode->tasks[i].bheadn->decoded_data);
+  }
+  decode->tasks_num = 0;
+}
+
+static void read_file_decode_structs_free(FileData *fd)
+{
+  if (fd->decode_structs) {
+    read_file_decode_structs_clear(fd->decode_structs);
+    MEM_SAFE_FREE(fd->decode_structs->tasks);
+    MEM_freeN(fd->decode_structs);
+    fd->decode_structs = NULL;
+  }
+}
+
+/**
+ * Reconstruct the data-blocks and data blocks starting at \a bhead_first for the current DNA
+ * on multiple threads. The results are used by #read_struct, so reading the data-blocks and
+ * restoring pointers still happens in order on a single thread.
+ *
+ * Blocks are read in file order, so a batch is usually used up before the next one is decoded.
+ * The file data of a batch is limited by #DECODE_STRUCTS_BATCH_SIZE, results of the previous
+ * batch that were not read (e.g. skipped blocks) are freed, so the decoded data in memory stays
+ * bounded. Those blocks are reconstructed by #read_struct if they are needed later.
+ */
+static void read_file_decode_structs(FileData *fd, BHead *bhead_first)
+{
+  DecodeStructs *decode = fd->decode_structs;
+  read_file_decode_structs_clear(decode);
+
+  size_t batch_size = 0;
+  for (BHead *bhead = bhead_first; bhead && batch_size < DECODE_STRUCTS_BATCH_SIZE;
+       bhead = blo_bhead_next(fd, bhead)) {
+    if (bhead->code == ENDB) {
+      break;
+    }
+    if (!read_file_decode_struct_is_needed(fd, bhead)) {
+      continue;
+    }
+
+    BHeadN *bheadn = BHEADN_FROM_BHEAD(bhead);
+    BHead *bhead_data = bhead;
+    if (!bheadn->has_data) {
+      /* File data is read in file order here, decoding happens on the threads. */
+      bhead_data = blo_bhead_read_full(fd, bhead);
+      if (bhead_data == NULL) {
+        /* Reported by #read_struct. */
+        continue;
+      }
+    }
+    else if (fd->flags & FD_FLAGS_SWITCH_ENDIAN) {
+      /* Endian switching happens in place, keep the block as is in case the result is freed and
+       * #read_struct reads it again. */
+      bhead_data = &((BHeadN *)MEM_dupallocN(bheadn))->bhead;
+    }
+
+    if (decode->tasks_num == decode->tasks_num_alloc) {
+      decode->tasks_num_alloc = max_ii(decode->tasks_num_alloc * 2, 1024);
+      decode->tasks = MEM_reallocN(decode->tasks,
+                                   sizeof(*decode->tasks) * (size_t)decode->tasks_num_alloc);
+    }
+    decode->tasks[decode->tasks_num].bheadn = bheadn;
+    decode->tasks[decode->tasks_num].bhead_data = bhead_data;
+    decode->tasks_num++;
+    batch_size += (size_t)bhead->len;
+  }
+
+  DecodeStructsData data = {fd, decode->tasks};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 16;
+  BLI_task_parallel_range(0, decode->tasks_num, &data, read_file_decode_struct_cb, &settings);
+
+  for (int i = 0; i < decode->tasks_num; i++) {
+    DecodeStructTask *task = &decode->tasks[i];
+    if (task->bhead_data != &task->bheadn->bhead) {
+      MEM_freeN(BHEADN_FROM_BHEAD(task->bhead_data));
+      task->bhead_data = NULL;
+    }
+  }
+}
+
+#endif /* USE_PARALLEL_STRUCT_DECODE */
+
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 {
   void *temp = NULL;
 
+#ifdef USE_PARALLEL_STRUCT_DECODE
+  BHeadN *bheadn = BHEADN_FROM_BHEAD(bh);
+  if (bheadn->decoded_data == NULL && fd->decode_structs &&
+      read_file_decode_struct_is_needed(fd, bh)) {
+    /* Decode this block and the following ones, which are usually read next. */
+    read_file_decode_structs(fd, bh);
+  }
+  if (bheadn->decoded_data) {
+    temp = bheadn->decoded_data;
+    bheadn->decoded_data = NULL;
+    return temp;
+  }
+#endif
+
   if (bh->len) {
 #ifdef USE_BHEAD_READ_ON_DEMAND
     BHead *bh_orig = bh;
@@ -3048,12 +3572,48 @@ static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *
   return success;
 }
 
+/**
+ * Whether the block can be left in the file (see #BLO_READ_SKIP_LARGE_DATA): it must be a large
+ * buffer that was not read yet and has the same layout in memory.
+ */
+static bool read_data_use_defer(const FileData *fd, const BHead *bhead)
+{
+#ifdef USE_BHEAD_READ_ON_DEMAND
+  return (fd->skip_flags & BLO_READ_SKIP_LARGE_DATA) &&
+         (fd->flags & FD_FLAGS_FILE_IS_UNCOMPRESSED) && bhead->SDNAnr == 0 &&
+         bhead->len >= BHEAD_DEFER_MIN_SIZE && fd->compflags[0] == SDNA_CMP_EQUAL &&
+         !BHEADN_FROM_BHEAD(bhead)->has_data;
+#else
+  UNUSED_VARS(fd, bhead);
+  return false;
+#endif
+}
+
+/* Clear the deferred blocks of the last data-block read by #read_data_into_datamap. */
+static void read_data_deferredmap_clear(FileData *fd)
+{
+  if (fd->deferredmap) {
+    oldnewmap_free(fd->deferredmap);
+    fd->deferredmap = NULL;
+  }
+}
+
 /* Read all data associated with a datablock into datamap. */
 static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *allocname)
 {
   bhead = blo_bhead_next(fd, bhead);
 
   while (bhead && bhead->code == DATA) {
+    if (read_data_use_defer(fd, bhead)) {
+      /* Read on demand, see #read_deferred_data_into_datamap and #BLO_read_data_defer. */
+      if (fd->deferredmap == NULL) {
+        fd->deferredmap = oldnewmap_new();
+      }
+      oldnewmap_insert(fd->deferredmap, bhead->old, bhead, 0);
+      bhead = blo_bhead_next(fd, bhead);
+      continue;
+    }
+
     /* The code below is useful for debugging leaks in data read from the blend file.
      * Without this the messages only tell us what ID-type the memory came from,
      * eg: `Data from OB len 64`, see #dataname.
@@ -3423,6 +3983,7 @@ static BHead *read_libblock(FileData *fd,
   bhead = read_data_into_datamap(fd, bhead, allocname);
   const bool success = direct_link_id(fd, main, id_tag, id, id_old);
   oldnewmap_clear(fd->datamap);
+  read_data_deferredmap_clear(fd);
 
   if (!success) {
     /* XXX This is probably working OK currently given the very limited scope of that flag.
@@ -3466,6 +4027,7 @@ BHead *blo_read_asset_data_block(FileData *fd, BHead *bhead, AssetMetaData **r_a
   BKE_asset_metadata_read(&reader, *r_asset_data);
 
   oldnewmap_clear(fd->datamap);
+  read_data_deferredmap_clear(fd);
 
   return bhead;
 }
@@ -3813,6 +4375,7 @@ static BHead *read_userdef(BlendFileData *bfd, FileData *fd, BHead *bhead)
 
   /* free fd->datamap again */
   oldnewmap_clear(fd->datamap);
+  read_data_deferredmap_clear(fd);
 
   return bhead;
 }
@@ -3846,6 +4409,14 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     STRNCPY(bfd->main->filepath, filepath);
   }
 
+#ifdef USE_PARALLEL_STRUCT_DECODE
+  /* Undo steps are written with the current DNA, there is nothing to decode. */
+  if ((fd->flags & FD_FLAGS_IS_MEMFILE) == 0 &&
+      (fd->skip_flags & (BLO_READ_SKIP_DATA | BLO_READ_SKIP_PARALLEL_DECODE)) == 0) {
+    fd->decode_structs = MEM_callocN(sizeof(*fd->decode_structs), __func__);
+  }
+#endif
+
   if (G.background) {
     /* We only read & store .blend thumbnail in background mode
      * (because we cannot re-generate it, no OpenGL available).
@@ -4061,6 +4632,10 @@ static BHead *find_previous_lib(FileData *fd, BHead *bhead)
     return NULL;
   }
 
+  if (fd->bhead_index) {
+    return bhead_index_find_lib(fd, bhead);
+  }
+
   for (; bhead; bhead = blo_bhead_prev(fd, bhead)) {
     if (bhead->code == ID_LI) {
       break;
@@ -4081,6 +4656,11 @@ static BHead *find_bhead(FileData *fd, void *old)
     return NULL;
   }
 
+  if (fd->bhead_index) {
+    /* Only ID pointers are expanded, which are all in the index. */
+    return bhead_index_find_old(fd, old);
+  }
+
   if (fd->bheadmap == NULL) {
     sort_bhead_old_map(fd);
   }
@@ -4112,7 +4692,7 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
   *((short *)idname_full) = idcode;
   BLI_strncpy(idname_full + 2, name, sizeof(idname_full) - 2);
 
-  return BLI_ghash_lookup(fd->bhead_idname_hash, idname_full);
+  return find_bhead_from_idname(fd, idname_full);
 
 #else
   BHead *bhead;
@@ -4135,6 +4715,9 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
 {
+  if (fd->bhead_index) {
+    return bhead_index_find_idname(fd, idname);
+  }
 #ifdef USE_GHASH_BHEAD
   return BLI_ghash_lookup(fd->bhead_idname_hash, idname);
 #else
@@ -4790,10 +5373,13 @@ static FileData *read_library_file_data(FileData *basefd,
                      TIP_("Read packed library:  '%s', parent '%s'"),
                      mainptr->curlib->filepath,
                      library_parent_filepath(mainptr->curlib));
-    fd = blo_filedata_from_memory(pf->data, pf->size, basefd->reports);
+    fd = blo_filedata_from_memory(
+        BKE_packedfile_data_ensure(pf, basefd->reports->reports), pf->size, basefd->reports);
 
     /* Needed for library_append and read_libraries. */
-    BLI_strncpy(fd->relabase, mainptr->curlib->filepath_abs, sizeof(fd->relabase));
+    if (fd) {
+      BLI_strncpy(fd->relabase, mainptr->curlib->filepath_abs, sizeof(fd->relabase));
+    }
   }
   else {
     /* Read file on disk. */
@@ -4956,6 +5542,201 @@ void *BLO_read_get_new_packed_address(BlendDataReader *reader, const void *old_a
   return newpackedadr(reader->fd, old_address);
 }
 
+/**
+ * Files that deferred data was left in. When such a file is replaced by saving, undo steps still
+ * reference the data in it, so a copy of the file is kept for them (see
+ * #BLO_deferred_data_file_keep).
+ */
+typedef struct DeferredDataFile {
+  struct DeferredDataFile *next, *prev;
+  char filepath[FILE_MAX];
+  int64_t file_mtime;
+  uint64_t file_size;
+  /** Copy of the file, made before the file was replaced. Empty while the file is unchanged. */
+  char copy_filepath[FILE_MAX];
+} DeferredDataFile;
+
+static ListBase deferred_data_files = {NULL, NULL};
+static ThreadMutex deferred_data_files_mutex = BLI_MUTEX_INITIALIZER;
+
+/** Call with #deferred_data_files_mutex locked. */
+static DeferredDataFile *deferred_data_file_find(const char *filepath,
+                                                 const int64_t file_mtime,
+                                                 const uint64_t file_size)
+{
+  LISTBASE_FOREACH (DeferredDataFile *, file, &deferred_data_files) {
+    if (file->file_mtime == file_mtime && file->file_size == file_size &&
+        BLI_path_cmp(file->filepath, filepath) == 0) {
+      return file;
+    }
+  }
+  return NULL;
+}
+
+BlendDeferredData *BLO_read_data_defer(BlendDataReader *reader, const void *old_address)
+{
+  FileData *fd = reader->fd;
+  if (fd->deferredmap == NULL || old_address == NULL ||
+      oldnewmap_lookup_entry(fd->datamap, old_address)) {
+    return NULL;
+  }
+  BHead *bhead = oldnewmap_lookup_and_inc(fd->deferredmap, old_address, false);
+  if (bhead == NULL) {
+    return NULL;
+  }
+
+  BlendDeferredData *deferred = MEM_callocN(sizeof(*deferred), __func__);
+  BLI_strncpy(deferred->filepath, fd->relabase, sizeof(deferred->filepath));
+#ifdef USE_BHEAD_READ_ON_DEMAND
+  deferred->offset = (uint64_t)BHEADN_FROM_BHEAD(bhead)->file_offset;
+#endif
+  deferred->size = (uint64_t)bhead->len;
+  deferred->file_mtime = fd->file_mtime;
+  deferred->file_size = fd->file_size;
+
+  BLI_mutex_lock(&deferred_data_files_mutex);
+  if (!deferred_data_file_find(deferred->filepath, deferred->file_mtime, deferred->file_size)) {
+    DeferredDataFile *file = MEM_callocN(sizeof(*file), __func__);
+    STRNCPY(file->filepath, deferred->filepath);
+    file->file_mtime = deferred->file_mtime;
+    file->file_size = deferred->file_size;
+    BLI_addtail(&deferred_data_files, file);
+  }
+  BLI_mutex_unlock(&deferred_data_files_mutex);
+
+  return deferred;
+}
+
+void BLO_deferred_data_file_keep(const char *filepath)
+{
+  BLI_stat_t st;
+  if (BLI_stat(filepath, &st) == -1) {
+    return;
+  }
+
+  BLI_mutex_lock(&deferred_data_files_mutex);
+  DeferredDataFile *file = deferred_data_file_find(
+      filepath, (int64_t)st.st_mtime, (uint64_t)st.st_size);
+  if (file != NULL && file->copy_filepath[0] == '\0') {
+    char name[64];
+    BLI_snprintf(name, sizeof(name), "deferred_data_%p.blend", (void *)file);
+    BLI_join_dirfile(
+        file->copy_filepath, sizeof(file->copy_filepath), BKE_tempdir_session(), name);
+    if (BLI_copy(filepath, file->copy_filepath) != 0) {
+      CLOG_ERROR(&LOG,
+                 "Unable to copy '%s' to '%s', undo steps may lose packed data",
+                 filepath,
+                 file->copy_filepath);
+      file->copy_filepath[0] = '\0';
+    }
+  }
+  BLI_mutex_unlock(&deferred_data_files_mutex);
+}
+
+void BLO_deferred_data_files_free(void)
+{
+  BLI_mutex_lock(&deferred_data_files_mutex);
+  LISTBASE_FOREACH (DeferredDataFile *, file, &deferred_data_files) {
+    if (file->copy_filepath[0] != '\0') {
+      BLI_delete(file->copy_filepath, false, false);
+    }
+  }
+  BLI_freelistN(&deferred_data_files);
+  BLI_mutex_unlock(&deferred_data_files_mutex);
+}
+
+/**
+ * Open the file that has the deferred data, or the copy of it kept when it was replaced.
+ * \return The file positioned at the data, or NULL when it can't be read or was modified.
+ */
+static FileReader *deferred_data_open(const BlendDeferredData *deferred)
+{
+  char filepath[FILE_MAX];
+  STRNCPY(filepath, deferred->filepath);
+
+  BLI_stat_t st;
+  if (BLI_stat(filepath, &st) == -1 || (int64_t)st.st_mtime != deferred->file_mtime ||
+      (uint64_t)st.st_size != deferred->file_size) {
+    BLI_mutex_lock(&deferred_data_files_mutex);
+    const DeferredDataFile *file = deferred_data_file_find(
+        deferred->filepath, deferred->file_mtime, deferred->file_size);
+    if (file != NULL) {
+      STRNCPY(filepath, file->copy_filepath);
+    }
+    BLI_mutex_unlock(&deferred_data_files_mutex);
+
+    if (file == NULL || filepath[0] == '\0' || BLI_stat(filepath, &st) == -1 ||
+        (uint64_t)st.st_size != deferred->file_size) {
+      CLOG_ERROR(&LOG, "File '%s' was modified or removed, can't read data", deferred->filepath);
+      return NULL;
+    }
+  }
+
+  const int filedes = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+  if (filedes == -1) {
+    CLOG_ERROR(&LOG, "Unable to open '%s': %s", filepath, strerror(errno));
+    return NULL;
+  }
+  FileReader *file = BLI_filereader_new_file(filedes);
+  if (file == NULL) {
+    close(filedes);
+    return NULL;
+  }
+  if (file->seek(file, (off64_t)deferred->offset, SEEK_SET) == -1) {
+    CLOG_ERROR(&LOG, "Unable to read data from '%s'", filepath);
+    file->close(file);
+    return NULL;
+  }
+  return file;
+}
+
+void *BLO_deferred_data_read(const BlendDeferredData *deferred, const char *allocname)
+{
+  FileReader *file = deferred_data_open(deferred);
+  if (file == NULL) {
+    return NULL;
+  }
+
+  void *data = MEM_mallocN((size_t)deferred->size, allocname);
+  if (file->read(file, data, (size_t)deferred->size) != (ssize_t)deferred->size) {
+    CLOG_ERROR(&LOG, "Unable to read data from '%s'", deferred->filepath);
+    MEM_freeN(data);
+    data = NULL;
+  }
+  file->close(file);
+
+  return data;
+}
+
+bool BLO_deferred_data_copy(const BlendDeferredData *deferred,
+                            bool (*write_fn)(void *userdata, const void *data, size_t size),
+                            void *userdata)
+{
+  FileReader *file = deferred_data_open(deferred);
+  if (file == NULL) {
+    return false;
+  }
+
+  const size_t buffer_size = min_zz((size_t)deferred->size, 1 << 20);
+  void *buffer = MEM_mallocN(buffer_size, __func__);
+  bool ok = true;
+  for (uint64_t done = 0; ok && done < deferred->size;) {
+    const size_t size = min_zz(buffer_size, (size_t)(deferred->size - done));
+    if (file->read(file, buffer, size) != (ssize_t)size) {
+      CLOG_ERROR(&LOG, "Unable to read data from '%s'", deferred->filepath);
+      ok = false;
+    }
+    else {
+      ok = write_fn(userdata, buffer, size);
+    }
+    done += size;
+  }
+  MEM_freeN(buffer);
+  file->close(file);
+
+  return ok;
+}
+
 ID *BLO_read_get_new_id_address(BlendLibReader *reader, Library *lib, ID *id)
 {
   return newlibadr(reader->fd, lib, id);
@@ -17,6 +17,7 @@
 #include "DNA_space_types.h"
 #include "DNA_windowmanager_types.h" /* for eReportType */
 
+struct BHeadIndex;
 struct BLI_mmap_file;
 struct BLOCacheStorage;
 struct IDNameLib_Map;
@@ -37,6 +38,8 @@ enum eFileDataFlag {
   FD_FLAGS_IS_MEMFILE = 1 << 4,
   /* XXX Unused in practice (checked once but never set). */
   FD_FLAGS_NOT_MY_LIBMAP = 1 << 5,
+  /** The file is read without decompression, offsets in the file can be used to read it later. */
+  FD_FLAGS_FILE_IS_UNCOMPRESSED = 1 << 6,
 };
 
 /* Disallow since it's 32bit on ms-windows. */
@@ -58,6 +61,9 @@ typedef struct FileData {
 
   /** Now only in use for library appending. */
   char relabase[FILE_MAX];
+  /** Modification time and size of the file, to detect changes when reading deferred data. */
+  int64_t file_mtime;
+  uint64_t file_size;
 
   /** General reading variables. */
   struct SDNA *filesdna;
@@ -90,6 +96,12 @@ typedef struct FileData {
   struct OldNewMap *globmap;
   struct OldNewMap *libmap;
   struct OldNewMap *packedmap;
+  /**
+   * Large data blocks of the data-block being read that were left in the file
+   * (see #BLO_READ_SKIP_LARGE_DATA), from their old address to their #BHead.
+   * NULL when there are none.
+   */
+  struct OldNewMap *deferredmap;
   struct BLOCacheStorage *cache_storage;
 
   struct BHeadSort *bheadmap;
@@ -98,6 +110,16 @@ typedef struct FileData {
   /** See: #USE_GHASH_BHEAD. */
   struct GHash *bhead_idname_hash;
 
+  /**
+   * Index of the ID blocks stored in the file, NULL when the file has none (or it can't be used).
+   * When set, #bhead_list only contains the blocks that were needed so far, sorted by their
+   * offset in the file.
+   */
+  struct BHeadIndex *bhead_index;
+
+  /** Blocks decoded in advance on multiple threads, see #USE_PARALLEL_STRUCT_DECODE. */
+  struct DecodeStructs *decode_structs;
+
   ListBase *mainlist;
   /** Used for undo. */
   ListBase *old_mainlist;
@@ -108,6 +130,45 @@ typedef struct FileData {
 
 #define SIZEOFBLENDERHEADER 12
 
+/**
+ * Optional index of the ID blocks of a file, allowing to read only the blocks needed when linking
+ * from a file or listing its data-blocks.
+ *
+ * It is stored in an #INDX block written after #ENDB (so that it is ignored by regular reading),
+ * which contains a #BHeadIndexHeader followed by the entries. The file ends with a
+ * #BHeadIndexTrailer to find the block without reading the whole file.
+ * All offsets are in the uncompressed file, values use the byte order of the file.
+ */
+typedef struct BHeadIndexHeader {
+  int32_t entries_num;
+  int32_t _pad;
+  /** Offsets of the #GLOB and #DNA1 blocks. */
+  uint64_t glob_offset;
+  uint64_t dna_offset;
+} BHeadIndexHeader;
+
+typedef struct BHeadIndexEntry {
+  /** Offset of the #BHead of the ID. */
+  uint64_t bhead_offset;
+  /** For #ID_LINK_PLACEHOLDER blocks, offset of the #ID_LI block of their library. */
+  uint64_t lib_offset;
+  /** #BHead.old of the ID. */
+  uint64_t old;
+  /** #BHead.code of the ID. */
+  int32_t code;
+  char name[66]; /* MAX_ID_NAME */
+  char _pad[2];
+} BHeadIndexEntry;
+
+#define BHEAD_INDEX_MAGIC "BLENINDX"
+
+typedef struct BHeadIndexTrailer {
+  /** #BHEAD_INDEX_MAGIC, without null terminator. */
+  char magic[8];
+  /** Offset of the #INDX block. */
+  uint64_t index_offset;
+} BHeadIndexTrailer;
+
 /***/
 struct Main;
 void blo_join_main(ListBase *mainlist);
@@ -156,6 +217,18 @@ BHead *blo_bhead_first(FileData *fd);
 BHead *blo_bhead_next(FileData *fd, BHead *thisblock);
 BHead *blo_bhead_prev(FileData *fd, BHead *thisblock);
 
+/**
+ * Entries of the ID block index of the file, to find the blocks of IDs without iterating over all
+ * blocks with #blo_bhead_next.
+ *
+ * \return NULL when the file has no usable index.
+ */
+const BHeadIndexEntry *blo_bhead_index_entries(const FileData *fd, int *r_entries_num);
+/**
+ * Read the block of an entry from #blo_bhead_index_entries.
+ */
+BHead *blo_bhead_index_bhead(FileData *fd, int entry_index);
+
 /**
  * Warning! Caller's responsibility to ensure given bhead **is** an ID one!
  */
@@ -19,13 +19,24 @@
 #  include <io.h>
 #endif
 
+#include <zstd.h>
+
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
+#include "DNA_genfile.h"
 #include "DNA_listBase.h"
+#include "DNA_packedFile_types.h"
+#include "DNA_sdna_types.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_task.h"
 
+#include "BLO_blend_defs.h"
+#include "BLO_read_write.h"
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
 
@@ -36,16 +47,366 @@
 /* keep last */
 #include "BLI_strict_flags.h"
 
+/* **************** shared chunk buffers *************** */
+
+/* Buffers smaller than this are not worth compressing. */
+#define MEMFILE_COMPRESS_MIN_SIZE 256
+/* Limits of the buffers compressed by one task, a canceled pool waits for the running task. */
+#define MEMFILE_COMPRESS_TASK_BUFS_MAX 256
+#define MEMFILE_COMPRESS_TASK_SIZE_MAX (1 << 22) /* 4mb */
+#define MEMFILE_ZSTD_COMPRESSION_LEVEL 1
+
+/**
+ * Content of a chunk, which can be used by any number of chunks of any undo steps.
+ *
+ * Buffers that are not used by the last few written memfiles can be compressed on a background
+ * thread (see #BLO_memfile_compress_old_chunks), they are decompressed again when used.
+ */
+typedef struct MemFileChunkBuf {
+  /** Number of chunks using the buffer. */
+  int users;
+  /** Hash of the content, see #memfile_chunk_buf_hash. */
+  uint hash;
+  /** Value of #memfile_generation when the buffer was last used. */
+  uint generation;
+  /** Size of the content in bytes. */
+  size_t size;
+  /** Content, NULL when compressed. */
+  char *data;
+  /** Compressed content (zstd frame), NULL when not compressed. */
+  void *data_compressed;
+  size_t size_compressed;
+  /** Compression did not save enough memory, don't try again. */
+  bool is_incompressible;
+  /**
+   * The memfile counting the memory of the buffer in its #MemFile.size: the one that added it, or
+   * the next one after merging. NULL when that memfile was freed while other ones still use it.
+   */
+  MemFile *owner;
+} MemFileChunkBuf;
+
+/**
+ * All chunk buffers in use by undo steps, to share identical chunks between any steps and IDs
+ * (not only with the chunk at the same position in the previous step, which is lost when an ID
+ * adds or removes a chunk).
+ *
+ * Undo steps are only written, read and freed from the main thread. The compression tasks only
+ * modify the data of their own buffers, and are stopped before the main thread uses any buffer.
+ */
+static GSet *memfile_chunk_bufs = NULL;
+/** Incremented for each written memfile, to find the buffers that have not been used lately. */
+static uint memfile_generation = 0;
+/** Background compression of the old buffers, NULL when not running. */
+static TaskPool *memfile_compress_pool = NULL;
+/** Updated atomically, as the compression tasks change it. */
+static MemFileStats memfile_stats = {0};
+
+static uint memfile_chunk_buf_hash(const char *data, const size_t size)
+{
+  return BLI_hash_mm2((const uchar *)data, size, 0);
+}
+
+/** Memory used by the content of the buffer. */
+static size_t memfile_chunk_buf_memory_size(const MemFileChunkBuf *chunk_buf)
+{
+  return chunk_buf->data != NULL ? chunk_buf->size : chunk_buf->size_compressed;
+}
+
+static void memfile_compress_stop(void)
+{
+  if (memfile_compress_pool != NULL) {
+    BLI_task_pool_cancel(memfile_compress_pool);
+    BLI_task_pool_free(memfile_compress_pool);
+    memfile_compress_pool = NULL;
+  }
+}
+
+/**
+ * Decompress the content of the buffer into \a r_data (of #MemFileChunkBuf.size bytes).
+ */
+static void memfile_chunk_buf_decompress(const MemFileChunkBuf *chunk_buf, char *r_data)
+{
+  BLI_assert(chunk_buf->data_compressed != NULL);
+  const size_t size = ZSTD_decompress(
+      r_data, chunk_buf->size, chunk_buf->data_compressed, chunk_buf->size_compressed);
+  BLI_assert(size == chunk_buf->size);
+  UNUSED_VARS_NDEBUG(size);
+}
+
+/**
+ * Get the content of the buffer, decompressing it when needed.
+ * Compression tasks must be stopped.
+ */
+static const char *memfile_chunk_buf_data_ensure(MemFileChunkBuf *chunk_buf)
+{
+  BLI_assert(memfile_compress_pool == NULL);
+  chunk_buf->generation = memfile_generation;
+  if (chunk_buf->data != NULL) {
+    return chunk_buf->data;
+  }
+
+  char *data = MEM_mallocN(chunk_buf->size, "Chunk buffer");
+  memfile_chunk_buf_decompress(chunk_buf, data);
+
+  if (chunk_buf->owner != NULL) {
+    chunk_buf->owner->size += chunk_buf->size - chunk_buf->size_compressed;
+  }
+  atomic_sub_and_fetch_z(&memfile_stats.buffers_compressed_num, 1);
+  atomic_sub_and_fetch_z(&memfile_stats.size_compressed, chunk_buf->size_compressed);
+  atomic_sub_and_fetch_z(&memfile_stats.size_compressed_original, chunk_buf->size);
+  atomic_add_and_fetch_z(&memfile_stats.size_uncompressed, chunk_buf->size);
+
+  MEM_freeN(chunk_buf->data_compressed);
+  chunk_buf->data_compressed = NULL;
+  chunk_buf->size_compressed = 0;
+  chunk_buf->data = data;
+  return data;
+}
+
+/**
+ * Compare the content of the buffer with \a data. A compressed buffer is only decompressed
+ * temporarily: when it matches, the buffer is shared, which does not need its content.
+ * Compression tasks must be stopped.
+ */
+static bool memfile_chunk_buf_data_equals(const MemFileChunkBuf *chunk_buf, const char *data)
+{
+  BLI_assert(memfile_compress_pool == NULL);
+  if (chunk_buf->data != NULL) {
+    return memcmp(chunk_buf->data, data, chunk_buf->size) == 0;
+  }
+  char *data_temp = MEM_mallocN(chunk_buf->size, __func__);
+  memfile_chunk_buf_decompress(chunk_buf, data_temp);
+  const bool is_equal = memcmp(data_temp, data, chunk_buf->size) == 0;
+  MEM_freeN(data_temp);
+  return is_equal;
+}
+
+static uint memfile_chunk_buf_hash_fn(const void *key)
+{
+  const MemFileChunkBuf *chunk_buf = key;
+  return chunk_buf->hash;
+}
+
+static bool memfile_chunk_buf_cmp_fn(const void *a, const void *b)
+{
+  const MemFileChunkBuf *chunk_buf_a = a;
+  const MemFileChunkBuf *chunk_buf_b = b;
+  if (chunk_buf_a == chunk_buf_b) {
+    return false;
+  }
+  if (chunk_buf_a->hash != chunk_buf_b->hash || chunk_buf_a->size != chunk_buf_b->size) {
+    return true;
+  }
+  if (chunk_buf_a->data != NULL) {
+    return !memfile_chunk_buf_data_equals(chunk_buf_b, chunk_buf_a->data);
+  }
+  if (chunk_buf_b->data != NULL) {
+    return !memfile_chunk_buf_data_equals(chunk_buf_a, chunk_buf_b->data);
+  }
+  /* Only when removing a buffer, both sides are compressed. */
+  char *data_temp = MEM_mallocN(chunk_buf_a->size, __func__);
+  memfile_chunk_buf_decompress(chunk_buf_a, data_temp);
+  const bool is_equal = memfile_chunk_buf_data_equals(chunk_buf_b, data_temp);
+  MEM_freeN(data_temp);
+  return !is_equal;
+}
+
+/**
+ * Find a buffer with the given content (written by any ID in any step), or create it.
+ * \return The buffer, with a user added.
+ */
+static MemFileChunkBuf *memfile_chunk_buf_ensure(MemFile *memfile,
+                                                 const char *buf,
+                                                 const size_t size)
+{
+  if (memfile_chunk_bufs == NULL) {
+    memfile_chunk_bufs = BLI_gset_new(
+        memfile_chunk_buf_hash_fn, memfile_chunk_buf_cmp_fn, __func__);
+  }
+
+  MemFileChunkBuf key = {
+      .hash = memfile_chunk_buf_hash(buf, size),
+      .size = size,
+      .data = (char *)buf,
+  };
+  MemFileChunkBuf *chunk_buf = BLI_gset_lookup(memfile_chunk_bufs, &key);
+  if (chunk_buf == NULL) {
+    chunk_buf = MEM_mallocN(sizeof(*chunk_buf), "MemFileChunkBuf");
+    *chunk_buf = key;
+    chunk_buf->data = MEM_mallocN(size, "Chunk buffer");
+    memcpy(chunk_buf->data, buf, size);
+    chunk_buf->owner = memfile;
+    BLI_gset_insert(memfile_chunk_bufs, chunk_buf);
+    memfile->size += size;
+
+    atomic_add_and_fetch_z(&memfile_stats.buffers_num, 1);
+    atomic_add_and_fetch_z(&memfile_stats.size_uncompressed, size);
+  }
+  chunk_buf->users++;
+  chunk_buf->generation = memfile_generation;
+  return chunk_buf;
+}
+
+static void memfile_chunk_buf_user_add(MemFileChunkBuf *chunk_buf)
+{
+  chunk_buf->users++;
+  chunk_buf->generation = memfile_generation;
+}
+
+static void memfile_chunk_buf_user_remove(MemFileChunkBuf *chunk_buf)
+{
+  BLI_assert(memfile_compress_pool == NULL);
+  BLI_assert(chunk_buf->users > 0);
+  if (--chunk_buf->users > 0) {
+    return;
+  }
+
+  if (chunk_buf->owner != NULL) {
+    chunk_buf->owner->size -= memfile_chunk_buf_memory_size(chunk_buf);
+  }
+  BLI_gset_remove(memfile_chunk_bufs, chunk_buf, NULL);
+  atomic_sub_and_fetch_z(&memfile_stats.buffers_num, 1);
+  if (chunk_buf->data != NULL) {
+    atomic_sub_and_fetch_z(&memfile_stats.size_uncompressed, chunk_buf->size);
+    MEM_freeN(chunk_buf->data);
+  }
+  else {
+    atomic_sub_and_fetch_z(&memfile_stats.buffers_compressed_num, 1);
+    atomic_sub_and_fetch_z(&memfile_stats.size_compressed, chunk_buf->size_compressed);
+    atomic_sub_and_fetch_z(&memfile_stats.size_compressed_original, chunk_buf->size);
+    MEM_freeN(chunk_buf->data_compressed);
+  }
+  MEM_freeN(chunk_buf);
+
+  if (BLI_gset_len(memfile_chunk_bufs) == 0) {
+    BLI_gset_free(memfile_chunk_bufs, NULL);
+    memfile_chunk_bufs = NULL;
+  }
+}
+
+/* **************** compression of old chunks *************** */
+
+typedef struct MemFileCompressTask {
+  int bufs_num;
+  MemFileChunkBuf *bufs[MEMFILE_COMPRESS_TASK_BUFS_MAX];
+} MemFileCompressTask;
+
+static void memfile_compress_task(TaskPool *__restrict pool, void *taskdata)
+{
+  MemFileCompressTask *task = taskdata;
+
+  for (int i = 0; i < task->bufs_num; i++) {
+    if (BLI_task_pool_current_canceled(pool)) {
+      break;
+    }
+    MemFileChunkBuf *chunk_buf = task->bufs[i];
+    const size_t size_bound = ZSTD_compressBound(chunk_buf->size);
+    void *data_compressed = MEM_mallocN(size_bound, "Chunk buffer compressed");
+    const size_t size_compressed = ZSTD_compress(data_compressed,
+                                                 size_bound,
+                                                 chunk_buf->data,
+                                                 chunk_buf->size,
+                                                 MEMFILE_ZSTD_COMPRESSION_LEVEL);
+    /* Require some gain, decompressing costs time when the step is used again. */
+    if (ZSTD_isError(size_compressed) ||
+        size_compressed > chunk_buf->size - chunk_buf->size / 8) {
+      MEM_freeN(data_compressed);
+      chunk_buf->is_incompressible = true;
+      continue;
+    }
+
+    chunk_buf->data_compressed = MEM_reallocN(data_compressed, size_compressed);
+    chunk_buf->size_compressed = size_compressed;
+    MEM_freeN(chunk_buf->data);
+    chunk_buf->data = NULL;
+
+    /* Other tasks may compress buffers of the same memfile. */
+    if (chunk_buf->owner != NULL) {
+      atomic_sub_and_fetch_z(&chunk_buf->owner->size, chunk_buf->size - size_compressed);
+    }
+
+    atomic_add_and_fetch_z(&memfile_stats.buffers_compressed_num, 1);
+    atomic_add_and_fetch_z(&memfile_stats.size_compressed, size_compressed);
+    atomic_add_and_fetch_z(&memfile_stats.size_compressed_original, chunk_buf->size);
+    atomic_sub_and_fetch_z(&memfile_stats.size_uncompressed, chunk_buf->size);
+  }
+}
+
+void BLO_memfile_compress_old_chunks(const int uncompressed_steps)
+{
+  memfile_compress_stop();
+  if (uncompressed_steps <= 0 || memfile_chunk_bufs == NULL) {
+    return;
+  }
+
+  MemFileCompressTask *task = NULL;
+  size_t task_size = 0;
+  GSET_FOREACH_BEGIN (MemFileChunkBuf *, chunk_buf, memfile_chunk_bufs) {
+    if (chunk_buf->data == NULL || chunk_buf->is_incompressible ||
+        chunk_buf->size < MEMFILE_COMPRESS_MIN_SIZE ||
+        memfile_generation - chunk_buf->generation < (uint)uncompressed_steps) {
+      continue;
+    }
+    if (task == NULL) {
+      if (memfile_compress_pool == NULL) {
+        memfile_compress_pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_LOW);
+      }
+      task = MEM_mallocN(sizeof(*task), __func__);
+      task->bufs_num = 0;
+      task_size = 0;
+    }
+    task->bufs[task->bufs_num++] = chunk_buf;
+    task_size += chunk_buf->size;
+    if (task->bufs_num == MEMFILE_COMPRESS_TASK_BUFS_MAX ||
+        task_size >= MEMFILE_COMPRESS_TASK_SIZE_MAX) {
+      BLI_task_pool_push(memfile_compress_pool, memfile_compress_task, task, true, NULL);
+      task = NULL;
+    }
+  }
+  GSET_FOREACH_END();
+
+  if (task != NULL) {
+    BLI_task_pool_push(memfile_compress_pool, memfile_compress_task, task, true, NULL);
+  }
+}
+
+void BLO_memfile_compress_wait(void)
+{
+  if (memfile_compress_pool != NULL) {
+    BLI_task_pool_work_and_wait(memfile_compress_pool);
+    BLI_task_pool_free(memfile_compress_pool);
+    memfile_compress_pool = NULL;
+  }
+}
+
+size_t BLO_memfile_memory_size_get(MemFile *memfile)
+{
+  return atomic_load_z(&memfile->size);
+}
+
+void BLO_memfile_stats_get(MemFileStats *r_stats)
+{
+  r_stats->buffers_num = atomic_load_z(&memfile_stats.buffers_num);
+  r_stats->buffers_compressed_num = atomic_load_z(&memfile_stats.buffers_compressed_num);
+  r_stats->size_uncompressed = atomic_load_z(&memfile_stats.size_uncompressed);
+  r_stats->size_compressed = atomic_load_z(&memfile_stats.size_compressed);
+  r_stats->size_compressed_original = atomic_load_z(&memfile_stats.size_compressed_original);
+}
+
 /* **************** support for memory-write, for undo buffers *************** */
 
 void BLO_memfile_free(MemFile *memfile)
 {
   MemFileChunk *chunk;
 
+  memfile_compress_stop();
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
+    MemFileChunkBuf *chunk_buf = chunk->buf;
+    if (chunk_buf->users > 1 && chunk_buf->owner == memfile) {
+      /* Still used by other memfiles, which don't count its memory. */
+      chunk_buf->owner = NULL;
     }
+    memfile_chunk_buf_user_remove(chunk_buf);
     MEM_freeN(chunk);
   }
   memfile->size = 0;
@@ -53,39 +414,29 @@ void BLO_memfile_free(MemFile *memfile)
 
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-  /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
-  GHash *buffer_to_second_memchunk = BLI_ghash_new(
-      BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, __func__);
-
-  /* First, detect all memchunks in second memfile that are not owned by it. */
-  for (MemFileChunk *sc = second->chunks.first; sc != NULL; sc = sc->next) {
-    if (sc->is_identical) {
-      BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
-    }
-  }
-
-  /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
-   * it is also used by the second memfile, transfer the ownership. */
-  for (MemFileChunk *fc = first->chunks.first; fc != NULL; fc = fc->next) {
-    if (!fc->is_identical) {
-      MemFileChunk *sc = BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf);
-      if (sc != NULL) {
-        BLI_assert(sc->is_identical);
-        sc->is_identical = false;
-        fc->is_identical = true;
+  /* Chunk buffers are reference counted, buffers still used by the second memfile (or any other)
+   * are kept when freeing the first one. The second memfile takes over the memory counted by the
+   * first one, buffers that are only used by the first one are subtracted when freeing them. */
+  memfile_compress_stop();
+  if (memfile_chunk_bufs != NULL) {
+    GSET_FOREACH_BEGIN (MemFileChunkBuf *, chunk_buf, memfile_chunk_bufs) {
+      if (chunk_buf->owner == first) {
+        chunk_buf->owner = second;
       }
-      /* Note that if the second memfile does not use that chunk, we assume that the first one
-       * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
     }
+    GSET_FOREACH_END();
   }
-
-  BLI_ghash_free(buffer_to_second_memchunk, NULL, NULL);
-
+  second->size += first->size;
+  first->size = 0;
   BLO_memfile_free(first);
 }
 
+const char *BLO_memfile_chunk_data_get(MemFileChunk *chunk)
+{
+  memfile_compress_stop();
+  return memfile_chunk_buf_data_ensure(chunk->buf);
+}
+
 void BLO_memfile_clear_future(MemFile *memfile)
 {
   LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
@@ -97,6 +448,9 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                             MemFile *written_memfile,
                             MemFile *reference_memfile)
 {
+  memfile_compress_stop();
+  memfile_generation++;
+
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
   mem_data->reference_current_chunk = reference_memfile ? reference_memfile->chunks.first : NULL;
@@ -154,21 +508,19 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   if (*compchunk_step != NULL) {
     MemFileChunk *compchunk = *compchunk_step;
     if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
+      if (memfile_chunk_buf_data_equals(compchunk->buf, buf)) {
         curchunk->buf = compchunk->buf;
         curchunk->is_identical = true;
         compchunk->is_identical_future = true;
+        memfile_chunk_buf_user_add(curchunk->buf);
       }
     }
     *compchunk_step = compchunk->next;
   }
 
-  /* not equal... */
+  /* not equal to the previous step, but the content may still be stored by any step... */
   if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+    curchunk->buf = memfile_chunk_buf_ensure(memfile, buf, size);
   }
 }
 
@@ -195,9 +547,153 @@ struct Main *BLO_memfile_main_get(struct MemFile *memfile,
   return bmain_undo;
 }
 
+/* **************** write memfiles as regular files *************** */
+
+/* Undo steps reference packed data that was left in the file it was read from (see
+ * #BKE_packedfile_blend_write), files on disk contain the data itself. The data is copied from
+ * the source file while writing, instead of reading it all into memory first. */
+
+typedef struct MemFileStreamReader {
+  MemFileSegmentNextFn next_fn;
+  void *next_userdata;
+  /** Remainder of the current segment. */
+  const char *data;
+  size_t size;
+} MemFileStreamReader;
+
+static bool memfile_stream_segment_ensure(MemFileStreamReader *reader)
+{
+  while (reader->size == 0) {
+    if (!reader->next_fn(reader->next_userdata, &reader->data, &reader->size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool memfile_stream_read(MemFileStreamReader *reader, void *buffer, size_t size)
+{
+  char *dst = buffer;
+  while (size > 0) {
+    if (!memfile_stream_segment_ensure(reader)) {
+      return false;
+    }
+    const size_t read_size = MIN2(size, reader->size);
+    memcpy(dst, reader->data, read_size);
+    dst += read_size;
+    size -= read_size;
+    reader->data += read_size;
+    reader->size -= read_size;
+  }
+  return true;
+}
+
+/** Pass the next \a size bytes to \a write_fn, without copying them. */
+static bool memfile_stream_copy(MemFileStreamReader *reader,
+                                size_t size,
+                                MemFileWriteFn write_fn,
+                                void *write_userdata)
+{
+  while (size > 0) {
+    if (!memfile_stream_segment_ensure(reader)) {
+      return false;
+    }
+    const size_t copy_size = MIN2(size, reader->size);
+    if (!write_fn(write_userdata, reader->data, copy_size)) {
+      return false;
+    }
+    size -= copy_size;
+    reader->data += copy_size;
+    reader->size -= copy_size;
+  }
+  return true;
+}
+
+bool BLO_memfile_write_stream(MemFileSegmentNextFn next_fn,
+                              void *next_userdata,
+                              MemFileWriteFn write_fn,
+                              void *write_userdata)
+{
+  MemFileStreamReader reader = {next_fn, next_userdata, NULL, 0};
+  const int packedfile_nr = DNA_struct_find_nr(DNA_sdna_current_get(), "PackedFile");
+
+  /* File header, memfiles are always written with the current #BHead. */
+  if (!memfile_stream_copy(&reader, 12, write_fn, write_userdata)) {
+    return false;
+  }
+
+  BHead bhead;
+  do {
+    if (!memfile_stream_read(&reader, &bhead, sizeof(bhead)) || bhead.len < 0) {
+      return false;
+    }
+
+    if (bhead.code == DATA && bhead.SDNAnr == packedfile_nr && bhead.nr == 1 &&
+        bhead.len == sizeof(PackedFile)) {
+      PackedFile pf;
+      if (!memfile_stream_read(&reader, &pf, sizeof(pf))) {
+        return false;
+      }
+      if (pf.deferred != NULL) {
+        BHead bhead_deferred;
+        BlendDeferredData deferred;
+        if (!memfile_stream_read(&reader, &bhead_deferred, sizeof(bhead_deferred)) ||
+            bhead_deferred.old != pf.deferred || bhead_deferred.len != sizeof(deferred) ||
+            !memfile_stream_read(&reader, &deferred, sizeof(deferred))) {
+          return false;
+        }
+        /* The block of the reference is replaced by the data, which takes over its address. */
+        pf.data = (void *)bhead_deferred.old;
+        pf.deferred = NULL;
+        const BHead bhead_data = {DATA, (int)deferred.size, bhead_deferred.old, 0, 1};
+        if (!write_fn(write_userdata, &bhead, sizeof(bhead)) ||
+            !write_fn(write_userdata, &pf, sizeof(pf)) ||
+            !write_fn(write_userdata, &bhead_data, sizeof(bhead_data)) ||
+            !BLO_deferred_data_copy(&deferred, write_fn, write_userdata)) {
+          return false;
+        }
+        continue;
+      }
+      if (!write_fn(write_userdata, &bhead, sizeof(bhead)) ||
+          !write_fn(write_userdata, &pf, sizeof(pf))) {
+        return false;
+      }
+      continue;
+    }
+
+    if (!write_fn(write_userdata, &bhead, sizeof(bhead)) ||
+        !memfile_stream_copy(&reader, (size_t)bhead.len, write_fn, write_userdata)) {
+      return false;
+    }
+  } while (bhead.code != ENDB);
+
+  return true;
+}
+
+static bool memfile_chunk_next(void *userdata, const char **r_data, size_t *r_size)
+{
+  MemFileChunk **chunk_p = userdata;
+  if (*chunk_p == NULL) {
+    return false;
+  }
+  *r_data = memfile_chunk_buf_data_ensure((*chunk_p)->buf);
+  *r_size = (*chunk_p)->size;
+  *chunk_p = (*chunk_p)->next;
+  return true;
+}
+
+static bool memfile_file_write(void *userdata, const void *data, size_t size)
+{
+  const int file = *(const int *)userdata;
+#ifdef _WIN32
+  return (size_t)write(file, data, (uint)size) == size;
+#else
+  return (size_t)write(file, data, size) == size;
+#endif
+}
+
 bool BLO_memfile_write_file(struct MemFile *memfile, const char *filepath)
 {
-  MemFileChunk *chunk;
   int file, oflags;
 
   /* NOTE: This is currently used for autosave and 'quit.blend',
@@ -226,20 +722,13 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filepath)
     return false;
   }
 
-  for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
-#ifdef _WIN32
-    if ((size_t)write(file, chunk->buf, (uint)chunk->size) != chunk->size)
-#else
-    if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size)
-#endif
-    {
-      break;
-    }
-  }
+  memfile_compress_stop();
+  MemFileChunk *chunk = memfile->chunks.first;
+  const bool ok = BLO_memfile_write_stream(memfile_chunk_next, &chunk, memfile_file_write, &file);
 
   close(file);
 
-  if (chunk) {
+  if (!ok) {
     fprintf(stderr,
             "Unable to save '%s': %s\n",
             filepath,
@@ -305,7 +794,9 @@ static ssize_t undo_read(FileReader *reader, void *buffer, size_t size)
         readsize = chunk->size - chunkoffset;
       }
 
-      memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+      /* Chunks of old steps may be compressed. */
+      const char *data = memfile_chunk_buf_data_ensure(chunk->buf);
+      memcpy(POINTER_OFFSET(buffer, totread), data + chunkoffset, readsize);
       totread += readsize;
       undo->reader.offset += (off64_t)readsize;
       seek += readsize;
@@ -333,6 +824,9 @@ FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction)
 {
   UndoReader *undo = MEM_callocN(sizeof(UndoReader), __func__);
 
+  /* Chunks are decompressed while reading. */
+  memfile_compress_stop();
+
   undo->memfile = memfile;
   undo->undo_direction = undo_direction;
 
@@ -429,9 +429,9 @@ void blo_do_versions_userdef(UserDef *userdef)
 
   if (!USER_VERSION_ATLEAST(278, 6)) {
     /* Clear preference flags for re-use. */
-    userdef->flag &= ~(USER_FLAG_NUMINPUT_ADVANCED | USER_FLAG_UNUSED_2 | USER_FLAG_UNUSED_3 |
-                       USER_FLAG_UNUSED_6 | USER_FLAG_UNUSED_7 | USER_FLAG_UNUSED_9 |
-                       USER_DEVELOPER_UI);
+    userdef->flag &= ~(USER_FLAG_NUMINPUT_ADVANCED | USER_LOAD_PACKED_ON_DEMAND |
+                       USER_FLAG_UNUSED_3 | USER_FLAG_UNUSED_6 | USER_FLAG_UNUSED_7 |
+                       USER_SAVE_BACKGROUND | USER_DEVELOPER_UI);
     userdef->uiflag &= ~(USER_HEADER_BOTTOM);
     userdef->transopts &= ~(USER_TR_UNUSED_2 | USER_TR_UNUSED_3 | USER_TR_UNUSED_4 |
                             USER_TR_UNUSED_6 | USER_TR_UNUSED_7);
@@ -774,6 +774,9 @@ void blo_do_versions_userdef(UserDef *userdef)
    */
   {
     /* Keep this block, even when empty. */
+
+    /* The baked display transform was opted out of with this flag, it is now opt-in. */
+    userdef->gpu_flag &= ~USER_GPU_FLAG_UNUSED_4;
   }
 
   LISTBASE_FOREACH (bTheme *, btheme, &userdef->themes) {
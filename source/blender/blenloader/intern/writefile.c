@@ -147,8 +147,29 @@ static CLG_LogRef LOG = {"blo.writefile"};
 typedef enum {
   WW_WRAP_NONE = 1,
   WW_WRAP_ZSTD,
+  /** Write to a #BlendFileWriteSnapshot, the file is stored later. */
+  WW_WRAP_SNAPSHOT,
 } eWriteWrapType;
 
+typedef struct WriteSnapshotBlock {
+  struct WriteSnapshotBlock *next, *prev;
+  size_t size;
+  /* Followed by the data. */
+} WriteSnapshotBlock;
+
+struct BlendFileWriteSnapshot {
+  char filepath[FILE_MAX];
+  int write_flags;
+  /** Number of `.blend1`, `.blend2`... versions to keep, zero when not saving versions. */
+  int versions;
+  /** The blocks are a copy of an undo memfile, see #BLO_memfile_write_stream. */
+  bool from_memfile;
+
+  /** #WriteSnapshotBlock, in file order. */
+  ListBase blocks;
+  size_t size;
+};
+
 typedef struct ZstdFrame {
   struct ZstdFrame *next, *prev;
 
@@ -168,6 +189,7 @@ struct WriteWrap {
 
   /* internal */
   int file_handle;
+  BlendFileWriteSnapshot *snapshot;
   struct {
     ListBase threadpool;
     ListBase tasks;
@@ -364,6 +386,26 @@ static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
   return buf_len;
 }
 
+/* snapshot */
+
+static bool ww_open_snapshot(WriteWrap *UNUSED(ww), const char *UNUSED(filepath))
+{
+  return true;
+}
+static bool ww_close_snapshot(WriteWrap *UNUSED(ww))
+{
+  return true;
+}
+static size_t ww_write_snapshot(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+  WriteSnapshotBlock *block = MEM_mallocN(sizeof(*block) + buf_len, "WriteSnapshotBlock");
+  block->size = buf_len;
+  memcpy(block + 1, buf, buf_len);
+  BLI_addtail(&ww->snapshot->blocks, block);
+  ww->snapshot->size += buf_len;
+  return buf_len;
+}
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -378,6 +420,13 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
       r_ww->use_buf = true;
       break;
     }
+    case WW_WRAP_SNAPSHOT: {
+      r_ww->open = ww_open_snapshot;
+      r_ww->close = ww_close_snapshot;
+      r_ww->write = ww_write_snapshot;
+      r_ww->use_buf = true;
+      break;
+    }
     default: {
       r_ww->open = ww_open_none;
       r_ww->close = ww_close_none;
@@ -422,6 +471,17 @@ typedef struct {
   /** When true, write to #WriteData.current, could also call 'is_undo'. */
   bool use_memfile;
 
+  /** ID block index written at the end of the file (not used for undo), see #BHeadIndexEntry. */
+  struct {
+    BHeadIndexEntry *entries;
+    int entries_num;
+    int entries_num_alloc;
+    /** Offset of the next written byte, in the uncompressed file. */
+    uint64_t file_offset;
+    /** Offset of the last written #ID_LI block. */
+    uint64_t lib_offset;
+  } index;
+
   /**
    * Wrap writing, so we can use zstd or
    * other compression types later, see: G_FILE_COMPRESS
@@ -488,6 +548,7 @@ static void writedata_free(WriteData *wd)
   if (wd->buffer.buf) {
     MEM_freeN(wd->buffer.buf);
   }
+  MEM_SAFE_FREE(wd->index.entries);
   MEM_freeN(wd);
 }
 
@@ -528,6 +589,7 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
 #ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
 #endif
+  wd->index.file_offset += len;
 
   if (wd->buffer.buf == NULL) {
     writedata_do_write(wd, adr, len);
@@ -652,6 +714,77 @@ static void mywrite_id_end(WriteData *wd, ID *UNUSED(id))
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name ID Block Index
+ *
+ * Offsets of the ID blocks in the file, used to read only the needed blocks when linking
+ * from the file or listing its data-blocks.
+ * \{ */
+
+/**
+ * Add an entry for the ID block about to be written.
+ */
+static void write_bhead_index_add(WriteData *wd, int filecode, const void *adr, const ID *id)
+{
+  if (wd->index.entries_num == wd->index.entries_num_alloc) {
+    wd->index.entries_num_alloc = max_ii(wd->index.entries_num_alloc * 2, 256);
+    wd->index.entries = MEM_reallocN(wd->index.entries,
+                                     sizeof(*wd->index.entries) * wd->index.entries_num_alloc);
+  }
+
+  if (filecode == ID_LI) {
+    wd->index.lib_offset = wd->index.file_offset;
+  }
+
+  BHeadIndexEntry *entry = &wd->index.entries[wd->index.entries_num++];
+  memset(entry, 0, sizeof(*entry));
+  entry->bhead_offset = wd->index.file_offset;
+  entry->lib_offset = (filecode == ID_LINK_PLACEHOLDER) ? wd->index.lib_offset : 0;
+  entry->old = (uint64_t)(uintptr_t)adr;
+  entry->code = filecode;
+  STRNCPY(entry->name, id->name);
+}
+
+/**
+ * Write the #INDX block and the #BHeadIndexTrailer, after #ENDB.
+ */
+static void write_bhead_index(WriteData *wd, const uint64_t glob_offset, const uint64_t dna_offset)
+{
+  const size_t entries_size = sizeof(*wd->index.entries) * (size_t)wd->index.entries_num;
+  const size_t len = sizeof(BHeadIndexHeader) + entries_size;
+  if (len > INT_MAX) {
+    /* The file can still be read without the index. */
+    return;
+  }
+
+  const uint64_t index_offset = wd->index.file_offset;
+
+  BHead bh;
+  bh.code = INDX;
+  bh.old = NULL;
+  bh.nr = 1;
+  bh.SDNAnr = 0;
+  bh.len = (int)len;
+  mywrite(wd, &bh, sizeof(BHead));
+
+  BHeadIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  header.entries_num = wd->index.entries_num;
+  header.glob_offset = glob_offset;
+  header.dna_offset = dna_offset;
+  mywrite(wd, &header, sizeof(header));
+  if (entries_size != 0) {
+    mywrite(wd, wd->index.entries, entries_size);
+  }
+
+  BHeadIndexTrailer trailer;
+  memcpy(trailer.magic, BHEAD_INDEX_MAGIC, sizeof(trailer.magic));
+  trailer.index_offset = index_offset;
+  mywrite(wd, &trailer, sizeof(trailer));
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Generic DNA File Writing
  * \{ */
@@ -681,6 +814,11 @@ static void writestruct_at_address_nr(
     return;
   }
 
+  if (filecode <= 0xFFFF && !wd->use_memfile) {
+    /* An ID code, see #blo_bhead_is_id. */
+    write_bhead_index_add(wd, filecode, adr, data);
+  }
+
   mywrite(wd, &bh, sizeof(BHead));
   mywrite(wd, data, (size_t)bh.len);
 }
@@ -1105,6 +1243,7 @@ static bool write_file_handle(Main *mainvar,
 
   write_renderinfo(wd, mainvar);
   write_thumb(wd, thumb);
+  const uint64_t glob_offset = wd->index.file_offset;
   write_global(wd, write_flags, mainvar);
 
   /* The window-manager and screen often change,
@@ -1247,6 +1386,7 @@ static bool write_file_handle(Main *mainvar,
    *
    * Note that we *borrow* the pointer to 'DNAstr',
    * so writing each time uses the same address and doesn't cause unnecessary undo overhead. */
+  const uint64_t dna_offset = wd->index.file_offset;
   writedata(wd, DNA1, (size_t)wd->sdna->data_len, wd->sdna->data);
 
   /* end of file */
@@ -1254,6 +1394,11 @@ static bool write_file_handle(Main *mainvar,
   bhead.code = ENDB;
   mywrite(wd, &bhead, sizeof(BHead));
 
+  /* Written after #ENDB, so it is ignored by regular reading (also in older versions). */
+  if (!wd->use_memfile) {
+    write_bhead_index(wd, glob_offset, dna_offset);
+  }
+
   blo_join_main(&mainlist);
 
   return mywrite_end(wd);
@@ -1261,12 +1406,12 @@ static bool write_file_handle(Main *mainvar,
 
 /* do reverse file history: .blend1 -> .blend2, .blend -> .blend1 */
 /* return: success(0), failure(1) */
-static bool do_history(const char *name, ReportList *reports)
+static bool do_history(const char *name, const int versions, ReportList *reports)
 {
   char tempname1[FILE_MAX], tempname2[FILE_MAX];
-  int hisnr = U.versions;
+  int hisnr = versions;
 
-  if (U.versions == 0) {
+  if (versions == 0) {
     return false;
   }
 
@@ -1307,20 +1452,17 @@ static bool do_history(const char *name, ReportList *reports)
 /** \name File Writing (Public)
  * \{ */
 
-bool BLO_write_file(Main *mainvar,
-                    const char *filepath,
-                    const int write_flags,
-                    const struct BlendFileWriteParams *params,
-                    ReportList *reports)
+/**
+ * Write \a mainvar with \a ww, remapping paths for the new file location.
+ * \return True on error.
+ */
+static bool write_file_handle_with_path_remap(Main *mainvar,
+                                              WriteWrap *ww,
+                                              const char *filepath,
+                                              const int write_flags,
+                                              const struct BlendFileWriteParams *params)
 {
-  BLI_assert(!BLI_path_is_rel(filepath));
-  BLI_assert(BLI_path_is_abs_from_cwd(filepath));
-
-  char tempname[FILE_MAX + 1];
-  WriteWrap ww;
-
   eBLO_WritePathRemap remap_mode = params->remap_mode;
-  const bool use_save_versions = params->use_save_versions;
   const bool use_save_as_copy = params->use_save_as_copy;
   const bool use_userdef = params->use_userdef;
   const BlendThumbnail *thumb = params->thumb;
@@ -1331,23 +1473,6 @@ bool BLO_write_file(Main *mainvar,
   const eBPathForeachFlag path_list_flag = (BKE_BPATH_FOREACH_PATH_SKIP_LINKED |
                                             BKE_BPATH_FOREACH_PATH_SKIP_MULTIFILE);
 
-  if (G.debug & G_DEBUG_IO && mainvar->lock != NULL) {
-    BKE_report(reports, RPT_INFO, "Checking sanity of current .blend file *BEFORE* save to disk");
-    BLO_main_validate_libraries(mainvar, reports);
-    BLO_main_validate_shapekeys(mainvar, reports);
-  }
-
-  /* open temporary file, so we preserve the original in case we crash */
-  BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
-
-  ww_handle_init((write_flags & G_FILE_COMPRESS) ? WW_WRAP_ZSTD : WW_WRAP_NONE, &ww);
-
-  if (ww.open(&ww, tempname) == false) {
-    BKE_reportf(
-        reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
-    return false;
-  }
-
   if (remap_mode == BLO_WRITE_PATH_REMAP_ABSOLUTE) {
     /* Paths will already be absolute, no remapping to do. */
     if (relbase_valid == false) {
@@ -1432,26 +1557,32 @@ bool BLO_write_file(Main *mainvar,
   }
 
   /* actual file writing */
-  const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, use_userdef, thumb);
-
-  ww.close(&ww);
+  const bool err = write_file_handle(mainvar, ww, NULL, NULL, write_flags, use_userdef, thumb);
 
   if (UNLIKELY(path_list_backup)) {
     BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
     BKE_bpath_list_free(path_list_backup);
   }
 
-  if (err) {
-    BKE_report(reports, RPT_ERROR, strerror(errno));
-    remove(tempname);
+  return err;
+}
 
-    return false;
-  }
+/**
+ * Replace \a filepath by the written temporary file, keeping versions of the previous file.
+ * \return Success.
+ */
+static bool write_file_finalize(const char *tempname,
+                                const char *filepath,
+                                const int versions,
+                                ReportList *reports)
+{
+  /* Undo steps may still reference packed data in the file that is replaced. */
+  BLO_deferred_data_file_keep(filepath);
 
   /* file save to temporary file was successful */
   /* now do reverse file history (move .blend1 -> .blend2, .blend -> .blend1) */
-  if (use_save_versions) {
-    const bool err_hist = do_history(filepath, reports);
+  if (versions != 0) {
+    const bool err_hist = do_history(filepath, versions, reports);
     if (err_hist) {
       BKE_report(reports, RPT_ERROR, "Version backup failed (file saved with @)");
       return false;
@@ -1463,6 +1594,55 @@ bool BLO_write_file(Main *mainvar,
     return false;
   }
 
+  return true;
+}
+
+bool BLO_write_file(Main *mainvar,
+                    const char *filepath,
+                    const int write_flags,
+                    const struct BlendFileWriteParams *params,
+                    ReportList *reports)
+{
+  BLI_assert(!BLI_path_is_rel(filepath));
+  BLI_assert(BLI_path_is_abs_from_cwd(filepath));
+
+  char tempname[FILE_MAX + 1];
+  WriteWrap ww;
+
+  if (G.debug & G_DEBUG_IO && mainvar->lock != NULL) {
+    BKE_report(reports, RPT_INFO, "Checking sanity of current .blend file *BEFORE* save to disk");
+    BLO_main_validate_libraries(mainvar, reports);
+    BLO_main_validate_shapekeys(mainvar, reports);
+  }
+
+  /* open temporary file, so we preserve the original in case we crash */
+  BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
+
+  ww_handle_init((write_flags & G_FILE_COMPRESS) ? WW_WRAP_ZSTD : WW_WRAP_NONE, &ww);
+
+  if (ww.open(&ww, tempname) == false) {
+    BKE_reportf(
+        reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
+    return false;
+  }
+
+  /* actual file writing */
+  const bool err = write_file_handle_with_path_remap(mainvar, &ww, filepath, write_flags, params);
+
+  ww.close(&ww);
+
+  if (err) {
+    BKE_report(reports, RPT_ERROR, strerror(errno));
+    remove(tempname);
+
+    return false;
+  }
+
+  if (!write_file_finalize(
+          tempname, filepath, params->use_save_versions ? U.versions : 0, reports)) {
+    return false;
+  }
+
   if (G.debug & G_DEBUG_IO && mainvar->lock != NULL) {
     BKE_report(reports, RPT_INFO, "Checking sanity of current .blend file *AFTER* save to disk");
     BLO_main_validate_libraries(mainvar, reports);
@@ -1471,6 +1651,145 @@ bool BLO_write_file(Main *mainvar,
   return true;
 }
 
+BlendFileWriteSnapshot *BLO_write_file_snapshot(Main *mainvar,
+                                                const char *filepath,
+                                                const int write_flags,
+                                                const struct BlendFileWriteParams *params,
+                                                ReportList *reports)
+{
+  BLI_assert(!BLI_path_is_rel(filepath));
+  BLI_assert(BLI_path_is_abs_from_cwd(filepath));
+
+  if (G.debug & G_DEBUG_IO && mainvar->lock != NULL) {
+    BKE_report(reports, RPT_INFO, "Checking sanity of current .blend file *BEFORE* save to disk");
+    BLO_main_validate_libraries(mainvar, reports);
+    BLO_main_validate_shapekeys(mainvar, reports);
+  }
+
+  BlendFileWriteSnapshot *snapshot = MEM_callocN(sizeof(*snapshot), __func__);
+  STRNCPY(snapshot->filepath, filepath);
+  snapshot->write_flags = write_flags;
+  snapshot->versions = params->use_save_versions ? U.versions : 0;
+
+  WriteWrap ww;
+  ww_handle_init(WW_WRAP_SNAPSHOT, &ww);
+  ww.snapshot = snapshot;
+
+  const bool err = write_file_handle_with_path_remap(mainvar, &ww, filepath, write_flags, params);
+  if (err) {
+    BKE_report(reports, RPT_ERROR, "Cannot write the file to memory");
+    BLO_write_file_snapshot_free(snapshot);
+    return NULL;
+  }
+
+  return snapshot;
+}
+
+BlendFileWriteSnapshot *BLO_write_file_snapshot_from_memfile(MemFile *memfile,
+                                                             const char *filepath)
+{
+  BlendFileWriteSnapshot *snapshot = MEM_callocN(sizeof(*snapshot), __func__);
+  STRNCPY(snapshot->filepath, filepath);
+  snapshot->from_memfile = true;
+
+  WriteWrap ww;
+  ww_handle_init(WW_WRAP_SNAPSHOT, &ww);
+  ww.snapshot = snapshot;
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
+    ww.write(&ww, BLO_memfile_chunk_data_get(chunk), chunk->size);
+  }
+
+  return snapshot;
+}
+
+typedef struct SnapshotStoreData {
+  const WriteSnapshotBlock *block;
+  size_t size_read;
+  size_t size_total;
+  float *progress;
+} SnapshotStoreData;
+
+static bool snapshot_block_next(void *userdata, const char **r_data, size_t *r_size)
+{
+  SnapshotStoreData *data = userdata;
+  if (data->block == NULL) {
+    return false;
+  }
+  *r_data = (const char *)(data->block + 1);
+  *r_size = data->block->size;
+  data->size_read += data->block->size;
+  data->block = data->block->next;
+  if (data->progress) {
+    *data->progress = (float)((double)data->size_read / (double)data->size_total);
+  }
+  return true;
+}
+
+static bool snapshot_write(void *userdata, const void *data, size_t size)
+{
+  WriteWrap *ww = userdata;
+  return ww->write(ww, data, size) == size;
+}
+
+size_t BLO_write_file_snapshot_size(const BlendFileWriteSnapshot *snapshot)
+{
+  return snapshot->size;
+}
+
+bool BLO_write_file_snapshot_store(const BlendFileWriteSnapshot *snapshot,
+                                   float *progress,
+                                   ReportList *reports)
+{
+  char tempname[FILE_MAX + 1];
+  WriteWrap ww;
+
+  /* open temporary file, so we preserve the original in case we crash */
+  BLI_snprintf(tempname, sizeof(tempname), "%s@", snapshot->filepath);
+
+  ww_handle_init((snapshot->write_flags & G_FILE_COMPRESS) ? WW_WRAP_ZSTD : WW_WRAP_NONE, &ww);
+
+  if (ww.open(&ww, tempname) == false) {
+    BKE_reportf(
+        reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
+    return false;
+  }
+
+  SnapshotStoreData data = {snapshot->blocks.first, 0, snapshot->size, progress};
+  bool err = false;
+  if (snapshot->from_memfile) {
+    err = !BLO_memfile_write_stream(snapshot_block_next, &data, snapshot_write, &ww);
+  }
+  else {
+    const char *block_data;
+    size_t block_size;
+    while (snapshot_block_next(&data, &block_data, &block_size)) {
+      if (!snapshot_write(&ww, block_data, block_size)) {
+        err = true;
+        break;
+      }
+    }
+  }
+
+  if (!ww.close(&ww)) {
+    err = true;
+  }
+
+  if (err) {
+    BKE_report(reports, RPT_ERROR, strerror(errno));
+    remove(tempname);
+
+    return false;
+  }
+
+  return write_file_finalize(tempname, snapshot->filepath, snapshot->versions, reports);
+}
+
+void BLO_write_file_snapshot_free(BlendFileWriteSnapshot *snapshot)
+{
+  BLI_freelistN(&snapshot->blocks);
+  MEM_freeN(snapshot);
+}
+
 bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags)
 {
   bool use_userdef = false;
@@ -0,0 +1,199 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <cstring>
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_appdir.h"
+#include "BKE_image.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_packedFile.h"
+
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_ID.h"
+#include "DNA_image_types.h"
+#include "DNA_packedFile_types.h"
+
+/* Large enough to be left in the file when reading with #BLO_READ_SKIP_LARGE_DATA. */
+static const int PACKED_SIZE = 512 * 1024;
+
+/**
+ * Undo steps reference packed data in the file it was read from, it must stay readable when the
+ * file is saved over, and recovery files written from the undo steps must contain it.
+ */
+class BlendfileDeferredDataTest : public BlendfileLoadingBaseTest {
+ protected:
+  std::string filepath;
+  std::string recovery_filepath;
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    BKE_tempdir_init(nullptr);
+    filepath = std::string(BKE_tempdir_base()) + "deferred_data_test.blend";
+    recovery_filepath = std::string(BKE_tempdir_base()) + "deferred_data_test_recovery.blend";
+  }
+
+  void TearDown() override
+  {
+    BLO_deferred_data_files_free();
+    BLI_delete(filepath.c_str(), false, false);
+    BLI_delete(recovery_filepath.c_str(), false, false);
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  static std::string packed_data()
+  {
+    std::string data(PACKED_SIZE, '\0');
+    for (int i = 0; i < PACKED_SIZE; i++) {
+      data[i] = char((i / 7 + i / 4096) % 253);
+    }
+    return data;
+  }
+
+  static void add_image(Main *bmain, const char *name)
+  {
+    Image *ima = static_cast<Image *>(BKE_id_new(bmain, ID_IM, name));
+    id_fake_user_set(&ima->id);
+    const std::string data = packed_data();
+    char *packed = static_cast<char *>(MEM_mallocN(data.size(), __func__));
+    memcpy(packed, data.data(), data.size());
+    BKE_image_packfiles_from_mem(nullptr, ima, packed, data.size());
+  }
+
+  static PackedFile *image_packedfile(Main *bmain, const char *name)
+  {
+    const Image *ima = static_cast<const Image *>(
+        BLI_findstring(&bmain->images, name, offsetof(ID, name) + 2));
+    if (ima == nullptr || BLI_listbase_is_empty(&ima->packedfiles)) {
+      return nullptr;
+    }
+    return static_cast<ImagePackedFile *>(ima->packedfiles.first)->packedfile;
+  }
+
+  static void expect_packed_data(PackedFile *pf)
+  {
+    ASSERT_NE(pf, nullptr);
+    ASSERT_EQ(pf->size, PACKED_SIZE);
+    const void *data = BKE_packedfile_data_ensure(pf, nullptr);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(std::string(static_cast<const char *>(data), PACKED_SIZE), packed_data());
+  }
+
+  static bool write(Main *bmain, const std::string &path)
+  {
+    BlendFileWriteParams params{};
+    params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+    return BLO_write_file(bmain, path.c_str(), 0, &params, nullptr);
+  }
+
+  static BlendFileData *read(const std::string &path, const eBLOReadSkip skip_flags)
+  {
+    BlendFileReadReport bf_reports{};
+    return BLO_read_from_file(path.c_str(), skip_flags, &bf_reports);
+  }
+
+  /** Read the file with its packed data left in it, and write an undo step of it. */
+  BlendFileData *read_deferred(MemFile *memfile)
+  {
+    Main *bmain = BKE_main_new();
+    add_image(bmain, "Packed");
+    EXPECT_TRUE(write(bmain, filepath));
+    BKE_main_free(bmain);
+
+    BlendFileData *bfd = read(filepath, BLO_READ_SKIP_LARGE_DATA);
+    if (bfd == nullptr) {
+      ADD_FAILURE() << filepath;
+      return nullptr;
+    }
+    const PackedFile *pf = image_packedfile(bfd->main, "Packed");
+    EXPECT_NE(pf, nullptr);
+    if (pf != nullptr) {
+      EXPECT_EQ(pf->data, nullptr);
+      EXPECT_NE(pf->deferred, nullptr);
+    }
+
+    EXPECT_TRUE(BLO_write_file_mem(bfd->main, nullptr, memfile, 0));
+    return bfd;
+  }
+};
+
+TEST_F(BlendfileDeferredDataTest, save_undo_save)
+{
+  MemFile memfile{};
+  BlendFileData *bfd = read_deferred(&memfile);
+  ASSERT_NE(bfd, nullptr);
+
+  /* Saving over the file changes its size (its modification time may not change). */
+  Image *ima = static_cast<Image *>(BKE_id_new(bfd->main, ID_IM, "Other"));
+  id_fake_user_set(&ima->id);
+  ASSERT_TRUE(write(bfd->main, filepath));
+  BLO_blendfiledata_free(bfd);
+
+  /* Undo to the step that references the data in the replaced file. */
+  Main *oldmain = BKE_main_new();
+  BlendFileReadParams params{};
+  params.skip_flags = BLO_READ_SKIP_UNDO_OLD_MAIN;
+  BlendFileData *bfd_undo = BLO_read_from_memfile(
+      oldmain, filepath.c_str(), &memfile, &params, nullptr);
+  BKE_main_free(oldmain);
+  BLO_memfile_free(&memfile);
+  ASSERT_NE(bfd_undo, nullptr);
+  PackedFile *pf = image_packedfile(bfd_undo->main, "Packed");
+  ASSERT_NE(pf, nullptr);
+  EXPECT_EQ(pf->data, nullptr);
+  expect_packed_data(pf);
+
+  ASSERT_TRUE(write(bfd_undo->main, filepath));
+  BLO_blendfiledata_free(bfd_undo);
+
+  BlendFileData *bfd_saved = read(filepath, BLO_READ_SKIP_NONE);
+  ASSERT_NE(bfd_saved, nullptr);
+  expect_packed_data(image_packedfile(bfd_saved->main, "Packed"));
+  EXPECT_EQ(image_packedfile(bfd_saved->main, "Other"), nullptr);
+  BLO_blendfiledata_free(bfd_saved);
+}
+
+TEST_F(BlendfileDeferredDataTest, recovery_file_from_memfile)
+{
+  MemFile memfile{};
+  BlendFileData *bfd = read_deferred(&memfile);
+  ASSERT_NE(bfd, nullptr);
+
+  /* As written by auto-save and on quit, the data is copied without reading it in memory. */
+  ASSERT_TRUE(BLO_memfile_write_file(&memfile, recovery_filepath.c_str()));
+  PackedFile *pf = image_packedfile(bfd->main, "Packed");
+  ASSERT_NE(pf, nullptr);
+  EXPECT_EQ(pf->data, nullptr);
+
+  BlendFileData *bfd_recovered = read(recovery_filepath, BLO_READ_SKIP_NONE);
+  ASSERT_NE(bfd_recovered, nullptr);
+  PackedFile *pf_recovered = image_packedfile(bfd_recovered->main, "Packed");
+  ASSERT_NE(pf_recovered, nullptr);
+  EXPECT_EQ(pf_recovered->deferred, nullptr);
+  expect_packed_data(pf_recovered);
+  BLO_blendfiledata_free(bfd_recovered);
+  BLI_delete(recovery_filepath.c_str(), false, false);
+
+  /* The same from a copy of the undo step, as auto-save does in a job. */
+  BlendFileWriteSnapshot *snapshot = BLO_write_file_snapshot_from_memfile(
+      &memfile, recovery_filepath.c_str());
+  BLO_memfile_free(&memfile);
+  ASSERT_TRUE(BLO_write_file_snapshot_store(snapshot, nullptr, nullptr));
+  BLO_write_file_snapshot_free(snapshot);
+
+  bfd_recovered = read(recovery_filepath, BLO_READ_SKIP_NONE);
+  ASSERT_NE(bfd_recovered, nullptr);
+  expect_packed_data(image_packedfile(bfd_recovered->main, "Packed"));
+  BLO_blendfiledata_free(bfd_recovered);
+  BLO_blendfiledata_free(bfd);
+}
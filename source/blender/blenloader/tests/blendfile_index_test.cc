@@ -0,0 +1,271 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "BKE_appdir.h"
+#include "BKE_main.h"
+
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+
+#include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_ID.h"
+
+extern "C" {
+#include "readfile.h"
+}
+
+/** Variants of a file written with an index, see #BlendfileIndexTest::write_variant. */
+enum class IndexVariant {
+  Intact,
+  /** The file ends at the #INDX block, like files written by older versions. */
+  Missing,
+  /** Part of the #INDX block and the trailer are cut off. */
+  Truncated,
+  /** The trailer points somewhere else than the #INDX block. */
+  BadTrailer,
+  /** The #GLOB and #DNA1 offsets point outside of the file. */
+  BadOffsets,
+  /** An entry points outside of the file. */
+  BadEntry,
+};
+
+class BlendfileIndexTest : public BlendfileLoadingBaseTest {
+ protected:
+  std::string indexed_filepath_;
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    if (!blendfile_load("modifier_stack/array_test.blend")) {
+      return;
+    }
+    BKE_tempdir_init(nullptr);
+    indexed_filepath_ = std::string(BKE_tempdir_base()) + "blendfile_index_test.blend";
+    BlendFileWriteParams params{};
+    params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+    ASSERT_TRUE(BLO_write_file(bfile->main, indexed_filepath_.c_str(), 0, &params, nullptr));
+  }
+
+  void TearDown() override
+  {
+    if (!indexed_filepath_.empty()) {
+      BLI_delete(indexed_filepath_.c_str(), false, false);
+    }
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  static std::string read_bytes(const std::string &filepath)
+  {
+    std::ifstream file(filepath, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+  }
+
+  static BHeadIndexTrailer read_trailer(const std::string &bytes)
+  {
+    BHeadIndexTrailer trailer;
+    memcpy(&trailer, bytes.data() + bytes.size() - sizeof(trailer), sizeof(trailer));
+    return trailer;
+  }
+
+  /** Write a modified copy of the indexed file, returns its path. */
+  std::string write_variant(const IndexVariant variant)
+  {
+    std::string bytes = read_bytes(indexed_filepath_);
+    const BHeadIndexTrailer trailer = read_trailer(bytes);
+    EXPECT_EQ(memcmp(trailer.magic, BHEAD_INDEX_MAGIC, sizeof(trailer.magic)), 0);
+    const size_t index_data_offset = size_t(trailer.index_offset) + sizeof(BHead);
+    BHeadIndexHeader header;
+    memcpy(&header, bytes.data() + index_data_offset, sizeof(header));
+
+    switch (variant) {
+      case IndexVariant::Intact:
+        break;
+      case IndexVariant::Missing:
+        bytes.resize(size_t(trailer.index_offset));
+        break;
+      case IndexVariant::Truncated:
+        bytes.resize(index_data_offset + sizeof(header) + sizeof(BHeadIndexEntry) / 2);
+        break;
+      case IndexVariant::BadTrailer: {
+        BHeadIndexTrailer bad_trailer = trailer;
+        bad_trailer.index_offset = header.glob_offset;
+        memcpy(bytes.data() + bytes.size() - sizeof(trailer), &bad_trailer, sizeof(trailer));
+        break;
+      }
+      case IndexVariant::BadOffsets: {
+        BHeadIndexHeader bad_header = header;
+        bad_header.glob_offset = bytes.size() * 2;
+        bad_header.dna_offset = 0;
+        memcpy(bytes.data() + index_data_offset, &bad_header, sizeof(header));
+        break;
+      }
+      case IndexVariant::BadEntry: {
+        EXPECT_GT(header.entries_num, 0);
+        BHeadIndexEntry entry;
+        const size_t entry_offset = index_data_offset + sizeof(header);
+        memcpy(&entry, bytes.data() + entry_offset, sizeof(entry));
+        entry.bhead_offset = bytes.size() * 2;
+        memcpy(bytes.data() + entry_offset, &entry, sizeof(entry));
+        break;
+      }
+    }
+
+    const std::string filepath = std::string(BKE_tempdir_base()) +
+                                 "blendfile_index_test_variant.blend";
+    std::ofstream file(filepath, std::ios::binary);
+    file.write(bytes.data(), std::streamsize(bytes.size()));
+    return filepath;
+  }
+
+  static bool has_index(const std::string &filepath)
+  {
+    BlendFileReadReport bf_reports{};
+    FileData *fd = blo_filedata_from_file(filepath.c_str(), &bf_reports);
+    if (fd == nullptr) {
+      ADD_FAILURE();
+      return false;
+    }
+    int entries_num;
+    const bool result = blo_bhead_index_entries(fd, &entries_num) != nullptr;
+    blo_filedata_free(fd);
+    return result;
+  }
+
+  /** Names of all IDs in the file, read as usual. */
+  static std::set<std::string> read_id_names(const std::string &filepath)
+  {
+    std::set<std::string> names;
+    BlendFileReadReport bf_reports{};
+    BlendFileData *bfd = BLO_read_from_file(filepath.c_str(), BLO_READ_SKIP_NONE, &bf_reports);
+    if (bfd == nullptr) {
+      ADD_FAILURE();
+      return names;
+    }
+    ID *id;
+    FOREACH_MAIN_ID_BEGIN (bfd->main, id) {
+      names.insert(id->name);
+    }
+    FOREACH_MAIN_ID_END;
+    BLO_blendfiledata_free(bfd);
+    return names;
+  }
+
+  /** Names of the objects in the file, listed like when linking. */
+  static std::set<std::string> list_object_names(const std::string &filepath)
+  {
+    std::set<std::string> names;
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath.c_str(), nullptr);
+    if (bh == nullptr) {
+      ADD_FAILURE();
+      return names;
+    }
+    int tot_names;
+    LinkNode *list = BLO_blendhandle_get_datablock_names(bh, ID_OB, false, &tot_names);
+    for (LinkNode *link = list; link; link = link->next) {
+      names.insert(static_cast<const char *>(link->link));
+    }
+    EXPECT_EQ(tot_names, int(names.size()));
+    BLI_linklist_freeN(list);
+    BLO_blendhandle_close(bh);
+    return names;
+  }
+};
+
+TEST_F(BlendfileIndexTest, written_and_used)
+{
+  if (indexed_filepath_.empty()) {
+    return;
+  }
+  EXPECT_TRUE(has_index(indexed_filepath_));
+
+  const std::string bytes = read_bytes(indexed_filepath_);
+  const BHeadIndexTrailer trailer = read_trailer(bytes);
+  EXPECT_EQ(memcmp(trailer.magic, BHEAD_INDEX_MAGIC, sizeof(trailer.magic)), 0);
+  EXPECT_LT(trailer.index_offset, bytes.size());
+}
+
+TEST_F(BlendfileIndexTest, same_contents_with_and_without_index)
+{
+  if (indexed_filepath_.empty()) {
+    return;
+  }
+  const std::set<std::string> expected_ids = read_id_names(indexed_filepath_);
+  const std::set<std::string> expected_objects = list_object_names(indexed_filepath_);
+  EXPECT_FALSE(expected_ids.empty());
+  EXPECT_FALSE(expected_objects.empty());
+
+  for (const IndexVariant variant : {IndexVariant::Missing,
+                                     IndexVariant::Truncated,
+                                     IndexVariant::BadTrailer,
+                                     IndexVariant::BadOffsets,
+                                     IndexVariant::BadEntry}) {
+    SCOPED_TRACE(int(variant));
+    const std::string filepath = write_variant(variant);
+    /* Broken indices are ignored, the file is scanned linearly instead. */
+    EXPECT_FALSE(has_index(filepath));
+    EXPECT_EQ(read_id_names(filepath), expected_ids);
+    EXPECT_EQ(list_object_names(filepath), expected_objects);
+    BLI_delete(filepath.c_str(), false, false);
+  }
+}
+
+TEST_F(BlendfileIndexTest, bhead_iteration)
+{
+  if (indexed_filepath_.empty()) {
+    return;
+  }
+  const std::string unindexed_filepath = write_variant(IndexVariant::Missing);
+
+  BlendFileReadReport bf_reports{};
+  FileData *fd = blo_filedata_from_file(indexed_filepath_.c_str(), &bf_reports);
+  FileData *fd_linear = blo_filedata_from_file(unindexed_filepath.c_str(), &bf_reports);
+  ASSERT_NE(fd, nullptr);
+  ASSERT_NE(fd_linear, nullptr);
+
+  int entries_num;
+  ASSERT_NE(blo_bhead_index_entries(fd, &entries_num), nullptr);
+  ASSERT_GE(entries_num, 2);
+
+  /* Only the block of the last ID is read, the blocks before it in the file are not, so the
+   * previous block is unknown. */
+  BHead *bhead = blo_bhead_index_bhead(fd, entries_num - 1);
+  ASSERT_NE(bhead, nullptr);
+  EXPECT_EQ(blo_bhead_prev(fd, bhead), nullptr);
+
+  /* Going forward reads the following blocks, which are then contiguous. */
+  BHead *bhead_next = blo_bhead_next(fd, bhead);
+  ASSERT_NE(bhead_next, nullptr);
+  EXPECT_EQ(blo_bhead_prev(fd, bhead_next), bhead);
+
+  /* Iterating from the start reads the same blocks as without the index, in the same order,
+   * including the already read blocks. */
+  BHead *bhead_linear = blo_bhead_first(fd_linear);
+  BHead *bhead_prev = nullptr;
+  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+    ASSERT_NE(bhead_linear, nullptr);
+    EXPECT_EQ(bhead->code, bhead_linear->code);
+    EXPECT_EQ(bhead->len, bhead_linear->len);
+    EXPECT_EQ(bhead->old, bhead_linear->old);
+    EXPECT_EQ(blo_bhead_prev(fd, bhead), bhead_prev);
+    if (bhead->code == ENDB) {
+      break;
+    }
+    bhead_prev = bhead;
+    bhead_linear = blo_bhead_next(fd_linear, bhead_linear);
+  }
+  ASSERT_NE(bhead, nullptr);
+
+  blo_filedata_free(fd);
+  blo_filedata_free(fd_linear);
+  BLI_delete(unindexed_filepath.c_str(), false, false);
+}
@@ -2,6 +2,25 @@
  * Copyright 2019 Blender Foundation. */
 #include "blendfile_loading_base_test.h"
 
+#include <cstring>
+
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "BLO_readfile.h"
+
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_sdna_types.h"
+#include "DNA_windowmanager_types.h"
+
+#include "wm.h"
+
 class BlendfileLoadingTest : public BlendfileLoadingBaseTest {
 };
 
@@ -14,3 +33,135 @@ TEST_F(BlendfileLoadingTest, CanaryTest)
   depsgraph_create(DAG_EVAL_RENDER);
   EXPECT_NE(nullptr, this->depsgraph);
 }
+
+static bool dna_name_is_pointer(const char *name)
+{
+  return name[0] == '*' || (name[0] == '(' && name[1] == '*');
+}
+
+/**
+ * Compare the members of a struct that are not pointers, as pointers differ between loads.
+ * The members before \a member_start are skipped.
+ * \return The number of the first differing member, or -1 when the structs are equal.
+ */
+static int dna_struct_compare(const SDNA *sdna,
+                              const int struct_nr,
+                              const char *a,
+                              const char *b,
+                              const int member_start = 0)
+{
+  const SDNA_Struct *struct_info = sdna->structs[struct_nr];
+  int offset = 0;
+  for (int i = 0; i < struct_info->members_len; i++) {
+    const SDNA_StructMember *member = &struct_info->members[i];
+    const char *name = sdna->names[member->name];
+    const int size = DNA_elem_size_nr(sdna, member->type, member->name);
+    if (i >= member_start && !dna_name_is_pointer(name)) {
+      const int member_struct_nr = DNA_struct_find_nr(sdna, sdna->types[member->type]);
+      if (member_struct_nr == -1) {
+        if (memcmp(a + offset, b + offset, size) != 0) {
+          return i;
+        }
+      }
+      else {
+        const int element_size = sdna->types_size[member->type];
+        for (int element = 0; element < sdna->names_array_len[member->name]; element++) {
+          const int element_offset = offset + element * element_size;
+          if (dna_struct_compare(sdna, member_struct_nr, a + element_offset, b + element_offset) !=
+              -1) {
+            return i;
+          }
+        }
+      }
+    }
+    offset += size;
+  }
+  return -1;
+}
+
+/** The DNA struct of an ID type, -1 when its name does not follow the usual prefixes. */
+static int dna_id_struct_find_nr(const SDNA *sdna, const ID *id)
+{
+  const char *type_name = BKE_idtype_get_info_from_id(id)->name;
+  for (const char *prefix : {"", "b", "wm"}) {
+    char struct_name[64];
+    BLI_snprintf(struct_name, sizeof(struct_name), "%s%s", prefix, type_name);
+    const int struct_nr = DNA_struct_find_nr(sdna, struct_name);
+    if (struct_nr != -1) {
+      return struct_nr;
+    }
+  }
+  return -1;
+}
+
+template<typename T> static void expect_arrays_equal(const T *a, const T *b, const int num)
+{
+  ASSERT_EQ(a == nullptr, b == nullptr);
+  if (a != nullptr) {
+    EXPECT_EQ(memcmp(a, b, sizeof(T) * size_t(num)), 0);
+  }
+}
+
+/* Older files need their blocks reconstructed for the current DNA, which is done on multiple
+ * threads in advance. The result has to be the same as reconstructing them one by one. */
+TEST_F(BlendfileLoadingTest, ParallelStructDecodeMatchesSerial)
+{
+  const char *filepath = "modifier_stack/array_test.blend";
+  if (!blendfile_load(filepath)) {
+    return;
+  }
+  char abspath[FILENAME_MAX];
+  BLI_path_join(abspath,
+                sizeof(abspath),
+                blender::tests::flags_test_asset_dir().c_str(),
+                filepath,
+                nullptr);
+  BlendFileReadReport bf_reports = {nullptr};
+  BlendFileData *bfile_serial = BLO_read_from_file(
+      abspath, BLO_READ_SKIP_PARALLEL_DECODE, &bf_reports);
+  ASSERT_NE(bfile_serial, nullptr);
+
+  const SDNA *sdna = DNA_sdna_current_get();
+  ListBase *lbarray[INDEX_ID_MAX], *lbarray_serial[INDEX_ID_MAX];
+  const int lb_num = set_listbasepointers(bfile->main, lbarray);
+  set_listbasepointers(bfile_serial->main, lbarray_serial);
+  for (int lb_index = 0; lb_index < lb_num; lb_index++) {
+    ID *id_serial = static_cast<ID *>(lbarray_serial[lb_index]->first);
+    LISTBASE_FOREACH (ID *, id, lbarray[lb_index]) {
+      ASSERT_NE(id_serial, nullptr) << "extra ID " << id->name;
+      SCOPED_TRACE(id->name);
+      EXPECT_STREQ(id->name, id_serial->name);
+      EXPECT_EQ(id->flag, id_serial->flag);
+      EXPECT_EQ(id->us, id_serial->us);
+
+      /* The #ID (the first member) has session data, only compare the rest of the struct. */
+      const int struct_nr = dna_id_struct_find_nr(sdna, id);
+      if (struct_nr != -1) {
+        const int member = dna_struct_compare(sdna,
+                                              struct_nr,
+                                              reinterpret_cast<const char *>(id),
+                                              reinterpret_cast<const char *>(id_serial),
+                                              1);
+        EXPECT_EQ(member, -1) << "member "
+                              << sdna->names[sdna->structs[struct_nr]->members[member].name];
+      }
+
+      if (GS(id->name) == ID_ME) {
+        const Mesh *mesh = reinterpret_cast<const Mesh *>(id);
+        const Mesh *mesh_serial = reinterpret_cast<const Mesh *>(id_serial);
+        expect_arrays_equal(mesh->mvert, mesh_serial->mvert, mesh->totvert);
+        expect_arrays_equal(mesh->medge, mesh_serial->medge, mesh->totedge);
+        expect_arrays_equal(mesh->mpoly, mesh_serial->mpoly, mesh->totpoly);
+        expect_arrays_equal(mesh->mloop, mesh_serial->mloop, mesh->totloop);
+      }
+      id_serial = static_cast<ID *>(id_serial->next);
+    }
+    EXPECT_EQ(id_serial, nullptr);
+  }
+
+  wmWindowManager *wm = static_cast<wmWindowManager *>(bfile_serial->main->wm.first);
+  if (wm != nullptr) {
+    wm_close_and_free(nullptr, wm);
+  }
+  BLO_blendfiledata_free(bfile_serial);
+}
@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <string>
+#include <vector>
+
+#include "BLI_listbase.h"
+
+#include "BLO_undofile.h"
+
+/** Content of a chunk, and the ID it is written for. */
+struct TestChunk {
+  uint id_session_uuid;
+  std::string data;
+};
+
+/** Chunk buffers are shared by all undo steps, the tests check them with global statistics. */
+class BlendfileUndoTest : public BlendfileLoadingBaseTest {
+ protected:
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    ASSERT_EQ(stats().buffers_num, 0);
+  }
+
+  static MemFileStats stats()
+  {
+    MemFileStats stats;
+    BLO_memfile_stats_get(&stats);
+    return stats;
+  }
+
+  /** Content that differs for each \a seed. */
+  static std::string test_data(const int seed, const size_t size = 1024)
+  {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+      data[i] = char((i / 16 + size_t(seed) * 7) % 251);
+    }
+    return data;
+  }
+
+  static void write_memfile(MemFile *memfile,
+                            MemFile *reference_memfile,
+                            const std::vector<TestChunk> &chunks)
+  {
+    MemFileWriteData mem_data{};
+    BLO_memfile_write_init(&mem_data, memfile, reference_memfile);
+    for (const TestChunk &chunk : chunks) {
+      mem_data.current_id_session_uuid = chunk.id_session_uuid;
+      BLO_memfile_chunk_add(&mem_data, chunk.data.data(), chunk.data.size());
+    }
+    BLO_memfile_write_finalize(&mem_data);
+  }
+
+  static void expect_memfile_contents(MemFile *memfile, const std::vector<TestChunk> &chunks)
+  {
+    ASSERT_EQ(BLI_listbase_count(&memfile->chunks), int(chunks.size()));
+    MemFileChunk *chunk = static_cast<MemFileChunk *>(memfile->chunks.first);
+    for (const TestChunk &test_chunk : chunks) {
+      ASSERT_EQ(chunk->size, test_chunk.data.size());
+      EXPECT_EQ(std::string(BLO_memfile_chunk_data_get(chunk), chunk->size), test_chunk.data);
+      chunk = static_cast<MemFileChunk *>(chunk->next);
+    }
+  }
+
+  static MemFileChunk *chunk_get(MemFile *memfile, const int index)
+  {
+    return static_cast<MemFileChunk *>(BLI_findlink(&memfile->chunks, index));
+  }
+};
+
+TEST_F(BlendfileUndoTest, chunks_shared_between_ids)
+{
+  MemFile memfile{};
+  const std::vector<TestChunk> chunks = {{1, test_data(0)}, {2, test_data(0)}, {3, test_data(1)}};
+  write_memfile(&memfile, nullptr, chunks);
+
+  /* The same data written for different IDs is stored once. */
+  EXPECT_EQ(stats().buffers_num, 2);
+  EXPECT_EQ(chunk_get(&memfile, 0)->buf, chunk_get(&memfile, 1)->buf);
+  EXPECT_NE(chunk_get(&memfile, 0)->buf, chunk_get(&memfile, 2)->buf);
+  EXPECT_EQ(memfile.size, 2 * test_data(0).size());
+  expect_memfile_contents(&memfile, chunks);
+
+  BLO_memfile_free(&memfile);
+  EXPECT_EQ(stats().buffers_num, 0);
+}
+
+TEST_F(BlendfileUndoTest, chunks_shared_between_steps)
+{
+  MemFile memfile_a{};
+  MemFile memfile_b{};
+  const std::vector<TestChunk> chunks_a = {{1, test_data(0)}, {2, test_data(1)}};
+  /* Another ID was added before the others, so chunks don't match by position. */
+  const std::vector<TestChunk> chunks_b = {
+      {3, test_data(2)}, {1, test_data(0)}, {2, test_data(1)}};
+  write_memfile(&memfile_a, nullptr, chunks_a);
+  write_memfile(&memfile_b, &memfile_a, chunks_b);
+
+  EXPECT_EQ(stats().buffers_num, 3);
+  EXPECT_EQ(chunk_get(&memfile_a, 0)->buf, chunk_get(&memfile_b, 1)->buf);
+  EXPECT_EQ(chunk_get(&memfile_a, 1)->buf, chunk_get(&memfile_b, 2)->buf);
+  /* Only the new content counts for the second step. */
+  EXPECT_EQ(memfile_b.size, test_data(2).size());
+
+  /* Freeing the first step (as when it is removed from the undo stack) keeps the buffers used by
+   * the second one. */
+  BLO_memfile_merge(&memfile_a, &memfile_b);
+  EXPECT_EQ(stats().buffers_num, 3);
+  expect_memfile_contents(&memfile_b, chunks_b);
+
+  BLO_memfile_free(&memfile_b);
+  EXPECT_EQ(stats().buffers_num, 0);
+}
+
+TEST_F(BlendfileUndoTest, chunks_released)
+{
+  MemFile memfile_a{};
+  MemFile memfile_b{};
+  MemFile memfile_c{};
+  const std::vector<TestChunk> chunks_a = {{1, test_data(0)}, {2, test_data(1)}};
+  const std::vector<TestChunk> chunks_b = {{1, test_data(2)}, {2, test_data(1)}};
+  const std::vector<TestChunk> chunks_c = {{1, test_data(2)}, {2, test_data(3)}};
+  write_memfile(&memfile_a, nullptr, chunks_a);
+  write_memfile(&memfile_b, &memfile_a, chunks_b);
+  write_memfile(&memfile_c, &memfile_b, chunks_c);
+  EXPECT_EQ(stats().buffers_num, 4);
+  EXPECT_TRUE(chunk_get(&memfile_b, 1)->is_identical);
+  EXPECT_TRUE(chunk_get(&memfile_c, 0)->is_identical);
+
+  /* Content only used by the first step. */
+  BLO_memfile_merge(&memfile_a, &memfile_b);
+  EXPECT_EQ(stats().buffers_num, 3);
+  expect_memfile_contents(&memfile_b, chunks_b);
+
+  /* Content only used by the second step. */
+  BLO_memfile_merge(&memfile_b, &memfile_c);
+  EXPECT_EQ(stats().buffers_num, 2);
+  expect_memfile_contents(&memfile_c, chunks_c);
+
+  BLO_memfile_free(&memfile_c);
+  EXPECT_EQ(stats().buffers_num, 0);
+}
+
+TEST_F(BlendfileUndoTest, chunks_compressed)
+{
+  MemFile memfile_a{};
+  MemFile memfile_b{};
+  MemFile memfile_c{};
+  const std::vector<TestChunk> chunks_a = {{1, test_data(0)}, {2, test_data(1)}};
+  const std::vector<TestChunk> chunks_b = {{1, test_data(2)}, {2, test_data(1)}};
+  const std::vector<TestChunk> chunks_c = {{1, test_data(3)}, {2, test_data(1)}};
+  write_memfile(&memfile_a, nullptr, chunks_a);
+  write_memfile(&memfile_b, &memfile_a, chunks_b);
+  write_memfile(&memfile_c, &memfile_b, chunks_c);
+  const size_t size_a = memfile_a.size;
+  EXPECT_EQ(size_a, 2 * test_data(0).size());
+
+  /* Only the content of the first step is not used by the last two steps. */
+  BLO_memfile_compress_old_chunks(2);
+  BLO_memfile_compress_wait();
+  EXPECT_EQ(stats().buffers_num, 4);
+  EXPECT_EQ(stats().buffers_compressed_num, 1);
+  EXPECT_EQ(stats().size_compressed_original, test_data(0).size());
+  EXPECT_LT(stats().size_compressed, test_data(0).size());
+  /* The memory limit counts the compressed size. */
+  EXPECT_EQ(BLO_memfile_memory_size_get(&memfile_a),
+            test_data(1).size() + stats().size_compressed);
+
+  /* A new step with the same content shares the compressed buffer, without decompressing it. */
+  MemFile memfile_d{};
+  const std::vector<TestChunk> chunks_d = {{3, test_data(0)}};
+  write_memfile(&memfile_d, &memfile_c, chunks_d);
+  EXPECT_EQ(stats().buffers_num, 4);
+  EXPECT_EQ(stats().buffers_compressed_num, 1);
+  EXPECT_EQ(chunk_get(&memfile_a, 0)->buf, chunk_get(&memfile_d, 0)->buf);
+  EXPECT_EQ(memfile_d.size, 0);
+
+  /* Reading the content decompresses it. */
+  expect_memfile_contents(&memfile_a, chunks_a);
+  expect_memfile_contents(&memfile_d, chunks_d);
+  EXPECT_EQ(stats().buffers_compressed_num, 0);
+  EXPECT_EQ(stats().size_compressed, 0);
+  EXPECT_EQ(BLO_memfile_memory_size_get(&memfile_a), size_a);
+
+  /* Compressing and freeing the steps in the undo stack order. */
+  BLO_memfile_compress_old_chunks(1);
+  BLO_memfile_compress_wait();
+  EXPECT_GT(stats().buffers_compressed_num, 0);
+  BLO_memfile_merge(&memfile_a, &memfile_b);
+  BLO_memfile_merge(&memfile_b, &memfile_c);
+  BLO_memfile_merge(&memfile_c, &memfile_d);
+  expect_memfile_contents(&memfile_d, chunks_d);
+  EXPECT_EQ(stats().buffers_num, 1);
+  /* The buffer added by the first step is now counted by the remaining one. */
+  EXPECT_EQ(BLO_memfile_memory_size_get(&memfile_d), test_data(0).size());
+
+  BLO_memfile_free(&memfile_d);
+  EXPECT_EQ(stats().buffers_num, 0);
+  EXPECT_EQ(stats().size_uncompressed, 0);
+  EXPECT_EQ(stats().size_compressed, 0);
+}
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "BKE_appdir.h"
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_report.h"
+
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_ID.h"
+#include "DNA_userdef_types.h"
+
+class BlendfileWriteSnapshotTest : public BlendfileLoadingBaseTest {
+ protected:
+  std::string temp_filepath(const char *name)
+  {
+    BKE_tempdir_init(nullptr);
+    const std::string filepath = std::string(BKE_tempdir_base()) + name;
+    written_filepaths_.insert(filepath);
+    return filepath;
+  }
+
+  void TearDown() override
+  {
+    for (const std::string &filepath : written_filepaths_) {
+      BLI_delete(filepath.c_str(), false, false);
+      BLI_delete((filepath + "1").c_str(), false, false);
+    }
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  static std::string read_bytes(const std::string &filepath)
+  {
+    std::ifstream file(filepath, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+  }
+
+  /** Names of all IDs in the file. */
+  static std::set<std::string> read_id_names(const std::string &filepath)
+  {
+    std::set<std::string> names;
+    BlendFileReadReport bf_reports{};
+    BlendFileData *bfd = BLO_read_from_file(filepath.c_str(), BLO_READ_SKIP_NONE, &bf_reports);
+    if (bfd == nullptr) {
+      ADD_FAILURE() << filepath;
+      return names;
+    }
+    ID *id;
+    FOREACH_MAIN_ID_BEGIN (bfd->main, id) {
+      names.insert(id->name);
+    }
+    FOREACH_MAIN_ID_END;
+    BLO_blendfiledata_free(bfd);
+    return names;
+  }
+
+  /** Write the loaded file as usual, returns its path. */
+  std::string write_reference(const char *name, const int write_flags)
+  {
+    const std::string filepath = temp_filepath(name);
+    BlendFileWriteParams params{};
+    params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+    EXPECT_TRUE(BLO_write_file(bfile->main, filepath.c_str(), write_flags, &params, nullptr));
+    return filepath;
+  }
+
+  static bool store_snapshot(BlendFileWriteSnapshot *snapshot)
+  {
+    ReportList reports;
+    BKE_reports_init(&reports, RPT_STORE);
+    float progress = -1.0f;
+    const bool success = BLO_write_file_snapshot_store(snapshot, &progress, &reports);
+    EXPECT_FALSE(BKE_reports_contain(&reports, RPT_ERROR));
+    EXPECT_FLOAT_EQ(progress, 1.0f);
+    BKE_reports_clear(&reports);
+    BLO_write_file_snapshot_free(snapshot);
+    return success;
+  }
+
+  std::set<std::string> written_filepaths_;
+};
+
+TEST_F(BlendfileWriteSnapshotTest, same_as_regular_write)
+{
+  if (!blendfile_load("modifier_stack/array_test.blend")) {
+    return;
+  }
+  const std::string reference_filepath = write_reference("snapshot_test_reference.blend", 0);
+  const std::string filepath = temp_filepath("snapshot_test.blend");
+
+  BlendFileWriteParams params{};
+  params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+  BlendFileWriteSnapshot *snapshot = BLO_write_file_snapshot(
+      bfile->main, filepath.c_str(), 0, &params, nullptr);
+  ASSERT_NE(snapshot, nullptr);
+  EXPECT_EQ(BLO_write_file_snapshot_size(snapshot), read_bytes(reference_filepath).size());
+  ASSERT_TRUE(store_snapshot(snapshot));
+
+  /* The same blocks are written (pointers of temporary data may differ between two writes). */
+  const std::string reference = read_bytes(reference_filepath);
+  const std::string written = read_bytes(filepath);
+  EXPECT_EQ(written.size(), reference.size());
+  EXPECT_EQ(written.substr(0, 12), reference.substr(0, 12));
+  const std::set<std::string> reference_names = read_id_names(reference_filepath);
+  EXPECT_FALSE(reference_names.empty());
+  EXPECT_EQ(read_id_names(filepath), reference_names);
+}
+
+TEST_F(BlendfileWriteSnapshotTest, compressed_with_versions)
+{
+  if (!blendfile_load("modifier_stack/array_test.blend")) {
+    return;
+  }
+  const std::string reference_filepath = write_reference("snapshot_test_reference_zstd.blend",
+                                                         G_FILE_COMPRESS);
+  const std::string filepath = temp_filepath("snapshot_test_zstd.blend");
+  /* An existing file, kept as a version when saving. */
+  const std::string previous = read_bytes(reference_filepath);
+  {
+    std::ofstream file(filepath, std::ios::binary);
+    file << previous;
+  }
+
+  BlendFileWriteParams params{};
+  params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+  params.use_save_versions = true;
+  BlendFileWriteSnapshot *snapshot = BLO_write_file_snapshot(
+      bfile->main, filepath.c_str(), G_FILE_COMPRESS, &params, nullptr);
+  ASSERT_NE(snapshot, nullptr);
+  ASSERT_TRUE(store_snapshot(snapshot));
+
+  EXPECT_EQ(read_id_names(filepath), read_id_names(reference_filepath));
+  if (U.versions > 0) {
+    EXPECT_EQ(read_bytes(filepath + "1"), previous);
+  }
+}
+
+TEST_F(BlendfileWriteSnapshotTest, from_memfile)
+{
+  if (!blendfile_load("modifier_stack/array_test.blend")) {
+    return;
+  }
+  MemFile memfile{};
+  ASSERT_TRUE(BLO_write_file_mem(bfile->main, nullptr, &memfile, G.fileflags));
+
+  const std::string filepath = temp_filepath("snapshot_test_memfile.blend");
+  BlendFileWriteSnapshot *snapshot = BLO_write_file_snapshot_from_memfile(&memfile,
+                                                                          filepath.c_str());
+  ASSERT_NE(snapshot, nullptr);
+  size_t memfile_size = 0;
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile.chunks) {
+    memfile_size += chunk->size;
+  }
+  EXPECT_EQ(BLO_write_file_snapshot_size(snapshot), memfile_size);
+  ASSERT_TRUE(store_snapshot(snapshot));
+
+  /* Byte for byte the same as writing the memfile directly (as auto-save does without a job). */
+  const std::string memfile_filepath = temp_filepath("snapshot_test_memfile_direct.blend");
+  ASSERT_TRUE(BLO_memfile_write_file(&memfile, memfile_filepath.c_str()));
+  EXPECT_EQ(read_bytes(filepath), read_bytes(memfile_filepath));
+  BLO_memfile_free(&memfile);
+
+  /* Undo steps also write unused IDs, so the regular file may have fewer. */
+  const std::set<std::string> names = read_id_names(filepath);
+  for (const std::string &name : read_id_names(write_reference("snapshot_test_ref.blend", 0))) {
+    EXPECT_EQ(names.count(name), 1) << name;
+  }
+}
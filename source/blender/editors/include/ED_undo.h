@@ -108,6 +108,11 @@ void ED_undosys_type_free(void);
 /* memfile_undo.c */
 
 struct MemFile *ED_undosys_stack_memfile_get_active(struct UndoStack *ustack);
+/**
+ * Update the size of the memfile steps, which shrink as their chunks are compressed
+ * (see #BLO_memfile_compress_old_chunks), so the memory limit counts the memory actually used.
+ */
+void ED_undosys_stack_memfile_data_size_update(struct UndoStack *ustack);
 /**
  * If the last undo step is a memfile one, find the first #MemFileChunk matching given ID
  * (using its session UUID), and tag it as "changed in the future".
@@ -105,6 +105,7 @@ static int wm_obj_export_exec(bContext *C, wmOperator *op)
   export_params.path_mode = RNA_enum_get(op->ptr, "path_mode");
   export_params.export_triangulated_mesh = RNA_boolean_get(op->ptr, "export_triangulated_mesh");
   export_params.export_curves_as_nurbs = RNA_boolean_get(op->ptr, "export_curves_as_nurbs");
+  export_params.compress_zstd = RNA_boolean_get(op->ptr, "compress_zstd");
 
   export_params.export_object_groups = RNA_boolean_get(op->ptr, "export_object_groups");
   export_params.export_material_groups = RNA_boolean_get(op->ptr, "export_material_groups");
@@ -165,6 +166,7 @@ static void ui_obj_export_settings(uiLayout *layout, PointerRNA *imfptr)
   uiItemR(sub, imfptr, "export_materials", 0, IFACE_("Materials"), ICON_NONE);
   uiItemR(sub, imfptr, "export_triangulated_mesh", 0, IFACE_("Triangulated Mesh"), ICON_NONE);
   uiItemR(sub, imfptr, "export_curves_as_nurbs", 0, IFACE_("Curves as NURBS"), ICON_NONE);
+  uiItemR(sub, imfptr, "compress_zstd", 0, IFACE_("Compress"), ICON_NONE);
 
   /* Grouping options. */
   box = uiLayoutBox(layout);
@@ -197,8 +199,13 @@ static bool wm_obj_export_check(bContext *C, wmOperator *op)
   bool changed = false;
   RNA_string_get(op->ptr, "filepath", filepath);
 
-  if (!BLI_path_extension_check(filepath, ".obj")) {
-    BLI_path_extension_ensure(filepath, FILE_MAX, ".obj");
+  const char *extension = RNA_boolean_get(op->ptr, "compress_zstd") ? ".obj.zst" : ".obj";
+  if (!BLI_path_extension_check(filepath, extension)) {
+    /* Drop the compression suffix before switching between compressed and plain files. */
+    if (BLI_path_extension_check(filepath, ".zst")) {
+      BLI_path_extension_replace(filepath, FILE_MAX, "");
+    }
+    BLI_path_extension_ensure(filepath, FILE_MAX, extension);
     RNA_string_set(op->ptr, "filepath", filepath);
     changed = true;
   }
@@ -342,6 +349,11 @@ void WM_OT_obj_export(struct wmOperatorType *ot)
                   false,
                   "Export Curves as NURBS",
                   "Export curves in parametric form instead of exporting as mesh");
+  RNA_def_boolean(ot->srna,
+                  "compress_zstd",
+                  false,
+                  "Compress",
+                  "Write a Zstandard compressed .obj.zst file");
 
   RNA_def_boolean(ot->srna,
                   "export_object_groups",
@@ -0,0 +1,267 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup editor/io
+ */
+
+#ifdef WITH_IO_PLY
+
+#  include "BKE_context.h"
+#  include "BKE_main.h"
+#  include "BKE_report.h"
+
+#  include "BLI_path_util.h"
+#  include "BLI_string.h"
+
+#  include "WM_api.h"
+#  include "WM_types.h"
+
+#  include "DNA_space_types.h"
+
+#  include "ED_outliner.h"
+
+#  include "RNA_access.h"
+#  include "RNA_define.h"
+
+#  include "IO_ply.h"
+#  include "io_ply_ops.h"
+
+static int wm_ply_import_invoke(bContext *C, wmOperator *op, const wmEvent *event)
+{
+  return WM_operator_filesel(C, op, event);
+}
+
+static int wm_ply_import_execute(bContext *C, wmOperator *op)
+{
+  struct PLYImportParams params;
+  params.forward_axis = RNA_enum_get(op->ptr, "forward_axis");
+  params.up_axis = RNA_enum_get(op->ptr, "up_axis");
+  params.use_scene_unit = RNA_boolean_get(op->ptr, "use_scene_unit");
+  params.global_scale = RNA_float_get(op->ptr, "global_scale");
+  params.use_mesh_validate = RNA_boolean_get(op->ptr, "use_mesh_validate");
+
+  int files_len = RNA_collection_length(op->ptr, "files");
+  int imported_num = 0;
+
+  if (files_len) {
+    PointerRNA fileptr;
+    PropertyRNA *prop;
+    char dir_only[FILE_MAX], file_only[FILE_MAX];
+
+    RNA_string_get(op->ptr, "directory", dir_only);
+    prop = RNA_struct_find_property(op->ptr, "files");
+    for (int i = 0; i < files_len; i++) {
+      RNA_property_collection_lookup_int(op->ptr, prop, i, &fileptr);
+      RNA_string_get(&fileptr, "name", file_only);
+      BLI_join_dirfile(params.filepath, sizeof(params.filepath), dir_only, file_only);
+      imported_num += PLY_import(C, &params, op->reports);
+    }
+  }
+  else if (RNA_struct_property_is_set(op->ptr, "filepath")) {
+    RNA_string_get(op->ptr, "filepath", params.filepath);
+    imported_num += PLY_import(C, &params, op->reports);
+  }
+  else {
+    BKE_report(op->reports, RPT_ERROR, "No filename given");
+    return OPERATOR_CANCELLED;
+  }
+
+  /* Keep the files that were imported when others failed. */
+  if (imported_num == 0) {
+    return OPERATOR_CANCELLED;
+  }
+
+  Scene *scene = CTX_data_scene(C);
+  WM_event_add_notifier(C, NC_SCENE | ND_OB_SELECT, scene);
+  WM_event_add_notifier(C, NC_SCENE | ND_OB_ACTIVE, scene);
+  WM_event_add_notifier(C, NC_SCENE | ND_LAYER_CONTENT, scene);
+  ED_outliner_select_sync_from_object_tag(C);
+
+  return OPERATOR_FINISHED;
+}
+
+static bool wm_ply_import_check(bContext *UNUSED(C), wmOperator *op)
+{
+  const int num_axes = 3;
+  /* Both forward and up axes cannot be the same (or same except opposite sign). */
+  if (RNA_enum_get(op->ptr, "forward_axis") % num_axes ==
+      (RNA_enum_get(op->ptr, "up_axis") % num_axes)) {
+    RNA_enum_set(op->ptr, "up_axis", RNA_enum_get(op->ptr, "up_axis") % num_axes + 1);
+    return true;
+  }
+  return false;
+}
+
+void WM_OT_ply_import(struct wmOperatorType *ot)
+{
+  PropertyRNA *prop;
+
+  ot->name = "Import PLY";
+  ot->description = "Import a PLY file as a mesh or point cloud object";
+  ot->idname = "WM_OT_ply_import";
+
+  ot->invoke = wm_ply_import_invoke;
+  ot->exec = wm_ply_import_execute;
+  ot->poll = WM_operator_winactive;
+  ot->check = wm_ply_import_check;
+  ot->flag = OPTYPE_REGISTER | OPTYPE_UNDO;
+
+  WM_operator_properties_filesel(ot,
+                                 FILE_TYPE_FOLDER,
+                                 FILE_BLENDER,
+                                 FILE_OPENFILE,
+                                 WM_FILESEL_FILEPATH | WM_FILESEL_FILES | WM_FILESEL_DIRECTORY |
+                                     WM_FILESEL_SHOW_PROPS,
+                                 FILE_DEFAULTDISPLAY,
+                                 FILE_SORT_ALPHA);
+
+  RNA_def_float(ot->srna, "global_scale", 1.0f, 1e-6f, 1e6f, "Scale", "", 0.001f, 1000.0f);
+  RNA_def_boolean(ot->srna,
+                  "use_scene_unit",
+                  false,
+                  "Scene Unit",
+                  "Apply current scene's unit (as defined by unit scale) to imported data");
+  RNA_def_enum(ot->srna, "forward_axis", io_transform_axis, IO_AXIS_Y, "Forward Axis", "");
+  RNA_def_enum(ot->srna, "up_axis", io_transform_axis, IO_AXIS_Z, "Up Axis", "");
+  RNA_def_boolean(ot->srna,
+                  "use_mesh_validate",
+                  false,
+                  "Validate Mesh",
+                  "Validate and correct imported mesh (slow)");
+
+  /* Only show .ply files by default. */
+  prop = RNA_def_string(ot->srna, "filter_glob", "*.ply", 0, "Extension Filter", "");
+  RNA_def_property_flag(prop, PROP_HIDDEN);
+}
+
+static int wm_ply_export_invoke(bContext *C, wmOperator *op, const wmEvent *UNUSED(event))
+{
+  if (!RNA_struct_property_is_set(op->ptr, "filepath")) {
+    Main *bmain = CTX_data_main(C);
+    char filepath[FILE_MAX];
+
+    if (BKE_main_blendfile_path(bmain)[0] == '\0') {
+      BLI_strncpy(filepath, "untitled", sizeof(filepath));
+    }
+    else {
+      BLI_strncpy(filepath, BKE_main_blendfile_path(bmain), sizeof(filepath));
+    }
+
+    BLI_path_extension_replace(filepath, sizeof(filepath), ".ply");
+    RNA_string_set(op->ptr, "filepath", filepath);
+  }
+
+  WM_event_add_fileselect(C, op);
+  return OPERATOR_RUNNING_MODAL;
+}
+
+static int wm_ply_export_execute(bContext *C, wmOperator *op)
+{
+  if (!RNA_struct_property_is_set(op->ptr, "filepath")) {
+    BKE_report(op->reports, RPT_ERROR, "No filename given");
+    return OPERATOR_CANCELLED;
+  }
+  struct PLYExportParams params;
+  RNA_string_get(op->ptr, "filepath", params.filepath);
+  params.forward_axis = RNA_enum_get(op->ptr, "axis_forward");
+  params.up_axis = RNA_enum_get(op->ptr, "axis_up");
+  params.global_scale = RNA_float_get(op->ptr, "global_scale");
+  params.export_selected_objects = RNA_boolean_get(op->ptr, "use_selection");
+  params.use_scene_unit = RNA_boolean_get(op->ptr, "use_scene_unit");
+  params.apply_modifiers = RNA_boolean_get(op->ptr, "use_mesh_modifiers");
+  params.ascii_format = RNA_boolean_get(op->ptr, "use_ascii");
+  params.export_normals = RNA_boolean_get(op->ptr, "use_normals");
+  params.export_colors = RNA_boolean_get(op->ptr, "use_colors");
+
+  if (!PLY_export(C, &params, op->reports)) {
+    return OPERATOR_CANCELLED;
+  }
+
+  return OPERATOR_FINISHED;
+}
+
+static bool wm_ply_export_check(bContext *UNUSED(C), wmOperator *op)
+{
+  char filepath[FILE_MAX];
+  bool changed = false;
+  RNA_string_get(op->ptr, "filepath", filepath);
+
+  if (!BLI_path_extension_check(filepath, ".ply")) {
+    BLI_path_extension_ensure(filepath, FILE_MAX, ".ply");
+    RNA_string_set(op->ptr, "filepath", filepath);
+    changed = true;
+  }
+
+  const int num_axes = 3;
+  /* Both forward and up axes cannot be the same (or same except opposite sign). */
+  if (RNA_enum_get(op->ptr, "axis_forward") % num_axes ==
+      (RNA_enum_get(op->ptr, "axis_up") % num_axes)) {
+    RNA_enum_set(op->ptr, "axis_up", RNA_enum_get(op->ptr, "axis_up") % num_axes + 1);
+    changed = true;
+  }
+  return changed;
+}
+
+void WM_OT_ply_export(struct wmOperatorType *ot)
+{
+  PropertyRNA *prop;
+
+  ot->name = "Export PLY";
+  ot->description = "Save the scene to a PLY file";
+  ot->idname = "WM_OT_ply_export";
+
+  ot->invoke = wm_ply_export_invoke;
+  ot->exec = wm_ply_export_execute;
+  ot->poll = WM_operator_winactive;
+  ot->check = wm_ply_export_check;
+  ot->flag = OPTYPE_PRESET;
+
+  WM_operator_properties_filesel(ot,
+                                 FILE_TYPE_FOLDER,
+                                 FILE_BLENDER,
+                                 FILE_SAVE,
+                                 WM_FILESEL_FILEPATH | WM_FILESEL_SHOW_PROPS,
+                                 FILE_DEFAULTDISPLAY,
+                                 FILE_SORT_ALPHA);
+
+  /* Property names match the ones of the Python PLY exporter add-on. */
+  RNA_def_boolean(ot->srna,
+                  "use_selection",
+                  false,
+                  "Selection Only",
+                  "Export selected objects only");
+  RNA_def_float(ot->srna, "global_scale", 1.0f, 1e-6f, 1e6f, "Scale", "", 0.001f, 1000.0f);
+  RNA_def_boolean(ot->srna,
+                  "use_scene_unit",
+                  false,
+                  "Scene Unit",
+                  "Apply current scene's unit (as defined by unit scale) to exported data");
+  RNA_def_boolean(ot->srna,
+                  "use_ascii",
+                  false,
+                  "ASCII",
+                  "Export using ASCII file format, otherwise use binary");
+  RNA_def_boolean(ot->srna,
+                  "use_mesh_modifiers",
+                  true,
+                  "Apply Modifiers",
+                  "Apply the modifiers before saving");
+  RNA_def_boolean(ot->srna,
+                  "use_normals",
+                  true,
+                  "Normals",
+                  "Export vertex normals (disable to save space)");
+  RNA_def_boolean(ot->srna,
+                  "use_colors",
+                  true,
+                  "Vertex Colors",
+                  "Export the active color attribute, interpolated to vertices");
+  RNA_def_enum(ot->srna, "axis_forward", io_transform_axis, IO_AXIS_Y, "Forward", "");
+  RNA_def_enum(ot->srna, "axis_up", io_transform_axis, IO_AXIS_Z, "Up", "");
+
+  /* Only show .ply files by default. */
+  prop = RNA_def_string(ot->srna, "filter_glob", "*.ply", 0, "Extension Filter", "");
+  RNA_def_property_flag(prop, PROP_HIDDEN);
+}
+
+#endif /* WITH_IO_PLY */
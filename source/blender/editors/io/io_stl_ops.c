@@ -7,8 +7,12 @@
 #ifdef WITH_IO_STL
 
 #  include "BKE_context.h"
+#  include "BKE_main.h"
 #  include "BKE_report.h"
 
+#  include "BLI_path_util.h"
+#  include "BLI_string.h"
+
 #  include "WM_api.h"
 #  include "WM_types.h"
 
@@ -130,4 +134,126 @@ void WM_OT_stl_import(struct wmOperatorType *ot)
   RNA_def_property_flag(prop, PROP_HIDDEN);
 }
 
+static const EnumPropertyItem stl_export_batch_mode_items[] = {
+    {0, "OFF", 0, "Off", "All data in one file"},
+    {1, "OBJECT", 0, "Object", "Each object as a file"},
+    {0, NULL, 0, NULL, NULL},
+};
+
+static int wm_stl_export_invoke(bContext *C, wmOperator *op, const wmEvent *UNUSED(event))
+{
+  if (!RNA_struct_property_is_set(op->ptr, "filepath")) {
+    Main *bmain = CTX_data_main(C);
+    char filepath[FILE_MAX];
+
+    if (BKE_main_blendfile_path(bmain)[0] == '\0') {
+      BLI_strncpy(filepath, "untitled", sizeof(filepath));
+    }
+    else {
+      BLI_strncpy(filepath, BKE_main_blendfile_path(bmain), sizeof(filepath));
+    }
+
+    BLI_path_extension_replace(filepath, sizeof(filepath), ".stl");
+    RNA_string_set(op->ptr, "filepath", filepath);
+  }
+
+  WM_event_add_fileselect(C, op);
+  return OPERATOR_RUNNING_MODAL;
+}
+
+static int wm_stl_export_execute(bContext *C, wmOperator *op)
+{
+  if (!RNA_struct_property_is_set(op->ptr, "filepath")) {
+    BKE_report(op->reports, RPT_ERROR, "No filename given");
+    return OPERATOR_CANCELLED;
+  }
+  struct STLExportParams params;
+  RNA_string_get(op->ptr, "filepath", params.filepath);
+  params.forward_axis = RNA_enum_get(op->ptr, "axis_forward");
+  params.up_axis = RNA_enum_get(op->ptr, "axis_up");
+  params.global_scale = RNA_float_get(op->ptr, "global_scale");
+  params.export_selected_objects = RNA_boolean_get(op->ptr, "use_selection");
+  params.use_scene_unit = RNA_boolean_get(op->ptr, "use_scene_unit");
+  params.apply_modifiers = RNA_boolean_get(op->ptr, "use_mesh_modifiers");
+  params.ascii_format = RNA_boolean_get(op->ptr, "ascii");
+  params.use_batch = RNA_enum_get(op->ptr, "batch_mode") != 0;
+
+  if (!STL_export(C, &params, op->reports)) {
+    return OPERATOR_CANCELLED;
+  }
+
+  return OPERATOR_FINISHED;
+}
+
+static bool wm_stl_export_check(bContext *UNUSED(C), wmOperator *op)
+{
+  char filepath[FILE_MAX];
+  bool changed = false;
+  RNA_string_get(op->ptr, "filepath", filepath);
+
+  if (!BLI_path_extension_check(filepath, ".stl")) {
+    BLI_path_extension_ensure(filepath, FILE_MAX, ".stl");
+    RNA_string_set(op->ptr, "filepath", filepath);
+    changed = true;
+  }
+
+  const int num_axes = 3;
+  /* Both forward and up axes cannot be the same (or same except opposite sign). */
+  if (RNA_enum_get(op->ptr, "axis_forward") % num_axes ==
+      (RNA_enum_get(op->ptr, "axis_up") % num_axes)) {
+    RNA_enum_set(op->ptr, "axis_up", RNA_enum_get(op->ptr, "axis_up") % num_axes + 1);
+    changed = true;
+  }
+  return changed;
+}
+
+void WM_OT_stl_export(struct wmOperatorType *ot)
+{
+  PropertyRNA *prop;
+
+  ot->name = "Export STL";
+  ot->description = "Save the scene to an STL file";
+  ot->idname = "WM_OT_stl_export";
+
+  ot->invoke = wm_stl_export_invoke;
+  ot->exec = wm_stl_export_execute;
+  ot->poll = WM_operator_winactive;
+  ot->check = wm_stl_export_check;
+  ot->flag = OPTYPE_PRESET;
+
+  WM_operator_properties_filesel(ot,
+                                 FILE_TYPE_FOLDER,
+                                 FILE_BLENDER,
+                                 FILE_SAVE,
+                                 WM_FILESEL_FILEPATH | WM_FILESEL_SHOW_PROPS,
+                                 FILE_DEFAULTDISPLAY,
+                                 FILE_SORT_ALPHA);
+
+  /* Property names match the ones of the Python STL exporter add-on. */
+  RNA_def_boolean(ot->srna,
+                  "use_selection",
+                  false,
+                  "Selection Only",
+                  "Export selected objects only");
+  RNA_def_float(ot->srna, "global_scale", 1.0f, 1e-6f, 1e6f, "Scale", "", 0.001f, 1000.0f);
+  RNA_def_boolean(ot->srna,
+                  "use_scene_unit",
+                  false,
+                  "Scene Unit",
+                  "Apply current scene's unit (as defined by unit scale) to exported data");
+  RNA_def_boolean(ot->srna, "ascii", false, "ASCII", "Save the file in ASCII file format");
+  RNA_def_boolean(ot->srna,
+                  "use_mesh_modifiers",
+                  true,
+                  "Apply Modifiers",
+                  "Apply the modifiers before saving");
+  RNA_def_enum(ot->srna, "batch_mode", stl_export_batch_mode_items, 0, "Batch Mode", "");
+  RNA_def_enum(ot->srna, "axis_forward", io_transform_axis, IO_AXIS_Y, "Forward", "");
+  RNA_def_enum(ot->srna, "axis_up", io_transform_axis, IO_AXIS_Z, "Up", "");
+
+  /* Only show .stl files by default. */
+  prop = RNA_def_string(ot->srna, "filter_glob", "*.stl", 0, "Extension Filter", "");
+  RNA_def_property_flag(prop, PROP_HIDDEN);
+}
+
 #endif /* WITH_IO_STL */
@@ -349,6 +349,17 @@ struct MemFile *ED_undosys_stack_memfile_get_active(UndoStack *ustack)
   return NULL;
 }
 
+void ED_undosys_stack_memfile_data_size_update(UndoStack *ustack)
+{
+  LISTBASE_FOREACH (UndoStep *, us_p, &ustack->steps) {
+    if (us_p->type == BKE_UNDOSYS_TYPE_MEMFILE) {
+      MemFileUndoStep *us = (MemFileUndoStep *)us_p;
+      us->data->undo_size = BLO_memfile_memory_size_get(&us->data->memfile);
+      us->step.data_size = us->data->undo_size;
+    }
+  }
+}
+
 void ED_undosys_stack_memfile_id_changed_tag(UndoStack *ustack, ID *id)
 {
   UndoStep *us = ustack->step_active;
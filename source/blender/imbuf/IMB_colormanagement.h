@@ -298,6 +298,13 @@ void IMB_display_buffer_transform_apply(unsigned char *display_buffer,
 
 void IMB_display_buffer_release(void *cache_handle);
 
+/**
+ * Whether display buffers of byte images may be computed with a baked LUT of the display
+ * transform, which is faster but can differ very slightly from the exact transform.
+ * Disabled by default, only affects display buffers computed afterwards.
+ */
+void IMB_colormanagement_display_lut_set_enabled(bool enabled);
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -249,6 +249,11 @@ typedef struct ImBuf {
   struct MEM_CacheLimiterHandle_s *c_handle;
   /** reference counter for multiple users */
   int refcounter;
+  /**
+   * Time in seconds it took to read or decode the buffer, zero when unknown.
+   * Used by the cache to weigh the cost of freeing it against its size.
+   */
+  float load_time;
 
   /* some parameters to pass along for packing images */
   /** Compressed image only used with png and exr currently */
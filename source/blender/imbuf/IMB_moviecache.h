@@ -30,6 +30,26 @@ typedef void (*MovieCachePriorityDeleterFP)(void *priority_data);
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
+/**
+ * Frames of all movie caches share one memory budget, and the least valuable frames are freed
+ * first when it is exceeded: those which are cheap to get back compared to the memory they use,
+ * and which haven't been accessed for a while.
+ *
+ * \param cost: Time in seconds it takes to get the frame back, zero when unknown (estimated from
+ * the size then).
+ * \param last_access: Last time the frame was used, see #PIL_check_seconds_timer.
+ * \return Value of keeping the frame in memory, comparable between all caches of the budget.
+ */
+float IMB_moviecache_frame_value(float cost, size_t size, double last_access);
+/**
+ * Free frames less valuable than \a value (see #IMB_moviecache_frame_value), least valuable
+ * first, until \a size memory has been freed. Used by caches which don't store their frames in
+ * a #MovieCache but share its memory budget.
+ *
+ * \return The amount of memory freed.
+ */
+size_t IMB_moviecache_free_less_valuable(float value, size_t size);
+
 struct MovieCache *IMB_moviecache_create(const char *name,
                                          int keysize,
                                          GHashHashFP hashfp,
@@ -46,6 +46,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #ifdef WITH_AVI
 #  include "AVI_avi.h"
 #endif
@@ -1575,6 +1577,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     return NULL;
   }
 
+  const double start_time = PIL_check_seconds_timer();
   filter_y = (anim->ib_flags & IB_animdeinterlace);
 
   if (preview_size == IMB_PROXY_NONE) {
@@ -1642,6 +1645,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
       IMB_filtery(ibuf);
     }
     BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->cur_position + 1);
+    /* Includes seeking, which is part of what it costs to get the frame back. */
+    ibuf->load_time = (float)(PIL_check_seconds_timer() - start_time);
   }
   return ibuf;
 }
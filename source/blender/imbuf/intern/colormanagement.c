@@ -30,6 +30,7 @@
 #include "BLI_math.h"
 #include "BLI_math_color.h"
 #include "BLI_rect.h"
+#include "BLI_simd.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
 
@@ -93,6 +94,8 @@ typedef struct ColormanageProcessor {
   bool is_data_result;
 } ColormanageProcessor;
 
+static void display_lut_free_all(void);
+
 static struct global_gpu_state {
   /* GPU shader currently bound. */
   bool gpu_shader_bound;
@@ -644,6 +647,9 @@ static void colormanage_free_config(void)
   BLI_freelistN(&global_looks);
   global_tot_looks = 0;
 
+  /* free baked display LUTs */
+  display_lut_free_all();
+
   OCIO_exit();
 }
 
@@ -1433,12 +1439,377 @@ const float *IMB_colormanagement_get_xyz_to_scene_linear()
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Baked Display LUT
+ *
+ * Byte buffers only have 256 values per channel, so the whole display transform of their colors
+ * (conversion to scene linear, curve mapping, look, view and display transforms) is baked into a
+ * 3D LUT once, instead of running OCIO on every pixel of every display buffer.
+ *
+ * The LUT is sampled with trilinear interpolation, so colors can differ very slightly from the
+ * exact transform. It is only used for display buffers, never when saving images.
+ * \{ */
+
+/* Number of grid values per axis, see #display_lut_grid_step. */
+#define DISPLAY_LUT_SIZE 62
+#define DISPLAY_LUT_ENTRIES (DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE)
+/* Number of LUTs kept in memory, for different view settings. */
+#define DISPLAY_LUT_CACHE_MAX 4
+
+typedef struct DisplayLUT {
+  struct DisplayLUT *next, *prev;
+
+  /* Settings the LUT was baked for. */
+  char from_colorspace[MAX_COLORSPACE_NAME];
+  char look[MAX_COLORSPACE_NAME];
+  char view_transform[MAX_COLORSPACE_NAME];
+  char display_device[MAX_COLORSPACE_NAME];
+  float exposure;
+  float gamma;
+  /** Copy of the curve mapping of the view settings, compared by contents. */
+  CurveMapping *curve_mapping;
+
+  /** Number of display buffer computations using the LUT, it is not freed while used. */
+  int users;
+
+  /** Byte values of the grid. */
+  unsigned char grid[DISPLAY_LUT_SIZE];
+  /** For every byte value, index of the grid value below it and interpolation weight. */
+  unsigned char grid_index[256];
+  float grid_weight[256];
+  /** RGBA display colors, indexed by `(b * DISPLAY_LUT_SIZE + g) * DISPLAY_LUT_SIZE + r`. */
+  float *table;
+} DisplayLUT;
+
+/* Most recently used first. */
+static ListBase global_display_luts = {NULL, NULL};
+static pthread_mutex_t display_lut_lock = BLI_MUTEX_INITIALIZER;
+static bool global_display_lut_enabled = false;
+
+static CurveMapping *display_lut_view_curve_mapping(const ColorManagedViewSettings *view_settings)
+{
+  return (view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) ? view_settings->curve_mapping :
+                                                               NULL;
+}
+
+/**
+ * Compare the settings of curve mappings which affect their evaluation. The same curve mapping
+ * can be edited and freed while the LUT exists, so its address and time-stamp are no key.
+ */
+static bool display_lut_curve_mapping_equals(const CurveMapping *a, const CurveMapping *b)
+{
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+  if (a->flag != b->flag || a->tone != b->tone || !equals_v3v3(a->black, b->black) ||
+      !equals_v3v3(a->white, b->white) || !BLI_rctf_compare(&a->clipr, &b->clipr, 0.0f)) {
+    return false;
+  }
+  for (int i = 0; i < CM_TOT; i++) {
+    const CurveMap *cuma_a = &a->cm[i];
+    const CurveMap *cuma_b = &b->cm[i];
+    if (cuma_a->totpoint != cuma_b->totpoint) {
+      return false;
+    }
+    for (int j = 0; j < cuma_a->totpoint; j++) {
+      const CurveMapPoint *point_a = &cuma_a->curve[j];
+      const CurveMapPoint *point_b = &cuma_b->curve[j];
+      if (point_a->x != point_b->x || point_a->y != point_b->y ||
+          point_a->flag != point_b->flag) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool display_lut_matches(const DisplayLUT *lut,
+                                const char *from_colorspace,
+                                const ColorManagedViewSettings *view_settings,
+                                const ColorManagedDisplaySettings *display_settings)
+{
+  return STREQ(lut->from_colorspace, from_colorspace) && STREQ(lut->look, view_settings->look) &&
+         STREQ(lut->view_transform, view_settings->view_transform) &&
+         STREQ(lut->display_device, display_settings->display_device) &&
+         lut->exposure == view_settings->exposure && lut->gamma == view_settings->gamma &&
+         display_lut_curve_mapping_equals(lut->curve_mapping,
+                                          display_lut_view_curve_mapping(view_settings));
+}
+
+/**
+ * Display transforms are usually steep for dark colors (especially after conversion to scene
+ * linear), so the grid is denser there.
+ */
+static int display_lut_grid_step(int value)
+{
+  if (value < 4) {
+    return 1;
+  }
+  if (value < 16) {
+    return 2;
+  }
+  if (value < 40) {
+    return 3;
+  }
+  return 5;
+}
+
+static void display_lut_bake(DisplayLUT *lut, ColormanageProcessor *cm_processor)
+{
+  float *entry;
+  int i, r, g, b;
+
+  for (i = 0; i < DISPLAY_LUT_SIZE; i++) {
+    lut->grid[i] = (i == 0) ? 0 : lut->grid[i - 1] + display_lut_grid_step(lut->grid[i - 1]);
+  }
+  BLI_assert(lut->grid[DISPLAY_LUT_SIZE - 1] == 255);
+
+  for (i = 0; i < DISPLAY_LUT_SIZE - 1; i++) {
+    const int range = lut->grid[i + 1] - lut->grid[i];
+    for (int value = lut->grid[i]; value <= lut->grid[i + 1]; value++) {
+      lut->grid_index[value] = i;
+      lut->grid_weight[value] = (float)(value - lut->grid[i]) / (float)range;
+    }
+  }
+
+  lut->table = MEM_mallocN(sizeof(float[4]) * DISPLAY_LUT_ENTRIES, "display LUT");
+
+  /* Same conversion as #display_buffer_apply_get_linear_buffer does for byte buffers. */
+  entry = lut->table;
+  for (b = 0; b < DISPLAY_LUT_SIZE; b++) {
+    for (g = 0; g < DISPLAY_LUT_SIZE; g++) {
+      for (r = 0; r < DISPLAY_LUT_SIZE; r++, entry += 4) {
+        entry[0] = ((float)lut->grid[r]) * (1.0f / 255.0f);
+        entry[1] = ((float)lut->grid[g]) * (1.0f / 255.0f);
+        entry[2] = ((float)lut->grid[b]) * (1.0f / 255.0f);
+        entry[3] = 1.0f;
+      }
+    }
+  }
+
+  if (!cm_processor->is_data_result) {
+    IMB_colormanagement_transform(lut->table,
+                                  DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE,
+                                  DISPLAY_LUT_SIZE,
+                                  4,
+                                  lut->from_colorspace,
+                                  global_role_scene_linear,
+                                  false);
+  }
+
+  IMB_colormanagement_processor_apply(cm_processor,
+                                      lut->table,
+                                      DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE,
+                                      DISPLAY_LUT_SIZE,
+                                      4,
+                                      false);
+}
+
+static void display_lut_free(DisplayLUT *lut)
+{
+  if (lut->curve_mapping) {
+    BKE_curvemapping_free(lut->curve_mapping);
+  }
+  MEM_freeN(lut->table);
+  MEM_freeN(lut);
+}
+
+static DisplayLUT *display_lut_find(const char *from_colorspace,
+                                    const ColorManagedViewSettings *view_settings,
+                                    const ColorManagedDisplaySettings *display_settings)
+{
+  LISTBASE_FOREACH (DisplayLUT *, lut, &global_display_luts) {
+    if (display_lut_matches(lut, from_colorspace, view_settings, display_settings)) {
+      return lut;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Get the LUT for the given settings, baking it with \a cm_processor when it doesn't exist yet
+ * and \a allow_bake is set. Must be released with #display_lut_release.
+ *
+ * Baking is done without holding the lock, so threads computing display buffers for other
+ * settings are not blocked by it. When several threads bake the same LUT, the first one to
+ * finish is kept.
+ */
+static DisplayLUT *display_lut_acquire(ColormanageProcessor *cm_processor,
+                                       const char *from_colorspace,
+                                       const ColorManagedViewSettings *view_settings,
+                                       const ColorManagedDisplaySettings *display_settings,
+                                       bool allow_bake)
+{
+  DisplayLUT *lut, *lut_baked = NULL;
+
+  BLI_mutex_lock(&display_lut_lock);
+  lut = display_lut_find(from_colorspace, view_settings, display_settings);
+  if (lut == NULL && allow_bake) {
+    BLI_mutex_unlock(&display_lut_lock);
+
+    CurveMapping *curve_mapping = display_lut_view_curve_mapping(view_settings);
+
+    lut_baked = MEM_callocN(sizeof(DisplayLUT), "display LUT settings");
+    STRNCPY(lut_baked->from_colorspace, from_colorspace);
+    STRNCPY(lut_baked->look, view_settings->look);
+    STRNCPY(lut_baked->view_transform, view_settings->view_transform);
+    STRNCPY(lut_baked->display_device, display_settings->display_device);
+    lut_baked->exposure = view_settings->exposure;
+    lut_baked->gamma = view_settings->gamma;
+    if (curve_mapping) {
+      lut_baked->curve_mapping = BKE_curvemapping_copy(curve_mapping);
+    }
+
+    display_lut_bake(lut_baked, cm_processor);
+
+    BLI_mutex_lock(&display_lut_lock);
+    lut = display_lut_find(from_colorspace, view_settings, display_settings);
+    if (lut == NULL) {
+      /* Free least recently used LUTs which are not in use. */
+      int luts_num = BLI_listbase_count(&global_display_luts);
+      DisplayLUT *lut_old = global_display_luts.last;
+      while (lut_old && luts_num >= DISPLAY_LUT_CACHE_MAX) {
+        DisplayLUT *lut_old_prev = lut_old->prev;
+        if (lut_old->users == 0) {
+          BLI_remlink(&global_display_luts, lut_old);
+          display_lut_free(lut_old);
+          luts_num--;
+        }
+        lut_old = lut_old_prev;
+      }
+
+      BLI_addhead(&global_display_luts, lut_baked);
+      lut = lut_baked;
+      lut_baked = NULL;
+    }
+  }
+
+  if (lut) {
+    /* Most recently used first. */
+    BLI_remlink(&global_display_luts, lut);
+    BLI_addhead(&global_display_luts, lut);
+    lut->users++;
+  }
+
+  BLI_mutex_unlock(&display_lut_lock);
+
+  if (lut_baked) {
+    /* Another thread baked the same LUT in the meantime. */
+    display_lut_free(lut_baked);
+  }
+
+  return lut;
+}
+
+static void display_lut_release(DisplayLUT *lut)
+{
+  BLI_mutex_lock(&display_lut_lock);
+  lut->users--;
+  BLI_mutex_unlock(&display_lut_lock);
+}
+
+static void display_lut_free_all(void)
+{
+  DisplayLUT *lut = global_display_luts.first;
+  while (lut) {
+    DisplayLUT *lut_next = lut->next;
+    BLI_assert(lut->users == 0);
+    display_lut_free(lut);
+    lut = lut_next;
+  }
+  BLI_listbase_clear(&global_display_luts);
+}
+
+void IMB_colormanagement_display_lut_set_enabled(bool enabled)
+{
+  global_display_lut_enabled = enabled;
+}
+
+/**
+ * Trilinear interpolation of the display color of a byte pixel, alpha is kept as is.
+ */
+BLI_INLINE void display_lut_evaluate(const DisplayLUT *lut,
+                                     const unsigned char pixel[4],
+                                     float r_color[4])
+{
+  const float *table = lut->table;
+  int index[3];
+  float weight[3];
+
+  for (int i = 0; i < 3; i++) {
+    index[i] = lut->grid_index[pixel[i]];
+    weight[i] = lut->grid_weight[pixel[i]];
+  }
+
+  const int stride_r = 4;
+  const int stride_g = 4 * DISPLAY_LUT_SIZE;
+  const int stride_b = 4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE;
+  const float *c000 = table + index[2] * stride_b + index[1] * stride_g + index[0] * stride_r;
+  const float *c010 = c000 + stride_g;
+  const float *c001 = c000 + stride_b;
+  const float *c011 = c001 + stride_g;
+
+#ifdef BLI_HAVE_SSE2
+  /* All channels of an entry at once. */
+  const __m128 weight_r = _mm_set1_ps(weight[0]);
+  const __m128 weight_g = _mm_set1_ps(weight[1]);
+  const __m128 weight_b = _mm_set1_ps(weight[2]);
+#  define LERP(a, b, t) _mm_add_ps((a), _mm_mul_ps(_mm_sub_ps((b), (a)), (t)))
+  const __m128 c00 = LERP(_mm_loadu_ps(c000), _mm_loadu_ps(c000 + stride_r), weight_r);
+  const __m128 c10 = LERP(_mm_loadu_ps(c010), _mm_loadu_ps(c010 + stride_r), weight_r);
+  const __m128 c01 = LERP(_mm_loadu_ps(c001), _mm_loadu_ps(c001 + stride_r), weight_r);
+  const __m128 c11 = LERP(_mm_loadu_ps(c011), _mm_loadu_ps(c011 + stride_r), weight_r);
+  const __m128 c0 = LERP(c00, c10, weight_g);
+  const __m128 c1 = LERP(c01, c11, weight_g);
+  _mm_storeu_ps(r_color, LERP(c0, c1, weight_b));
+#  undef LERP
+#else
+  float c00[3], c10[3], c01[3], c11[3], c0[3], c1[3];
+  interp_v3_v3v3(c00, c000, c000 + stride_r, weight[0]);
+  interp_v3_v3v3(c10, c010, c010 + stride_r, weight[0]);
+  interp_v3_v3v3(c01, c001, c001 + stride_r, weight[0]);
+  interp_v3_v3v3(c11, c011, c011 + stride_r, weight[0]);
+  interp_v3_v3v3(c0, c00, c10, weight[1]);
+  interp_v3_v3v3(c1, c01, c11, weight[1]);
+  interp_v3_v3v3(r_color, c0, c1, weight[2]);
+#endif
+
+  r_color[3] = ((float)pixel[3]) * (1.0f / 255.0f);
+}
+
+static void display_lut_apply_byte(const DisplayLUT *lut,
+                                   const unsigned char *byte_buffer,
+                                   unsigned char *display_buffer,
+                                   size_t pixels_num)
+{
+  for (size_t i = 0; i < pixels_num; i++, byte_buffer += 4, display_buffer += 4) {
+    float color[4];
+    display_lut_evaluate(lut, byte_buffer, color);
+    unit_float_to_uchar_clamp_v3(display_buffer, color);
+    display_buffer[3] = byte_buffer[3];
+  }
+}
+
+static void display_lut_apply_float(const DisplayLUT *lut,
+                                    const unsigned char *byte_buffer,
+                                    float *linear_buffer,
+                                    size_t pixels_num)
+{
+  for (size_t i = 0; i < pixels_num; i++, byte_buffer += 4, linear_buffer += 4) {
+    display_lut_evaluate(lut, byte_buffer, linear_buffer);
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Threaded Display Buffer Transform Routines
  * \{ */
 
 typedef struct DisplayBufferThread {
   ColormanageProcessor *cm_processor;
+  /** Baked transform of byte colors to use instead of #cm_processor. */
+  const DisplayLUT *display_lut;
 
   const float *buffer;
   unsigned char *byte_buffer;
@@ -1462,6 +1833,7 @@ typedef struct DisplayBufferThread {
 typedef struct DisplayBufferInitData {
   ImBuf *ibuf;
   ColormanageProcessor *cm_processor;
+  const DisplayLUT *display_lut;
   const float *buffer;
   unsigned char *byte_buffer;
 
@@ -1493,6 +1865,7 @@ static void display_buffer_init_handle(void *handle_v,
   memset(handle, 0, sizeof(DisplayBufferThread));
 
   handle->cm_processor = init_data->cm_processor;
+  handle->display_lut = init_data->display_lut;
 
   if (init_data->buffer) {
     handle->buffer = init_data->buffer + offset;
@@ -1640,18 +2013,30 @@ static void *do_display_buffer_apply_thread(void *handle_v)
                                  width);
     }
   }
+  else if (handle->display_lut && display_buffer == NULL && dither == 0.0f) {
+    /* Baked transform straight from the byte buffer to the display buffer. */
+    display_lut_apply_byte(
+        handle->display_lut, handle->byte_buffer, display_buffer_byte, ((size_t)width) * height);
+  }
   else {
     bool is_straight_alpha;
     float *linear_buffer = MEM_mallocN(((size_t)channels) * width * height * sizeof(float),
                                        "color conversion linear buffer");
 
-    display_buffer_apply_get_linear_buffer(handle, height, linear_buffer, &is_straight_alpha);
+    if (handle->display_lut) {
+      display_lut_apply_float(
+          handle->display_lut, handle->byte_buffer, linear_buffer, ((size_t)width) * height);
+      is_straight_alpha = true;
+    }
+    else {
+      display_buffer_apply_get_linear_buffer(handle, height, linear_buffer, &is_straight_alpha);
+    }
 
     bool predivide = handle->predivide && (is_straight_alpha == false);
 
-    if (is_data) {
+    if (is_data || handle->display_lut) {
       /* special case for data buffers - no color space conversions,
-       * only generate byte buffers
+       * only generate byte buffers (also when the LUT already applied the transform)
        */
     }
     else {
@@ -1701,12 +2086,14 @@ static void display_buffer_apply_threaded(ImBuf *ibuf,
                                           unsigned char *byte_buffer,
                                           float *display_buffer,
                                           unsigned char *display_buffer_byte,
-                                          ColormanageProcessor *cm_processor)
+                                          ColormanageProcessor *cm_processor,
+                                          const DisplayLUT *display_lut)
 {
   DisplayBufferInitData init_data;
 
   init_data.ibuf = ibuf;
   init_data.cm_processor = cm_processor;
+  init_data.display_lut = display_lut;
   init_data.buffer = buffer;
   init_data.byte_buffer = byte_buffer;
   init_data.display_buffer = display_buffer;
@@ -1758,14 +2145,25 @@ static bool is_ibuf_rect_in_display_space(ImBuf *ibuf,
   return false;
 }
 
+/**
+ * Whether the display transform of the byte buffer of \a ibuf can use a #DisplayLUT.
+ */
+static bool display_lut_supported(const ImBuf *ibuf)
+{
+  return ibuf->rect_float == NULL && ibuf->rect != NULL && ibuf->channels == 4 &&
+         (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA) == 0;
+}
+
 static void colormanage_display_buffer_process_ex(
     ImBuf *ibuf,
     float *display_buffer,
     unsigned char *display_buffer_byte,
     const ColorManagedViewSettings *view_settings,
-    const ColorManagedDisplaySettings *display_settings)
+    const ColorManagedDisplaySettings *display_settings,
+    bool use_display_lut)
 {
   ColormanageProcessor *cm_processor = NULL;
+  DisplayLUT *display_lut = NULL;
   bool skip_transform = false;
 
   /* if we're going to transform byte buffer, check whether transformation would
@@ -1779,6 +2177,16 @@ static void colormanage_display_buffer_process_ex(
 
   if (skip_transform == false) {
     cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+
+    if (use_display_lut && global_display_lut_enabled && view_settings &&
+        display_lut_supported(ibuf)) {
+      const char *from_colorspace = ibuf->rect_colorspace ? ibuf->rect_colorspace->name :
+                                                            global_role_default_byte;
+      /* Baking costs about as much as transforming an image with as many pixels. */
+      const bool allow_bake = ((size_t)ibuf->x) * ibuf->y >= DISPLAY_LUT_ENTRIES;
+      display_lut = display_lut_acquire(
+          cm_processor, from_colorspace, view_settings, display_settings, allow_bake);
+    }
   }
 
   display_buffer_apply_threaded(ibuf,
@@ -1786,7 +2194,12 @@ static void colormanage_display_buffer_process_ex(
                                 (unsigned char *)ibuf->rect,
                                 display_buffer,
                                 display_buffer_byte,
-                                cm_processor);
+                                cm_processor,
+                                display_lut);
+
+  if (display_lut) {
+    display_lut_release(display_lut);
+  }
 
   if (cm_processor) {
     IMB_colormanagement_processor_free(cm_processor);
@@ -1799,7 +2212,7 @@ static void colormanage_display_buffer_process(ImBuf *ibuf,
                                                const ColorManagedDisplaySettings *display_settings)
 {
   colormanage_display_buffer_process_ex(
-      ibuf, NULL, display_buffer, view_settings, display_settings);
+      ibuf, NULL, display_buffer, view_settings, display_settings, true);
 }
 
 /** \} */
@@ -2456,8 +2869,12 @@ static void colormanagement_imbuf_make_display_space(
     imb_addrectImBuf(ibuf);
   }
 
-  colormanage_display_buffer_process_ex(
-      ibuf, ibuf->rect_float, (unsigned char *)ibuf->rect, view_settings, display_settings);
+  colormanage_display_buffer_process_ex(ibuf,
+                                        ibuf->rect_float,
+                                        (unsigned char *)ibuf->rect,
+                                        view_settings,
+                                        display_settings,
+                                        false);
 }
 
 void IMB_colormanagement_imbuf_make_display_space(
@@ -7,6 +7,8 @@
 
 #undef DEBUG_MESSAGES
 
+#include <cfloat>
+#include <cmath>
 #include <cstdlib> /* for qsort */
 #include <memory.h>
 #include <mutex>
@@ -15,11 +17,14 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_ghash.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #include "IMB_moviecache.h"
 
 #include "IMB_imbuf.h"
@@ -43,6 +48,11 @@ static MEM_CacheLimiterC *limitor = nullptr;
  * so regular mutex will not work here, hence the recursive lock. */
 static std::recursive_mutex limitor_lock;
 
+/* Average time in seconds it takes to load a byte of the buffers which know their load time,
+ * used as the cost of buffers which don't (results of processing, display buffers...).
+ * Protected by #limitor_lock. */
+static float cost_per_byte = 2e-9f;
+
 struct MovieCache {
   char name[64];
 
@@ -77,6 +87,10 @@ struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  /* Time in seconds it takes to get #ibuf back once freed, zero when unknown. */
+  float cost;
+  /* Last time #ibuf was put in or taken from the cache, see #PIL_check_seconds_timer. */
+  double last_access;
   /* Indicates that #ibuf is null, because there was an error during load. */
   bool added_empty;
 };
@@ -206,27 +220,28 @@ static size_t get_item_size(void *p)
   return size;
 }
 
-static int get_item_priority(void *item_v, int default_priority)
+static int moviecache_value_to_priority(float value)
+{
+  /* Logarithmic scale, so values of very different magnitude still compare correctly. */
+  return int(log2f(max_ff(value, FLT_MIN)) * 256.0f);
+}
+
+static int get_item_priority(void *item_v, int UNUSED(default_priority))
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
   MovieCache *cache = item->cache_owner;
-  int priority;
-
-  if (!cache->getitempriorityfp) {
-    PRINT("%s: cache '%s' item %p use default priority %d\n",
-          __func__,
-          cache->name,
-          item,
-          default_priority);
+  float value = IMB_moviecache_frame_value(
+      item->cost, item->ibuf ? get_size_in_memory(item->ibuf) : 0, item->last_access);
 
-    return default_priority;
+  if (cache->getitempriorityfp) {
+    /* The callbacks give 0 to the most important item, less important items get lower values. */
+    const int priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+    value /= 1.0f + float(abs(priority));
   }
 
-  priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+  PRINT("%s: cache '%s' item %p value %g\n", __func__, cache->name, item, value);
 
-  PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
-
-  return priority;
+  return moviecache_value_to_priority(value);
 }
 
 static bool get_item_destroyable(void *item_v)
@@ -262,6 +277,41 @@ void IMB_moviecache_destruct(void)
   }
 }
 
+float IMB_moviecache_frame_value(float cost, size_t size, double last_access)
+{
+  if (size == 0) {
+    return FLT_MAX;
+  }
+
+  if (cost <= 0.0f) {
+    limitor_lock.lock();
+    cost = cost_per_byte * float(size);
+    limitor_lock.unlock();
+  }
+
+  /* Frames which haven't been used for a while are less likely to be needed again soon. */
+  const double age = max_dd(PIL_check_seconds_timer() - last_access, 0.0);
+
+  return float(double(cost) / double(size) / (1.0 + age));
+}
+
+size_t IMB_moviecache_free_less_valuable(float value, size_t size)
+{
+  size_t freed;
+
+  if (!limitor) {
+    return 0;
+  }
+
+  limitor_lock.lock();
+  freed = MEM_CacheLimiter_free_lower_priority(limitor, moviecache_value_to_priority(value), size);
+  limitor_lock.unlock();
+
+  PRINT("%s: freed %zu bytes of frames less valuable than %g\n", __func__, freed, value);
+
+  return freed;
+}
+
 MovieCache *IMB_moviecache_create(const char *name,
                                   int keysize,
                                   GHashHashFP hashfp,
@@ -332,6 +382,8 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   item->cache_owner = cache;
   item->c_handle = nullptr;
   item->priority_data = nullptr;
+  item->cost = ibuf ? ibuf->load_time : 0.0f;
+  item->last_access = PIL_check_seconds_timer();
   item->added_empty = ibuf == nullptr;
 
   if (cache->getprioritydatafp) {
@@ -348,6 +400,12 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     limitor_lock.lock();
   }
 
+  if (item->cost > 0.0f) {
+    /* Running average, so the estimate follows the kind of media being played back. */
+    const float size = float(max_zz(IMB_get_size_in_memory(ibuf), 1));
+    cost_per_byte += (item->cost / size - cost_per_byte) * 0.1f;
+  }
+
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
 
   MEM_CacheLimiter_ref(item->c_handle);
@@ -414,6 +472,7 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey, bool *r_is_cached_em
   if (item) {
     if (item->ibuf) {
       limitor_lock.lock();
+      item->last_access = PIL_check_seconds_timer();
       MEM_CacheLimiter_touch(item->c_handle);
       limitor_lock.unlock();
 
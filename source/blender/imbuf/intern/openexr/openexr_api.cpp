@@ -16,6 +16,7 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 /* The OpenEXR version can reliably be found in this header file from OpenEXR,
  * for both 2.x and 3.x:
@@ -83,10 +84,13 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 #endif
 }
 #include "BLI_blenlib.h"
+#include "BLI_enumerable_thread_specific.hh"
 #include "BLI_fileops.h"
 #include "BLI_math_color.h"
 #include "BLI_mmap.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -128,6 +132,12 @@ class IMemStream : public Imf::IStream {
     _exrbuf = exrbuf;
   }
 
+  /** Another stream reading the same memory, with its own position. */
+  IMemStream *duplicate() const
+  {
+    return new IMemStream(_exrbuf, _exrsize);
+  }
+
   bool read(char c[], int n) override
   {
     if (n + _exrpos <= _exrsize) {
@@ -1164,6 +1174,34 @@ void IMB_exr_clear_channels(void *handle)
   BLI_freelistN(&data->channels);
 }
 
+/** Conversion of the float channels written as half float, see #IMB_exr_write_channels. */
+struct ExrHalfChannel {
+  const float *rect;
+  size_t xstride;
+  half *rect_half;
+};
+
+struct ExrHalfConversion {
+  std::vector<ExrHalfChannel> channels;
+  int width;
+};
+
+static void exr_half_conversion_row(void *__restrict userdata,
+                                    const int y,
+                                    const TaskParallelTLS *__restrict /*tls*/)
+{
+  const ExrHalfConversion *conversion = (const ExrHalfConversion *)userdata;
+  const size_t row_offset = ((size_t)y) * conversion->width;
+
+  for (const ExrHalfChannel &channel : conversion->channels) {
+    const float *rect = channel.rect + row_offset * channel.xstride;
+    half *cur = channel.rect_half + row_offset;
+    for (int x = 0; x < conversion->width; x++, cur++) {
+      *cur = float_to_half_safe(rect[x * channel.xstride]);
+    }
+  }
+}
+
 void IMB_exr_write_channels(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
@@ -1173,6 +1211,8 @@ void IMB_exr_write_channels(void *handle)
   if (data->channels.first) {
     const size_t num_pixels = ((size_t)data->width) * data->height;
     half *rect_half = nullptr, *current_rect_half = nullptr;
+    ExrHalfConversion half_conversion;
+    half_conversion.width = data->width;
 
     /* We allocate temporary storage for half pixels for all the channels at once. */
     if (data->num_half_channels != 0) {
@@ -1184,11 +1224,9 @@ void IMB_exr_write_channels(void *handle)
     for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
       /* Writing starts from last scan-line, stride negative. */
       if (echan->use_half_float) {
-        float *rect = echan->rect;
-        half *cur = current_rect_half;
-        for (size_t i = 0; i < num_pixels; i++, cur++) {
-          *cur = float_to_half_safe(rect[i * echan->xstride]);
-        }
+        /* Converted below, for all channels at once. */
+        half_conversion.channels.push_back(
+            {echan->rect, (size_t)echan->xstride, current_rect_half});
         half *rect_to_write = current_rect_half + (data->height - 1L) * data->width;
         frameBuffer.insert(
             echan->name,
@@ -1205,6 +1243,14 @@ void IMB_exr_write_channels(void *handle)
       }
     }
 
+    if (!half_conversion.channels.empty()) {
+      TaskParallelSettings settings;
+      BLI_parallel_range_settings_defaults(&settings);
+      settings.min_iter_per_thread = 16;
+      BLI_task_parallel_range(
+          0, data->height, &half_conversion, exr_half_conversion_row, &settings);
+    }
+
     data->ofile->setFrameBuffer(frameBuffer);
     try {
       data->ofile->writePixels(data->height);
@@ -1273,6 +1319,106 @@ void IMB_exrtile_write_channels(
   }
 }
 
+/** Range of scan-lines of a part, read by one task of #IMB_exr_read_channels. */
+struct ExrReadTask {
+  int part;
+  int ymin, ymax;
+};
+
+struct ExrReadData {
+  ExrHandle *handle;
+  std::vector<FrameBuffer> frame_buffers;
+  std::vector<ExrReadTask> tasks;
+};
+
+/**
+ * Number of scan-lines compressed together in a block. Reading a range of lines decompresses
+ * all the blocks it overlaps, so ranges read in parallel are aligned to blocks.
+ */
+static int exr_compression_block_lines(const Compression compression)
+{
+  switch (compression) {
+    case NO_COMPRESSION:
+    case RLE_COMPRESSION:
+    case ZIPS_COMPRESSION:
+      return 1;
+    case ZIP_COMPRESSION:
+    case PXR24_COMPRESSION:
+      return 16;
+    case PIZ_COMPRESSION:
+    case B44_COMPRESSION:
+    case B44A_COMPRESSION:
+    case DWAA_COMPRESSION:
+      return 32;
+    case DWAB_COMPRESSION:
+      return 256;
+    default:
+      return 1;
+  }
+}
+
+/**
+ * File reading the pixels of #IMB_exr_read_channels on one thread, with its own stream on the
+ * same memory or file. Blocks are then read and decompressed concurrently instead of taking turns
+ * on the stream of the handle. The OpenEXR thread pool is not used by these files, the tasks
+ * already use all threads.
+ */
+struct ExrThreadReader {
+  IStream *stream = nullptr;
+  MultiPartInputFile *file = nullptr;
+  bool open_failed = false;
+
+  ExrThreadReader() = default;
+  ExrThreadReader(const ExrThreadReader &other) = delete;
+  ExrThreadReader &operator=(const ExrThreadReader &other) = delete;
+
+  ~ExrThreadReader()
+  {
+    delete file;
+    delete stream;
+  }
+
+  /** Open the file of \a handle_stream, once for every thread. */
+  bool ensure_open(IStream &handle_stream)
+  {
+    if (file || open_failed) {
+      return file != nullptr;
+    }
+    try {
+      IMemStream *mem_stream = dynamic_cast<IMemStream *>(&handle_stream);
+      if (mem_stream) {
+        stream = mem_stream->duplicate();
+      }
+      else {
+        stream = new IFileStream(handle_stream.fileName());
+      }
+      file = new MultiPartInputFile(*stream, 0);
+    }
+    catch (const std::exception &exc) {
+      std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+      open_failed = true;
+      return false;
+    }
+    return true;
+  }
+};
+
+static void exr_read_task_pixels(const ExrReadData &read_data,
+                                 const ExrReadTask &task,
+                                 MultiPartInputFile &file)
+{
+  try {
+    InputPart in(file, task.part);
+    in.setFrameBuffer(read_data.frame_buffers[task.part]);
+    exr_printf(
+        "readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", task.part, task.ymin, task.ymax);
+    in.readPixels(task.ymin, task.ymax);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+  }
+}
+
 void IMB_exr_read_channels(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
@@ -1293,14 +1439,34 @@ void IMB_exr_read_channels(void *handle)
       "name",
       "internal_name");
 
+  /* Frame-buffers of all parts are set up first, then parts are read in ranges of scan-lines
+   * by parallel tasks. */
+  ExrReadData read_data;
+  read_data.handle = data;
+  read_data.frame_buffers.resize(numparts);
+  const int threads_num = BLI_system_thread_count();
+
   for (int i = 0; i < numparts; i++) {
     /* Read part header. */
     InputPart in(*data->ifile, i);
     Header header = in.header();
     Box2i dw = header.dataWindow();
 
+    /* Split scan-line parts in about as many ranges as there are threads, tiled parts are read
+     * at once. Ranges are not made too small, every readPixels call has some overhead. */
+    const int part_height = dw.max.y - dw.min.y + 1;
+    int range_lines = part_height;
+    if (!header.hasTileDescription() && threads_num > 1) {
+      const int block_lines = exr_compression_block_lines(header.compression());
+      range_lines = max_ii((part_height + threads_num - 1) / threads_num, 64);
+      range_lines = (range_lines + block_lines - 1) / block_lines * block_lines;
+    }
+    for (int ymin = dw.min.y; ymin <= dw.max.y; ymin += range_lines) {
+      read_data.tasks.push_back({i, ymin, min_ii(ymin + range_lines - 1, dw.max.y)});
+    }
+
     /* Insert all matching channel into frame-buffer. */
-    FrameBuffer frameBuffer;
+    FrameBuffer &frameBuffer = read_data.frame_buffers[i];
     ExrChannel *echan;
 
     for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
@@ -1338,18 +1504,24 @@ void IMB_exr_read_channels(void *handle)
         printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
       }
     }
+  }
 
-    /* Read pixels. */
-    try {
-      in.setFrameBuffer(frameBuffer);
-      exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", i, dw.min.y, dw.max.y);
-      in.readPixels(dw.min.y, dw.max.y);
-    }
-    catch (const std::exception &exc) {
-      std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
-      break;
-    }
+  /* Read pixels. */
+  if (read_data.tasks.size() == 1) {
+    exr_read_task_pixels(read_data, read_data.tasks[0], *data->ifile);
+    return;
   }
+  blender::threading::EnumerableThreadSpecific<ExrThreadReader> readers;
+  blender::threading::parallel_for(
+      blender::IndexRange(read_data.tasks.size()), 1, [&](const blender::IndexRange range) {
+        ExrThreadReader &reader = readers.local();
+        if (!reader.ensure_open(*data->ifile_stream)) {
+          return;
+        }
+        for (const int64_t i : range) {
+          exr_read_task_pixels(read_data, read_data.tasks[i], *reader.file);
+        }
+      });
 }
 
 void IMB_exr_multilayer_convert(void *handle,
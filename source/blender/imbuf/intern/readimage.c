@@ -18,6 +18,8 @@
 #include "BLI_utildefines.h"
 #include <stdlib.h>
 
+#include "PIL_time.h"
+
 #include "IMB_allocimbuf.h"
 #include "IMB_filetype.h"
 #include "IMB_imbuf.h"
@@ -211,6 +213,7 @@ ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_S
   ImBuf *ibuf;
   int file, a;
   char filepath_tx[IMB_FILENAME_SIZE];
+  const double start_time = PIL_check_seconds_timer();
 
   BLI_assert(!BLI_path_is_rel(filepath));
 
@@ -229,6 +232,7 @@ ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_S
     for (a = 1; a < ibuf->miptot; a++) {
       BLI_strncpy(ibuf->mipmap[a - 1]->cachename, filepath_tx, sizeof(ibuf->cachename));
     }
+    ibuf->load_time = (float)(PIL_check_seconds_timer() - start_time);
   }
 
   close(file);
@@ -9,6 +9,8 @@
 
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_math_vector.h"
+#include "BLI_simd.h"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
@@ -888,498 +890,541 @@ static bool q_scale_linear_interpolation(struct ImBuf *ibuf, int newx, int newy)
   return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
+/* -------------------------------------------------------------------- */
+/** \name Separable Scaling
+ *
+ * #IMB_scaleImBuf scales along one axis at a time. All rows (or columns) of the image use the
+ * same source pixels and weights, which are computed once as "steps", one per destination pixel.
+ * Lines are then scaled in parallel, with the 4 channels of a pixel processed together.
+ * The arithmetic (and so the result) is the same as scaling pixel by pixel.
+ * \{ */
+
+#ifdef BLI_HAVE_SSE2
+typedef __m128 ScalePixel;
+#else
+typedef struct ScalePixel {
+  float v[4];
+} ScalePixel;
+#endif
+
+BLI_INLINE ScalePixel scale_pixel_load_byte(const uchar src[4])
 {
-  const bool do_rect = (ibuf->rect != NULL);
-  const bool do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = IMB_get_rect_len(ibuf) * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y;
-
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-  if (!do_rect && !do_float) {
-    return ibuf;
-  }
+#ifdef BLI_HAVE_SSE2
+  int packed;
+  memcpy(&packed, src, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i src16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(src16, zero));
+#else
+  ScalePixel r = {{src[0], src[1], src[2], src[3]}};
+  return r;
+#endif
+}
 
-  if (do_rect) {
-    _newrect = MEM_mallocN(sizeof(uchar[4]) * newx * ibuf->y, "scaledownx");
-    if (_newrect == NULL) {
-      return ibuf;
-    }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scaledownxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
-  }
+BLI_INLINE ScalePixel scale_pixel_load_float(const float src[4])
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_loadu_ps(src);
+#else
+  ScalePixel r = {{src[0], src[1], src[2], src[3]}};
+  return r;
+#endif
+}
 
-  add = (ibuf->x - 0.01) / newx;
+BLI_INLINE ScalePixel scale_pixel_zero(void)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_setzero_ps();
+#else
+  ScalePixel r = {{0.0f, 0.0f, 0.0f, 0.0f}};
+  return r;
+#endif
+}
 
-  if (do_rect) {
-    rect = (uchar *)ibuf->rect;
-    newrect = _newrect;
-  }
-  if (do_float) {
-    rectf = ibuf->rect_float;
-    newrectf = _newrectf;
-  }
+BLI_INLINE ScalePixel scale_pixel_negate(ScalePixel a)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_xor_ps(a, _mm_set1_ps(-0.0f));
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] = -a.v[i];
+  }
+  return a;
+#endif
+}
 
-  for (y = ibuf->y; y > 0; y--) {
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+BLI_INLINE ScalePixel scale_pixel_add(ScalePixel a, const ScalePixel b)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_add_ps(a, b);
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] += b.v[i];
+  }
+  return a;
+#endif
+}
 
-    for (x = newx; x > 0; x--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
+BLI_INLINE ScalePixel scale_pixel_sub(ScalePixel a, const ScalePixel b)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_sub_ps(a, b);
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] -= b.v[i];
+  }
+  return a;
+#endif
+}
 
-      sample += add;
+BLI_INLINE ScalePixel scale_pixel_add_fl(ScalePixel a, const float f)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_add_ps(a, _mm_set1_ps(f));
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] += f;
+  }
+  return a;
+#endif
+}
 
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
+BLI_INLINE ScalePixel scale_pixel_mul_fl(ScalePixel a, const float f)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_mul_ps(a, _mm_set1_ps(f));
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] *= f;
+  }
+  return a;
+#endif
+}
 
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += 4;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += 4;
-        }
-      }
+BLI_INLINE ScalePixel scale_pixel_div_fl(ScalePixel a, const float f)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_div_ps(a, _mm_set1_ps(f));
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] /= f;
+  }
+  return a;
+#endif
+}
 
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += 4;
-
-        newrect[0] = roundf((nval[0] + sample * val[0]) / add);
-        newrect[1] = roundf((nval[1] + sample * val[1]) / add);
-        newrect[2] = roundf((nval[2] + sample * val[2]) / add);
-        newrect[3] = roundf((nval[3] + sample * val[3]) / add);
-
-        newrect += 4;
-      }
-      if (do_float) {
+BLI_INLINE void scale_pixel_store_float(float dst[4], const ScalePixel a)
+{
+#ifdef BLI_HAVE_SSE2
+  _mm_storeu_ps(dst, a);
+#else
+  copy_v4_v4(dst, a.v);
+#endif
+}
 
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += 4;
+#ifdef BLI_HAVE_SSE2
+BLI_INLINE void scale_pixel_store_byte_sse2(uchar dst[4], const __m128i a)
+{
+  const __m128i a16 = _mm_packs_epi32(a, a);
+  const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(a16, a16));
+  memcpy(dst, &packed, sizeof(packed));
+}
+#endif
 
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
+/** Store non-negative values rounded like `roundf`. */
+BLI_INLINE void scale_pixel_store_byte_round(uchar dst[4], const ScalePixel a)
+{
+#ifdef BLI_HAVE_SSE2
+  /* Round half away from zero (the SSE conversion rounds half to even). */
+  const __m128 a_trunc = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+  const __m128 round_up = _mm_cmpge_ps(_mm_sub_ps(a, a_trunc), _mm_set1_ps(0.5f));
+  const __m128 a_round = _mm_add_ps(a_trunc, _mm_and_ps(round_up, _mm_set1_ps(1.0f)));
+  scale_pixel_store_byte_sse2(dst, _mm_cvttps_epi32(a_round));
+#else
+  for (int i = 0; i < 4; i++) {
+    dst[i] = roundf(a.v[i]);
+  }
+#endif
+}
 
-        newrectf += 4;
-      }
+/** Store non-negative values truncated. */
+BLI_INLINE void scale_pixel_store_byte_trunc(uchar dst[4], const ScalePixel a)
+{
+#ifdef BLI_HAVE_SSE2
+  scale_pixel_store_byte_sse2(dst, _mm_cvttps_epi32(a));
+#else
+  for (int i = 0; i < 4; i++) {
+    dst[i] = a.v[i];
+  }
+#endif
+}
 
+/**
+ * Source pixels of a destination pixel when scaling down: the source pixel before the first one
+ * is partially subtracted, the next ones are added and the last one is partially added.
+ */
+typedef struct ScaleDownStep {
+  /** Index of the first source pixel. */
+  int src_index;
+  /** Number of source pixels added entirely. */
+  int whole_num;
+  /** Weight of the pixel before #src_index. */
+  float sample_prev;
+  /** Weight of the last source pixel, after the whole ones. */
+  float sample_last;
+} ScaleDownStep;
+
+static ScaleDownStep *scaledown_steps_create(const int newlen, const float add)
+{
+  ScaleDownStep *steps = MEM_mallocN(sizeof(*steps) * newlen, __func__);
+  float sample = 0.0f;
+  int src_index = 0;
+
+  for (int i = 0; i < newlen; i++) {
+    ScaleDownStep *step = &steps[i];
+    step->src_index = src_index;
+    step->sample_prev = sample;
+    step->whole_num = 0;
+
+    sample += add;
+    while (sample >= 1.0f) {
       sample -= 1.0f;
+      step->whole_num++;
     }
-  }
+    step->sample_last = sample;
+    sample -= 1.0f;
 
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug T26502. */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug T26502. */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = _newrectf;
+    src_index += step->whole_num + 1;
   }
-  (void)rect_size; /* UNUSED in release builds */
 
-  ibuf->x = newx;
-  return ibuf;
+  return steps;
 }
 
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+/** Number of source pixels read by the steps. */
+static int scaledown_steps_src_len(const ScaleDownStep *steps, const int newlen)
+{
+  const ScaleDownStep *step_last = &steps[newlen - 1];
+  return step_last->src_index + step_last->whole_num + 1;
+}
+
+/** \a stride is the distance between source pixels (in channels). */
+BLI_INLINE ScalePixel scaledown_pixel_byte(const uchar *src,
+                                           const size_t stride,
+                                           const ScaleDownStep *step,
+                                           const float add)
 {
-  const bool do_rect = (ibuf->rect != NULL);
-  const bool do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = IMB_get_rect_len(ibuf) * 4;
+  src += step->src_index * stride;
+  const ScalePixel prev = step->src_index ? scale_pixel_load_byte(src - stride) :
+                                            scale_pixel_zero();
+  ScalePixel nval = scale_pixel_mul_fl(scale_pixel_negate(prev), step->sample_prev);
+  for (int i = 0; i < step->whole_num; i++, src += stride) {
+    nval = scale_pixel_add(nval, scale_pixel_load_byte(src));
+  }
+  const ScalePixel val = scale_pixel_load_byte(src);
+  return scale_pixel_div_fl(scale_pixel_add(nval, scale_pixel_mul_fl(val, step->sample_last)),
+                            add);
+}
 
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y, skipx;
+BLI_INLINE ScalePixel scaledown_pixel_float(const float *src,
+                                            const size_t stride,
+                                            const ScaleDownStep *step,
+                                            const float add)
+{
+  src += step->src_index * stride;
+  const ScalePixel prev = step->src_index ? scale_pixel_load_float(src - stride) :
+                                            scale_pixel_zero();
+  ScalePixel nval = scale_pixel_mul_fl(scale_pixel_negate(prev), step->sample_prev);
+  for (int i = 0; i < step->whole_num; i++, src += stride) {
+    nval = scale_pixel_add(nval, scale_pixel_load_float(src));
+  }
+  const ScalePixel val = scale_pixel_load_float(src);
+  return scale_pixel_div_fl(scale_pixel_add(nval, scale_pixel_mul_fl(val, step->sample_last)),
+                            add);
+}
 
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+/**
+ * Source pixels of a destination pixel when scaling up: it is interpolated between
+ * a source pixel and the next one.
+ */
+typedef struct ScaleUpStep {
+  int src_index;
+  float sample;
+} ScaleUpStep;
 
-  if (!do_rect && !do_float) {
-    return ibuf;
+static ScaleUpStep *scaleup_steps_create(const int newlen, const float add)
+{
+  ScaleUpStep *steps = MEM_mallocN(sizeof(*steps) * newlen, __func__);
+  float sample = 0.0f;
+  int src_index = 0;
+
+  for (int i = 0; i < newlen; i++) {
+    if (sample >= 1.0f) {
+      sample -= 1.0f;
+      src_index++;
+    }
+    steps[i].src_index = src_index;
+    steps[i].sample = sample;
+    sample += add;
   }
 
-  if (do_rect) {
-    _newrect = MEM_mallocN(sizeof(uchar[4]) * newy * ibuf->x, "scaledowny");
-    if (_newrect == NULL) {
-      return ibuf;
+  return steps;
+}
+
+BLI_INLINE ScalePixel scaleup_pixel_byte(const uchar *src,
+                                         const size_t stride,
+                                         const ScaleUpStep *step)
+{
+  src += step->src_index * stride;
+  const ScalePixel val = scale_pixel_load_byte(src);
+  const ScalePixel diff = scale_pixel_sub(scale_pixel_load_byte(src + stride), val);
+  return scale_pixel_add(scale_pixel_add_fl(val, 0.5f), scale_pixel_mul_fl(diff, step->sample));
+}
+
+BLI_INLINE ScalePixel scaleup_pixel_float(const float *src,
+                                          const size_t stride,
+                                          const ScaleUpStep *step)
+{
+  src += step->src_index * stride;
+  const ScalePixel val = scale_pixel_load_float(src);
+  const ScalePixel diff = scale_pixel_sub(scale_pixel_load_float(src + stride), val);
+  return scale_pixel_add(val, scale_pixel_mul_fl(diff, step->sample));
+}
+
+/** Buffers and steps of one scaling pass, shared by the threads. */
+typedef struct ScaleAxisData {
+  const uchar *rect;
+  uchar *newrect;
+  const float *rectf;
+  float *newrectf;
+  /** Width of the source and destination images. */
+  int x, newx;
+  const ScaleDownStep *down_steps;
+  const ScaleUpStep *up_steps;
+  float add;
+} ScaleAxisData;
+
+static void scaledownx_line(void *custom_data, int y)
+{
+  const ScaleAxisData *data = custom_data;
+  const size_t src_offset = (size_t)y * data->x * 4;
+  const size_t dst_offset = (size_t)y * data->newx * 4;
+
+  if (data->rect) {
+    const uchar *src = data->rect + src_offset;
+    uchar *dst = data->newrect + dst_offset;
+    for (int x = 0; x < data->newx; x++, dst += 4) {
+      scale_pixel_store_byte_round(dst,
+                                   scaledown_pixel_byte(src, 4, &data->down_steps[x], data->add));
     }
   }
-  if (do_float) {
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newy * ibuf->x, "scaledownyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
+  if (data->rectf) {
+    const float *src = data->rectf + src_offset;
+    float *dst = data->newrectf + dst_offset;
+    for (int x = 0; x < data->newx; x++, dst += 4) {
+      scale_pixel_store_float(dst, scaledown_pixel_float(src, 4, &data->down_steps[x], data->add));
     }
   }
+}
 
-  add = (ibuf->y - 0.01) / newy;
-  skipx = 4 * ibuf->x;
-
-  for (x = skipx - 4; x >= 0; x -= 4) {
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + x;
-      newrect = _newrect + x;
+static void scaledowny_line(void *custom_data, int y)
+{
+  const ScaleAxisData *data = custom_data;
+  const ScaleDownStep *step = &data->down_steps[y];
+  const size_t stride = (size_t)data->x * 4;
+  const size_t dst_offset = (size_t)y * stride;
+
+  if (data->rect) {
+    uchar *dst = data->newrect + dst_offset;
+    for (int x = 0; x < data->x; x++, dst += 4) {
+      scale_pixel_store_byte_round(
+          dst, scaledown_pixel_byte(data->rect + x * 4, stride, step, data->add));
     }
-    if (do_float) {
-      rectf = ibuf->rect_float + x;
-      newrectf = _newrectf + x;
+  }
+  if (data->rectf) {
+    float *dst = data->newrectf + dst_offset;
+    for (int x = 0; x < data->x; x++, dst += 4) {
+      scale_pixel_store_float(dst,
+                              scaledown_pixel_float(data->rectf + x * 4, stride, step, data->add));
     }
+  }
+}
 
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (y = newy; y > 0; y--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
-
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += skipx;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += skipx;
-        }
-      }
-
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += skipx;
-
-        newrect[0] = roundf((nval[0] + sample * val[0]) / add);
-        newrect[1] = roundf((nval[1] + sample * val[1]) / add);
-        newrect[2] = roundf((nval[2] + sample * val[2]) / add);
-        newrect[3] = roundf((nval[3] + sample * val[3]) / add);
-
-        newrect += skipx;
-      }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += skipx;
+static void scaleupx_line(void *custom_data, int y)
+{
+  const ScaleAxisData *data = custom_data;
+  const size_t src_offset = (size_t)y * data->x * 4;
+  const size_t dst_offset = (size_t)y * data->newx * 4;
+
+  if (data->rect) {
+    const uchar *src = data->rect + src_offset;
+    uchar *dst = data->newrect + dst_offset;
+    for (int x = 0; x < data->newx; x++, dst += 4) {
+      scale_pixel_store_byte_trunc(dst, scaleup_pixel_byte(src, 4, &data->up_steps[x]));
+    }
+  }
+  if (data->rectf) {
+    const float *src = data->rectf + src_offset;
+    float *dst = data->newrectf + dst_offset;
+    for (int x = 0; x < data->newx; x++, dst += 4) {
+      scale_pixel_store_float(dst, scaleup_pixel_float(src, 4, &data->up_steps[x]));
+    }
+  }
+}
 
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
+static void scaleupy_line(void *custom_data, int y)
+{
+  const ScaleAxisData *data = custom_data;
+  const ScaleUpStep *step = &data->up_steps[y];
+  const size_t stride = (size_t)data->x * 4;
+  const size_t dst_offset = (size_t)y * stride;
+
+  if (data->rect) {
+    uchar *dst = data->newrect + dst_offset;
+    for (int x = 0; x < data->x; x++, dst += 4) {
+      scale_pixel_store_byte_trunc(dst, scaleup_pixel_byte(data->rect + x * 4, stride, step));
+    }
+  }
+  if (data->rectf) {
+    float *dst = data->newrectf + dst_offset;
+    for (int x = 0; x < data->x; x++, dst += 4) {
+      scale_pixel_store_float(dst, scaleup_pixel_float(data->rectf + x * 4, stride, step));
+    }
+  }
+}
 
-        newrectf += skipx;
-      }
+/**
+ * Allocate the scaled buffers of \a ibuf for a \a newx by \a newy image.
+ * \return False when the buffers can't be allocated, nothing is scaled then.
+ */
+static bool scale_axis_data_init(ScaleAxisData *data, ImBuf *ibuf, int newx, int newy)
+{
+  memset(data, 0, sizeof(*data));
+  data->rect = (const uchar *)ibuf->rect;
+  data->rectf = ibuf->rect_float;
+  data->x = ibuf->x;
+  data->newx = newx;
 
-      sample -= 1.0f;
+  if (ibuf->rect) {
+    data->newrect = MEM_mallocN(sizeof(uchar[4]) * newx * newy, "scale rect");
+    if (data->newrect == NULL) {
+      return false;
+    }
+  }
+  if (ibuf->rect_float) {
+    data->newrectf = MEM_mallocN(sizeof(float[4]) * newx * newy, "scale rectf");
+    if (data->newrectf == NULL) {
+      MEM_SAFE_FREE(data->newrect);
+      return false;
     }
   }
+  return true;
+}
 
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug T26502. */
+/** Replace the buffers of \a ibuf by the scaled ones. */
+static void scale_axis_data_apply(ScaleAxisData *data, ImBuf *ibuf, int newx, int newy)
+{
+  if (data->newrect) {
     imb_freerectImBuf(ibuf);
     ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
+    ibuf->rect = (unsigned int *)data->newrect;
   }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug T26502. */
+  if (data->newrectf) {
     imb_freerectfloatImBuf(ibuf);
     ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+    ibuf->rect_float = data->newrectf;
   }
-  (void)rect_size; /* UNUSED in release builds */
-
+  ibuf->x = newx;
   ibuf->y = newy;
-  return ibuf;
 }
 
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
 {
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  int x, y;
-  bool do_rect = false, do_float = false;
-
-  if (ibuf == NULL) {
-    return NULL;
-  }
   if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
     return ibuf;
   }
 
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-    if (_newrect == NULL) {
-      return ibuf;
-    }
-  }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scaleupxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
+  ScaleAxisData data;
+  if (!scale_axis_data_init(&data, ibuf, newx, ibuf->y)) {
+    return ibuf;
   }
 
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
+  data.add = (ibuf->x - 0.01) / newx;
+  ScaleDownStep *steps = scaledown_steps_create(newx, data.add);
+  BLI_assert(scaledown_steps_src_len(steps, newx) == ibuf->x); /* see bug T26502. */
+  data.down_steps = steps;
 
-  /* Special case, copy all columns, needed since the scaling logic assumes there is at least
-   * two rows to interpolate between causing out of bounds read for 1px images, see T70356. */
-  if (UNLIKELY(ibuf->x == 1)) {
-    if (do_rect) {
-      for (y = ibuf->y; y > 0; y--) {
-        for (x = newx; x > 0; x--) {
-          memcpy(newrect, rect, sizeof(char[4]));
-          newrect += 4;
-        }
-        rect += 4;
-      }
-    }
-    if (do_float) {
-      for (y = ibuf->y; y > 0; y--) {
-        for (x = newx; x > 0; x--) {
-          memcpy(newrectf, rectf, sizeof(float[4]));
-          newrectf += 4;
-        }
-        rectf += 4;
-      }
-    }
-  }
-  else {
-    const float add = (ibuf->x - 1.001) / (newx - 1.0);
-    float sample;
+  IMB_processor_apply_threaded_scanlines(ibuf->y, scaledownx_line, &data);
 
-    float val_a, nval_a, diff_a;
-    float val_b, nval_b, diff_b;
-    float val_g, nval_g, diff_g;
-    float val_r, nval_r, diff_r;
-    float val_af, nval_af, diff_af;
-    float val_bf, nval_bf, diff_bf;
-    float val_gf, nval_gf, diff_gf;
-    float val_rf, nval_rf, diff_rf;
+  MEM_freeN(steps);
+  scale_axis_data_apply(&data, ibuf, newx, ibuf->y);
+  return ibuf;
+}
 
-    val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-    val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-    val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-    val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
+static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+{
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return ibuf;
+  }
 
-    for (y = ibuf->y; y > 0; y--) {
+  ScaleAxisData data;
+  if (!scale_axis_data_init(&data, ibuf, ibuf->x, newy)) {
+    return ibuf;
+  }
 
-      sample = 0;
+  data.add = (ibuf->y - 0.01) / newy;
+  ScaleDownStep *steps = scaledown_steps_create(newy, data.add);
+  BLI_assert(scaledown_steps_src_len(steps, newy) == ibuf->y); /* see bug T26502. */
+  data.down_steps = steps;
 
-      if (do_rect) {
-        val_a = rect[0];
-        nval_a = rect[4];
-        diff_a = nval_a - val_a;
-        val_a += 0.5f;
-
-        val_b = rect[1];
-        nval_b = rect[5];
-        diff_b = nval_b - val_b;
-        val_b += 0.5f;
-
-        val_g = rect[2];
-        nval_g = rect[6];
-        diff_g = nval_g - val_g;
-        val_g += 0.5f;
-
-        val_r = rect[3];
-        nval_r = rect[7];
-        diff_r = nval_r - val_r;
-        val_r += 0.5f;
-
-        rect += 8;
-      }
-      if (do_float) {
-        val_af = rectf[0];
-        nval_af = rectf[4];
-        diff_af = nval_af - val_af;
+  IMB_processor_apply_threaded_scanlines(newy, scaledowny_line, &data);
 
-        val_bf = rectf[1];
-        nval_bf = rectf[5];
-        diff_bf = nval_bf - val_bf;
+  MEM_freeN(steps);
+  scale_axis_data_apply(&data, ibuf, ibuf->x, newy);
+  return ibuf;
+}
 
-        val_gf = rectf[2];
-        nval_gf = rectf[6];
-        diff_gf = nval_gf - val_gf;
+static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+{
+  if (ibuf == NULL) {
+    return NULL;
+  }
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return ibuf;
+  }
 
-        val_rf = rectf[3];
-        nval_rf = rectf[7];
-        diff_rf = nval_rf - val_rf;
+  ScaleAxisData data;
+  if (!scale_axis_data_init(&data, ibuf, newx, ibuf->y)) {
+    return ibuf;
+  }
 
-        rectf += 8;
-      }
-      for (x = newx; x > 0; x--) {
-        if (sample >= 1.0f) {
-          sample -= 1.0f;
-
-          if (do_rect) {
-            val_a = nval_a;
-            nval_a = rect[0];
-            diff_a = nval_a - val_a;
-            val_a += 0.5f;
-
-            val_b = nval_b;
-            nval_b = rect[1];
-            diff_b = nval_b - val_b;
-            val_b += 0.5f;
-
-            val_g = nval_g;
-            nval_g = rect[2];
-            diff_g = nval_g - val_g;
-            val_g += 0.5f;
-
-            val_r = nval_r;
-            nval_r = rect[3];
-            diff_r = nval_r - val_r;
-            val_r += 0.5f;
-            rect += 4;
-          }
-          if (do_float) {
-            val_af = nval_af;
-            nval_af = rectf[0];
-            diff_af = nval_af - val_af;
-
-            val_bf = nval_bf;
-            nval_bf = rectf[1];
-            diff_bf = nval_bf - val_bf;
-
-            val_gf = nval_gf;
-            nval_gf = rectf[2];
-            diff_gf = nval_gf - val_gf;
-
-            val_rf = nval_rf;
-            nval_rf = rectf[3];
-            diff_rf = nval_rf - val_rf;
-            rectf += 4;
-          }
-        }
-        if (do_rect) {
-          newrect[0] = val_a + sample * diff_a;
-          newrect[1] = val_b + sample * diff_b;
-          newrect[2] = val_g + sample * diff_g;
-          newrect[3] = val_r + sample * diff_r;
-          newrect += 4;
+  /* Special case, copy all columns, needed since the scaling logic assumes there is at least
+   * two rows to interpolate between causing out of bounds read for 1px images, see T70356. */
+  if (UNLIKELY(ibuf->x == 1)) {
+    for (int y = 0; y < ibuf->y; y++) {
+      for (int x = 0; x < newx; x++) {
+        const size_t offset = ((size_t)y * newx + x) * 4;
+        if (data.newrect) {
+          memcpy(data.newrect + offset, data.rect + y * 4, sizeof(char[4]));
         }
-        if (do_float) {
-          newrectf[0] = val_af + sample * diff_af;
-          newrectf[1] = val_bf + sample * diff_bf;
-          newrectf[2] = val_gf + sample * diff_gf;
-          newrectf[3] = val_rf + sample * diff_rf;
-          newrectf += 4;
+        if (data.newrectf) {
+          memcpy(data.newrectf + offset, data.rectf + y * 4, sizeof(float[4]));
         }
-        sample += add;
       }
     }
   }
-
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+  else {
+    ScaleUpStep *steps = scaleup_steps_create(newx, (ibuf->x - 1.001) / (newx - 1.0));
+    data.up_steps = steps;
+    IMB_processor_apply_threaded_scanlines(ibuf->y, scaleupx_line, &data);
+    MEM_freeN(steps);
   }
 
-  ibuf->x = newx;
+  scale_axis_data_apply(&data, ibuf, newx, ibuf->y);
   return ibuf;
 }
 
 static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
 {
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  int x, y, skipx;
-  bool do_rect = false, do_float = false;
-
   if (ibuf == NULL) {
     return NULL;
   }
@@ -1387,195 +1432,37 @@ static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
     return ibuf;
   }
 
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-    if (_newrect == NULL) {
-      return ibuf;
-    }
-  }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(sizeof(float[4]) * ibuf->x * newy, "scaleupyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
+  ScaleAxisData data;
+  if (!scale_axis_data_init(&data, ibuf, ibuf->x, newy)) {
+    return ibuf;
   }
 
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  skipx = 4 * ibuf->x;
-
   /* Special case, copy all rows, needed since the scaling logic assumes there is at least
    * two rows to interpolate between causing out of bounds read for 1px images, see T70356. */
   if (UNLIKELY(ibuf->y == 1)) {
-    if (do_rect) {
-      for (y = newy; y > 0; y--) {
-        memcpy(newrect, rect, sizeof(char) * skipx);
-        newrect += skipx;
+    const size_t row_len = (size_t)ibuf->x * 4;
+    for (int y = 0; y < newy; y++) {
+      if (data.newrect) {
+        memcpy(data.newrect + y * row_len, data.rect, sizeof(char) * row_len);
       }
-    }
-    if (do_float) {
-      for (y = newy; y > 0; y--) {
-        memcpy(newrectf, rectf, sizeof(float) * skipx);
-        newrectf += skipx;
+      if (data.newrectf) {
+        memcpy(data.newrectf + y * row_len, data.rectf, sizeof(float) * row_len);
       }
     }
   }
   else {
-    const float add = (ibuf->y - 1.001) / (newy - 1.0);
-    float sample;
-
-    float val_a, nval_a, diff_a;
-    float val_b, nval_b, diff_b;
-    float val_g, nval_g, diff_g;
-    float val_r, nval_r, diff_r;
-    float val_af, nval_af, diff_af;
-    float val_bf, nval_bf, diff_bf;
-    float val_gf, nval_gf, diff_gf;
-    float val_rf, nval_rf, diff_rf;
-
-    val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-    val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-    val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-    val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-
-    for (x = ibuf->x; x > 0; x--) {
-      sample = 0;
-      if (do_rect) {
-        rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-        newrect = _newrect + 4 * (x - 1);
-
-        val_a = rect[0];
-        nval_a = rect[skipx];
-        diff_a = nval_a - val_a;
-        val_a += 0.5f;
-
-        val_b = rect[1];
-        nval_b = rect[skipx + 1];
-        diff_b = nval_b - val_b;
-        val_b += 0.5f;
-
-        val_g = rect[2];
-        nval_g = rect[skipx + 2];
-        diff_g = nval_g - val_g;
-        val_g += 0.5f;
-
-        val_r = rect[3];
-        nval_r = rect[skipx + 3];
-        diff_r = nval_r - val_r;
-        val_r += 0.5f;
-
-        rect += 2 * skipx;
-      }
-      if (do_float) {
-        rectf = ibuf->rect_float + 4 * (x - 1);
-        newrectf = _newrectf + 4 * (x - 1);
-
-        val_af = rectf[0];
-        nval_af = rectf[skipx];
-        diff_af = nval_af - val_af;
-
-        val_bf = rectf[1];
-        nval_bf = rectf[skipx + 1];
-        diff_bf = nval_bf - val_bf;
-
-        val_gf = rectf[2];
-        nval_gf = rectf[skipx + 2];
-        diff_gf = nval_gf - val_gf;
-
-        val_rf = rectf[3];
-        nval_rf = rectf[skipx + 3];
-        diff_rf = nval_rf - val_rf;
-
-        rectf += 2 * skipx;
-      }
-
-      for (y = newy; y > 0; y--) {
-        if (sample >= 1.0f) {
-          sample -= 1.0f;
-
-          if (do_rect) {
-            val_a = nval_a;
-            nval_a = rect[0];
-            diff_a = nval_a - val_a;
-            val_a += 0.5f;
-
-            val_b = nval_b;
-            nval_b = rect[1];
-            diff_b = nval_b - val_b;
-            val_b += 0.5f;
-
-            val_g = nval_g;
-            nval_g = rect[2];
-            diff_g = nval_g - val_g;
-            val_g += 0.5f;
-
-            val_r = nval_r;
-            nval_r = rect[3];
-            diff_r = nval_r - val_r;
-            val_r += 0.5f;
-            rect += skipx;
-          }
-          if (do_float) {
-            val_af = nval_af;
-            nval_af = rectf[0];
-            diff_af = nval_af - val_af;
-
-            val_bf = nval_bf;
-            nval_bf = rectf[1];
-            diff_bf = nval_bf - val_bf;
-
-            val_gf = nval_gf;
-            nval_gf = rectf[2];
-            diff_gf = nval_gf - val_gf;
-
-            val_rf = nval_rf;
-            nval_rf = rectf[3];
-            diff_rf = nval_rf - val_rf;
-            rectf += skipx;
-          }
-        }
-        if (do_rect) {
-          newrect[0] = val_a + sample * diff_a;
-          newrect[1] = val_b + sample * diff_b;
-          newrect[2] = val_g + sample * diff_g;
-          newrect[3] = val_r + sample * diff_r;
-          newrect += skipx;
-        }
-        if (do_float) {
-          newrectf[0] = val_af + sample * diff_af;
-          newrectf[1] = val_bf + sample * diff_bf;
-          newrectf[2] = val_gf + sample * diff_gf;
-          newrectf[3] = val_rf + sample * diff_rf;
-          newrectf += skipx;
-        }
-        sample += add;
-      }
-    }
+    ScaleUpStep *steps = scaleup_steps_create(newy, (ibuf->y - 1.001) / (newy - 1.0));
+    data.up_steps = steps;
+    IMB_processor_apply_threaded_scanlines(newy, scaleupy_line, &data);
+    MEM_freeN(steps);
   }
 
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
-  }
-
-  ibuf->y = newy;
+  scale_axis_data_apply(&data, ibuf, ibuf->x, newy);
   return ibuf;
 }
 
+/** \} */
+
 static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 {
   int *zbuf, *newzbuf, *_newzbuf = NULL;
@@ -10,6 +10,7 @@
 
 #include "BLI_math.h"
 #include "BLI_rect.h"
+#include "BLI_simd.h"
 
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
@@ -41,6 +42,12 @@ struct TransformUserData {
    */
   rctf src_crop;
 
+  /**
+   * \brief The transform only scales and translates, the V coordinate is the same for all pixels
+   * of a scanline.
+   */
+  bool is_axis_aligned;
+
   /**
    * \brief Initialize the start_uv, add_x and add_y fields based on the given transform matrix.
    */
@@ -49,6 +56,7 @@ struct TransformUserData {
     init_start_uv(transform_matrix);
     init_add_x(transform_matrix);
     init_add_y(transform_matrix);
+    is_axis_aligned = add_x[1] == 0.0f && add_y[0] == 0.0f;
   }
 
  private:
@@ -105,6 +113,13 @@ class BaseDiscard {
    * \brief Should the source pixel at the given uv coordinate be discarded.
    */
   virtual bool should_discard(const TransformUserData &user_data, const float uv[2]) = 0;
+
+  /**
+   * \brief Should all source pixels at the given v coordinate be discarded.
+   *
+   * Used for axis-aligned transforms, to skip scanlines entirely.
+   */
+  virtual bool should_discard_row(const TransformUserData &user_data, const float v) = 0;
 };
 
 /**
@@ -122,6 +137,11 @@ class CropSource : public BaseDiscard {
     return uv[0] < user_data.src_crop.xmin || uv[0] >= user_data.src_crop.xmax ||
            uv[1] < user_data.src_crop.ymin || uv[1] >= user_data.src_crop.ymax;
   }
+
+  bool should_discard_row(const TransformUserData &user_data, const float v) override
+  {
+    return v < user_data.src_crop.ymin || v >= user_data.src_crop.ymax;
+  }
 };
 
 /**
@@ -139,6 +159,12 @@ class NoDiscard : public BaseDiscard {
   {
     return false;
   }
+
+  bool should_discard_row(const TransformUserData &UNUSED(user_data),
+                          const float UNUSED(v)) override
+  {
+    return false;
+  }
 };
 
 /**
@@ -255,11 +281,73 @@ class WrapRepeatUV : public BaseUVWrapping {
   }
 };
 
+/**
+ * \brief Weighted sum of the 4 channels of 4 source pixels, as done by
+ * #BLI_bilinear_interpolation_fl and #BLI_bilinear_interpolation_char (with the same results).
+ *
+ * Uses SSE2 to process the 4 channels at once when available.
+ */
+template<typename StorageType>
+inline void bilinear_mix_rgba(const StorageType *row1,
+                              const StorageType *row2,
+                              const StorageType *row3,
+                              const StorageType *row4,
+                              const float a,
+                              const float b,
+                              StorageType r_sample[4])
+{
+  const float a_b = a * b;
+  const float ma_b = (1.0f - a) * b;
+  const float a_mb = a * (1.0f - b);
+  const float ma_mb = (1.0f - a) * (1.0f - b);
+
+#ifdef BLI_HAVE_SSE2
+  const auto load = [](const StorageType *pixel) -> __m128 {
+    if constexpr (std::is_same_v<StorageType, float>) {
+      return _mm_loadu_ps(pixel);
+    }
+    else {
+      int packed;
+      memcpy(&packed, pixel, sizeof(packed));
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i pixel16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+      return _mm_cvtepi32_ps(_mm_unpacklo_epi16(pixel16, zero));
+    }
+  };
+  __m128 result = _mm_mul_ps(_mm_set1_ps(ma_mb), load(row1));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(a_mb), load(row3)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(ma_b), load(row2)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(a_b), load(row4)));
+  if constexpr (std::is_same_v<StorageType, float>) {
+    _mm_storeu_ps(r_sample, result);
+  }
+  else {
+    const __m128i result32 = _mm_cvttps_epi32(_mm_add_ps(result, _mm_set1_ps(0.5f)));
+    const __m128i result16 = _mm_packs_epi32(result32, result32);
+    const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(result16, result16));
+    memcpy(r_sample, &packed, sizeof(packed));
+  }
+#else
+  for (int i = 0; i < 4; i++) {
+    const float result = ma_mb * row1[i] + a_mb * row3[i] + ma_b * row2[i] + a_b * row4[i];
+    if constexpr (std::is_same_v<StorageType, float>) {
+      r_sample[i] = result;
+    }
+    else {
+      r_sample[i] = (unsigned char)(result + 0.5f);
+    }
+  }
+#endif
+}
+
 /**
  * \brief Read a sample from an image buffer.
  *
  * A sampler can read from an image buffer.
  *
+ * Sampling is split in a part that only depends on the v coordinate (#init_row) and a part that
+ * depends on the u coordinate, so axis-aligned transforms only do the first part once per
+ * scanline.
  */
 template<
     /** \brief Interpolation mode to use when sampling. */
@@ -282,59 +370,96 @@ template<
 class Sampler {
   UVWrapping uv_wrapper;
 
+  /** \brief Sampling of 4 channel buffers with #bilinear_mix_rgba. */
+  static constexpr bool UseBilinearRGBA = Filter == IMB_FILTER_BILINEAR && NumChannels == 4;
+
  public:
   using ChannelType = StorageType;
   static const int ChannelLen = NumChannels;
   using SampleType = std::array<StorageType, NumChannels>;
 
-  void sample(const ImBuf *source, const float u, const float v, SampleType &r_sample)
+  /**
+   * \brief Part of the sampling that only depends on the v coordinate.
+   */
+  struct Row {
+    float wrapped_v;
+    /**
+     * \brief Source rows to sample from (the two nearest ones for bilinear filtering), nullptr
+     * when outside of the image.
+     */
+    const StorageType *row1;
+    const StorageType *row2;
+    /** \brief Bilinear weight of #row2. */
+    float b;
+    /** \brief The whole row is outside of the image. */
+    bool is_outside;
+  };
+
+  void init_row(const ImBuf *source, const float v, Row &r_row)
   {
-    if constexpr (Filter == IMB_FILTER_BILINEAR && std::is_same_v<StorageType, float> &&
-                  NumChannels == 4) {
-      const float wrapped_u = uv_wrapper.modify_u(source, u);
-      const float wrapped_v = uv_wrapper.modify_v(source, v);
-      bilinear_interpolation_color_fl(source, nullptr, r_sample.data(), wrapped_u, wrapped_v);
+    r_row.wrapped_v = uv_wrapper.modify_v(source, v);
+    r_row.row1 = nullptr;
+    r_row.row2 = nullptr;
+    r_row.b = 0.0f;
+    r_row.is_outside = false;
+
+    if constexpr (UseBilinearRGBA) {
+      const int y1 = (int)floor(r_row.wrapped_v);
+      const int y2 = (int)ceil(r_row.wrapped_v);
+      r_row.is_outside = y2 < 0 || y1 >= source->y;
+      if (r_row.is_outside) {
+        return;
+      }
+      if (y1 >= 0) {
+        r_row.row1 = source_buffer(source) + (size_t)source->x * y1 * NumChannels;
+      }
+      if (y2 <= source->y - 1) {
+        r_row.row2 = source_buffer(source) + (size_t)source->x * y2 * NumChannels;
+      }
+      r_row.b = r_row.wrapped_v - floorf(r_row.wrapped_v);
     }
-    else if constexpr (Filter == IMB_FILTER_NEAREST &&
-                       std::is_same_v<StorageType, unsigned char> && NumChannels == 4) {
-      const float wrapped_u = uv_wrapper.modify_u(source, u);
-      const float wrapped_v = uv_wrapper.modify_v(source, v);
-      nearest_interpolation_color_char(source, r_sample.data(), nullptr, wrapped_u, wrapped_v);
+    else if constexpr (Filter == IMB_FILTER_NEAREST) {
+      const int y1 = (int)(r_row.wrapped_v);
+      r_row.is_outside = y1 < 0 || y1 >= source->y;
+      if (!r_row.is_outside) {
+        r_row.row1 = source_buffer(source) + (size_t)source->x * y1 * NumChannels;
+      }
     }
-    else if constexpr (Filter == IMB_FILTER_BILINEAR &&
-                       std::is_same_v<StorageType, unsigned char> && NumChannels == 4) {
+  }
+
+  void sample(const ImBuf *source, const Row &row, const float u, SampleType &r_sample)
+  {
+    if constexpr (UseBilinearRGBA) {
       const float wrapped_u = uv_wrapper.modify_u(source, u);
-      const float wrapped_v = uv_wrapper.modify_v(source, v);
-      bilinear_interpolation_color_char(source, r_sample.data(), nullptr, wrapped_u, wrapped_v);
+      sample_bilinear_rgba(source, row, wrapped_u, r_sample);
     }
     else if constexpr (Filter == IMB_FILTER_BILINEAR && std::is_same_v<StorageType, float>) {
+      const float wrapped_u = uv_wrapper.modify_u(source, u);
       if constexpr (std::is_same_v<UVWrapping, WrapRepeatUV>) {
+        /* Coordinates must be wrapped already, only the neighbors past the edges are wrapped. */
         BLI_bilinear_interpolation_wrap_fl(source->rect_float,
                                            r_sample.data(),
                                            source->x,
                                            source->y,
                                            NumChannels,
-                                           u,
-                                           v,
+                                           wrapped_u,
+                                           row.wrapped_v,
                                            true,
                                            true);
       }
       else {
-        const float wrapped_u = uv_wrapper.modify_u(source, u);
-        const float wrapped_v = uv_wrapper.modify_v(source, v);
         BLI_bilinear_interpolation_fl(source->rect_float,
                                       r_sample.data(),
                                       source->x,
                                       source->y,
                                       NumChannels,
                                       wrapped_u,
-                                      wrapped_v);
+                                      row.wrapped_v);
       }
     }
-    else if constexpr (Filter == IMB_FILTER_NEAREST && std::is_same_v<StorageType, float>) {
+    else if constexpr (Filter == IMB_FILTER_NEAREST) {
       const float wrapped_u = uv_wrapper.modify_u(source, u);
-      const float wrapped_v = uv_wrapper.modify_v(source, v);
-      sample_nearest_float(source, wrapped_u, wrapped_v, r_sample);
+      sample_nearest(source, row, wrapped_u, r_sample);
     }
     else {
       /* Unsupported sampler. */
@@ -342,30 +467,63 @@ class Sampler {
     }
   }
 
+  void sample(const ImBuf *source, const float u, const float v, SampleType &r_sample)
+  {
+    Row row;
+    init_row(source, v, row);
+    sample(source, row, u, r_sample);
+  }
+
  private:
-  void sample_nearest_float(const ImBuf *source,
+  static const StorageType *source_buffer(const ImBuf *source)
+  {
+    if constexpr (std::is_same_v<StorageType, float>) {
+      return source->rect_float;
+    }
+    else {
+      return reinterpret_cast<const unsigned char *>(source->rect);
+    }
+  }
+
+  void sample_bilinear_rgba(const ImBuf *source,
+                            const Row &row,
                             const float u,
-                            const float v,
                             SampleType &r_sample)
   {
-    BLI_STATIC_ASSERT(std::is_same_v<StorageType, float>);
+    const int x1 = (int)floor(u);
+    const int x2 = (int)ceil(u);
+
+    if (row.is_outside || x2 < 0 || x1 >= source->x) {
+      r_sample.fill(0);
+      return;
+    }
+
+    /* Sample including outside of edges of image. */
+    static const StorageType empty[4] = {0, 0, 0, 0};
+    const bool x1_inside = x1 >= 0;
+    const bool x2_inside = x2 <= source->x - 1;
+    const StorageType *row1 = (x1_inside && row.row1) ? row.row1 + x1 * NumChannels : empty;
+    const StorageType *row2 = (x1_inside && row.row2) ? row.row2 + x1 * NumChannels : empty;
+    const StorageType *row3 = (x2_inside && row.row1) ? row.row1 + x2 * NumChannels : empty;
+    const StorageType *row4 = (x2_inside && row.row2) ? row.row2 + x2 * NumChannels : empty;
+
+    bilinear_mix_rgba(row1, row2, row3, row4, u - floorf(u), row.b, r_sample.data());
+  }
 
+  void sample_nearest(const ImBuf *source, const Row &row, const float u, SampleType &r_sample)
+  {
     /* ImBuf in must have a valid rect or rect_float, assume this is already checked */
-    int x1 = (int)(u);
-    int y1 = (int)(v);
+    const int x1 = (int)(u);
 
     /* Break when sample outside image is requested. */
-    if (x1 < 0 || x1 >= source->x || y1 < 0 || y1 >= source->y) {
-      for (int i = 0; i < NumChannels; i++) {
-        r_sample[i] = 0.0f;
-      }
+    if (row.is_outside || x1 < 0 || x1 >= source->x) {
+      r_sample.fill(0);
       return;
     }
 
-    const size_t offset = ((size_t)source->x * y1 + x1) * NumChannels;
-    const float *dataF = source->rect_float + offset;
+    const StorageType *data = row.row1 + (size_t)x1 * NumChannels;
     for (int i = 0; i < NumChannels; i++) {
-      r_sample[i] = dataF[i];
+      r_sample[i] = data[i];
     }
   }
 };
@@ -468,6 +626,27 @@ class ScanlineProcessor {
     madd_v2_v2v2fl(uv, user_data->start_uv, user_data->add_y, scanline);
 
     output.init_pixel_pointer(user_data->dst, 0, scanline);
+
+    if (user_data->is_axis_aligned) {
+      /* Only the u coordinate changes along the scanline. */
+      if (discarder.should_discard_row(*user_data, uv[1])) {
+        return;
+      }
+      typename Sampler::Row row;
+      sampler.init_row(user_data->src, uv[1], row);
+      for (int xi = 0; xi < width; xi++) {
+        if (!discarder.should_discard(*user_data, uv)) {
+          typename Sampler::SampleType sample;
+          sampler.sample(user_data->src, row, uv[0], sample);
+          channel_converter.convert_and_store(sample, output);
+        }
+
+        uv[0] += user_data->add_x[0];
+        output.increase_pixel_pointer();
+      }
+      return;
+    }
+
     for (int xi = 0; xi < width; xi++) {
       if (!discarder.should_discard(*user_data, uv)) {
         typename Sampler::SampleType sample;
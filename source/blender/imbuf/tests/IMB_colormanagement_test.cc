@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "BLI_rand.hh"
+
+#include "BKE_appdir.h"
+#include "BKE_colortools.h"
+
+#include "DNA_color_types.h"
+
+#include "IMB_colormanagement.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "CLG_log.h"
+
+namespace blender::imbuf::tests {
+
+/** Large enough for the display LUT to be baked, see #colormanage_display_buffer_process_ex. */
+static const int lut_image_x = 512;
+static const int lut_image_y = 512;
+
+class ColormanagementDisplayLUTTest : public testing::Test {
+ protected:
+  ColorManagedViewSettings view_settings_;
+  ColorManagedDisplaySettings display_settings_;
+
+  static void SetUpTestCase()
+  {
+    CLG_init();
+    BKE_appdir_init();
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+    BKE_appdir_exit();
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    BKE_color_managed_display_settings_init(&display_settings_);
+    IMB_colormanagement_init_default_view_settings(&view_settings_, &display_settings_);
+  }
+
+  void TearDown() override
+  {
+    IMB_colormanagement_display_lut_set_enabled(false);
+    BKE_color_managed_view_settings_free(&view_settings_);
+  }
+
+  /** Byte image with random colors, and the darkest and brightest colors in the first row. */
+  static ImBuf *create_test_image(const int x, const int y)
+  {
+    ImBuf *ibuf = IMB_allocImBuf(x, y, 32, IB_rect);
+    RandomNumberGenerator rng(uint32_t(x * 1000 + y));
+    uchar *rect = reinterpret_cast<uchar *>(ibuf->rect);
+    for (size_t i = 0; i < size_t(x) * y * 4; i++) {
+      rect[i] = uchar(rng.get_int32(256));
+    }
+    memset(rect, 0, 4);
+    memset(rect + 4, 255, 4);
+    return ibuf;
+  }
+
+  /** Display buffer of a copy of \a src, so no display buffer cached in the image is used. */
+  std::vector<uchar> display_buffer(const ImBuf *src)
+  {
+    ImBuf *ibuf = IMB_dupImBuf(src);
+    void *cache_handle = nullptr;
+    const uchar *buffer = IMB_display_buffer_acquire(
+        ibuf, &view_settings_, &display_settings_, &cache_handle);
+    std::vector<uchar> result(buffer, buffer + size_t(ibuf->x) * ibuf->y * 4);
+    IMB_display_buffer_release(cache_handle);
+    IMB_freeImBuf(ibuf);
+    return result;
+  }
+
+  std::vector<uchar> display_buffer(const ImBuf *src, const bool use_display_lut)
+  {
+    IMB_colormanagement_display_lut_set_enabled(use_display_lut);
+    return display_buffer(src);
+  }
+
+  /** Curve mapping scaling all colors by \a factor. */
+  void use_curve_mapping(const float factor)
+  {
+    if (view_settings_.curve_mapping == nullptr) {
+      view_settings_.curve_mapping = BKE_curvemapping_add(4, 0.0f, 0.0f, 1.0f, 1.0f);
+    }
+    CurveMapping *curve_mapping = view_settings_.curve_mapping;
+    curve_mapping->cm[3].curve[1].y = factor;
+    BKE_curvemapping_changed(curve_mapping, false);
+    BKE_curvemapping_init(curve_mapping);
+    view_settings_.flag |= COLORMANAGE_VIEW_USE_CURVES;
+  }
+
+  /**
+   * The LUT is sampled with trilinear interpolation: display colors may be off by a byte value
+   * where the transform is steep or clipped, but not more, and only rarely.
+   */
+  void expect_within_error_bound()
+  {
+    ImBuf *ibuf = create_test_image(lut_image_x, lut_image_y);
+    const std::vector<uchar> exact = display_buffer(ibuf, false);
+    const std::vector<uchar> baked = display_buffer(ibuf, true);
+    ASSERT_EQ(exact.size(), baked.size());
+
+    size_t total_error = 0;
+    for (size_t i = 0; i < exact.size(); i++) {
+      const int error = abs(int(exact[i]) - int(baked[i]));
+      if (i % 4 == 3) {
+        EXPECT_EQ(error, 0) << "alpha of pixel " << i / 4;
+        continue;
+      }
+      EXPECT_LE(error, 2) << "pixel " << i / 4 << " channel " << i % 4;
+      total_error += size_t(error);
+    }
+    EXPECT_LT(double(total_error) / (exact.size() / 4 * 3), 0.1);
+
+    IMB_freeImBuf(ibuf);
+  }
+};
+
+/* The LUT is opt-in, the exact transform is used by default. */
+TEST_F(ColormanagementDisplayLUTTest, disabled_by_default)
+{
+  view_settings_.gamma = 1.6f;
+  ImBuf *ibuf = create_test_image(lut_image_x, lut_image_y);
+  const std::vector<uchar> result = display_buffer(ibuf);
+  EXPECT_EQ(result, display_buffer(ibuf, false));
+  EXPECT_NE(result, display_buffer(ibuf, true));
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(ColormanagementDisplayLUTTest, error_bound_exposure_gamma)
+{
+  for (const float exposure : {-1.5f, 0.0f, 1.0f}) {
+    for (const float gamma : {0.7f, 1.0f, 1.6f}) {
+      SCOPED_TRACE(testing::Message() << "exposure " << exposure << ", gamma " << gamma);
+      view_settings_.exposure = exposure;
+      view_settings_.gamma = gamma;
+      expect_within_error_bound();
+    }
+  }
+}
+
+TEST_F(ColormanagementDisplayLUTTest, error_bound_curve_mapping)
+{
+  view_settings_.exposure = 0.5f;
+  use_curve_mapping(0.8f);
+  expect_within_error_bound();
+}
+
+TEST_F(ColormanagementDisplayLUTTest, cache_keyed_on_curve_mapping_contents)
+{
+  view_settings_.gamma = 0.8f;
+  use_curve_mapping(0.7f);
+  ImBuf *ibuf = create_test_image(lut_image_x, lut_image_y);
+  const std::vector<uchar> baked = display_buffer(ibuf, true);
+
+  /* The first rows of the image, too small for a LUT to be baked for it. */
+  const int small_y = 3;
+  ImBuf *ibuf_small = IMB_allocImBuf(lut_image_x, small_y, 32, IB_rect);
+  memcpy(ibuf_small->rect, ibuf->rect, sizeof(uint) * lut_image_x * small_y);
+
+  /* A copy of the curve mapping has the same contents, the existing LUT is used. */
+  CurveMapping *curve_mapping = view_settings_.curve_mapping;
+  view_settings_.curve_mapping = BKE_curvemapping_copy(curve_mapping);
+  BKE_curvemapping_free(curve_mapping);
+  const std::vector<uchar> small_baked = display_buffer(ibuf_small, true);
+  ASSERT_EQ(small_baked.size(), size_t(lut_image_x) * small_y * 4);
+  EXPECT_TRUE(std::equal(small_baked.begin(), small_baked.end(), baked.begin()));
+
+  /* Once edited, the LUT doesn't match anymore and the exact transform is used. */
+  use_curve_mapping(0.6f);
+  EXPECT_EQ(display_buffer(ibuf_small, true), display_buffer(ibuf_small, false));
+
+  IMB_freeImBuf(ibuf);
+  IMB_freeImBuf(ibuf_small);
+}
+
+}  // namespace blender::imbuf::tests
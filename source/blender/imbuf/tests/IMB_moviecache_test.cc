@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cfloat>
+#include <cstdlib>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
+
+namespace blender::imbuf::tests {
+
+struct TestFrameKey {
+  int framenr;
+};
+
+static unsigned int test_frame_hash(const void *key)
+{
+  return uint(static_cast<const TestFrameKey *>(key)->framenr);
+}
+
+static bool test_frame_cmp(const void *a, const void *b)
+{
+  return static_cast<const TestFrameKey *>(a)->framenr !=
+         static_cast<const TestFrameKey *>(b)->framenr;
+}
+
+/* Same priority as the frames of movie clips: the distance to the last frame put in the cache. */
+
+static void *test_frame_priority_data(void *userkey)
+{
+  int *framenr = static_cast<int *>(MEM_mallocN(sizeof(int), __func__));
+  *framenr = static_cast<const TestFrameKey *>(userkey)->framenr;
+  return framenr;
+}
+
+static int test_frame_item_priority(void *last_userkey, void *priority_data)
+{
+  return -abs(static_cast<const TestFrameKey *>(last_userkey)->framenr -
+              *static_cast<const int *>(priority_data));
+}
+
+static void test_frame_priority_free(void *priority_data)
+{
+  MEM_freeN(priority_data);
+}
+
+/** Size of the frames, large enough for the memory of the cache items to be negligible. */
+static const int frame_x = 64;
+static const int frame_y = 64;
+
+class MovieCacheTest : public testing::Test {
+ protected:
+  MovieCache *cache_;
+  size_t frame_size_;
+
+  static void SetUpTestCase()
+  {
+    IMB_moviecache_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_moviecache_destruct();
+  }
+
+  void SetUp() override
+  {
+    cache_ = IMB_moviecache_create(
+        "test", sizeof(TestFrameKey), test_frame_hash, test_frame_cmp);
+    ImBuf *ibuf = IMB_allocImBuf(frame_x, frame_y, 32, IB_rect);
+    frame_size_ = IMB_get_size_in_memory(ibuf);
+    IMB_freeImBuf(ibuf);
+  }
+
+  void TearDown() override
+  {
+    IMB_moviecache_free(cache_);
+  }
+
+  /** Put a frame that took \a load_time seconds to read, \a scale times the usual frame size. */
+  void put_frame(const int framenr, const float load_time, const int scale = 1)
+  {
+    ImBuf *ibuf = IMB_allocImBuf(frame_x * scale, frame_y, 32, IB_rect);
+    ibuf->load_time = load_time;
+    TestFrameKey key = {framenr};
+    IMB_moviecache_put(cache_, &key, ibuf);
+    IMB_freeImBuf(ibuf);
+  }
+
+  bool is_cached(const int framenr)
+  {
+    TestFrameKey key = {framenr};
+    ImBuf *ibuf = IMB_moviecache_get(cache_, &key, nullptr);
+    if (ibuf == nullptr) {
+      return false;
+    }
+    IMB_freeImBuf(ibuf);
+    return true;
+  }
+};
+
+TEST(imbuf_moviecache, frame_value_order)
+{
+  const double now = PIL_check_seconds_timer();
+  const float value = IMB_moviecache_frame_value(0.1f, 1000, now);
+  /* Frames that take longer to get back, for their size, are more valuable. */
+  EXPECT_GT(IMB_moviecache_frame_value(0.2f, 1000, now), value);
+  EXPECT_LT(IMB_moviecache_frame_value(0.1f, 2000, now), value);
+  /* Frames that haven't been used for a while are less valuable. */
+  EXPECT_LT(IMB_moviecache_frame_value(0.1f, 1000, now - 10.0), value);
+  /* Frames that don't use memory are never freed. */
+  EXPECT_EQ(IMB_moviecache_frame_value(0.1f, 0, now), FLT_MAX);
+}
+
+TEST_F(MovieCacheTest, free_less_valuable_in_value_order)
+{
+  /* From the most to the least valuable per byte: 2, 3, 4 (same cost as 3 for 4 times the
+   * memory) and 1. */
+  put_frame(1, 0.001f);
+  put_frame(2, 0.1f);
+  put_frame(3, 0.01f);
+  put_frame(4, 0.01f, 4);
+
+  /* Freeing any memory frees one frame, the least valuable one. */
+  EXPECT_GT(IMB_moviecache_free_less_valuable(FLT_MAX, 1), 0);
+  EXPECT_FALSE(is_cached(1));
+  EXPECT_TRUE(is_cached(4));
+  EXPECT_GT(IMB_moviecache_free_less_valuable(FLT_MAX, 1), 0);
+  EXPECT_FALSE(is_cached(4));
+  EXPECT_TRUE(is_cached(3));
+  EXPECT_GT(IMB_moviecache_free_less_valuable(FLT_MAX, 1), 0);
+  EXPECT_FALSE(is_cached(3));
+  EXPECT_TRUE(is_cached(2));
+}
+
+TEST_F(MovieCacheTest, free_less_valuable_below_value)
+{
+  put_frame(1, 0.001f);
+  put_frame(2, 0.1f);
+  put_frame(3, 0.01f);
+
+  /* Frames at least as valuable as the given value are kept, even when more memory is needed. */
+  const float value = IMB_moviecache_frame_value(0.03f, frame_size_, PIL_check_seconds_timer());
+  EXPECT_GE(IMB_moviecache_free_less_valuable(value, SIZE_MAX), frame_size_ * 2);
+  EXPECT_FALSE(is_cached(1));
+  EXPECT_TRUE(is_cached(2));
+  EXPECT_FALSE(is_cached(3));
+}
+
+TEST_F(MovieCacheTest, free_less_valuable_far_from_current_frame)
+{
+  IMB_moviecache_set_priority_callback(
+      cache_, test_frame_priority_data, test_frame_item_priority, test_frame_priority_free);
+
+  /* Frame 5 is put last, it is the current frame. */
+  for (const int framenr : {1, 2, 3, 4, 6, 7, 8, 9, 5}) {
+    put_frame(framenr, 0.01f);
+  }
+
+  /* Frames further from the current frame are freed first. */
+  EXPECT_GE(IMB_moviecache_free_less_valuable(FLT_MAX, frame_size_ * 4), frame_size_ * 4);
+  for (int framenr = 1; framenr <= 9; framenr++) {
+    EXPECT_EQ(is_cached(framenr), framenr >= 3 && framenr <= 7) << "frame " << framenr;
+  }
+}
+
+}  // namespace blender::imbuf::tests
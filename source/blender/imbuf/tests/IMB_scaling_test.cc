@@ -0,0 +1,220 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "IMB_test_utils.hh"
+
+namespace blender::imbuf::tests {
+
+/**
+ * Pixels of an image, used for the reference implementation below. Bytes and floats are scaled
+ * the same way except for rounding, see #ScaleReference.
+ */
+template<typename T> struct TestImage {
+  int x, y;
+  std::vector<T> pixels;
+
+  TestImage(const int x, const int y) : x(x), y(y), pixels(size_t(x) * y * 4)
+  {
+  }
+};
+
+/**
+ * Pixel by pixel implementation of the passes of #IMB_scaleImBuf, as it was before lines were
+ * scaled in parallel with SIMD. Each pass scales lines of pixels along one axis, \a stride is the
+ * distance between two pixels of a line.
+ *
+ * Products are computed in statements of their own, so they are rounded before being added like
+ * in the SIMD kernels, even by compilers that fuse multiply-adds within an expression.
+ */
+template<typename T> struct ScaleReference {
+  static constexpr bool is_byte = std::is_same_v<T, uchar>;
+
+  static void scale_down_line(const T *src, T *dst, const int stride, const int len, int newlen)
+  {
+    const float add = (len - 0.01) / newlen;
+    float sample = 0.0f;
+    float val[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float nval[4];
+    for (; newlen > 0; newlen--) {
+      for (int c = 0; c < 4; c++) {
+        nval[c] = -val[c] * sample;
+      }
+      sample += add;
+      while (sample >= 1.0f) {
+        sample -= 1.0f;
+        for (int c = 0; c < 4; c++) {
+          nval[c] += src[c];
+        }
+        src += stride;
+      }
+      for (int c = 0; c < 4; c++) {
+        val[c] = src[c];
+        const float weighted = sample * val[c];
+        const float result = (nval[c] + weighted) / add;
+        dst[c] = is_byte ? T(roundf(result)) : T(result);
+      }
+      src += stride;
+      dst += stride;
+      sample -= 1.0f;
+    }
+  }
+
+  static void scale_up_line(const T *src, T *dst, const int stride, const int len, int newlen)
+  {
+    if (len == 1) {
+      for (; newlen > 0; newlen--) {
+        std::copy(src, src + 4, dst);
+        dst += stride;
+      }
+      return;
+    }
+    /* Bytes are truncated, rounding is done by adding a half. */
+    const float round_ofs = is_byte ? 0.5f : 0.0f;
+    const float add = (len - 1.001) / (newlen - 1.0);
+    float sample = 0.0f;
+    float val[4], nval[4], diff[4];
+    for (int c = 0; c < 4; c++) {
+      val[c] = src[c];
+      nval[c] = src[stride + c];
+      diff[c] = nval[c] - val[c];
+      val[c] += round_ofs;
+    }
+    src += 2 * stride;
+    for (; newlen > 0; newlen--) {
+      if (sample >= 1.0f) {
+        sample -= 1.0f;
+        for (int c = 0; c < 4; c++) {
+          val[c] = nval[c];
+          nval[c] = src[c];
+          diff[c] = nval[c] - val[c];
+          val[c] += round_ofs;
+        }
+        src += stride;
+      }
+      for (int c = 0; c < 4; c++) {
+        const float weighted = sample * diff[c];
+        dst[c] = T(val[c] + weighted);
+      }
+      dst += stride;
+      sample += add;
+    }
+  }
+
+  static TestImage<T> scale_x(const TestImage<T> &src, const int newx)
+  {
+    TestImage<T> dst(newx, src.y);
+    for (int y = 0; y < src.y; y++) {
+      const T *src_line = &src.pixels[size_t(y) * src.x * 4];
+      T *dst_line = &dst.pixels[size_t(y) * newx * 4];
+      if (newx < src.x) {
+        scale_down_line(src_line, dst_line, 4, src.x, newx);
+      }
+      else {
+        scale_up_line(src_line, dst_line, 4, src.x, newx);
+      }
+    }
+    return dst;
+  }
+
+  static TestImage<T> scale_y(const TestImage<T> &src, const int newy)
+  {
+    TestImage<T> dst(src.x, newy);
+    for (int x = 0; x < src.x; x++) {
+      if (newy < src.y) {
+        scale_down_line(&src.pixels[x * 4], &dst.pixels[x * 4], src.x * 4, src.y, newy);
+      }
+      else {
+        scale_up_line(&src.pixels[x * 4], &dst.pixels[x * 4], src.x * 4, src.y, newy);
+      }
+    }
+    return dst;
+  }
+
+  /** Same order of passes as #IMB_scaleImBuf. */
+  static TestImage<T> scale(TestImage<T> image, const int newx, const int newy)
+  {
+    if (newx < image.x) {
+      image = scale_x(image, newx);
+    }
+    if (newy < image.y) {
+      image = scale_y(image, newy);
+    }
+    if (newx > image.x) {
+      image = scale_x(image, newx);
+    }
+    if (newy > image.y) {
+      image = scale_y(image, newy);
+    }
+    return image;
+  }
+};
+
+static void test_scale(const int x, const int y, const int newx, const int newy)
+{
+  SCOPED_TRACE(testing::Message() << x << "x" << y << " to " << newx << "x" << newy);
+  ImBuf *ibuf = create_test_image(x, y, IB_rect | IB_rectfloat, uint32_t(x * 1000 + y));
+
+  TestImage<uchar> ref_byte(x, y);
+  TestImage<float> ref_float(x, y);
+  const uchar *rect = reinterpret_cast<const uchar *>(ibuf->rect);
+  ref_byte.pixels.assign(rect, rect + ref_byte.pixels.size());
+  ref_float.pixels.assign(ibuf->rect_float, ibuf->rect_float + ref_float.pixels.size());
+  ref_byte = ScaleReference<uchar>::scale(ref_byte, newx, newy);
+  ref_float = ScaleReference<float>::scale(ref_float, newx, newy);
+  ImBuf *expected = IMB_allocImBuf(newx, newy, 32, IB_rect | IB_rectfloat);
+  std::copy(ref_byte.pixels.begin(),
+            ref_byte.pixels.end(),
+            reinterpret_cast<uchar *>(expected->rect));
+  std::copy(ref_float.pixels.begin(), ref_float.pixels.end(), expected->rect_float);
+
+  ASSERT_TRUE(IMB_scaleImBuf(ibuf, newx, newy));
+  /* The same operations in the same order, the results are bit identical. */
+  expect_images_equal(ibuf, expected);
+
+  IMB_freeImBuf(ibuf);
+  IMB_freeImBuf(expected);
+}
+
+TEST(imbuf_scaling, scale_down)
+{
+  test_scale(13, 9, 5, 4);
+  test_scale(17, 3, 6, 3);
+  test_scale(3, 17, 3, 6);
+  test_scale(7, 7, 1, 1);
+  test_scale(31, 33, 30, 32);
+}
+
+TEST(imbuf_scaling, scale_up)
+{
+  test_scale(5, 4, 13, 9);
+  test_scale(6, 3, 17, 3);
+  test_scale(3, 6, 3, 17);
+  test_scale(2, 2, 7, 5);
+  test_scale(30, 32, 31, 33);
+}
+
+TEST(imbuf_scaling, scale_single_pixel_lines)
+{
+  /* Lines of one pixel are copied when scaling up. */
+  test_scale(1, 1, 5, 3);
+  test_scale(1, 7, 3, 7);
+  test_scale(7, 1, 7, 5);
+  test_scale(1, 9, 4, 2);
+}
+
+TEST(imbuf_scaling, scale_mixed)
+{
+  test_scale(17, 3, 6, 11);
+  test_scale(3, 17, 11, 6);
+  /* Large enough to be scaled by multiple threads. */
+  test_scale(257, 131, 129, 263);
+  test_scale(131, 257, 263, 129);
+}
+
+}  // namespace blender::imbuf::tests
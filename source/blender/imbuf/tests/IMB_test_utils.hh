@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup imbuf
+ *
+ * Utilities to compare image operations with pixel by pixel reference implementations.
+ */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "BLI_rand.hh"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+namespace blender::imbuf::tests {
+
+/**
+ * Whether the compiler may contract a multiply and an add in the same expression into a fused
+ * multiply-add, which skips the rounding of the product. Clang does so on targets that have the
+ * instruction (ARM64, or x86 with FMA enabled). GCC builds use `-ffp-contract=off`, MSVC doesn't
+ * contract by default, and SIMD intrinsics are never fused.
+ */
+#if defined(__clang__) && defined(__FP_FAST_FMAF)
+constexpr bool compiler_may_fuse_multiply_add = true;
+#else
+constexpr bool compiler_may_fuse_multiply_add = false;
+#endif
+
+/**
+ * Image with random pixels, for the buffers in \a flags (#IB_rect and/or #IB_rectfloat).
+ * A quarter of the pixels are fully transparent and another quarter fully opaque, for the early
+ * outs of operations on alpha. Float colors go outside of the 0..1 range.
+ */
+inline ImBuf *create_test_image(const int x, const int y, const int flags, const uint32_t seed)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, flags);
+  RandomNumberGenerator rng(seed);
+  uchar *rect = reinterpret_cast<uchar *>(ibuf->rect);
+  for (size_t i = 0; i < size_t(x) * y; i++) {
+    const int alpha_kind = rng.get_int32(4);
+    if (rect) {
+      uchar *pixel = rect + i * 4;
+      for (int c = 0; c < 3; c++) {
+        pixel[c] = uchar(rng.get_int32(256));
+      }
+      pixel[3] = alpha_kind == 0 ? 0 : (alpha_kind == 1 ? 255 : uchar(rng.get_int32(256)));
+    }
+    if (ibuf->rect_float) {
+      float *pixel = ibuf->rect_float + i * 4;
+      for (int c = 0; c < 3; c++) {
+        pixel[c] = rng.get_float() * 3.0f - 1.0f;
+      }
+      pixel[3] = alpha_kind == 0 ? 0.0f : (alpha_kind == 1 ? 1.0f : rng.get_float());
+    }
+  }
+  return ibuf;
+}
+
+/** Largest differences allowed when comparing with a reference, exact by default. */
+struct ImageTolerance {
+  int byte = 0;
+  /** In units of the float epsilon, relative to the expected value (or to 1 when smaller). */
+  float float_epsilons = 0.0f;
+};
+
+/** Compare the byte and float buffers that both images have, pixel by pixel. */
+inline void expect_images_equal(const ImBuf *result,
+                                const ImBuf *expected,
+                                const ImageTolerance tolerance = {})
+{
+  ASSERT_EQ(result->x, expected->x);
+  ASSERT_EQ(result->y, expected->y);
+  const uchar *rect = reinterpret_cast<const uchar *>(result->rect);
+  const uchar *rect_expected = reinterpret_cast<const uchar *>(expected->rect);
+  for (size_t i = 0; i < size_t(result->x) * result->y * 4; i++) {
+    const int pixel = int(i / 4);
+    if (rect && rect_expected) {
+      EXPECT_LE(std::abs(int(rect[i]) - int(rect_expected[i])), tolerance.byte)
+          << "byte pixel " << pixel % result->x << "," << pixel / result->x << " channel "
+          << i % 4 << ": " << int(rect[i]) << ", expected " << int(rect_expected[i]);
+    }
+    if (result->rect_float && expected->rect_float) {
+      const float value = result->rect_float[i];
+      const float value_expected = expected->rect_float[i];
+      const float max_diff = tolerance.float_epsilons * FLT_EPSILON *
+                             std::max(std::abs(value_expected), 1.0f);
+      EXPECT_LE(std::abs(value - value_expected), max_diff)
+          << "float pixel " << pixel % result->x << "," << pixel / result->x << " channel "
+          << i % 4 << ": " << value << ", expected " << value_expected;
+    }
+  }
+}
+
+}  // namespace blender::imbuf::tests
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "BLI_math.h"
+#include "BLI_rect.h"
+
+#include "IMB_test_utils.hh"
+
+namespace blender::imbuf::tests {
+
+/** Value of destination pixels that are not written (discarded by cropping). */
+static const float untouched_fl = -7.0f;
+static const uchar untouched_char = 42;
+
+static ImBuf *create_source_image(const int x,
+                                  const int y,
+                                  const int channels,
+                                  const bool is_float)
+{
+  ImBuf *ibuf = create_test_image(
+      x, y, is_float ? IB_rectfloat : IB_rect, uint32_t(x * 100 + y * 10 + channels));
+  /* Fewer channels use the start of the same random buffer. */
+  ibuf->channels = channels;
+  return ibuf;
+}
+
+static ImBuf *create_destination_image(const int x, const int y, const bool is_float)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, is_float ? IB_rectfloat : IB_rect);
+  if (is_float) {
+    std::fill(ibuf->rect_float, ibuf->rect_float + size_t(x) * y * 4, untouched_fl);
+  }
+  else {
+    uchar *rect = reinterpret_cast<uchar *>(ibuf->rect);
+    std::fill(rect, rect + size_t(x) * y * 4, untouched_char);
+  }
+  return ibuf;
+}
+
+static float wrap_repeat(const float f, const int size)
+{
+  int i = int(floor(f)) % size;
+  if (i < 0) {
+    i += size;
+  }
+  return i;
+}
+
+/**
+ * Scalar implementation of #IMB_transform, sampling every pixel with the generic interpolation
+ * functions of BLI, as done before sampling was vectorized.
+ */
+static void transform_reference(const ImBuf *src,
+                                ImBuf *dst,
+                                const eIMBTransformMode mode,
+                                const eIMBInterpolationFilterMode filter,
+                                const float transform_matrix[4][4],
+                                const rctf *src_crop)
+{
+  const bool is_float = dst->rect_float != nullptr;
+  const int channels = is_float ? src->channels : 4;
+
+  /* Same stepping through the source image as the transform. */
+  const float orig[3] = {0.0f, 0.0f, 0.0f};
+  const float uv_max_x[3] = {float(src->x), 0.0f, 0.0f};
+  const float uv_max_y[3] = {0.0f, float(src->y), 0.0f};
+  float start_uv[3], add_x[3], add_y[3];
+  mul_v3_m4v3(start_uv, transform_matrix, orig);
+  mul_v3_m4v3(add_x, transform_matrix, uv_max_x);
+  sub_v2_v2(add_x, start_uv);
+  mul_v2_fl(add_x, 1.0f / src->x);
+  mul_v3_m4v3(add_y, transform_matrix, uv_max_y);
+  sub_v2_v2(add_y, start_uv);
+  mul_v2_fl(add_y, 1.0f / src->y);
+
+  for (int y = 0; y < dst->y; y++) {
+    float uv[2];
+    madd_v2_v2v2fl(uv, start_uv, add_y, y);
+    for (int x = 0; x < dst->x; x++, add_v2_v2(uv, add_x)) {
+      if (mode == IMB_TRANSFORM_MODE_CROP_SRC &&
+          (uv[0] < src_crop->xmin || uv[0] >= src_crop->xmax || uv[1] < src_crop->ymin ||
+           uv[1] >= src_crop->ymax)) {
+        continue;
+      }
+      float u = uv[0], v = uv[1];
+      const bool use_wrap_fl = mode == IMB_TRANSFORM_MODE_WRAP_REPEAT &&
+                               filter == IMB_FILTER_BILINEAR && is_float && channels != 4;
+      if (mode == IMB_TRANSFORM_MODE_WRAP_REPEAT) {
+        u = wrap_repeat(u, src->x);
+        v = wrap_repeat(v, src->y);
+      }
+
+      const size_t dst_offset = (size_t(y) * dst->x + x) * 4;
+      if (!is_float) {
+        uchar *dst_pixel = reinterpret_cast<uchar *>(dst->rect) + dst_offset;
+        const uchar *src_rect = reinterpret_cast<const uchar *>(src->rect);
+        if (filter == IMB_FILTER_BILINEAR) {
+          BLI_bilinear_interpolation_char(src_rect, dst_pixel, src->x, src->y, 4, u, v);
+        }
+        else {
+          const int x1 = int(u), y1 = int(v);
+          if (x1 < 0 || x1 >= src->x || y1 < 0 || y1 >= src->y) {
+            memset(dst_pixel, 0, 4);
+          }
+          else {
+            copy_v4_v4_uchar(dst_pixel, src_rect + (size_t(y1) * src->x + x1) * 4);
+          }
+        }
+        continue;
+      }
+
+      float sample[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+      if (use_wrap_fl) {
+        BLI_bilinear_interpolation_wrap_fl(
+            src->rect_float, sample, src->x, src->y, channels, u, v, true, true);
+      }
+      else if (filter == IMB_FILTER_BILINEAR) {
+        BLI_bilinear_interpolation_fl(src->rect_float, sample, src->x, src->y, channels, u, v);
+      }
+      else {
+        const int x1 = int(u), y1 = int(v);
+        if (x1 >= 0 && x1 < src->x && y1 >= 0 && y1 < src->y) {
+          const float *src_pixel = src->rect_float + (size_t(y1) * src->x + x1) * channels;
+          std::copy(src_pixel, src_pixel + channels, sample);
+        }
+      }
+      float *dst_pixel = dst->rect_float + dst_offset;
+      switch (channels) {
+        case 1:
+          copy_v4_fl4(dst_pixel, sample[0], sample[0], sample[0], 1.0f);
+          break;
+        case 2:
+          copy_v4_fl4(dst_pixel, sample[0], sample[1], 0.0f, 1.0f);
+          break;
+        case 3:
+          copy_v4_fl4(dst_pixel, sample[0], sample[1], sample[2], 1.0f);
+          break;
+        default:
+          copy_v4_v4(dst_pixel, sample);
+          break;
+      }
+    }
+  }
+}
+
+static void test_transform(const float transform_matrix[4][4])
+{
+  const rctf src_crop = {2.5f, 10.0f, 1.0f, 8.5f};
+  for (const bool is_float : {false, true}) {
+    for (const int channels : {1, 3, 4}) {
+      if (!is_float && channels != 4) {
+        continue;
+      }
+      for (const eIMBInterpolationFilterMode filter : {IMB_FILTER_NEAREST, IMB_FILTER_BILINEAR}) {
+        for (const eIMBTransformMode mode : {IMB_TRANSFORM_MODE_REGULAR,
+                                             IMB_TRANSFORM_MODE_CROP_SRC,
+                                             IMB_TRANSFORM_MODE_WRAP_REPEAT}) {
+          SCOPED_TRACE(testing::Message() << (is_float ? "float " : "byte ") << channels
+                                          << " channels, filter " << filter << ", mode " << mode);
+          const rctf *crop = mode == IMB_TRANSFORM_MODE_CROP_SRC ? &src_crop : nullptr;
+          ImBuf *src = create_source_image(13, 11, channels, is_float);
+          ImBuf *dst = create_destination_image(17, 9, is_float);
+          ImBuf *dst_ref = create_destination_image(17, 9, is_float);
+
+          IMB_transform(src, dst, mode, filter, transform_matrix, crop);
+          transform_reference(src, dst_ref, mode, filter, transform_matrix, crop);
+
+          /* Bit identical, unless the compiler fused the multiply-adds of the reference: the
+           * BLI bilinear functions mix the four source pixels in a single expression. Then floats
+           * differ by the rounding of up to four products, and bytes can round the other way. */
+          ImageTolerance tolerance;
+          if (compiler_may_fuse_multiply_add && filter == IMB_FILTER_BILINEAR) {
+            tolerance.byte = 1;
+            tolerance.float_epsilons = 4.0f;
+          }
+          expect_images_equal(dst, dst_ref, tolerance);
+
+          IMB_freeImBuf(src);
+          IMB_freeImBuf(dst);
+          IMB_freeImBuf(dst_ref);
+        }
+      }
+    }
+  }
+}
+
+TEST(imbuf_transform, axis_aligned)
+{
+  /* Scale and translation only: the V coordinate is the same along scanlines. Sampling goes past
+   * the image edges on all sides. */
+  float transform_matrix[4][4];
+  unit_m4(transform_matrix);
+  transform_matrix[0][0] = 0.85f;
+  transform_matrix[1][1] = 1.3f;
+  transform_matrix[3][0] = -1.75f;
+  transform_matrix[3][1] = -0.6f;
+  test_transform(transform_matrix);
+}
+
+TEST(imbuf_transform, axis_aligned_flipped)
+{
+  float transform_matrix[4][4];
+  unit_m4(transform_matrix);
+  transform_matrix[0][0] = -0.7f;
+  transform_matrix[1][1] = -1.1f;
+  transform_matrix[3][0] = 12.5f;
+  transform_matrix[3][1] = 9.25f;
+  test_transform(transform_matrix);
+}
+
+TEST(imbuf_transform, axis_aligned_pixel_centers)
+{
+  /* Samples exactly on source pixels, bilinear weights of 0 and 1. */
+  float transform_matrix[4][4];
+  unit_m4(transform_matrix);
+  transform_matrix[3][0] = -2.0f;
+  transform_matrix[3][1] = 1.0f;
+  test_transform(transform_matrix);
+}
+
+TEST(imbuf_transform, rotated)
+{
+  float transform_matrix[4][4];
+  unit_m4(transform_matrix);
+  const float angle = DEG2RADF(30.0f);
+  transform_matrix[0][0] = cosf(angle) * 0.9f;
+  transform_matrix[0][1] = sinf(angle) * 0.9f;
+  transform_matrix[1][0] = -sinf(angle) * 1.2f;
+  transform_matrix[1][1] = cosf(angle) * 1.2f;
+  transform_matrix[3][0] = 3.5f;
+  transform_matrix[3][1] = -2.25f;
+  test_transform(transform_matrix);
+}
+
+}  // namespace blender::imbuf::tests
@@ -6,6 +6,7 @@
  */
 
 #include "abc_reader_archive.h"
+#include "abc_sample_cache.h"
 
 #include "Alembic/AbcCoreLayer/Read.h"
 
@@ -111,19 +112,26 @@ ArchiveReader::ArchiveReader(struct Main *bmain, const char *filename)
 #ifdef WIN32
   UTF16_ENCODE(abs_filename);
   std::wstring wstr(abs_filename_16);
-  m_infile.open(wstr.c_str(), std::ios::in | std::ios::binary);
   UTF16_UN_ENCODE(abs_filename);
-#else
-  m_infile.open(abs_filename, std::ios::in | std::ios::binary);
 #endif
 
-  m_streams.push_back(&m_infile);
+  for (std::ifstream &infile : m_infiles) {
+#ifdef WIN32
+    infile.open(wstr.c_str(), std::ios::in | std::ios::binary);
+#else
+    infile.open(abs_filename, std::ios::in | std::ios::binary);
+#endif
+    m_streams.push_back(&infile);
+  }
 
   m_archive = open_archive(abs_filename, m_streams);
 }
 
 ArchiveReader::~ArchiveReader()
 {
+  if (m_archive.valid()) {
+    MeshSampleCache::get().remove_archive(m_archive.getTop().getArchive().getPtr().get());
+  }
   for (ArchiveReader *reader : m_readers) {
     delete reader;
   }
@@ -22,7 +22,8 @@ namespace blender::io::alembic {
 
 class ArchiveReader {
   Alembic::Abc::IArchive m_archive;
-  std::ifstream m_infile;
+  /* Ogawa serves concurrent reads (e.g. from sample prefetching) from separate streams. */
+  std::ifstream m_infiles[4];
   std::vector<std::istream *> m_streams;
 
   std::vector<ArchiveReader *> m_readers;
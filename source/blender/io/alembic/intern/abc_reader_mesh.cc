@@ -468,11 +468,11 @@ static void read_velocity(const V3fArraySamplePtr &velocities,
 static void read_mesh_sample(const std::string &iobject_full_name,
                              ImportSettings *settings,
                              const IPolyMeshSchema &schema,
+                             MeshSamplePrefetcher &samples,
+                             const IPolyMeshSchema::Sample &sample,
                              const ISampleSelector &selector,
                              CDStreamConfig &config)
 {
-  const IPolyMeshSchema::Sample sample = schema.getValue(selector);
-
   AbcMeshData abc_mesh_data;
   abc_mesh_data.face_counts = sample.getFaceCounts();
   abc_mesh_data.face_indices = sample.getFaceIndices();
@@ -481,8 +481,8 @@ static void read_mesh_sample(const std::string &iobject_full_name,
   get_weight_and_index(config, schema.getTimeSampling(), schema.getNumSamples());
 
   if (config.weight != 0.0f) {
-    Alembic::AbcGeom::IPolyMeshSchema::Sample ceil_sample;
-    schema.get(ceil_sample, Alembic::Abc::ISampleSelector(config.ceil_index));
+    const IPolyMeshSchema::Sample ceil_sample = samples.get(
+        Alembic::Abc::ISampleSelector(config.ceil_index));
     abc_mesh_data.ceil_positions = ceil_sample.getPositions();
   }
 
@@ -541,6 +541,7 @@ AbcMeshReader::AbcMeshReader(const IObject &object, ImportSettings &settings)
 
   IPolyMesh ipoly_mesh(m_iobject, kWrapExisting);
   m_schema = ipoly_mesh.getSchema();
+  m_samples = std::make_unique<MeshSamplePrefetcher>(m_iobject, m_schema);
 
   get_min_max_time(m_iobject, m_schema, m_min_time, m_max_time);
 }
@@ -659,7 +660,7 @@ bool AbcMeshReader::topology_changed(const Mesh *existing_mesh, const ISampleSel
 {
   IPolyMeshSchema::Sample sample;
   try {
-    sample = m_schema.getValue(sample_sel);
+    sample = m_samples->get(sample_sel);
   }
   catch (Alembic::Util::Exception &ex) {
     printf("Alembic: error reading mesh sample for '%s/%s' at time %f: %s\n",
@@ -689,7 +690,7 @@ Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
 {
   IPolyMeshSchema::Sample sample;
   try {
-    sample = m_schema.getValue(sample_sel);
+    sample = m_samples->get(sample_sel);
   }
   catch (Alembic::Util::Exception &ex) {
     if (err_str != nullptr) {
@@ -758,7 +759,8 @@ Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
   config.time = sample_sel.getRequestedTime();
   config.modifier_error_message = err_str;
 
-  read_mesh_sample(m_iobject.getFullName(), &settings, m_schema, sample_sel, config);
+  read_mesh_sample(
+      m_iobject.getFullName(), &settings, m_schema, *m_samples, sample, sample_sel, config);
 
   if (new_mesh) {
     /* Here we assume that the number of materials doesn't change, i.e. that
@@ -776,6 +778,11 @@ Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
   return existing_mesh;
 }
 
+void AbcMeshReader::prefetch_samples_after(const ISampleSelector &sample_sel)
+{
+  m_samples->prefetch_after(sample_sel);
+}
+
 void AbcMeshReader::assign_facesets_to_mpoly(const ISampleSelector &sample_sel,
                                              MPoly *mpoly,
                                              int totpoly,
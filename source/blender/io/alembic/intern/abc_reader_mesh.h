@@ -7,6 +7,9 @@
 
 #include "abc_customdata.h"
 #include "abc_reader_object.h"
+#include "abc_sample_cache.h"
+
+#include <memory>
 
 struct Mesh;
 
@@ -14,6 +17,7 @@ namespace blender::io::alembic {
 
 class AbcMeshReader final : public AbcObjectReader {
   Alembic::AbcGeom::IPolyMeshSchema m_schema;
+  std::unique_ptr<MeshSamplePrefetcher> m_samples;
 
  public:
   AbcMeshReader(const Alembic::Abc::IObject &object, ImportSettings &settings);
@@ -32,6 +36,7 @@ class AbcMeshReader final : public AbcObjectReader {
                          const char **err_str) override;
   bool topology_changed(const Mesh *existing_mesh,
                         const Alembic::Abc::ISampleSelector &sample_sel) override;
+  void prefetch_samples_after(const Alembic::Abc::ISampleSelector &sample_sel) override;
 
  private:
   void readFaceSetsSample(Main *bmain,
@@ -141,6 +141,10 @@ class AbcObjectReader {
                                  const char **err_str);
   virtual bool topology_changed(const Mesh *existing_mesh,
                                 const Alembic::Abc::ISampleSelector &sample_sel);
+  /** Start reading the samples following the selected one in the background, for playback. */
+  virtual void prefetch_samples_after(const Alembic::Abc::ISampleSelector & /*sample_sel*/)
+  {
+  }
 
   /** Reads the object matrix and sets up an object transform if animated. */
   void setupObjectTransform(chrono_t time);
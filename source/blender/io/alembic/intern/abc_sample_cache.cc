@@ -0,0 +1,221 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup balembic
+ */
+
+#include "abc_sample_cache.h"
+
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_hash.hh"
+#include "BLI_task.h"
+
+#include "DNA_userdef_types.h"
+
+using Alembic::Abc::ISampleSelector;
+using Alembic::AbcGeom::index_t;
+using Alembic::AbcGeom::IPolyMeshSchema;
+
+namespace blender::io::alembic {
+
+/* Number of samples read ahead of the last requested one. */
+static const int PREFETCH_SAMPLES_NUM = 4;
+
+template<typename T> static size_t array_sample_size(const T &array_sample)
+{
+  return array_sample ? array_sample->size() * sizeof(typename T::element_type::value_type) : 0;
+}
+
+static size_t mesh_sample_size(const IPolyMeshSchema::Sample &sample)
+{
+  return sizeof(sample) + array_sample_size(sample.getPositions()) +
+         array_sample_size(sample.getVelocities()) + array_sample_size(sample.getFaceIndices()) +
+         array_sample_size(sample.getFaceCounts());
+}
+
+size_t MeshSampleCache::KeyHash::operator()(const Key &key) const
+{
+  return get_default_hash_3(key.archive, key.object_path, int64_t(key.sample_index));
+}
+
+MeshSampleCache::MeshSampleCache(const size_t budget) : m_budget(budget)
+{
+}
+
+MeshSampleCache &MeshSampleCache::get()
+{
+  static MeshSampleCache cache(0);
+  /* Follow the memory cache limit preference, which can be changed at any time. */
+  cache.set_budget(size_t(U.memcachelimit) * 1024 * 1024);
+  return cache;
+}
+
+void MeshSampleCache::set_budget(const size_t budget)
+{
+  std::lock_guard lock(m_mutex);
+  m_budget = budget;
+  evict_to_budget();
+}
+
+size_t MeshSampleCache::used_size() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_used_size;
+}
+
+bool MeshSampleCache::lookup(const Key &key, IPolyMeshSchema::Sample &r_sample)
+{
+  std::lock_guard lock(m_mutex);
+  auto it = m_entries.find(key);
+  if (it == m_entries.end()) {
+    return false;
+  }
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru_position);
+  r_sample = it->second.sample;
+  return true;
+}
+
+bool MeshSampleCache::contains(const Key &key)
+{
+  std::lock_guard lock(m_mutex);
+  return m_entries.find(key) != m_entries.end();
+}
+
+void MeshSampleCache::add(const Key &key, const IPolyMeshSchema::Sample &sample)
+{
+  std::lock_guard lock(m_mutex);
+  if (m_entries.find(key) != m_entries.end()) {
+    /* Read by another thread in the meantime. */
+    return;
+  }
+  m_lru.push_front(key);
+  Entry entry;
+  entry.sample = sample;
+  entry.size = mesh_sample_size(sample);
+  entry.lru_position = m_lru.begin();
+  m_used_size += entry.size;
+  m_entries.emplace(key, std::move(entry));
+  evict_to_budget();
+}
+
+void MeshSampleCache::remove_archive(const void *archive)
+{
+  std::lock_guard lock(m_mutex);
+  for (auto it = m_lru.begin(); it != m_lru.end();) {
+    if (it->archive != archive) {
+      ++it;
+      continue;
+    }
+    auto entry = m_entries.find(*it);
+    m_used_size -= entry->second.size;
+    m_entries.erase(entry);
+    it = m_lru.erase(it);
+  }
+}
+
+void MeshSampleCache::evict_to_budget()
+{
+  while (m_used_size > m_budget && !m_lru.empty()) {
+    auto entry = m_entries.find(m_lru.back());
+    m_used_size -= entry->second.size;
+    m_entries.erase(entry);
+    m_lru.pop_back();
+  }
+}
+
+/* ************************************************************************** */
+
+MeshSamplePrefetcher::MeshSamplePrefetcher(const Alembic::Abc::IObject &object,
+                                           const IPolyMeshSchema &schema)
+    : m_schema(schema),
+      m_archive(object.getArchive().getPtr().get()),
+      m_object_path(object.getFullName()),
+      m_task_pool(nullptr)
+{
+}
+
+MeshSamplePrefetcher::~MeshSamplePrefetcher()
+{
+  if (m_task_pool) {
+    /* The tasks read from the archive, which is closed after its readers are freed. */
+    BLI_task_pool_cancel(m_task_pool);
+    BLI_task_pool_free(m_task_pool);
+  }
+}
+
+MeshSampleCache::Key MeshSamplePrefetcher::key(const index_t sample_index) const
+{
+  return {m_archive, m_object_path, sample_index};
+}
+
+IPolyMeshSchema::Sample MeshSamplePrefetcher::get(const ISampleSelector &sample_sel)
+{
+  const index_t sample_index = sample_sel.getIndex(m_schema.getTimeSampling(),
+                                                   m_schema.getNumSamples());
+  MeshSampleCache &cache = MeshSampleCache::get();
+  IPolyMeshSchema::Sample sample;
+  if (!cache.lookup(key(sample_index), sample)) {
+    m_schema.get(sample, ISampleSelector(sample_index));
+    cache.add(key(sample_index), sample);
+  }
+  return sample;
+}
+
+void MeshSamplePrefetcher::prefetch_after(const ISampleSelector &sample_sel)
+{
+  const index_t samples_num = m_schema.getNumSamples();
+  if (samples_num <= 1) {
+    return;
+  }
+  const index_t sample_index = sample_sel.getIndex(m_schema.getTimeSampling(), samples_num);
+  const index_t last_index = std::min<index_t>(sample_index + PREFETCH_SAMPLES_NUM,
+                                               samples_num - 1);
+
+  MeshSampleCache &cache = MeshSampleCache::get();
+  std::lock_guard lock(m_pending_mutex);
+  for (index_t index = sample_index + 1; index <= last_index; index++) {
+    if (m_pending.count(index) || cache.contains(key(index))) {
+      continue;
+    }
+    if (m_task_pool == nullptr) {
+      m_task_pool = BLI_task_pool_create_background(this, TASK_PRIORITY_LOW);
+    }
+    index_t *task_index = static_cast<index_t *>(MEM_mallocN(sizeof(index_t), __func__));
+    *task_index = index;
+    m_pending.insert(index);
+    BLI_task_pool_push(m_task_pool, prefetch_task, task_index, true, nullptr);
+  }
+}
+
+void MeshSamplePrefetcher::wait_for_prefetch()
+{
+  if (m_task_pool) {
+    BLI_task_pool_work_and_wait(m_task_pool);
+  }
+}
+
+void MeshSamplePrefetcher::prefetch_task(TaskPool *__restrict pool, void *taskdata)
+{
+  MeshSamplePrefetcher *prefetcher = static_cast<MeshSamplePrefetcher *>(
+      BLI_task_pool_user_data(pool));
+  const index_t sample_index = *static_cast<const index_t *>(taskdata);
+
+  if (!BLI_task_pool_current_canceled(pool)) {
+    try {
+      IPolyMeshSchema::Sample sample;
+      prefetcher->m_schema.get(sample, ISampleSelector(sample_index));
+      MeshSampleCache::get().add(prefetcher->key(sample_index), sample);
+    }
+    catch (Alembic::Util::Exception &) {
+      /* Errors are reported when the sample is read for evaluation. */
+    }
+  }
+
+  std::lock_guard lock(prefetcher->m_pending_mutex);
+  prefetcher->m_pending.erase(sample_index);
+}
+
+}  // namespace blender::io::alembic
@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#pragma once
+
+/** \file
+ * \ingroup balembic
+ */
+
+#include <Alembic/Abc/All.h>
+#include <Alembic/AbcGeom/All.h>
+
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+struct TaskPool;
+
+namespace blender::io::alembic {
+
+/**
+ * Memory-budgeted cache of decoded poly-mesh samples, shared by all open archives.
+ *
+ * Samples are keyed by archive, object path and sample index (which identifies the sample time
+ * in the object's time sampling). When the budget is exceeded the least recently used samples
+ * are evicted.
+ */
+class MeshSampleCache {
+ public:
+  struct Key {
+    const void *archive;
+    std::string object_path;
+    Alembic::AbcGeom::index_t sample_index;
+
+    bool operator==(const Key &other) const
+    {
+      return archive == other.archive && sample_index == other.sample_index &&
+             object_path == other.object_path;
+    }
+  };
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  struct Entry {
+    Alembic::AbcGeom::IPolyMeshSchema::Sample sample;
+    size_t size;
+    std::list<Key>::iterator lru_position;
+  };
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<Key, Entry, KeyHash> m_entries;
+  /** Most recently used keys first. */
+  std::list<Key> m_lru;
+  size_t m_used_size = 0;
+  size_t m_budget;
+
+ public:
+  /** Use #get for the cache shared by the archives, other instances are for testing. */
+  explicit MeshSampleCache(size_t budget);
+
+  /** The budget of the shared cache is the "Memory Cache Limit" preference. */
+  static MeshSampleCache &get();
+
+  /** Change the memory budget in bytes, evicting samples when the new budget is exceeded. */
+  void set_budget(size_t budget);
+  /** Memory in bytes used by the cached samples. */
+  size_t used_size() const;
+
+  bool lookup(const Key &key, Alembic::AbcGeom::IPolyMeshSchema::Sample &r_sample);
+  bool contains(const Key &key);
+  void add(const Key &key, const Alembic::AbcGeom::IPolyMeshSchema::Sample &sample);
+
+  /**
+   * Drop all samples of an archive. Must be called before the archive is closed, as a later
+   * archive could be allocated at the same address.
+   */
+  void remove_archive(const void *archive);
+
+ private:
+  void evict_to_budget();
+};
+
+/**
+ * Reads the samples of one poly-mesh schema through the #MeshSampleCache, and decodes the
+ * samples following the last requested one on background threads so that playback does not
+ * wait for the file.
+ */
+class MeshSamplePrefetcher {
+  Alembic::AbcGeom::IPolyMeshSchema m_schema;
+  const void *m_archive;
+  std::string m_object_path;
+
+  TaskPool *m_task_pool;
+  std::mutex m_pending_mutex;
+  /** Sample indices that are scheduled or being read on a background thread. */
+  std::set<Alembic::AbcGeom::index_t> m_pending;
+
+ public:
+  MeshSamplePrefetcher(const Alembic::Abc::IObject &object,
+                       const Alembic::AbcGeom::IPolyMeshSchema &schema);
+  /** Cancels the scheduled reads and waits for the running ones. */
+  ~MeshSamplePrefetcher();
+
+  MeshSamplePrefetcher(const MeshSamplePrefetcher &other) = delete;
+  MeshSamplePrefetcher &operator=(const MeshSamplePrefetcher &other) = delete;
+
+  /**
+   * Get the sample from the cache, or read it from the file on a miss.
+   * Throws #Alembic::Util::Exception like #IPolyMeshSchema::getValue.
+   */
+  Alembic::AbcGeom::IPolyMeshSchema::Sample get(const Alembic::Abc::ISampleSelector &sample_sel);
+
+  /** Schedule background reads of the samples following the selected one. */
+  void prefetch_after(const Alembic::Abc::ISampleSelector &sample_sel);
+  /** Wait until the scheduled reads are done. */
+  void wait_for_prefetch();
+
+ private:
+  MeshSampleCache::Key key(Alembic::AbcGeom::index_t sample_index) const;
+  static void prefetch_task(TaskPool *pool, void *taskdata);
+};
+
+}  // namespace blender::io::alembic
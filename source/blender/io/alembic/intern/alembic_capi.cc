@@ -808,12 +808,15 @@ Mesh *ABC_read_mesh(CacheReader *reader,
   }
 
   ISampleSelector sample_sel = sample_selector_for_time(params->time);
-  return abc_reader->read_mesh(existing_mesh,
-                               sample_sel,
-                               params->read_flags,
-                               params->velocity_name,
-                               params->velocity_scale,
-                               err_str);
+  Mesh *mesh = abc_reader->read_mesh(existing_mesh,
+                                     sample_sel,
+                                     params->read_flags,
+                                     params->velocity_name,
+                                     params->velocity_scale,
+                                     err_str);
+  /* Playback usually evaluates the following frames next. */
+  abc_reader->prefetch_samples_after(sample_sel);
+  return mesh;
 }
 
 bool ABC_mesh_topology_changed(CacheReader *reader,
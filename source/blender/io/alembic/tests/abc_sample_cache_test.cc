@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+/* Keep first since utildefines defines AT which conflicts with STL */
+#include "intern/abc_reader_archive.h"
+#include "intern/abc_sample_cache.h"
+
+#include <Alembic/AbcCoreOgawa/All.h>
+
+#include "BKE_appdir.h"
+#include "BKE_main.h"
+#include "BLI_fileops.h"
+#include "BLI_threads.h"
+#include "DNA_userdef_types.h"
+
+using namespace Alembic::AbcGeom;
+
+namespace blender::io::alembic {
+
+static const int SAMPLES_NUM = 8;
+
+/* A triangle that moves one unit along X per sample. */
+static std::string write_test_archive(const char *name)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string filepath = std::string(BKE_tempdir_base()) + name;
+  OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), filepath);
+  const uint32_t time_sampling = archive.addTimeSampling(TimeSampling(1.0 / 24.0, 0.0));
+  OPolyMesh mesh(OObject(archive, kTop), "triangle", time_sampling);
+  const int32_t face_indices[3] = {0, 1, 2};
+  const int32_t face_counts[1] = {3};
+  for (int i = 0; i < SAMPLES_NUM; i++) {
+    const V3f positions[3] = {V3f(i, 0, 0), V3f(i + 1, 0, 0), V3f(i, 1, 0)};
+    mesh.getSchema().set(OPolyMeshSchema::Sample(V3fArraySample(positions, 3),
+                                                 Int32ArraySample(face_indices, 3),
+                                                 Int32ArraySample(face_counts, 1)));
+  }
+  return filepath;
+}
+
+static float first_position_x(const IPolyMeshSchema::Sample &sample)
+{
+  return (*sample.getPositions())[0].x;
+}
+
+class AlembicSampleCacheTest : public testing::Test {
+ protected:
+  Main *bmain;
+  std::string filepath;
+  int memcachelimit;
+
+  void SetUp() override
+  {
+    BLI_threadapi_init();
+    bmain = BKE_main_new();
+    filepath = write_test_archive("abc_sample_cache_test.abc");
+    memcachelimit = U.memcachelimit;
+    U.memcachelimit = 1024;
+  }
+
+  void TearDown() override
+  {
+    U.memcachelimit = memcachelimit;
+    BLI_delete(filepath.c_str(), false, false);
+    BKE_main_free(bmain);
+    BLI_threadapi_exit();
+  }
+};
+
+TEST_F(AlembicSampleCacheTest, prefetch_hits)
+{
+  ArchiveReader *archive = ArchiveReader::get(bmain, {filepath.c_str()});
+  ASSERT_TRUE(archive != nullptr && archive->valid());
+  {
+    const IObject object(archive->getTop(), "triangle");
+    const IPolyMesh mesh(object, kWrapExisting);
+    MeshSamplePrefetcher samples(object, mesh.getSchema());
+    const void *archive_ptr = object.getArchive().getPtr().get();
+    MeshSampleCache &cache = MeshSampleCache::get();
+
+    const ISampleSelector sample_sel(index_t(2));
+    EXPECT_EQ(first_position_x(samples.get(sample_sel)), 2.0f);
+    samples.prefetch_after(sample_sel);
+    samples.wait_for_prefetch();
+
+    /* The four following samples are read ahead, not the ones before or after those. */
+    for (index_t index = 0; index < SAMPLES_NUM; index++) {
+      const bool expect_cached = index >= 2 && index <= 6;
+      EXPECT_EQ(cache.contains({archive_ptr, object.getFullName(), index}), expect_cached)
+          << "sample " << index;
+    }
+    IPolyMeshSchema::Sample sample;
+    EXPECT_TRUE(cache.lookup({archive_ptr, object.getFullName(), 5}, sample));
+    EXPECT_EQ(first_position_x(sample), 5.0f);
+    EXPECT_EQ(first_position_x(samples.get(ISampleSelector(index_t(5)))), 5.0f);
+  }
+  delete archive;
+}
+
+/* Freeing the archive drops its samples, a later archive can be allocated at the same address. */
+TEST_F(AlembicSampleCacheTest, invalidate_on_archive_free)
+{
+  MeshSampleCache &cache = MeshSampleCache::get();
+  const size_t used_size = cache.used_size();
+
+  ArchiveReader *archive = ArchiveReader::get(bmain, {filepath.c_str()});
+  ASSERT_TRUE(archive != nullptr && archive->valid());
+  const IObject object(archive->getTop(), "triangle");
+  const void *archive_ptr = object.getArchive().getPtr().get();
+  const std::string object_path = object.getFullName();
+  {
+    const IPolyMesh mesh(object, kWrapExisting);
+    MeshSamplePrefetcher samples(object, mesh.getSchema());
+    samples.get(ISampleSelector(index_t(0)));
+    samples.prefetch_after(ISampleSelector(index_t(0)));
+    samples.wait_for_prefetch();
+  }
+  EXPECT_TRUE(cache.contains({archive_ptr, object_path, 0}));
+  EXPECT_GT(cache.used_size(), used_size);
+
+  delete archive;
+  for (index_t index = 0; index < SAMPLES_NUM; index++) {
+    EXPECT_FALSE(cache.contains({archive_ptr, object_path, index})) << "sample " << index;
+  }
+  EXPECT_EQ(cache.used_size(), used_size);
+}
+
+TEST_F(AlembicSampleCacheTest, evict_least_recently_used)
+{
+  ArchiveReader *archive = ArchiveReader::get(bmain, {filepath.c_str()});
+  ASSERT_TRUE(archive != nullptr && archive->valid());
+  {
+    const IPolyMesh mesh(IObject(archive->getTop(), "triangle"), kWrapExisting);
+    IPolyMeshSchema::Sample samples[3];
+    for (index_t index = 0; index < 3; index++) {
+      mesh.getSchema().get(samples[index], ISampleSelector(index));
+    }
+
+    /* Keys of another archive, so that the shared cache is not involved. */
+    const int other_archive = 0;
+    const MeshSampleCache::Key keys[3] = {{&other_archive, "/triangle", 0},
+                                          {&other_archive, "/triangle", 1},
+                                          {&other_archive, "/triangle", 2}};
+    MeshSampleCache cache(SIZE_MAX);
+    cache.add(keys[0], samples[0]);
+    const size_t sample_size = cache.used_size();
+    cache.set_budget(sample_size * 2);
+    cache.add(keys[1], samples[1]);
+
+    /* Using the first sample makes the second the least recently used one. */
+    IPolyMeshSchema::Sample sample;
+    EXPECT_TRUE(cache.lookup(keys[0], sample));
+    cache.add(keys[2], samples[2]);
+    EXPECT_TRUE(cache.contains(keys[0]));
+    EXPECT_FALSE(cache.contains(keys[1]));
+    EXPECT_TRUE(cache.contains(keys[2]));
+    EXPECT_EQ(cache.used_size(), sample_size * 2);
+
+    cache.set_budget(0);
+    EXPECT_EQ(cache.used_size(), 0);
+    EXPECT_FALSE(cache.contains(keys[0]));
+  }
+  delete archive;
+}
+
+/* The shared cache follows the memory cache limit preference. */
+TEST_F(AlembicSampleCacheTest, budget_from_preferences)
+{
+  ArchiveReader *archive = ArchiveReader::get(bmain, {filepath.c_str()});
+  ASSERT_TRUE(archive != nullptr && archive->valid());
+  {
+    const IObject object(archive->getTop(), "triangle");
+    const IPolyMesh mesh(object, kWrapExisting);
+    MeshSamplePrefetcher samples(object, mesh.getSchema());
+    samples.get(ISampleSelector(index_t(0)));
+    EXPECT_GT(MeshSampleCache::get().used_size(), 0);
+
+    U.memcachelimit = 0;
+    EXPECT_EQ(MeshSampleCache::get().used_size(), 0);
+    EXPECT_EQ(first_position_x(samples.get(ISampleSelector(index_t(1)))), 1.0f);
+  }
+  delete archive;
+}
+
+}  // namespace blender::io::alembic
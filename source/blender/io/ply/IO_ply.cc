@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#include "BLI_timeit.hh"
+
+#include "IO_ply.h"
+#include "ply_export.hh"
+#include "ply_import.hh"
+
+bool PLY_import(bContext *C,
+                const struct PLYImportParams *import_params,
+                struct ReportList *reports)
+{
+  SCOPED_TIMER("PLY Import");
+  return blender::io::ply::importer_main(C, *import_params, reports);
+}
+
+bool PLY_export(bContext *C,
+                const struct PLYExportParams *export_params,
+                struct ReportList *reports)
+{
+  SCOPED_TIMER("PLY Export");
+  return blender::io::ply::exporter_main(C, *export_params, reports);
+}
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#pragma once
+
+#include "BKE_context.h"
+#include "BLI_path_util.h"
+#include "IO_orientation.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ReportList;
+
+struct PLYImportParams {
+  /** Full path to the source PLY file to import. */
+  char filepath[FILE_MAX];
+  eIOAxis forward_axis;
+  eIOAxis up_axis;
+  bool use_scene_unit;
+  float global_scale;
+  bool use_mesh_validate;
+};
+
+struct PLYExportParams {
+  /** Full path to the destination PLY file. */
+  char filepath[FILE_MAX];
+  eIOAxis forward_axis;
+  eIOAxis up_axis;
+  float global_scale;
+  bool export_selected_objects;
+  bool use_scene_unit;
+  bool apply_modifiers;
+  bool ascii_format;
+  bool export_normals;
+  /** Write the active color attribute, interpolated to vertices. */
+  bool export_colors;
+};
+
+/**
+ * C-interface for the importer.
+ *
+ * \return False if the file could not be imported, the error is added to \a reports.
+ */
+bool PLY_import(bContext *C,
+                const struct PLYImportParams *import_params,
+                struct ReportList *reports);
+
+/**
+ * C-interface for the exporter.
+ *
+ * \return False if the file could not be written, the error is added to \a reports.
+ */
+bool PLY_export(bContext *C,
+                const struct PLYExportParams *export_params,
+                struct ReportList *reports);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,312 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "BKE_attribute.h"
+#include "BKE_blender_version.h"
+#include "BKE_geometry_set.hh"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+#include "BKE_report.h"
+
+#include "BLI_array.hh"
+#include "BLI_color.hh"
+#include "BLI_endian_defines.h"
+#include "BLI_fileops.h"
+#include "BLI_function_ref.hh"
+#include "BLI_math_color.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "ply_export.hh"
+
+namespace blender::io::ply {
+
+/* Size of the stdio buffer: the records are written in large blocks anyway. */
+static const size_t FILE_BUFFER_SIZE = 4 * 1024 * 1024;
+/* Number of records formatted by one task, and number of tasks kept in memory at once. */
+static const int64_t RECORDS_PER_TASK = 4096;
+static const int64_t TASKS_PER_BLOCK = 256;
+
+struct ExportObject {
+  const Mesh *mesh;
+  float transform[4][4];
+  float normal_transform[3][3];
+};
+
+static Mesh *get_export_mesh(const Object *object, const bool apply_modifiers)
+{
+  if (!apply_modifiers && object->type == OB_MESH) {
+    return BKE_object_get_pre_modified_mesh(object);
+  }
+  /* Other object types only have geometry after evaluation. */
+  return BKE_object_get_evaluated_mesh(object);
+}
+
+/**
+ * Format `records_num` records on multiple threads and write them to the file in order.
+ * Binary records are appended to the text as raw bytes in native byte order.
+ */
+static void write_records(FILE *file,
+                          const int64_t records_num,
+                          FunctionRef<void(int64_t record, std::string &r_data)> format_record)
+{
+  const int64_t tasks_num = (records_num + RECORDS_PER_TASK - 1) / RECORDS_PER_TASK;
+  Array<std::string> texts(std::min(tasks_num, TASKS_PER_BLOCK));
+  for (int64_t block_start = 0; block_start < tasks_num; block_start += TASKS_PER_BLOCK) {
+    const int64_t block_tasks_num = std::min(TASKS_PER_BLOCK, tasks_num - block_start);
+    threading::parallel_for(IndexRange(block_tasks_num), 1, [&](IndexRange tasks) {
+      for (const int64_t task : tasks) {
+        const int64_t first = (block_start + task) * RECORDS_PER_TASK;
+        const int64_t last = std::min(first + RECORDS_PER_TASK, records_num);
+        std::string &text = texts[task];
+        text.clear();
+        for (int64_t record = first; record < last; record++) {
+          format_record(record, text);
+        }
+      }
+    });
+    for (const int64_t task : IndexRange(block_tasks_num)) {
+      fwrite(texts[task].data(), 1, texts[task].size(), file);
+    }
+  }
+}
+
+template<typename T> static void append_binary(std::string &r_data, const T &value)
+{
+  r_data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void write_vertices(FILE *file,
+                           const ExportObject &export_object,
+                           const PLYExportParams &export_params)
+{
+  const Mesh *mesh = export_object.mesh;
+  const MVert *verts = mesh->mvert;
+  const float(*vert_normals)[3] = export_params.export_normals ?
+                                      BKE_mesh_vertex_normals_ensure(mesh) :
+                                      nullptr;
+
+  VArray<ColorGeometry4f> colors;
+  if (export_params.export_colors) {
+    const CustomDataLayer *colors_layer = BKE_id_attributes_active_color_get(&mesh->id);
+    const ColorGeometry4f white(1.0f, 1.0f, 1.0f, 1.0f);
+    if (colors_layer != nullptr) {
+      MeshComponent component;
+      component.replace(const_cast<Mesh *>(mesh), GeometryOwnershipType::ReadOnly);
+      colors = component.attribute_get_for_read<ColorGeometry4f>(
+          colors_layer->name, ATTR_DOMAIN_POINT, white);
+    }
+    else {
+      colors = VArray<ColorGeometry4f>::ForSingle(white, mesh->totvert);
+    }
+  }
+
+  write_records(file, mesh->totvert, [&](const int64_t i, std::string &r_data) {
+    float co[3];
+    mul_v3_m4v3(co, export_object.transform, verts[i].co);
+    float no[3];
+    if (vert_normals) {
+      mul_v3_m3v3(no, export_object.normal_transform, vert_normals[i]);
+      normalize_v3(no);
+    }
+    uchar color[4];
+    if (colors) {
+      const ColorGeometry4f linear = colors[i];
+      float srgb[3];
+      linearrgb_to_srgb_v3_v3(srgb, linear);
+      unit_float_to_uchar_clamp_v3(color, srgb);
+      color[3] = unit_float_to_uchar_clamp(linear.a);
+    }
+
+    if (export_params.ascii_format) {
+      char buf[256];
+      int len = BLI_snprintf_rlen(buf, sizeof(buf), "%f %f %f", co[0], co[1], co[2]);
+      if (vert_normals) {
+        len += BLI_snprintf_rlen(buf + len, sizeof(buf) - len, " %f %f %f", no[0], no[1], no[2]);
+      }
+      if (colors) {
+        len += BLI_snprintf_rlen(
+            buf + len, sizeof(buf) - len, " %u %u %u %u", color[0], color[1], color[2], color[3]);
+      }
+      r_data.append(buf, len);
+      r_data.push_back('\n');
+      return;
+    }
+    r_data.append(reinterpret_cast<const char *>(co), sizeof(co));
+    if (vert_normals) {
+      r_data.append(reinterpret_cast<const char *>(no), sizeof(no));
+    }
+    if (colors) {
+      r_data.append(reinterpret_cast<const char *>(color), sizeof(color));
+    }
+  });
+}
+
+static void write_faces(FILE *file,
+                        const Mesh *mesh,
+                        const uint32_t vertex_offset,
+                        const bool large_faces,
+                        const bool ascii)
+{
+  const MPoly *polys = mesh->mpoly;
+  const MLoop *loops = mesh->mloop;
+  write_records(file, mesh->totpoly, [&](const int64_t i, std::string &r_data) {
+    const MPoly &poly = polys[i];
+    if (ascii) {
+      char buf[32];
+      r_data.append(buf, BLI_snprintf_rlen(buf, sizeof(buf), "%d", poly.totloop));
+      for (const MLoop &loop : Span<MLoop>(loops + poly.loopstart, poly.totloop)) {
+        r_data.append(buf, BLI_snprintf_rlen(buf, sizeof(buf), " %u", loop.v + vertex_offset));
+      }
+      r_data.push_back('\n');
+      return;
+    }
+    if (large_faces) {
+      append_binary<int32_t>(r_data, poly.totloop);
+    }
+    else {
+      append_binary<uint8_t>(r_data, poly.totloop);
+    }
+    for (const MLoop &loop : Span<MLoop>(loops + poly.loopstart, poly.totloop)) {
+      append_binary<uint32_t>(r_data, loop.v + vertex_offset);
+    }
+  });
+}
+
+bool exporter_main(bContext *C, const PLYExportParams &export_params, ReportList *reports)
+{
+  Depsgraph *depsgraph = CTX_data_ensure_evaluated_depsgraph(C);
+  return export_frame(depsgraph, export_params, reports);
+}
+
+bool export_frame(Depsgraph *depsgraph, const PLYExportParams &export_params, ReportList *reports)
+{
+  Scene *scene = DEG_get_evaluated_scene(depsgraph);
+
+  /* Global scale and axis conversion, applied on top of the object transforms. */
+  float global_scale = export_params.global_scale;
+  if ((scene->unit.system != USER_UNIT_NONE) && export_params.use_scene_unit) {
+    global_scale *= scene->unit.scale_length;
+  }
+  float axes_transform[3][3];
+  unit_m3(axes_transform);
+  /* +Y-forward and +Z-up are the Blender's default axis settings. */
+  mat3_from_axis_conversion(
+      export_params.forward_axis, export_params.up_axis, IO_AXIS_Y, IO_AXIS_Z, axes_transform);
+  mul_m3_fl(axes_transform, global_scale);
+  float global_transform[4][4];
+  copy_m4_m3(global_transform, axes_transform);
+
+  /* The element counts are part of the header, so gather all meshes first. */
+  Vector<ExportObject> export_objects;
+  int64_t verts_num = 0;
+  int64_t faces_num = 0;
+  bool large_faces = false;
+  const int deg_objects_visibility_flags = DEG_ITER_OBJECT_FLAG_LINKED_DIRECTLY |
+                                           DEG_ITER_OBJECT_FLAG_LINKED_VIA_SET |
+                                           DEG_ITER_OBJECT_FLAG_VISIBLE |
+                                           DEG_ITER_OBJECT_FLAG_DUPLI;
+  DEG_OBJECT_ITER_BEGIN (depsgraph, object, deg_objects_visibility_flags) {
+    if (export_params.export_selected_objects && !(object->base_flag & BASE_SELECTED)) {
+      continue;
+    }
+    if (!ELEM(object->type, OB_MESH, OB_CURVES_LEGACY, OB_SURF, OB_FONT, OB_MBALL)) {
+      continue;
+    }
+    const Mesh *mesh = get_export_mesh(object, export_params.apply_modifiers);
+    if (mesh == nullptr || mesh->totvert == 0) {
+      continue;
+    }
+    ExportObject export_object;
+    export_object.mesh = mesh;
+    mul_m4_m4m4(export_object.transform, global_transform, object->obmat);
+    copy_m3_m4(export_object.normal_transform, export_object.transform);
+    invert_m3(export_object.normal_transform);
+    transpose_m3(export_object.normal_transform);
+    export_objects.append(export_object);
+
+    verts_num += mesh->totvert;
+    faces_num += mesh->totpoly;
+    for (const MPoly &poly : Span<MPoly>(mesh->mpoly, mesh->totpoly)) {
+      if (poly.totloop > UINT8_MAX) {
+        large_faces = true;
+        break;
+      }
+    }
+  }
+  DEG_OBJECT_ITER_END;
+
+  if (verts_num > UINT32_MAX) {
+    BKE_report(reports, RPT_ERROR, "PLY Export: too many vertices to export");
+    return false;
+  }
+
+  FILE *file = BLI_fopen(export_params.filepath, export_params.ascii_format ? "w" : "wb");
+  if (file == nullptr) {
+    BKE_reportf(reports, RPT_ERROR, "PLY Export: cannot open file '%s'", export_params.filepath);
+    return false;
+  }
+  setvbuf(file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+  /* Binary data is written in native byte order. */
+  const char *format = export_params.ascii_format ? "ascii" :
+                       ENDIAN_ORDER == L_ENDIAN   ? "binary_little_endian" :
+                                                    "binary_big_endian";
+  fprintf(file, "ply\nformat %s 1.0\n", format);
+  fprintf(file, "comment Created by Blender %s\n", BKE_blender_version_string());
+  fprintf(file, "element vertex %lld\n", static_cast<long long>(verts_num));
+  fprintf(file, "property float x\nproperty float y\nproperty float z\n");
+  if (export_params.export_normals) {
+    fprintf(file, "property float nx\nproperty float ny\nproperty float nz\n");
+  }
+  if (export_params.export_colors) {
+    fprintf(file,
+            "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+            "property uchar alpha\n");
+  }
+  fprintf(file, "element face %lld\n", static_cast<long long>(faces_num));
+  fprintf(file,
+          "property list %s uint vertex_indices\nend_header\n",
+          large_faces ? "int" : "uchar");
+
+  for (const ExportObject &export_object : export_objects) {
+    write_vertices(file, export_object, export_params);
+  }
+  int64_t vertex_offset = 0;
+  for (const ExportObject &export_object : export_objects) {
+    write_faces(file,
+                export_object.mesh,
+                uint32_t(vertex_offset),
+                large_faces,
+                export_params.ascii_format);
+    vertex_offset += export_object.mesh->totvert;
+  }
+
+  const bool write_error = ferror(file);
+  if (fclose(file) != 0 || write_error) {
+    BKE_reportf(
+        reports, RPT_ERROR, "PLY Export: error writing to file '%s'", export_params.filepath);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace blender::io::ply
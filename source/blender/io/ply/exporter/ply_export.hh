@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#pragma once
+
+#include "IO_ply.h"
+
+struct Depsgraph;
+
+namespace blender::io::ply {
+
+/* Main export function used from within Blender. */
+bool exporter_main(bContext *C, const PLYExportParams &export_params, ReportList *reports);
+
+/**
+ * Export the objects of an evaluated depsgraph. Used from tests, where full bContext does not
+ * exist.
+ *
+ * \return False if the file could not be written, the error is added to \a reports.
+ */
+bool export_frame(Depsgraph *depsgraph, const PLYExportParams &export_params, ReportList *reports);
+
+}  // namespace blender::io::ply
@@ -0,0 +1,479 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "BKE_attribute.h"
+#include "BKE_customdata.h"
+#include "BKE_layer.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+#include "BKE_pointcloud.h"
+#include "BKE_report.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_fileops.hh"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_vec_types.hh"
+#include "BLI_memory_utils.hh"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "ply_import.hh"
+#include "ply_import_reader.hh"
+
+namespace blender::io::ply {
+
+/** Size of the window of the file that is kept in memory while streaming the element data. */
+static const int64_t READ_BUFFER_SIZE = 4 * 1024 * 1024;
+
+static int find_property(const PlyElement &element, Span<StringRef> names)
+{
+  for (const StringRef name : names) {
+    const int index = element.property_index(name);
+    if (index != -1) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Point the sinks of the x/y/z-like properties `names` at consecutive floats starting at `dst`.
+ * \return true if any of them exists.
+ */
+static bool set_vector_sinks(const PlyElement &element,
+                             Span<Vector<StringRef>> names,
+                             char *dst,
+                             const int64_t stride,
+                             MutableSpan<PlySink> sinks,
+                             MutableSpan<bool> used)
+{
+  bool found = false;
+  for (const int component : names.index_range()) {
+    const int index = find_property(element, names[component]);
+    if (index == -1) {
+      continue;
+    }
+    sinks[index] = {dst + component * sizeof(float), stride, PlySinkType::FLOAT};
+    used[index] = true;
+    found = true;
+  }
+  return found;
+}
+
+/** Attributes of the face element, which are compacted once invalid faces are known. */
+struct FaceAttribute {
+  std::string name;
+  eCustomDataType type;
+  int property;
+  Array<char> data;
+};
+
+/**
+ * The geometry that vertex data is streamed into: a mesh when the file has faces,
+ * a point cloud otherwise.
+ */
+struct ImportGeometry {
+  ID *id = nullptr;
+  Mesh *mesh = nullptr;
+  PointCloud *pointcloud = nullptr;
+  int verts_num = 0;
+
+  /* Mesh only, these are stored on corners and need the faces first. */
+  Array<float3> vertex_normals;
+  Array<float2> vertex_uvs;
+  std::string color_name;
+};
+
+/**
+ * Add a generic attribute and return its data, which stays valid when more layers are added.
+ */
+static char *add_attribute(ID *id,
+                           const char *name,
+                           const eCustomDataType type,
+                           const eAttrDomain domain)
+{
+  CustomDataLayer *layer = BKE_id_attribute_new(id, name, type, domain, nullptr);
+  return layer ? static_cast<char *>(layer->data) : nullptr;
+}
+
+static bool read_vertices(PlyReadBuffer &buffer,
+                          const PlyFormat format,
+                          const PlyElement &element,
+                          ImportGeometry &geometry)
+{
+  const int props_num = element.properties.size();
+  Array<PlySink> sinks(props_num);
+  Array<bool> used(props_num, false);
+
+  char *positions;
+  int64_t positions_stride;
+  if (geometry.mesh) {
+    positions = reinterpret_cast<char *>(geometry.mesh->mvert[0].co);
+    positions_stride = sizeof(MVert);
+  }
+  else {
+    positions = reinterpret_cast<char *>(geometry.pointcloud->co);
+    positions_stride = sizeof(float3);
+  }
+  const Vector<Vector<StringRef>> position_names = {{"x"}, {"y"}, {"z"}};
+  set_vector_sinks(element, position_names, positions, positions_stride, sinks, used);
+
+  const Vector<Vector<StringRef>> normal_names = {
+      {"nx", "normal_x"}, {"ny", "normal_y"}, {"nz", "normal_z"}};
+  if (geometry.mesh) {
+    Array<float3> normals(geometry.verts_num, float3(0.0f));
+    if (set_vector_sinks(element,
+                         normal_names,
+                         reinterpret_cast<char *>(normals.data()),
+                         sizeof(float3),
+                         sinks,
+                         used)) {
+      geometry.vertex_normals = std::move(normals);
+    }
+  }
+  else if (find_property(element, normal_names[0]) != -1) {
+    char *normals = add_attribute(geometry.id, "normal", CD_PROP_FLOAT3, ATTR_DOMAIN_POINT);
+    set_vector_sinks(element, normal_names, normals, sizeof(float3), sinks, used);
+  }
+
+  const Vector<Vector<StringRef>> uv_names = {{"s", "u", "texture_u", "texture_s"},
+                                              {"t", "v", "texture_v", "texture_t"}};
+  if (find_property(element, uv_names[0]) != -1 && find_property(element, uv_names[1]) != -1) {
+    if (geometry.mesh) {
+      geometry.vertex_uvs.reinitialize(geometry.verts_num);
+      set_vector_sinks(element,
+                       uv_names,
+                       reinterpret_cast<char *>(geometry.vertex_uvs.data()),
+                       sizeof(float2),
+                       sinks,
+                       used);
+    }
+    else {
+      char *uvs = add_attribute(geometry.id, "UVMap", CD_PROP_FLOAT2, ATTR_DOMAIN_POINT);
+      set_vector_sinks(element, uv_names, uvs, sizeof(float2), sinks, used);
+    }
+  }
+
+  /* 8-bit colors, which are white and opaque unless the file specifies otherwise. */
+  const Vector<Vector<StringRef>> color_names = {{"red", "diffuse_red", "r"},
+                                                 {"green", "diffuse_green", "g"},
+                                                 {"blue", "diffuse_blue", "b"},
+                                                 {"alpha", "diffuse_alpha", "a"}};
+  if (find_property(element, color_names[0]) != -1) {
+    CustomDataLayer *layer = BKE_id_attribute_new(
+        geometry.id, "Col", CD_PROP_BYTE_COLOR, ATTR_DOMAIN_POINT, nullptr);
+    geometry.color_name = layer->name;
+    char *colors = static_cast<char *>(layer->data);
+    for (const int component : color_names.index_range()) {
+      const int index = find_property(element, color_names[component]);
+      if (index != -1) {
+        sinks[index] = {colors + component, sizeof(MLoopCol), PlySinkType::BYTE_COLOR};
+        used[index] = true;
+      }
+    }
+  }
+
+  /* Everything else becomes a generic attribute with the name of the property. */
+  for (const int i : IndexRange(props_num)) {
+    const PlyProperty &property = element.properties[i];
+    if (used[i] || property.is_list()) {
+      continue;
+    }
+    const bool is_integer = data_type_is_integer(property.type);
+    char *data = add_attribute(geometry.id,
+                               property.name.c_str(),
+                               is_integer ? CD_PROP_INT32 : CD_PROP_FLOAT,
+                               ATTR_DOMAIN_POINT);
+    sinks[i] = {data, 4, is_integer ? PlySinkType::INT : PlySinkType::FLOAT};
+  }
+
+  return read_element(buffer, format, element, sinks, {});
+}
+
+static bool read_faces(PlyReadBuffer &buffer,
+                       const PlyFormat format,
+                       const PlyElement &element,
+                       ImportGeometry &geometry)
+{
+  const int props_num = element.properties.size();
+  Array<PlySink> sinks(props_num);
+  Vector<FaceAttribute> attributes;
+  for (const int i : IndexRange(props_num)) {
+    const PlyProperty &property = element.properties[i];
+    if (!property.is_list()) {
+      const bool is_integer = data_type_is_integer(property.type);
+      attributes.append({property.name, is_integer ? CD_PROP_INT32 : CD_PROP_FLOAT, i});
+    }
+  }
+  /* Point the sinks at the attribute data only once the vector does not grow anymore. */
+  for (FaceAttribute &attribute : attributes) {
+    attribute.data.reinitialize(element.count * 4);
+    sinks[attribute.property] = {attribute.data.data(),
+                                 4,
+                                 attribute.type == CD_PROP_INT32 ? PlySinkType::INT :
+                                                                   PlySinkType::FLOAT};
+  }
+
+  /* Faces with less than three vertices or out of range indices are skipped. */
+  Vector<int> face_sizes;
+  Vector<int> corner_verts;
+  Array<bool> face_valid(element.count, false);
+  face_sizes.reserve(element.count);
+  corner_verts.reserve(element.count * 3);
+  const int verts_num = geometry.verts_num;
+  auto add_face = [&](const int64_t record, Span<int64_t> values) {
+    if (values.size() < 3) {
+      return;
+    }
+    for (const int64_t vert : values) {
+      if (vert < 0 || vert >= verts_num) {
+        return;
+      }
+    }
+    face_sizes.append(values.size());
+    for (const int64_t vert : values) {
+      corner_verts.append(vert);
+    }
+    face_valid[record] = true;
+  };
+
+  PlyListReceiver list_receiver;
+  list_receiver.list_property = find_property(element, {"vertex_indices", "vertex_index"});
+  list_receiver.fn = add_face;
+  if (!read_element(buffer, format, element, sinks, list_receiver)) {
+    return false;
+  }
+  if (corner_verts.size() > INT32_MAX) {
+    fprintf(stderr, "PLY Importer: too many face corners\n");
+    return false;
+  }
+  if (face_sizes.size() < element.count) {
+    fprintf(stderr,
+            "PLY Importer: %lld invalid faces were skipped\n",
+            static_cast<long long>(element.count - face_sizes.size()));
+  }
+
+  Mesh *mesh = geometry.mesh;
+  mesh->totpoly = face_sizes.size();
+  mesh->totloop = corner_verts.size();
+  mesh->mpoly = static_cast<MPoly *>(
+      CustomData_add_layer(&mesh->pdata, CD_MPOLY, CD_CALLOC, nullptr, mesh->totpoly));
+  mesh->mloop = static_cast<MLoop *>(
+      CustomData_add_layer(&mesh->ldata, CD_MLOOP, CD_CALLOC, nullptr, mesh->totloop));
+  int loopstart = 0;
+  for (const int i : face_sizes.index_range()) {
+    mesh->mpoly[i].loopstart = loopstart;
+    mesh->mpoly[i].totloop = face_sizes[i];
+    loopstart += face_sizes[i];
+  }
+  threading::parallel_for(corner_verts.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      mesh->mloop[i].v = corner_verts[i];
+    }
+  });
+
+  for (const FaceAttribute &attribute : attributes) {
+    char *dst = add_attribute(&mesh->id, attribute.name.c_str(), attribute.type, ATTR_DOMAIN_FACE);
+    int64_t face = 0;
+    for (const int64_t record : face_valid.index_range()) {
+      if (face_valid[record]) {
+        memcpy(dst + face * 4, attribute.data.data() + record * 4, 4);
+        face++;
+      }
+    }
+  }
+  return true;
+}
+
+/** Apply the data that is stored per vertex in the file but per corner in meshes. */
+static void finish_mesh(ImportGeometry &geometry)
+{
+  Mesh *mesh = geometry.mesh;
+  /* NOTE: edges must be calculated first before setting custom normals. */
+  BKE_mesh_calc_edges(mesh, false, false);
+
+  if (!geometry.vertex_uvs.is_empty()) {
+    MLoopUV *uvs = static_cast<MLoopUV *>(CustomData_add_layer_named(
+        &mesh->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, mesh->totloop, "UVMap"));
+    threading::parallel_for(IndexRange(mesh->totloop), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        copy_v2_v2(uvs[i].uv, geometry.vertex_uvs[mesh->mloop[i].v]);
+      }
+    });
+  }
+
+  if (!geometry.vertex_normals.is_empty()) {
+    BKE_mesh_set_custom_normals_from_vertices(
+        mesh, reinterpret_cast<float(*)[3]>(geometry.vertex_normals.data()));
+    mesh->flag |= ME_AUTOSMOOTH;
+  }
+
+  if (!geometry.color_name.empty()) {
+    CustomDataLayer *layer = BKE_id_attributes_color_find(&mesh->id, geometry.color_name.c_str());
+    BKE_id_attributes_active_color_set(&mesh->id, layer);
+    BKE_id_attributes_render_color_set(&mesh->id, layer);
+  }
+}
+
+bool importer_main(bContext *C, const PLYImportParams &import_params, ReportList *reports)
+{
+  Main *bmain = CTX_data_main(C);
+  Scene *scene = CTX_data_scene(C);
+  ViewLayer *view_layer = CTX_data_view_layer(C);
+  return importer_main(bmain, scene, view_layer, import_params, reports);
+}
+
+bool importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const PLYImportParams &import_params,
+                   ReportList *reports)
+{
+  FILE *file = BLI_fopen(import_params.filepath, "rb");
+  if (!file) {
+    BKE_reportf(reports, RPT_ERROR, "PLY Import: cannot open file '%s'", import_params.filepath);
+    return false;
+  }
+  BLI_SCOPED_DEFER([&]() { fclose(file); });
+
+  PlyReadBuffer buffer(file, READ_BUFFER_SIZE);
+  PlyHeader header;
+  if (!read_header(buffer, header)) {
+    BKE_reportf(
+        reports, RPT_ERROR, "PLY Import: invalid PLY header in '%s'", import_params.filepath);
+    return false;
+  }
+  const PlyElement *vertex_element = header.find_element("vertex");
+  if (vertex_element == nullptr || vertex_element->count == 0) {
+    BKE_reportf(reports, RPT_ERROR, "PLY Import: no vertices in '%s'", import_params.filepath);
+    return false;
+  }
+  if (vertex_element->count > INT32_MAX) {
+    BKE_reportf(
+        reports, RPT_ERROR, "PLY Import: too many vertices in '%s'", import_params.filepath);
+    return false;
+  }
+  const PlyElement *face_element = header.find_element("face");
+  const bool is_mesh = face_element != nullptr && face_element->count > 0;
+
+  /* Name used for both geometry and object. */
+  char ob_name[FILE_MAX];
+  BLI_strncpy(ob_name, BLI_path_basename(import_params.filepath), FILE_MAX);
+  BLI_path_extension_replace(ob_name, FILE_MAX, "");
+
+  ImportGeometry geometry;
+  geometry.verts_num = vertex_element->count;
+  if (is_mesh) {
+    Mesh *mesh = BKE_mesh_add(bmain, ob_name);
+    /* User count is already 1 here, but will be set later in #BKE_mesh_assign_object. */
+    id_us_min(&mesh->id);
+    mesh->totvert = geometry.verts_num;
+    mesh->mvert = static_cast<MVert *>(
+        CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, nullptr, mesh->totvert));
+    geometry.mesh = mesh;
+    geometry.id = &mesh->id;
+  }
+  else {
+    PointCloud *pointcloud = static_cast<PointCloud *>(BKE_pointcloud_add(bmain, ob_name));
+    pointcloud->totpoint = geometry.verts_num;
+    CustomData_realloc(&pointcloud->pdata, pointcloud->totpoint);
+    BKE_pointcloud_update_customdata_pointers(pointcloud);
+    geometry.pointcloud = pointcloud;
+    geometry.id = &pointcloud->id;
+  }
+
+  /* Elements are stored one after another, in the order of the header. */
+  bool success = true;
+  for (const PlyElement &element : header.elements) {
+    if (&element == vertex_element) {
+      success = read_vertices(buffer, header.format, element, geometry);
+    }
+    else if (&element == face_element && is_mesh) {
+      success = read_faces(buffer, header.format, element, geometry);
+    }
+    else if (element.count > 0) {
+      /* Unsupported elements (edges, materials, ...) are skipped. */
+      const Array<PlySink> sinks(element.properties.size());
+      success = read_element(buffer, header.format, element, sinks, {});
+    }
+    if (!success) {
+      break;
+    }
+  }
+  if (!success) {
+    BKE_reportf(reports, RPT_ERROR, "PLY Import: failed to read '%s'", import_params.filepath);
+    BKE_id_free(bmain, geometry.id);
+    return false;
+  }
+
+  Object *obj;
+  if (is_mesh) {
+    finish_mesh(geometry);
+    if (import_params.use_mesh_validate) {
+      bool verbose_validate = false;
+#ifdef DEBUG
+      verbose_validate = true;
+#endif
+      BKE_mesh_validate(geometry.mesh, verbose_validate, false);
+    }
+    obj = BKE_object_add_only_object(bmain, OB_MESH, ob_name);
+    BKE_mesh_assign_object(bmain, obj, geometry.mesh);
+  }
+  else {
+    /* A "radius" property becomes the built-in radius attribute. */
+    BKE_pointcloud_update_customdata_pointers(geometry.pointcloud);
+    obj = BKE_object_add_only_object(bmain, OB_POINTCLOUD, ob_name);
+    obj->data = geometry.pointcloud;
+  }
+
+  BKE_view_layer_base_deselect_all(view_layer);
+  LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
+  BKE_collection_object_add(bmain, lc->collection, obj);
+  Base *base = BKE_view_layer_base_find(view_layer, obj);
+  BKE_view_layer_base_select_and_set_active(view_layer, base);
+
+  float global_scale = import_params.global_scale;
+  if ((scene->unit.system != USER_UNIT_NONE) && import_params.use_scene_unit) {
+    global_scale *= scene->unit.scale_length;
+  }
+  float scale_vec[3] = {global_scale, global_scale, global_scale};
+  float obmat3x3[3][3];
+  unit_m3(obmat3x3);
+  float obmat4x4[4][4];
+  unit_m4(obmat4x4);
+  /* +Y-forward and +Z-up are the Blender's default axis settings. */
+  mat3_from_axis_conversion(
+      IO_AXIS_Y, IO_AXIS_Z, import_params.forward_axis, import_params.up_axis, obmat3x3);
+  copy_m4_m3(obmat4x4, obmat3x3);
+  rescale_m4(obmat4x4, scale_vec);
+  BKE_object_apply_mat4(obj, obmat4x4, true, false);
+
+  DEG_id_tag_update(&lc->collection->id, ID_RECALC_COPY_ON_WRITE);
+  int flags = ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
+              ID_RECALC_BASE_FLAGS;
+  DEG_id_tag_update_ex(bmain, &obj->id, flags);
+  DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+  DEG_relations_tag_update(bmain);
+  return true;
+}
+
+}  // namespace blender::io::ply
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#pragma once
+
+#include "IO_ply.h"
+
+namespace blender::io::ply {
+
+/* Main import function used from within Blender. */
+bool importer_main(bContext *C, const PLYImportParams &import_params, ReportList *reports);
+
+/**
+ * Used from tests, where full bContext does not exist.
+ *
+ * \return False if the file could not be imported, the error is added to \a reports.
+ */
+bool importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const PLYImportParams &import_params,
+                   ReportList *reports);
+
+}  // namespace blender::io::ply
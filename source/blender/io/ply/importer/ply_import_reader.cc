@@ -0,0 +1,607 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "BLI_endian_defines.h"
+#include "BLI_task.hh"
+#include "BLI_utildefines.h"
+
+#include "fast_float.h"
+
+#include "ply_import_reader.hh"
+
+namespace blender::io::ply {
+
+/* -------------------------------------------------------------------- */
+/** \name Data Types
+ * \{ */
+
+int data_type_size(const PlyDataType type)
+{
+  switch (type) {
+    case PlyDataType::CHAR:
+    case PlyDataType::UCHAR:
+      return 1;
+    case PlyDataType::SHORT:
+    case PlyDataType::USHORT:
+      return 2;
+    case PlyDataType::INT:
+    case PlyDataType::UINT:
+    case PlyDataType::FLOAT:
+      return 4;
+    case PlyDataType::DOUBLE:
+      return 8;
+    case PlyDataType::NONE:
+      break;
+  }
+  return 0;
+}
+
+bool data_type_is_integer(const PlyDataType type)
+{
+  return !ELEM(type, PlyDataType::FLOAT, PlyDataType::DOUBLE, PlyDataType::NONE);
+}
+
+static PlyDataType data_type_from_name(StringRef name)
+{
+  if (ELEM(name, "char", "int8")) {
+    return PlyDataType::CHAR;
+  }
+  if (ELEM(name, "uchar", "uint8")) {
+    return PlyDataType::UCHAR;
+  }
+  if (ELEM(name, "short", "int16")) {
+    return PlyDataType::SHORT;
+  }
+  if (ELEM(name, "ushort", "uint16")) {
+    return PlyDataType::USHORT;
+  }
+  if (ELEM(name, "int", "int32")) {
+    return PlyDataType::INT;
+  }
+  if (ELEM(name, "uint", "uint32")) {
+    return PlyDataType::UINT;
+  }
+  if (ELEM(name, "float", "float32")) {
+    return PlyDataType::FLOAT;
+  }
+  if (ELEM(name, "double", "float64")) {
+    return PlyDataType::DOUBLE;
+  }
+  return PlyDataType::NONE;
+}
+
+int PlyElement::property_index(StringRef name) const
+{
+  for (const int i : properties.index_range()) {
+    if (properties[i].name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const PlyElement *PlyHeader::find_element(StringRef name) const
+{
+  for (const PlyElement &element : elements) {
+    if (element.name == name) {
+      return &element;
+    }
+  }
+  return nullptr;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Read Buffer
+ * \{ */
+
+PlyReadBuffer::PlyReadBuffer(FILE *file, const int64_t buffer_size)
+    : file_(file), buffer_(buffer_size)
+{
+}
+
+bool PlyReadBuffer::ensure_available(const int64_t size)
+{
+  if (end_ - pos_ >= size) {
+    return true;
+  }
+  if (eof_) {
+    return false;
+  }
+  /* Move the unread remainder to the front, and fill up the rest of the buffer. */
+  const int64_t remaining = end_ - pos_;
+  if (size > buffer_.size()) {
+    Array<char> new_buffer(std::max(size, buffer_.size() * 2));
+    memcpy(new_buffer.data(), buffer_.data() + pos_, remaining);
+    buffer_ = std::move(new_buffer);
+  }
+  else {
+    memmove(buffer_.data(), buffer_.data() + pos_, remaining);
+  }
+  pos_ = 0;
+  end_ = remaining;
+  while (end_ < size) {
+    const size_t read = fread(buffer_.data() + end_, 1, buffer_.size() - end_, file_);
+    if (read == 0) {
+      eof_ = true;
+      break;
+    }
+    end_ += read;
+  }
+  return end_ >= size;
+}
+
+bool PlyReadBuffer::read_line(StringRef &r_line)
+{
+  int64_t searched = 0;
+  while (true) {
+    const Span<char> data = this->available();
+    const void *newline = memchr(data.data() + searched, '\n', data.size() - searched);
+    if (newline != nullptr) {
+      const int64_t length = static_cast<const char *>(newline) - data.data();
+      r_line = StringRef(data.data(), length);
+      this->advance(length + 1);
+      return true;
+    }
+    searched = data.size();
+    if (!this->ensure_available(data.size() + 1)) {
+      /* Last line of the file without a terminator. */
+      const Span<char> rest = this->available();
+      if (rest.is_empty()) {
+        return false;
+      }
+      r_line = StringRef(rest.data(), rest.size());
+      this->advance(rest.size());
+      return true;
+    }
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Header
+ * \{ */
+
+static Vector<StringRef> split_words(StringRef line)
+{
+  Vector<StringRef> words;
+  int64_t pos = 0;
+  while (pos < line.size()) {
+    const int64_t start = line.find_first_not_of(" \t\r", pos);
+    if (start == StringRef::not_found) {
+      break;
+    }
+    int64_t end = line.find_first_of(" \t\r", start);
+    if (end == StringRef::not_found) {
+      end = line.size();
+    }
+    words.append(line.substr(start, end - start));
+    pos = end;
+  }
+  return words;
+}
+
+bool read_header(PlyReadBuffer &buffer, PlyHeader &r_header)
+{
+  StringRef line;
+  if (!buffer.read_line(line) || line.trim() != "ply") {
+    fprintf(stderr, "PLY Importer: not a PLY file\n");
+    return false;
+  }
+  bool has_format = false;
+  while (buffer.read_line(line)) {
+    const Vector<StringRef> words = split_words(line);
+    if (words.is_empty() || ELEM(words[0], "comment", "obj_info")) {
+      continue;
+    }
+    if (words[0] == "end_header") {
+      if (!has_format) {
+        fprintf(stderr, "PLY Importer: missing format in header\n");
+        return false;
+      }
+      for (PlyElement &element : r_header.elements) {
+        element.stride = 0;
+        for (const PlyProperty &property : element.properties) {
+          if (property.is_list()) {
+            element.stride = -1;
+            break;
+          }
+          element.stride += data_type_size(property.type);
+        }
+      }
+      return true;
+    }
+    if (words[0] == "format" && words.size() >= 2) {
+      if (words[1] == "ascii") {
+        r_header.format = PlyFormat::ASCII;
+      }
+      else if (words[1] == "binary_little_endian") {
+        r_header.format = PlyFormat::BINARY_LE;
+      }
+      else if (words[1] == "binary_big_endian") {
+        r_header.format = PlyFormat::BINARY_BE;
+      }
+      else {
+        fprintf(stderr, "PLY Importer: unknown format '%s'\n", std::string(words[1]).c_str());
+        return false;
+      }
+      has_format = true;
+    }
+    else if (words[0] == "element" && words.size() >= 3) {
+      PlyElement element;
+      element.name = words[1];
+      element.count = std::strtoll(std::string(words[2]).c_str(), nullptr, 10);
+      if (element.count < 0) {
+        fprintf(stderr, "PLY Importer: invalid element count\n");
+        return false;
+      }
+      r_header.elements.append(std::move(element));
+    }
+    else if (words[0] == "property" && !r_header.elements.is_empty()) {
+      PlyProperty property;
+      if (words.size() >= 5 && words[1] == "list") {
+        property.count_type = data_type_from_name(words[2]);
+        property.type = data_type_from_name(words[3]);
+        property.name = words[4];
+        if (!data_type_is_integer(property.count_type)) {
+          fprintf(stderr, "PLY Importer: invalid list count type\n");
+          return false;
+        }
+      }
+      else if (words.size() >= 3) {
+        property.type = data_type_from_name(words[1]);
+        property.name = words[2];
+      }
+      if (property.type == PlyDataType::NONE) {
+        fprintf(stderr, "PLY Importer: invalid property '%s'\n", std::string(line).c_str());
+        return false;
+      }
+      r_header.elements.last().properties.append(std::move(property));
+    }
+    else {
+      fprintf(stderr, "PLY Importer: unexpected header line '%s'\n", std::string(line).c_str());
+      return false;
+    }
+  }
+  fprintf(stderr, "PLY Importer: unexpected end of file in header\n");
+  return false;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Element Data
+ * \{ */
+
+template<typename T> static double load_binary(const char *src, const bool swap)
+{
+  T value;
+  if (swap) {
+    char *dst = reinterpret_cast<char *>(&value);
+    for (int i = 0; i < sizeof(T); i++) {
+      dst[i] = src[sizeof(T) - 1 - i];
+    }
+  }
+  else {
+    memcpy(&value, src, sizeof(T));
+  }
+  return static_cast<double>(value);
+}
+
+static double load_binary(const char *src, const PlyDataType type, const bool swap)
+{
+  switch (type) {
+    case PlyDataType::CHAR:
+      return load_binary<int8_t>(src, swap);
+    case PlyDataType::UCHAR:
+      return load_binary<uint8_t>(src, swap);
+    case PlyDataType::SHORT:
+      return load_binary<int16_t>(src, swap);
+    case PlyDataType::USHORT:
+      return load_binary<uint16_t>(src, swap);
+    case PlyDataType::INT:
+      return load_binary<int32_t>(src, swap);
+    case PlyDataType::UINT:
+      return load_binary<uint32_t>(src, swap);
+    case PlyDataType::FLOAT:
+      return load_binary<float>(src, swap);
+    case PlyDataType::DOUBLE:
+      return load_binary<double>(src, swap);
+    case PlyDataType::NONE:
+      break;
+  }
+  return 0.0;
+}
+
+/**
+ * Parse the next number of an ASCII record, advancing `r_pos`.
+ * \return false when the record has no more numbers.
+ */
+static bool parse_ascii(const StringRef line, int64_t &r_pos, double &r_value)
+{
+  const char *p = line.data() + r_pos;
+  const char *end = line.data() + line.size();
+  while (p < end && ELEM(*p, ' ', '\t', '\r')) {
+    p++;
+  }
+  if (p < end && *p == '+') {
+    p++;
+  }
+  const fast_float::from_chars_result res = fast_float::from_chars(p, end, r_value);
+  if (res.ec != std::errc()) {
+    return false;
+  }
+  r_pos = res.ptr - line.data();
+  return true;
+}
+
+static void store(const PlySink &sink,
+                  const PlyDataType source_type,
+                  const int64_t record,
+                  double value)
+{
+  char *dst = sink.dst + record * sink.stride;
+  switch (sink.type) {
+    case PlySinkType::FLOAT:
+      *reinterpret_cast<float *>(dst) = static_cast<float>(value);
+      break;
+    case PlySinkType::INT:
+      *reinterpret_cast<int32_t *>(dst) = static_cast<int32_t>(value);
+      break;
+    case PlySinkType::BYTE_COLOR:
+      if (!data_type_is_integer(source_type)) {
+        value *= 255.0;
+      }
+      *reinterpret_cast<uint8_t *>(dst) = static_cast<uint8_t>(
+          std::clamp(value + 0.5, 0.0, 255.0));
+      break;
+  }
+}
+
+static bool is_blank(StringRef line)
+{
+  return line.find_first_not_of(" \t\r") == StringRef::not_found;
+}
+
+/** Records of elements without list properties, decoded a buffer-full at a time. */
+static bool read_binary_records(PlyReadBuffer &buffer,
+                                const bool swap,
+                                const PlyElement &element,
+                                Span<PlySink> sinks)
+{
+  const int64_t stride = element.stride;
+  if (stride == 0) {
+    return true;
+  }
+  Array<int64_t> offsets(element.properties.size());
+  int64_t offset = 0;
+  for (const int i : element.properties.index_range()) {
+    offsets[i] = offset;
+    offset += data_type_size(element.properties[i].type);
+  }
+
+  int64_t done = 0;
+  while (done < element.count) {
+    if (!buffer.ensure_available(stride)) {
+      return false;
+    }
+    const Span<char> data = buffer.available();
+    const int64_t records_num = std::min(element.count - done, data.size() / stride);
+    threading::parallel_for(IndexRange(records_num), 4096, [&](IndexRange range) {
+      for (const int64_t i : range) {
+        const char *record = data.data() + i * stride;
+        for (const int p : element.properties.index_range()) {
+          if (sinks[p].dst == nullptr) {
+            continue;
+          }
+          const PlyDataType type = element.properties[p].type;
+          store(sinks[p], type, done + i, load_binary(record + offsets[p], type, swap));
+        }
+      }
+    });
+    buffer.advance(records_num * stride);
+    done += records_num;
+  }
+  return true;
+}
+
+/** Records of elements without list properties, one per line, parsed in parallel. */
+static bool read_ascii_records(PlyReadBuffer &buffer,
+                               const PlyElement &element,
+                               Span<PlySink> sinks)
+{
+  Vector<StringRef> lines;
+  int64_t done = 0;
+  while (done < element.count) {
+    /* Gather all complete lines that are in the buffer. */
+    lines.clear();
+    const Span<char> data = buffer.available();
+    int64_t pos = 0;
+    while (done + lines.size() < element.count) {
+      const void *newline = memchr(data.data() + pos, '\n', data.size() - pos);
+      if (newline == nullptr) {
+        break;
+      }
+      const int64_t end = static_cast<const char *>(newline) - data.data();
+      const StringRef line(data.data() + pos, end - pos);
+      pos = end + 1;
+      if (!is_blank(line)) {
+        lines.append(line);
+      }
+    }
+    if (lines.is_empty()) {
+      buffer.advance(pos);
+      const int64_t remaining = data.size() - pos;
+      if (!buffer.ensure_available(remaining + 1)) {
+        /* Last line of the file without a terminator. */
+        const Span<char> rest = buffer.available();
+        if (rest.is_empty() || is_blank(StringRef(rest.data(), rest.size()))) {
+          return false;
+        }
+        lines.append(StringRef(rest.data(), rest.size()));
+        pos = rest.size();
+      }
+      else {
+        continue;
+      }
+    }
+
+    std::atomic<bool> valid = true;
+    threading::parallel_for(lines.index_range(), 1024, [&](IndexRange range) {
+      for (const int64_t i : range) {
+        int64_t line_pos = 0;
+        for (const int p : element.properties.index_range()) {
+          double value;
+          if (!parse_ascii(lines[i], line_pos, value)) {
+            valid = false;
+            return;
+          }
+          if (sinks[p].dst != nullptr) {
+            store(sinks[p], element.properties[p].type, done + i, value);
+          }
+        }
+      }
+    });
+    if (!valid) {
+      return false;
+    }
+    buffer.advance(pos);
+    done += lines.size();
+  }
+  return true;
+}
+
+/** Records with list properties have a variable size, so they are decoded sequentially. */
+static bool read_binary_list_records(PlyReadBuffer &buffer,
+                                     const bool swap,
+                                     const PlyElement &element,
+                                     Span<PlySink> sinks,
+                                     const PlyListReceiver &list_receiver)
+{
+  Vector<int64_t> values;
+  for (int64_t record = 0; record < element.count; record++) {
+    for (const int p : element.properties.index_range()) {
+      const PlyProperty &property = element.properties[p];
+      const int type_size = data_type_size(property.type);
+      if (!property.is_list()) {
+        if (!buffer.ensure_available(type_size)) {
+          return false;
+        }
+        if (sinks[p].dst != nullptr) {
+          store(sinks[p],
+                property.type,
+                record,
+                load_binary(buffer.available().data(), property.type, swap));
+        }
+        buffer.advance(type_size);
+        continue;
+      }
+      const int count_size = data_type_size(property.count_type);
+      if (!buffer.ensure_available(count_size)) {
+        return false;
+      }
+      const int64_t count = static_cast<int64_t>(
+          load_binary(buffer.available().data(), property.count_type, swap));
+      buffer.advance(count_size);
+      if (count < 0 || !buffer.ensure_available(count * type_size)) {
+        return false;
+      }
+      if (p == list_receiver.list_property) {
+        values.clear();
+        const char *src = buffer.available().data();
+        for (int64_t i = 0; i < count; i++) {
+          values.append(
+              static_cast<int64_t>(load_binary(src + i * type_size, property.type, swap)));
+        }
+        list_receiver.fn(record, values);
+      }
+      buffer.advance(count * type_size);
+    }
+  }
+  return true;
+}
+
+static bool read_ascii_list_records(PlyReadBuffer &buffer,
+                                    const PlyElement &element,
+                                    Span<PlySink> sinks,
+                                    const PlyListReceiver &list_receiver)
+{
+  Vector<int64_t> values;
+  StringRef line;
+  int64_t record = 0;
+  while (record < element.count) {
+    if (!buffer.read_line(line)) {
+      return false;
+    }
+    if (is_blank(line)) {
+      continue;
+    }
+    int64_t line_pos = 0;
+    for (const int p : element.properties.index_range()) {
+      const PlyProperty &property = element.properties[p];
+      double value;
+      if (!parse_ascii(line, line_pos, value)) {
+        return false;
+      }
+      if (!property.is_list()) {
+        if (sinks[p].dst != nullptr) {
+          store(sinks[p], property.type, record, value);
+        }
+        continue;
+      }
+      const int64_t count = static_cast<int64_t>(value);
+      values.clear();
+      for (int64_t i = 0; i < count; i++) {
+        if (!parse_ascii(line, line_pos, value)) {
+          return false;
+        }
+        values.append(static_cast<int64_t>(value));
+      }
+      if (p == list_receiver.list_property) {
+        list_receiver.fn(record, values);
+      }
+    }
+    record++;
+  }
+  return true;
+}
+
+bool read_element(PlyReadBuffer &buffer,
+                  const PlyFormat format,
+                  const PlyElement &element,
+                  Span<PlySink> sinks,
+                  const PlyListReceiver &list_receiver)
+{
+  BLI_assert(sinks.size() == element.properties.size());
+  const bool swap = (format == PlyFormat::BINARY_LE) != (ENDIAN_ORDER == L_ENDIAN);
+  bool success;
+  if (format == PlyFormat::ASCII) {
+    success = element.stride >= 0 ? read_ascii_records(buffer, element, sinks) :
+                                    read_ascii_list_records(buffer, element, sinks, list_receiver);
+  }
+  else {
+    success = element.stride >= 0 ?
+                  read_binary_records(buffer, swap, element, sinks) :
+                  read_binary_list_records(buffer, swap, element, sinks, list_receiver);
+  }
+  if (!success) {
+    fprintf(stderr,
+            "PLY Importer: failed to read element '%s', the file is truncated or corrupt\n",
+            element.name.c_str());
+  }
+  return success;
+}
+
+/** \} */
+
+}  // namespace blender::io::ply
@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "BLI_array.hh"
+#include "BLI_function_ref.hh"
+#include "BLI_span.hh"
+#include "BLI_string_ref.hh"
+#include "BLI_vector.hh"
+
+namespace blender::io::ply {
+
+enum class PlyFormat {
+  ASCII,
+  BINARY_LE,
+  BINARY_BE,
+};
+
+enum class PlyDataType {
+  NONE = 0,
+  CHAR,
+  UCHAR,
+  SHORT,
+  USHORT,
+  INT,
+  UINT,
+  FLOAT,
+  DOUBLE,
+};
+
+int data_type_size(PlyDataType type);
+bool data_type_is_integer(PlyDataType type);
+
+struct PlyProperty {
+  std::string name;
+  PlyDataType type = PlyDataType::NONE;
+  /** Type of the item count for list properties, #PlyDataType::NONE for scalars. */
+  PlyDataType count_type = PlyDataType::NONE;
+
+  bool is_list() const
+  {
+    return count_type != PlyDataType::NONE;
+  }
+};
+
+struct PlyElement {
+  std::string name;
+  int64_t count = 0;
+  Vector<PlyProperty> properties;
+  /** Size of one binary record, or -1 when the element has list properties. */
+  int64_t stride = 0;
+
+  int property_index(StringRef name) const;
+};
+
+struct PlyHeader {
+  PlyFormat format = PlyFormat::ASCII;
+  Vector<PlyElement> elements;
+
+  const PlyElement *find_element(StringRef name) const;
+};
+
+/**
+ * Buffered sequential access to a file, which keeps only a bounded window of it in memory
+ * so that files much larger than the available memory can be streamed.
+ */
+class PlyReadBuffer {
+ private:
+  FILE *file_;
+  Array<char> buffer_;
+  int64_t pos_ = 0;
+  int64_t end_ = 0;
+  bool eof_ = false;
+
+ public:
+  PlyReadBuffer(FILE *file, int64_t buffer_size);
+
+  /**
+   * Make at least `size` contiguous bytes available, the buffer grows when it is too small.
+   * \return false when the end of the file is reached first.
+   */
+  bool ensure_available(int64_t size);
+  Span<char> available() const
+  {
+    return Span<char>(buffer_.data() + pos_, end_ - pos_);
+  }
+  void advance(int64_t size)
+  {
+    pos_ += size;
+  }
+  /**
+   * Read the next line without its terminator.
+   * \return false at the end of the file.
+   */
+  bool read_line(StringRef &r_line);
+};
+
+/**
+ * Parse the header, leaving the buffer at the first byte of the element data.
+ * \return false when the file is not a valid PLY file.
+ */
+bool read_header(PlyReadBuffer &buffer, PlyHeader &r_header);
+
+enum class PlySinkType {
+  FLOAT,
+  INT,
+  /** 8-bit color component, floating point sources are scaled from the 0-1 range. */
+  BYTE_COLOR,
+};
+
+/**
+ * Destination of one scalar property: the value of record `i` is stored at `dst + i * stride`.
+ */
+struct PlySink {
+  char *dst = nullptr;
+  int64_t stride = 0;
+  PlySinkType type = PlySinkType::FLOAT;
+};
+
+/**
+ * Receives the list property values of records that cannot be decoded independently.
+ * `values` stays valid only during the call.
+ */
+struct PlyListReceiver {
+  int list_property = -1;
+  /** Called once per record with its list values. */
+  FunctionRef<void(int64_t record, Span<int64_t> values)> fn;
+};
+
+/**
+ * Decode all records of `element` into the sinks, one per property (sinks without a
+ * destination are skipped). Elements without list properties are decoded on multiple threads,
+ * a buffer-full of records at a time.
+ */
+bool read_element(PlyReadBuffer &buffer,
+                  PlyFormat format,
+                  const PlyElement &element,
+                  Span<PlySink> sinks,
+                  const PlyListReceiver &list_receiver);
+
+}  // namespace blender::io::ply
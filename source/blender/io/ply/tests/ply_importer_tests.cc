@@ -0,0 +1,331 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <algorithm>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "testing/testing.h"
+#include "tests/blendfile_loading_base_test.h"
+
+#include "BKE_appdir.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+#include "BKE_report.h"
+
+#include "BLI_endian_defines.h"
+#include "BLI_fileops.h"
+#include "BLI_math_vec_types.hh"
+#include "BLI_string.h"
+#include "BLI_vector.hh"
+
+#include "BLO_readfile.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+#include "DNA_scene_types.h"
+
+#include "ply_export.hh"
+#include "ply_import.hh"
+
+namespace blender::io::ply {
+
+/* A quad and a triangle sharing an edge. */
+static const Vector<float3> test_positions = {{0.0f, 0.0f, 0.0f},
+                                              {1.0f, 0.0f, 0.0f},
+                                              {1.0f, 1.0f, 0.0f},
+                                              {0.0f, 1.0f, 0.0f},
+                                              {2.0f, 0.5f, 0.0f}};
+static const Vector<Vector<int>> test_faces = {{0, 1, 2, 3}, {1, 4, 2}};
+
+static std::string temp_file_path(const char *name)
+{
+  BKE_tempdir_init(nullptr);
+  return std::string(BKE_tempdir_base()) + name;
+}
+
+static void write_file(const std::string &filepath, const std::string &contents)
+{
+  std::ofstream file(filepath, std::ios::binary);
+  file << contents;
+}
+
+static std::string header(const char *format, const int64_t verts_num, const int64_t faces_num)
+{
+  return std::string("ply\nformat ") + format +
+         " 1.0\n"
+         "comment test file\n"
+         "element vertex " +
+         std::to_string(verts_num) +
+         "\n"
+         "property float x\nproperty float y\nproperty float z\n"
+         "element face " +
+         std::to_string(faces_num) +
+         "\n"
+         "property list uchar int vertex_indices\n"
+         "end_header\n";
+}
+
+static std::string ascii_file(const Span<Vector<int>> faces)
+{
+  std::string text = header("ascii", test_positions.size(), faces.size());
+  for (const float3 &co : test_positions) {
+    char buf[128];
+    BLI_snprintf(buf, sizeof(buf), "%f %f %f\n", co.x, co.y, co.z);
+    text += buf;
+  }
+  for (const Vector<int> &face : faces) {
+    text += std::to_string(face.size());
+    for (const int vert : face) {
+      text += " " + std::to_string(vert);
+    }
+    text += "\n";
+  }
+  return text;
+}
+
+template<typename T> static void append_binary(std::string &r_data, T value, const bool big_endian)
+{
+  char bytes[sizeof(T)];
+  memcpy(bytes, &value, sizeof(T));
+  if (big_endian != (ENDIAN_ORDER == B_ENDIAN)) {
+    std::reverse(bytes, bytes + sizeof(T));
+  }
+  r_data.append(bytes, sizeof(T));
+}
+
+static std::string binary_file(const Span<Vector<int>> faces, const bool big_endian)
+{
+  std::string data = header(big_endian ? "binary_big_endian" : "binary_little_endian",
+                            test_positions.size(),
+                            faces.size());
+  for (const float3 &co : test_positions) {
+    append_binary(data, co.x, big_endian);
+    append_binary(data, co.y, big_endian);
+    append_binary(data, co.z, big_endian);
+  }
+  for (const Vector<int> &face : faces) {
+    append_binary(data, uint8_t(face.size()), big_endian);
+    for (const int vert : face) {
+      append_binary(data, int32_t(vert), big_endian);
+    }
+  }
+  return data;
+}
+
+class ply_importer_test : public BlendfileLoadingBaseTest {
+ public:
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    if (!blendfile_load("io_tests/blend_geometry/all_quads.blend")) {
+      ADD_FAILURE();
+    }
+  }
+
+  /** Import the file and return the created object, null if the import failed. */
+  Object *import_file(const std::string &filepath)
+  {
+    PLYImportParams params{};
+    BLI_strncpy(params.filepath, filepath.c_str(), sizeof(params.filepath));
+    params.forward_axis = IO_AXIS_Y;
+    params.up_axis = IO_AXIS_Z;
+    params.global_scale = 1.0f;
+    params.use_mesh_validate = true;
+
+    ViewLayer *view_layer = bfile->cur_view_layer;
+    Base *base_prev = view_layer->basact;
+    ReportList reports;
+    BKE_reports_init(&reports, RPT_STORE);
+    const bool success = importer_main(
+        bfile->main, bfile->curscene, view_layer, params, &reports);
+    /* Failures are reported, successful imports don't report errors. */
+    EXPECT_EQ(BKE_reports_contain(&reports, RPT_ERROR), !success);
+    BKE_reports_clear(&reports);
+    BLI_delete(filepath.c_str(), false, false);
+    if (!success) {
+      EXPECT_EQ(view_layer->basact, base_prev);
+      return nullptr;
+    }
+    EXPECT_NE(view_layer->basact, nullptr);
+    EXPECT_NE(view_layer->basact, base_prev);
+    return view_layer->basact ? view_layer->basact->object : nullptr;
+  }
+
+  void expect_test_mesh(const Object *object, const Span<Vector<int>> faces)
+  {
+    ASSERT_NE(object, nullptr);
+    ASSERT_EQ(object->type, OB_MESH);
+    const Mesh *mesh = static_cast<const Mesh *>(object->data);
+    ASSERT_EQ(mesh->totvert, test_positions.size());
+    for (const int i : test_positions.index_range()) {
+      EXPECT_V3_NEAR(mesh->mvert[i].co, test_positions[i], 1e-6f);
+    }
+    ASSERT_EQ(mesh->totpoly, faces.size());
+    for (const int i : faces.index_range()) {
+      const MPoly &poly = mesh->mpoly[i];
+      ASSERT_EQ(poly.totloop, faces[i].size());
+      for (const int corner : IndexRange(poly.totloop)) {
+        EXPECT_EQ(mesh->mloop[poly.loopstart + corner].v, faces[i][corner]);
+      }
+    }
+  }
+};
+
+TEST_F(ply_importer_test, import_ascii)
+{
+  const std::string filepath = temp_file_path("ply_import_ascii.ply");
+  write_file(filepath, ascii_file(test_faces));
+  expect_test_mesh(import_file(filepath), test_faces);
+}
+
+TEST_F(ply_importer_test, import_binary_little_endian)
+{
+  const std::string filepath = temp_file_path("ply_import_binary_le.ply");
+  write_file(filepath, binary_file(test_faces, false));
+  expect_test_mesh(import_file(filepath), test_faces);
+}
+
+TEST_F(ply_importer_test, import_binary_big_endian)
+{
+  const std::string filepath = temp_file_path("ply_import_binary_be.ply");
+  write_file(filepath, binary_file(test_faces, true));
+  expect_test_mesh(import_file(filepath), test_faces);
+}
+
+TEST_F(ply_importer_test, import_invalid_face_indices)
+{
+  /* Out of range, negative and too few indices: these faces are skipped. */
+  Vector<Vector<int>> faces = {{0, 1, 5}, {0, 1, 2, 3}, {0, -1, 2}, {0, 1}, {1, 4, 2}, {4, 3, 9}};
+  for (const bool binary : {false, true}) {
+    SCOPED_TRACE(binary ? "binary" : "ascii");
+    const std::string filepath = temp_file_path(binary ? "ply_import_invalid_binary.ply" :
+                                                         "ply_import_invalid_ascii.ply");
+    write_file(filepath, binary ? binary_file(faces, false) : ascii_file(faces));
+    expect_test_mesh(import_file(filepath), test_faces);
+  }
+}
+
+TEST_F(ply_importer_test, import_truncated)
+{
+  /* The face element ends early: nothing is imported. */
+  std::string data = binary_file(test_faces, false);
+  data.resize(data.size() - 3);
+  const std::string filepath = temp_file_path("ply_import_truncated.ply");
+  write_file(filepath, data);
+  EXPECT_EQ(import_file(filepath), nullptr);
+}
+
+TEST_F(ply_importer_test, import_failure_is_reported)
+{
+  EXPECT_EQ(import_file(temp_file_path("ply_import_missing.ply")), nullptr);
+
+  const std::string filepath = temp_file_path("ply_import_not_ply.ply");
+  write_file(filepath, "solid not a ply file\n");
+  EXPECT_EQ(import_file(filepath), nullptr);
+}
+
+TEST_F(ply_importer_test, import_points)
+{
+  /* Without faces, vertices become a point cloud. */
+  const std::string filepath = temp_file_path("ply_import_points.ply");
+  write_file(filepath, ascii_file({}));
+  const Object *object = import_file(filepath);
+  ASSERT_NE(object, nullptr);
+  ASSERT_EQ(object->type, OB_POINTCLOUD);
+  const PointCloud *pointcloud = static_cast<const PointCloud *>(object->data);
+  ASSERT_EQ(pointcloud->totpoint, test_positions.size());
+  for (const int i : test_positions.index_range()) {
+    EXPECT_V3_NEAR(pointcloud->co[i], test_positions[i], 1e-6f);
+  }
+}
+
+TEST_F(ply_importer_test, export_import_round_trip)
+{
+  depsgraph_create(DAG_EVAL_VIEWPORT);
+
+  /* Expected contents, gathered the same way as the exporter does. */
+  int64_t verts_num = 0;
+  Vector<int> face_sizes;
+  const int deg_objects_visibility_flags = DEG_ITER_OBJECT_FLAG_LINKED_DIRECTLY |
+                                           DEG_ITER_OBJECT_FLAG_LINKED_VIA_SET |
+                                           DEG_ITER_OBJECT_FLAG_VISIBLE |
+                                           DEG_ITER_OBJECT_FLAG_DUPLI;
+  DEG_OBJECT_ITER_BEGIN (depsgraph, object, deg_objects_visibility_flags) {
+    if (!ELEM(object->type, OB_MESH, OB_CURVES_LEGACY, OB_SURF, OB_FONT, OB_MBALL)) {
+      continue;
+    }
+    const Mesh *mesh = BKE_object_get_evaluated_mesh(object);
+    if (mesh == nullptr || mesh->totvert == 0) {
+      continue;
+    }
+    verts_num += mesh->totvert;
+    for (const int i : IndexRange(mesh->totpoly)) {
+      face_sizes.append(mesh->mpoly[i].totloop);
+    }
+  }
+  DEG_OBJECT_ITER_END;
+  ASSERT_GT(verts_num, 0);
+
+  const Mesh *meshes[2];
+  for (const bool ascii : {true, false}) {
+    SCOPED_TRACE(ascii ? "ascii" : "binary");
+    const std::string filepath = temp_file_path(ascii ? "ply_round_trip_ascii.ply" :
+                                                        "ply_round_trip_binary.ply");
+    PLYExportParams params{};
+    BLI_strncpy(params.filepath, filepath.c_str(), sizeof(params.filepath));
+    params.forward_axis = IO_AXIS_Y;
+    params.up_axis = IO_AXIS_Z;
+    params.global_scale = 1.0f;
+    params.apply_modifiers = true;
+    params.ascii_format = ascii;
+    EXPECT_TRUE(export_frame(depsgraph, params, nullptr));
+
+    const Object *object = import_file(filepath);
+    ASSERT_NE(object, nullptr);
+    ASSERT_EQ(object->type, OB_MESH);
+    const Mesh *mesh = static_cast<const Mesh *>(object->data);
+    EXPECT_EQ(mesh->totvert, verts_num);
+    ASSERT_EQ(mesh->totpoly, face_sizes.size());
+    for (const int i : face_sizes.index_range()) {
+      EXPECT_EQ(mesh->mpoly[i].totloop, face_sizes[i]);
+    }
+    meshes[ascii ? 0 : 1] = mesh;
+  }
+
+  /* ASCII is written with 6 decimals, binary exactly. */
+  const Mesh *ascii_mesh = meshes[0];
+  const Mesh *binary_mesh = meshes[1];
+  ASSERT_EQ(ascii_mesh->totvert, binary_mesh->totvert);
+  for (const int i : IndexRange(ascii_mesh->totvert)) {
+    EXPECT_V3_NEAR(ascii_mesh->mvert[i].co, binary_mesh->mvert[i].co, 1e-5f);
+  }
+  ASSERT_EQ(ascii_mesh->totloop, binary_mesh->totloop);
+  for (const int i : IndexRange(ascii_mesh->totloop)) {
+    EXPECT_EQ(ascii_mesh->mloop[i].v, binary_mesh->mloop[i].v);
+  }
+}
+
+TEST_F(ply_importer_test, export_failure_is_reported)
+{
+  depsgraph_create(DAG_EVAL_VIEWPORT);
+
+  const std::string filepath = temp_file_path("ply_export_missing_dir/scene.ply");
+  PLYExportParams params{};
+  BLI_strncpy(params.filepath, filepath.c_str(), sizeof(params.filepath));
+  params.forward_axis = IO_AXIS_Y;
+  params.up_axis = IO_AXIS_Z;
+  params.global_scale = 1.0f;
+  ReportList reports;
+  BKE_reports_init(&reports, RPT_STORE);
+  EXPECT_FALSE(export_frame(depsgraph, params, &reports));
+  EXPECT_TRUE(BKE_reports_contain(&reports, RPT_ERROR));
+  BKE_reports_clear(&reports);
+}
+
+}  // namespace blender::io::ply
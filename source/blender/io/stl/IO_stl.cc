@@ -7,6 +7,7 @@
 #include "BLI_timeit.hh"
 
 #include "IO_stl.h"
+#include "stl_export.hh"
 #include "stl_import.hh"
 
 void STL_import(bContext *C, const struct STLImportParams *import_params)
@@ -14,3 +15,11 @@ void STL_import(bContext *C, const struct STLImportParams *import_params)
   SCOPED_TIMER("STL Import");
   blender::io::stl::importer_main(C, *import_params);
 }
+
+bool STL_export(bContext *C,
+                const struct STLExportParams *export_params,
+                struct ReportList *reports)
+{
+  SCOPED_TIMER("STL Export");
+  return blender::io::stl::exporter_main(C, *export_params, reports);
+}
@@ -14,6 +14,8 @@
 extern "C" {
 #endif
 
+struct ReportList;
+
 struct STLImportParams {
   /** Full path to the source STL file to import. */
   char filepath[FILE_MAX];
@@ -25,11 +27,35 @@ struct STLImportParams {
   bool use_mesh_validate;
 };
 
+struct STLExportParams {
+  /** Full path to the destination STL file. */
+  char filepath[FILE_MAX];
+  eIOAxis forward_axis;
+  eIOAxis up_axis;
+  float global_scale;
+  bool export_selected_objects;
+  bool use_scene_unit;
+  bool apply_modifiers;
+  bool ascii_format;
+  /** Write one file per object, named after the object (made unique when objects or their
+   * instances share a name). */
+  bool use_batch;
+};
+
 /**
  * C-interface for the importer.
  */
 void STL_import(bContext *C, const struct STLImportParams *import_params);
 
+/**
+ * C-interface for the exporter.
+ *
+ * \return False if a file could not be written, the error is added to \a reports.
+ */
+bool STL_export(bContext *C,
+                const struct STLExportParams *export_params,
+                struct ReportList *reports);
+
 #ifdef __cplusplus
 }
 #endif
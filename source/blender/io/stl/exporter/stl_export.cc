@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <memory>
+#include <string>
+
+#include "BKE_context.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+#include "BKE_object.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "stl_export.hh"
+#include "stl_export_writer.hh"
+
+namespace blender::io::stl {
+
+/* Triangles are gathered and written in blocks of this size, to bound memory usage. */
+static const int TRIS_PER_BLOCK = 1024 * 1024;
+
+static Mesh *get_export_mesh(const Object *object, const bool apply_modifiers)
+{
+  if (!apply_modifiers && object->type == OB_MESH) {
+    return BKE_object_get_pre_modified_mesh(object);
+  }
+  /* Other object types only have geometry after evaluation. */
+  return BKE_object_get_evaluated_mesh(object);
+}
+
+static void write_mesh(FileWriter &writer,
+                       const Mesh *mesh,
+                       const float transform[4][4],
+                       Array<PackedTriangle> &buffer)
+{
+  const MLoopTri *looptris = BKE_mesh_runtime_looptri_ensure(mesh);
+  const int looptris_num = BKE_mesh_runtime_looptri_len(mesh);
+  const MVert *verts = mesh->mvert;
+  const MLoop *loops = mesh->mloop;
+
+  for (int block_start = 0; block_start < looptris_num; block_start += TRIS_PER_BLOCK) {
+    const int block_size = std::min(TRIS_PER_BLOCK, looptris_num - block_start);
+    if (buffer.size() < block_size) {
+      buffer.reinitialize(block_size);
+    }
+    MutableSpan<PackedTriangle> tris = buffer.as_mutable_span().take_front(block_size);
+    threading::parallel_for(tris.index_range(), 2048, [&](IndexRange range) {
+      for (const int i : range) {
+        const MLoopTri &looptri = looptris[block_start + i];
+        PackedTriangle &tri = tris[i];
+        for (int corner = 0; corner < 3; corner++) {
+          const MVert &vert = verts[loops[looptri.tri[corner]].v];
+          mul_v3_m4v3(tri.vertices[corner], transform, vert.co);
+        }
+        normal_tri_v3(tri.normal, tri.vertices[0], tri.vertices[1], tri.vertices[2]);
+        tri.attribute_byte_count = 0;
+      }
+    });
+    writer.write_triangles(tris);
+  }
+}
+
+std::string batch_filepath(const char *filepath,
+                           const char *object_name,
+                           Set<std::string> &used_filepaths)
+{
+  char prefix[FILE_MAX];
+  BLI_strncpy(prefix, filepath, sizeof(prefix));
+  BLI_path_extension_replace(prefix, sizeof(prefix), "");
+  char safe_name[MAX_ID_NAME];
+  BLI_strncpy(safe_name, object_name, sizeof(safe_name));
+  BLI_filename_make_safe(safe_name);
+
+  const std::string base = std::string(prefix) + safe_name;
+  std::string result = base + ".stl";
+  /* Names made safe for file paths can collide, and instances share the name of their object. */
+  for (int number = 1; !used_filepaths.add(result); number++) {
+    char suffix[16];
+    BLI_snprintf(suffix, sizeof(suffix), ".%03d", number);
+    result = base + suffix + ".stl";
+  }
+  return result;
+}
+
+bool exporter_main(bContext *C, const STLExportParams &export_params, ReportList *reports)
+{
+  Depsgraph *depsgraph = CTX_data_ensure_evaluated_depsgraph(C);
+  return export_frame(depsgraph, export_params, reports);
+}
+
+bool export_frame(Depsgraph *depsgraph, const STLExportParams &export_params, ReportList *reports)
+{
+  Scene *scene = DEG_get_evaluated_scene(depsgraph);
+
+  /* Global scale and axis conversion, applied on top of the object transforms. */
+  float global_scale = export_params.global_scale;
+  if ((scene->unit.system != USER_UNIT_NONE) && export_params.use_scene_unit) {
+    global_scale *= scene->unit.scale_length;
+  }
+  float axes_transform[3][3];
+  unit_m3(axes_transform);
+  /* +Y-forward and +Z-up are the Blender's default axis settings. */
+  mat3_from_axis_conversion(
+      export_params.forward_axis, export_params.up_axis, IO_AXIS_Y, IO_AXIS_Z, axes_transform);
+  mul_m3_fl(axes_transform, global_scale);
+  float global_transform[4][4];
+  copy_m4_m3(global_transform, axes_transform);
+
+  std::unique_ptr<FileWriter> writer;
+  if (!export_params.use_batch) {
+    writer = std::make_unique<FileWriter>(
+        export_params.filepath, export_params.ascii_format, reports);
+    if (!writer->is_open()) {
+      return false;
+    }
+  }
+  Set<std::string> used_filepaths;
+  bool success = true;
+
+  /* Reused for all objects, grows up to the block size as needed. */
+  Array<PackedTriangle> buffer;
+
+  const int deg_objects_visibility_flags = DEG_ITER_OBJECT_FLAG_LINKED_DIRECTLY |
+                                           DEG_ITER_OBJECT_FLAG_LINKED_VIA_SET |
+                                           DEG_ITER_OBJECT_FLAG_VISIBLE |
+                                           DEG_ITER_OBJECT_FLAG_DUPLI;
+  DEG_OBJECT_ITER_BEGIN (depsgraph, object, deg_objects_visibility_flags) {
+    if (export_params.export_selected_objects && !(object->base_flag & BASE_SELECTED)) {
+      continue;
+    }
+    if (!ELEM(object->type, OB_MESH, OB_CURVES_LEGACY, OB_SURF, OB_FONT, OB_MBALL)) {
+      continue;
+    }
+    const Mesh *mesh = get_export_mesh(object, export_params.apply_modifiers);
+    if (mesh == nullptr) {
+      continue;
+    }
+
+    float transform[4][4];
+    mul_m4_m4m4(transform, global_transform, object->obmat);
+
+    if (export_params.use_batch) {
+      const std::string filepath = batch_filepath(
+          export_params.filepath, object->id.name + 2, used_filepaths);
+      FileWriter object_writer(filepath.c_str(), export_params.ascii_format, reports);
+      if (object_writer.is_open()) {
+        write_mesh(object_writer, mesh, transform, buffer);
+      }
+      success &= object_writer.close();
+    }
+    else {
+      write_mesh(*writer, mesh, transform, buffer);
+    }
+  }
+  DEG_OBJECT_ITER_END;
+
+  if (writer) {
+    success &= writer->close();
+  }
+  return success;
+}
+
+}  // namespace blender::io::stl
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include <string>
+
+#include "BLI_set.hh"
+
+#include "IO_stl.h"
+
+struct Depsgraph;
+
+namespace blender::io::stl {
+
+/* Main export function used from within Blender. */
+bool exporter_main(bContext *C, const STLExportParams &export_params, ReportList *reports);
+
+/**
+ * Export the objects of an evaluated depsgraph. Used from tests, where full #bContext does not
+ * exist.
+ *
+ * \return False if a file could not be written, the error is added to \a reports.
+ */
+bool export_frame(Depsgraph *depsgraph, const STLExportParams &export_params, ReportList *reports);
+
+/**
+ * File path of an object in batch mode: the export file path without extension, followed by the
+ * object name. Objects that share a name (like instances of the same object) get a numbered
+ * suffix, based on the file paths used so far.
+ */
+std::string batch_filepath(const char *filepath,
+                           const char *object_name,
+                           Set<std::string> &used_filepaths);
+
+}  // namespace blender::io::stl
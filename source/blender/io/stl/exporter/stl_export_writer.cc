@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <cstring>
+#include <string>
+
+#include "BKE_blender_version.h"
+#include "BKE_report.h"
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "stl_export_writer.hh"
+
+namespace blender::io::stl {
+
+/* Size of the stdio buffer: the triangles are written in large blocks anyway. */
+static const size_t FILE_BUFFER_SIZE = 4 * 1024 * 1024;
+/* Number of triangles formatted as ASCII text by one task. */
+static const int64_t ASCII_TRIS_PER_TASK = 4096;
+
+static std::string header_text()
+{
+  return std::string("Exported from Blender-") + BKE_blender_version_string();
+}
+
+FileWriter::FileWriter(const char *filepath, const bool ascii, ReportList *reports)
+    : filepath_(filepath), ascii_(ascii), reports_(reports)
+{
+  file_ = BLI_fopen(filepath, ascii ? "w" : "wb");
+  if (file_ == nullptr) {
+    BKE_reportf(reports_, RPT_ERROR, "STL Export: cannot open file '%s'", filepath);
+    return;
+  }
+  setvbuf(file_, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+  const std::string header = header_text();
+  if (ascii_) {
+    fprintf(file_, "solid %s\n", header.c_str());
+  }
+  else {
+    char binary_header[80] = {0};
+    memcpy(binary_header, header.c_str(), std::min(header.size(), sizeof(binary_header)));
+    fwrite(binary_header, sizeof(binary_header), 1, file_);
+    /* Triangle count, written once all triangles are known. */
+    fwrite(&tris_num_, sizeof(uint32_t), 1, file_);
+  }
+}
+
+FileWriter::~FileWriter()
+{
+  close();
+}
+
+bool FileWriter::close()
+{
+  if (file_ == nullptr) {
+    return false;
+  }
+  bool success = true;
+  if (ascii_) {
+    fprintf(file_, "endsolid %s\n", header_text().c_str());
+  }
+  else if (fseek(file_, 80, SEEK_SET) != 0) {
+    success = false;
+  }
+  else {
+    fwrite(&tris_num_, sizeof(uint32_t), 1, file_);
+  }
+  if (ferror(file_)) {
+    success = false;
+  }
+  if (fclose(file_) != 0) {
+    success = false;
+  }
+  file_ = nullptr;
+
+  if (!success) {
+    BKE_reportf(reports_, RPT_ERROR, "STL Export: error writing to file '%s'", filepath_.c_str());
+  }
+  return success;
+}
+
+static void format_ascii_triangle(const PackedTriangle &tri, std::string &r_text)
+{
+  char buf[256];
+  int len = BLI_snprintf_rlen(buf,
+                              sizeof(buf),
+                              "facet normal %f %f %f\nouter loop\n",
+                              tri.normal[0],
+                              tri.normal[1],
+                              tri.normal[2]);
+  r_text.append(buf, len);
+  for (int i = 0; i < 3; i++) {
+    len = BLI_snprintf_rlen(buf,
+                            sizeof(buf),
+                            "vertex %f %f %f\n",
+                            tri.vertices[i][0],
+                            tri.vertices[i][1],
+                            tri.vertices[i][2]);
+    r_text.append(buf, len);
+  }
+  r_text.append("endloop\nendfacet\n");
+}
+
+void FileWriter::write_triangles(Span<PackedTriangle> tris)
+{
+  if (file_ == nullptr || tris.is_empty()) {
+    return;
+  }
+  tris_num_ += uint32_t(tris.size());
+
+  if (!ascii_) {
+    fwrite(tris.data(), sizeof(PackedTriangle), size_t(tris.size()), file_);
+    return;
+  }
+
+  const int64_t tasks_num = (tris.size() + ASCII_TRIS_PER_TASK - 1) / ASCII_TRIS_PER_TASK;
+  Array<std::string> texts(tasks_num);
+  threading::parallel_for(IndexRange(tasks_num), 1, [&](IndexRange tasks) {
+    for (const int64_t task : tasks) {
+      const IndexRange range = tris.index_range().slice(
+          task * ASCII_TRIS_PER_TASK,
+          std::min(ASCII_TRIS_PER_TASK, tris.size() - task * ASCII_TRIS_PER_TASK));
+      std::string &text = texts[task];
+      for (const int64_t i : range) {
+        format_ascii_triangle(tris[i], text);
+      }
+    }
+  });
+  for (const std::string &text : texts) {
+    fwrite(text.data(), 1, text.size(), file_);
+  }
+}
+
+}  // namespace blender::io::stl
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "BLI_span.hh"
+
+struct ReportList;
+
+namespace blender::io::stl {
+
+#pragma pack(push, 1)
+/**
+ * One triangle, laid out exactly like in a binary STL file, so that whole
+ * arrays of them can be written with a single call.
+ */
+struct PackedTriangle {
+  float normal[3];
+  float vertices[3][3];
+  uint16_t attribute_byte_count = 0;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(PackedTriangle) == 50, "Binary STL triangle must be 50 bytes");
+
+class FileWriter {
+ private:
+  FILE *file_ = nullptr;
+  std::string filepath_;
+  bool ascii_;
+  ReportList *reports_;
+  uint32_t tris_num_ = 0;
+
+ public:
+  /**
+   * Open the file and write the header. Check #is_open for success, errors are added to
+   * \a reports (which may be null).
+   */
+  FileWriter(const char *filepath, bool ascii, ReportList *reports);
+  /**
+   * Closes the file if #close was not called.
+   */
+  ~FileWriter();
+
+  /**
+   * Finish the file (ASCII footer, or the triangle count in binary files) and close it.
+   * \return False if the file was not open or any write failed.
+   */
+  bool close();
+
+  FileWriter(const FileWriter &) = delete;
+  FileWriter &operator=(const FileWriter &) = delete;
+
+  bool is_open() const
+  {
+    return file_ != nullptr;
+  }
+
+  /**
+   * Append triangles to the file. ASCII text is formatted on multiple threads;
+   * binary triangles are written as-is.
+   */
+  void write_triangles(Span<PackedTriangle> tris);
+};
+
+}  // namespace blender::io::stl
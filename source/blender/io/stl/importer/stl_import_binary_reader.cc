@@ -6,12 +6,17 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <functional>
 
 #include "BKE_main.h"
 #include "BKE_mesh.h"
 
 #include "BLI_array.hh"
+#include "BLI_map.hh"
 #include "BLI_memory_utils.hh"
+#include "BLI_mmap.h"
+#include "BLI_task.hh"
 
 #include "DNA_mesh_types.h"
 
@@ -29,6 +34,267 @@ struct STLBinaryTriangle {
 };
 #pragma pack(pop)
 
+/* Files with fewer triangles are read serially, threading overhead would dominate. */
+static const uint32_t PARALLEL_TRIS_THRESHOLD = 64 * 1024;
+/* Vertices and triangles are distributed over this many hash tables, to merge them in parallel. */
+static const int SHARDS_NUM = 256;
+/* Number of elements processed by one task, when counting and distributing elements. */
+static const int BLOCK_SIZE = 64 * 1024;
+
+/* Triangles in the mapped file are not aligned, so copy the coordinates. */
+static float3 corner_position(Span<STLBinaryTriangle> stl_tris, const int corner)
+{
+  const STLBinaryTriangle &tri = stl_tris[corner / 3];
+  const float *co = corner % 3 == 0 ? tri.v1 : (corner % 3 == 1 ? tri.v2 : tri.v3);
+  float3 pos;
+  memcpy(&pos, co, sizeof(pos));
+  return pos;
+}
+
+static float3 tri_normal(Span<STLBinaryTriangle> stl_tris, const int tri)
+{
+  float3 normal;
+  memcpy(&normal, stl_tris[tri].normal, sizeof(normal));
+  return normal;
+}
+
+static IndexRange block_range(const int block, const int size)
+{
+  return IndexRange(block * BLOCK_SIZE, std::min(BLOCK_SIZE, size - block * BLOCK_SIZE));
+}
+
+static int hash_to_shard(const uint64_t hash)
+{
+  /* Mix all hash bits, the low bits of vector hashes are not well distributed. */
+  return int(((hash ^ (hash >> 32)) * 0x9E3779B97F4A7C15ull) >> 56) % SHARDS_NUM;
+}
+
+/**
+ * For every element, find the index of the first element with an equal key. Keys are
+ * distributed over shards by their hash, and every shard is merged by a single task that visits
+ * its elements in order, so the result is the same as merging all keys serially.
+ */
+template<typename Key, typename GetKeyFn>
+static Array<int> find_first_equal(const int size, const GetKeyFn &get_key)
+{
+  const int blocks_num = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  Array<uint8_t> shards(size);
+  Array<int> block_shard_counts(blocks_num * SHARDS_NUM, 0);
+  threading::parallel_for(IndexRange(blocks_num), 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      MutableSpan<int> counts = block_shard_counts.as_mutable_span().slice(block * SHARDS_NUM,
+                                                                           SHARDS_NUM);
+      for (const int i : block_range(block, size)) {
+        const int shard = hash_to_shard(DefaultHash<Key>{}(get_key(i)));
+        shards[i] = uint8_t(shard);
+        counts[shard]++;
+      }
+    }
+  });
+
+  /* Turn the counts into the positions where every block writes the elements of each shard,
+   * keeping the elements of a shard sorted by index. */
+  Array<int> shard_offsets(SHARDS_NUM + 1);
+  int offset = 0;
+  for (const int shard : IndexRange(SHARDS_NUM)) {
+    shard_offsets[shard] = offset;
+    for (const int block : IndexRange(blocks_num)) {
+      int &count = block_shard_counts[block * SHARDS_NUM + shard];
+      const int block_count = count;
+      count = offset;
+      offset += block_count;
+    }
+  }
+  shard_offsets[SHARDS_NUM] = offset;
+
+  Array<int> sorted_indices(size);
+  threading::parallel_for(IndexRange(blocks_num), 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      MutableSpan<int> cursors = block_shard_counts.as_mutable_span().slice(block * SHARDS_NUM,
+                                                                            SHARDS_NUM);
+      for (const int i : block_range(block, size)) {
+        sorted_indices[cursors[shards[i]]++] = i;
+      }
+    }
+  });
+
+  Array<int> first_equal(size);
+  threading::parallel_for(IndexRange(SHARDS_NUM), 1, [&](IndexRange shard_range) {
+    for (const int shard : shard_range) {
+      const Span<int> indices = sorted_indices.as_span().slice(
+          shard_offsets[shard], shard_offsets[shard + 1] - shard_offsets[shard]);
+      Map<Key, int> first_by_key;
+      first_by_key.reserve(indices.size());
+      for (const int i : indices) {
+        first_equal[i] = first_by_key.lookup_or_add(get_key(i), i);
+      }
+    }
+  });
+  return first_equal;
+}
+
+/**
+ * Give consecutive new indices to the selected elements, keeping their order. Once the number of
+ * selected elements is known, `allocate(selected_num)` is called, and then `assign(i, new_index)`
+ * for every selected element.
+ */
+template<typename SelectFn, typename AllocateFn, typename AssignFn>
+static void compact_indices(const int size,
+                            const SelectFn &is_selected,
+                            const AllocateFn &allocate,
+                            const AssignFn &assign)
+{
+  const int blocks_num = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  Array<int> block_offsets(blocks_num);
+  threading::parallel_for(IndexRange(blocks_num), 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      int count = 0;
+      for (const int i : block_range(block, size)) {
+        count += is_selected(i) ? 1 : 0;
+      }
+      block_offsets[block] = count;
+    }
+  });
+  int total = 0;
+  for (int &offset : block_offsets) {
+    const int count = offset;
+    offset = total;
+    total += count;
+  }
+  allocate(total);
+  threading::parallel_for(IndexRange(blocks_num), 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      int new_index = block_offsets[block];
+      for (const int i : block_range(block, size)) {
+        if (is_selected(i)) {
+          assign(i, new_index++);
+        }
+      }
+    }
+  });
+}
+
+/**
+ * Merge vertices and triangles of the memory-mapped triangle array in parallel. Gives the same
+ * mesh as adding the triangles one by one to #STLMeshHelper.
+ */
+static Mesh *stl_tris_to_mesh_parallel(Span<STLBinaryTriangle> stl_tris,
+                                       Main *bmain,
+                                       char *mesh_name,
+                                       bool use_custom_normals)
+{
+  const int tris_num = stl_tris.size();
+  const int corners_num = tris_num * 3;
+
+  /* Vertices are numbered in the order of their first use, like #VectorSet does. */
+  Array<int> corner_verts;
+  Array<float3> verts;
+  {
+    const Array<int> first_corner = find_first_equal<float3>(
+        corners_num, [&](const int corner) { return corner_position(stl_tris, corner); });
+    corner_verts.reinitialize(corners_num);
+    compact_indices(
+        corners_num,
+        [&](const int corner) { return first_corner[corner] == corner; },
+        [&](const int verts_num) { verts.reinitialize(verts_num); },
+        [&](const int corner, const int vert) {
+          corner_verts[corner] = vert;
+          verts[vert] = corner_position(stl_tris, corner);
+        });
+    threading::parallel_for(IndexRange(corners_num), 4096, [&](IndexRange corners) {
+      for (const int corner : corners) {
+        const int first = first_corner[corner];
+        if (first != corner) {
+          corner_verts[corner] = corner_verts[first];
+        }
+      }
+    });
+  }
+
+  auto get_tri = [&](const int tri) -> Triangle {
+    return {corner_verts[3 * tri], corner_verts[3 * tri + 1], corner_verts[3 * tri + 2]};
+  };
+  auto is_degenerate = [&](const int tri) {
+    const Triangle t = get_tri(tri);
+    return (t.v1 == t.v2) || (t.v1 == t.v3) || (t.v2 == t.v3);
+  };
+
+  /* Degenerate triangles are never equal to valid ones, so they don't affect the merging. */
+  const Array<int> first_tri = find_first_equal<Triangle>(tris_num, get_tri);
+  Array<bool> tri_kept(tris_num);
+  threading::parallel_for(IndexRange(tris_num), 4096, [&](IndexRange tris_range) {
+    for (const int tri : tris_range) {
+      tri_kept[tri] = !is_degenerate(tri) && first_tri[tri] == tri;
+    }
+  });
+
+  Array<Triangle> tris;
+  Array<float3> loop_normals;
+  compact_indices(
+      tris_num,
+      [&](const int tri) { return tri_kept[tri]; },
+      [&](const int kept_tris_num) {
+        tris.reinitialize(kept_tris_num);
+        if (use_custom_normals) {
+          loop_normals.reinitialize(kept_tris_num * 3);
+        }
+      },
+      [&](const int tri, const int new_tri) {
+        tris[new_tri] = get_tri(tri);
+        if (use_custom_normals) {
+          loop_normals.as_mutable_span().slice(new_tri * 3, 3).fill(tri_normal(stl_tris, tri));
+        }
+      });
+
+  const int degenerate_tris_num = threading::parallel_reduce(
+      IndexRange(tris_num),
+      4096,
+      0,
+      [&](IndexRange tris_range, int count) {
+        for (const int tri : tris_range) {
+          count += is_degenerate(tri) ? 1 : 0;
+        }
+        return count;
+      },
+      std::plus<int>());
+  report_removed_tris(degenerate_tris_num, tris_num - tris.size() - degenerate_tris_num);
+
+  return create_mesh_from_tris(bmain, mesh_name, verts, tris, loop_normals);
+}
+
+/**
+ * Read the triangles directly from the memory-mapped file and merge them in parallel.
+ * Returns false when the file can't be mapped.
+ */
+static bool read_stl_binary_mapped(FILE *file,
+                                   const uint32_t num_tris,
+                                   Main *bmain,
+                                   char *mesh_name,
+                                   bool use_custom_normals,
+                                   Mesh **r_mesh)
+{
+  BLI_mmap_file *mmap_file = BLI_mmap_open(fileno(file));
+  if (mmap_file == nullptr) {
+    return false;
+  }
+  BLI_SCOPED_DEFER([&]() { BLI_mmap_free(mmap_file); });
+
+  const size_t tris_offset = BINARY_HEADER_SIZE + sizeof(uint32_t);
+  if (BLI_mmap_get_length(mmap_file) < tris_offset + size_t(num_tris) * BINARY_STRIDE) {
+    return false;
+  }
+  const char *memory = static_cast<const char *>(BLI_mmap_get_pointer(mmap_file));
+  const Span<STLBinaryTriangle> stl_tris(
+      reinterpret_cast<const STLBinaryTriangle *>(memory + tris_offset), num_tris);
+
+  Mesh *mesh = stl_tris_to_mesh_parallel(stl_tris, bmain, mesh_name, use_custom_normals);
+  if (BLI_mmap_any_io_error(mmap_file)) {
+    fprintf(stderr, "STL Importer: failed to read file, I/O error.\n");
+  }
+  *r_mesh = mesh;
+  return true;
+}
+
 Mesh *read_stl_binary(FILE *file, Main *bmain, char *mesh_name, bool use_custom_normals)
 {
   const int chunk_size = 1024;
@@ -43,6 +309,20 @@ Mesh *read_stl_binary(FILE *file, Main *bmain, char *mesh_name, bool use_custom_
     return BKE_mesh_add(bmain, mesh_name);
   }
 
+  if (uint64_t(num_tris) * 3 > INT32_MAX) {
+    fprintf(stderr, "STL Importer: too many triangles (%u) for a single mesh.\n", num_tris);
+    return nullptr;
+  }
+
+  if (num_tris >= PARALLEL_TRIS_THRESHOLD) {
+    Mesh *mesh = nullptr;
+    if (read_stl_binary_mapped(file, num_tris, bmain, mesh_name, use_custom_normals, &mesh)) {
+      return mesh;
+    }
+    /* Mapping the file failed, fall back to reading it in chunks. */
+    fseek(file, BINARY_HEADER_SIZE + sizeof(uint32_t), SEEK_SET);
+  }
+
   Array<STLBinaryTriangle> tris_buf(chunk_size);
   STLMeshHelper stl_mesh(num_tris, use_custom_normals);
   size_t num_read_tris;
@@ -60,55 +60,75 @@ void STLMeshHelper::add_triangle(const float3 &a,
   }
 }
 
-Mesh *STLMeshHelper::to_mesh(Main *bmain, char *mesh_name)
+void report_removed_tris(const int degenerate_tris_num, const int duplicate_tris_num)
 {
-  if (degenerate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << degenerate_tris_num_ << " degenerate triangles were removed"
+  if (degenerate_tris_num > 0) {
+    std::cout << "STL Importer: " << degenerate_tris_num << " degenerate triangles were removed"
               << std::endl;
   }
-  if (duplicate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << duplicate_tris_num_ << " duplicate triangles were removed"
+  if (duplicate_tris_num > 0) {
+    std::cout << "STL Importer: " << duplicate_tris_num << " duplicate triangles were removed"
               << std::endl;
   }
+}
 
+Mesh *create_mesh_from_tris(Main *bmain,
+                            char *mesh_name,
+                            Span<float3> verts,
+                            Span<Triangle> tris,
+                            MutableSpan<float3> loop_normals)
+{
   Mesh *mesh = BKE_mesh_add(bmain, mesh_name);
   /* User count is already 1 here, but will be set later in #BKE_mesh_assign_object. */
   id_us_min(&mesh->id);
 
-  mesh->totvert = verts_.size();
+  mesh->totvert = verts.size();
   mesh->mvert = static_cast<MVert *>(
       CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, nullptr, mesh->totvert));
-  for (int i = 0; i < mesh->totvert; i++) {
-    copy_v3_v3(mesh->mvert[i].co, verts_[i]);
-  }
+  threading::parallel_for(verts.index_range(), 4096, [&](IndexRange verts_range) {
+    for (const int i : verts_range) {
+      copy_v3_v3(mesh->mvert[i].co, verts[i]);
+    }
+  });
 
-  mesh->totpoly = tris_.size();
-  mesh->totloop = tris_.size() * 3;
+  mesh->totpoly = tris.size();
+  mesh->totloop = tris.size() * 3;
   mesh->mpoly = static_cast<MPoly *>(
       CustomData_add_layer(&mesh->pdata, CD_MPOLY, CD_CALLOC, nullptr, mesh->totpoly));
   mesh->mloop = static_cast<MLoop *>(
       CustomData_add_layer(&mesh->ldata, CD_MLOOP, CD_CALLOC, nullptr, mesh->totloop));
 
-  threading::parallel_for(tris_.index_range(), 2048, [&](IndexRange tris_range) {
+  threading::parallel_for(tris.index_range(), 2048, [&](IndexRange tris_range) {
     for (const int i : tris_range) {
       mesh->mpoly[i].loopstart = 3 * i;
       mesh->mpoly[i].totloop = 3;
 
-      mesh->mloop[3 * i].v = tris_[i].v1;
-      mesh->mloop[3 * i + 1].v = tris_[i].v2;
-      mesh->mloop[3 * i + 2].v = tris_[i].v3;
+      mesh->mloop[3 * i].v = tris[i].v1;
+      mesh->mloop[3 * i + 1].v = tris[i].v2;
+      mesh->mloop[3 * i + 2].v = tris[i].v3;
     }
   });
 
   /* NOTE: edges must be calculated first before setting custom normals. */
   BKE_mesh_calc_edges(mesh, false, false);
 
-  if (use_custom_normals_ && loop_normals_.size() == mesh->totloop) {
-    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(loop_normals_.data()));
+  if (!loop_normals.is_empty() && loop_normals.size() == mesh->totloop) {
+    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(loop_normals.data()));
     mesh->flag |= ME_AUTOSMOOTH;
   }
 
   return mesh;
 }
 
+Mesh *STLMeshHelper::to_mesh(Main *bmain, char *mesh_name)
+{
+  report_removed_tris(degenerate_tris_num_, duplicate_tris_num_);
+  return create_mesh_from_tris(bmain,
+                               mesh_name,
+                               verts_.as_span(),
+                               tris_.as_span(),
+                               use_custom_normals_ ? loop_normals_.as_mutable_span() :
+                                                     MutableSpan<float3>());
+}
+
 }  // namespace blender::io::stl
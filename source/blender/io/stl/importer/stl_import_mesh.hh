@@ -45,6 +45,21 @@ class Triangle {
   }
 };
 
+/**
+ * Create a mesh from de-duplicated vertex positions and triangles indexing into them.
+ * `loop_normals` is either empty or contains three custom normals per triangle.
+ */
+Mesh *create_mesh_from_tris(Main *bmain,
+                            char *mesh_name,
+                            Span<float3> verts,
+                            Span<Triangle> tris,
+                            MutableSpan<float3> loop_normals);
+
+/**
+ * Print how many triangles were removed while merging duplicates.
+ */
+void report_removed_tris(int degenerate_tris_num, int duplicate_tris_num);
+
 class STLMeshHelper {
  private:
   VectorSet<float3> verts_;
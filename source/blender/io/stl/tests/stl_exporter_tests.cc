@@ -0,0 +1,268 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+#include "testing/testing.h"
+#include "tests/blendfile_loading_base_test.h"
+
+#include "BKE_appdir.h"
+#include "BKE_blender_version.h"
+#include "BKE_report.h"
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "DEG_depsgraph.h"
+
+#include "stl_export.hh"
+#include "stl_export_writer.hh"
+
+namespace blender::io::stl {
+
+static std::string read_file_in_string(const std::string &file_path, const bool binary)
+{
+  std::ifstream file(file_path, binary ? std::ios::binary : std::ios::in);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+static std::string temp_file_path(const char *name)
+{
+  BKE_tempdir_init(nullptr);
+  return std::string(BKE_tempdir_base()) + name;
+}
+
+static std::string header_text()
+{
+  return std::string("Exported from Blender-") + BKE_blender_version_string();
+}
+
+static PackedTriangle make_triangle(const float x_offset)
+{
+  PackedTriangle tri;
+  const float normal[3] = {0.0f, 0.0f, 1.0f};
+  const float vertices[3][3] = {
+      {x_offset, 0.0f, 0.0f}, {x_offset + 1.0f, 0.0f, 0.0f}, {x_offset, 2.0f, 0.0f}};
+  memcpy(tri.normal, normal, sizeof(normal));
+  memcpy(tri.vertices, vertices, sizeof(vertices));
+  return tri;
+}
+
+TEST(stl_exporter_writer, ascii_golden)
+{
+  const std::string filepath = temp_file_path("stl_export_ascii.stl");
+  {
+    FileWriter writer(filepath.c_str(), true, nullptr);
+    ASSERT_TRUE(writer.is_open());
+    const PackedTriangle tris[2] = {make_triangle(0.0f), make_triangle(1.0f)};
+    writer.write_triangles(Span<PackedTriangle>(tris, 2));
+    EXPECT_TRUE(writer.close());
+  }
+
+  const std::string golden = "solid " + header_text() +
+                             "\n"
+                             "facet normal 0.000000 0.000000 1.000000\n"
+                             "outer loop\n"
+                             "vertex 0.000000 0.000000 0.000000\n"
+                             "vertex 1.000000 0.000000 0.000000\n"
+                             "vertex 0.000000 2.000000 0.000000\n"
+                             "endloop\n"
+                             "endfacet\n"
+                             "facet normal 0.000000 0.000000 1.000000\n"
+                             "outer loop\n"
+                             "vertex 1.000000 0.000000 0.000000\n"
+                             "vertex 2.000000 0.000000 0.000000\n"
+                             "vertex 1.000000 2.000000 0.000000\n"
+                             "endloop\n"
+                             "endfacet\n"
+                             "endsolid " +
+                             header_text() + "\n";
+  EXPECT_EQ(read_file_in_string(filepath, false), golden);
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+TEST(stl_exporter_writer, binary_golden)
+{
+  const std::string filepath = temp_file_path("stl_export_binary.stl");
+  {
+    FileWriter writer(filepath.c_str(), false, nullptr);
+    ASSERT_TRUE(writer.is_open());
+    /* Triangles written in two calls, the count is only written when closing the file. */
+    const PackedTriangle tri_a = make_triangle(0.0f);
+    const PackedTriangle tri_b = make_triangle(1.0f);
+    writer.write_triangles(Span<PackedTriangle>(&tri_a, 1));
+    writer.write_triangles(Span<PackedTriangle>(&tri_b, 1));
+    EXPECT_TRUE(writer.close());
+  }
+
+  /* Little-endian IEEE floats. */
+  const std::string f0("\x00\x00\x00\x00", 4);
+  const std::string f1("\x00\x00\x80\x3f", 4);
+  const std::string f2("\x00\x00\x00\x40", 4);
+  const std::string attribute_byte_count("\x00\x00", 2);
+
+  std::string golden = header_text();
+  golden.resize(80, '\0');
+  golden += std::string("\x02\x00\x00\x00", 4);
+  golden += f0 + f0 + f1;
+  golden += f0 + f0 + f0 + f1 + f0 + f0 + f0 + f2 + f0;
+  golden += attribute_byte_count;
+  golden += f0 + f0 + f1;
+  golden += f1 + f0 + f0 + f2 + f0 + f0 + f1 + f2 + f0;
+  golden += attribute_byte_count;
+
+  EXPECT_EQ(read_file_in_string(filepath, true), golden);
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+TEST(stl_exporter_writer, ascii_many_triangles_keep_order)
+{
+  /* More triangles than formatted by a single task, to format them on multiple threads. */
+  const int tris_num = 10000;
+  Array<PackedTriangle> tris(tris_num);
+  for (const int i : tris.index_range()) {
+    tris[i] = make_triangle(float(i));
+  }
+
+  const std::string filepath = temp_file_path("stl_export_ascii_many.stl");
+  {
+    FileWriter writer(filepath.c_str(), true, nullptr);
+    ASSERT_TRUE(writer.is_open());
+    writer.write_triangles(tris);
+    EXPECT_TRUE(writer.close());
+  }
+
+  std::ifstream file(filepath);
+  std::string line;
+  int facets_num = 0;
+  int vertex_lines_num = 0;
+  while (std::getline(file, line)) {
+    if (BLI_str_startswith(line.c_str(), "facet normal")) {
+      facets_num++;
+    }
+    else if (BLI_str_startswith(line.c_str(), "vertex")) {
+      /* First vertex of each triangle starts at the triangle index. */
+      if (vertex_lines_num % 3 == 0) {
+        char expected[64];
+        BLI_snprintf(expected, sizeof(expected), "vertex %f ", float(vertex_lines_num / 3));
+        EXPECT_TRUE(BLI_str_startswith(line.c_str(), expected)) << line;
+      }
+      vertex_lines_num++;
+    }
+  }
+  EXPECT_EQ(facets_num, tris_num);
+  EXPECT_EQ(vertex_lines_num, tris_num * 3);
+  file.close();
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+TEST(stl_exporter_writer, open_failure_is_reported)
+{
+  const std::string filepath = temp_file_path("stl_export_missing_dir/file.stl");
+  ReportList reports;
+  BKE_reports_init(&reports, RPT_STORE);
+  {
+    FileWriter writer(filepath.c_str(), false, &reports);
+    EXPECT_FALSE(writer.is_open());
+    EXPECT_FALSE(writer.close());
+  }
+  EXPECT_EQ(BLI_listbase_count(&reports.list), 1);
+  EXPECT_TRUE(BKE_reports_contain(&reports, RPT_ERROR));
+  BKE_reports_clear(&reports);
+}
+
+TEST(stl_exporter, batch_filepath_unique)
+{
+  Set<std::string> used_filepaths;
+  EXPECT_EQ(batch_filepath("/tmp/scene.stl", "Cube", used_filepaths), "/tmp/sceneCube.stl");
+  /* Instances of the same object. */
+  EXPECT_EQ(batch_filepath("/tmp/scene.stl", "Cube", used_filepaths), "/tmp/sceneCube.001.stl");
+  EXPECT_EQ(batch_filepath("/tmp/scene.stl", "Cube", used_filepaths), "/tmp/sceneCube.002.stl");
+  /* Different names that are the same once made safe for file paths. */
+  EXPECT_EQ(batch_filepath("/tmp/scene.stl", "A/B", used_filepaths), "/tmp/sceneA_B.stl");
+  EXPECT_EQ(batch_filepath("/tmp/scene.stl", "A:B", used_filepaths), "/tmp/sceneA_B.001.stl");
+  EXPECT_EQ(batch_filepath("/tmp/scene.stl", "Sphere", used_filepaths), "/tmp/sceneSphere.stl");
+}
+
+class stl_exporter_test : public BlendfileLoadingBaseTest {
+ public:
+  bool load_file_and_depsgraph(const std::string &filepath)
+  {
+    if (!blendfile_load(filepath.c_str())) {
+      return false;
+    }
+    depsgraph_create(DAG_EVAL_VIEWPORT);
+    return true;
+  }
+
+  STLExportParams default_params(const std::string &filepath, const bool ascii)
+  {
+    STLExportParams params{};
+    BLI_strncpy(params.filepath, filepath.c_str(), sizeof(params.filepath));
+    params.forward_axis = IO_AXIS_Y;
+    params.up_axis = IO_AXIS_Z;
+    params.global_scale = 1.0f;
+    params.apply_modifiers = true;
+    params.ascii_format = ascii;
+    return params;
+  }
+};
+
+TEST_F(stl_exporter_test, ascii_and_binary_match)
+{
+  if (!load_file_and_depsgraph("io_tests/blend_geometry/all_quads.blend")) {
+    ADD_FAILURE();
+    return;
+  }
+
+  const std::string binary_path = temp_file_path("stl_export_scene_binary.stl");
+  const std::string ascii_path = temp_file_path("stl_export_scene_ascii.stl");
+  EXPECT_TRUE(export_frame(depsgraph, default_params(binary_path, false), nullptr));
+  EXPECT_TRUE(export_frame(depsgraph, default_params(ascii_path, true), nullptr));
+
+  const std::string binary = read_file_in_string(binary_path, true);
+  ASSERT_GE(binary.size(), 84);
+  uint32_t tris_num;
+  memcpy(&tris_num, binary.data() + 80, sizeof(tris_num));
+  EXPECT_GT(tris_num, 0);
+  EXPECT_EQ(binary.size(), 84 + size_t(tris_num) * sizeof(PackedTriangle));
+
+  std::ifstream ascii(ascii_path);
+  std::string line;
+  uint32_t facets_num = 0;
+  while (std::getline(ascii, line)) {
+    facets_num += BLI_str_startswith(line.c_str(), "facet normal");
+  }
+  EXPECT_EQ(facets_num, tris_num);
+  ascii.close();
+
+  BLI_delete(binary_path.c_str(), false, false);
+  BLI_delete(ascii_path.c_str(), false, false);
+}
+
+TEST_F(stl_exporter_test, write_failure_is_reported)
+{
+  if (!load_file_and_depsgraph("io_tests/blend_geometry/all_quads.blend")) {
+    ADD_FAILURE();
+    return;
+  }
+
+  const std::string filepath = temp_file_path("stl_export_missing_dir/scene.stl");
+  for (const bool use_batch : {false, true}) {
+    ReportList reports;
+    BKE_reports_init(&reports, RPT_STORE);
+    STLExportParams params = default_params(filepath, false);
+    params.use_batch = use_batch;
+    EXPECT_FALSE(export_frame(depsgraph, params, &reports));
+    EXPECT_TRUE(BKE_reports_contain(&reports, RPT_ERROR));
+    BKE_reports_clear(&reports);
+  }
+}
+
+}  // namespace blender::io::stl
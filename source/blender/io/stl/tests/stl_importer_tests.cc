@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "testing/testing.h"
+#include "tests/blendfile_loading_base_test.h"
+
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+
+#include "BLI_fileops.h"
+#include "BLI_math_vec_types.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "stl_import_binary_reader.hh"
+#include "stl_import_mesh.hh"
+
+namespace blender::io::stl {
+
+struct TestTriangle {
+  float3 normal;
+  float3 v1, v2, v3;
+};
+
+/**
+ * Triangles of a grid, so most vertices are shared by six triangles, with some duplicate
+ * triangles (in another vertex order) and some degenerate ones.
+ */
+static Vector<TestTriangle> grid_triangles(const int size_x, const int size_y)
+{
+  Vector<TestTriangle> tris;
+  for (int y = 0; y < size_y; y++) {
+    for (int x = 0; x < size_x; x++) {
+      const float3 v00(x, y, (x * y) % 7), v10(x + 1, y, ((x + 1) * y) % 7);
+      const float3 v01(x, y + 1, (x * (y + 1)) % 7);
+      const float3 v11(x + 1, y + 1, ((x + 1) * (y + 1)) % 7);
+      const float3 normal(0.0f, float(x % 3) - 1.0f, 1.0f);
+      tris.append({normal, v00, v10, v11});
+      tris.append({normal, v00, v11, v01});
+      if ((x + y) % 101 == 0) {
+        tris.append({normal, v11, v01, v00});
+      }
+      if ((x + y) % 97 == 0) {
+        tris.append({normal, v00, v10, v00});
+      }
+    }
+  }
+  return tris;
+}
+
+static std::string write_binary_stl(const char *name, Span<TestTriangle> tris)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string filepath = std::string(BKE_tempdir_base()) + name;
+  FILE *file = BLI_fopen(filepath.c_str(), "wb");
+  char header[BINARY_HEADER_SIZE] = {0};
+  fwrite(header, 1, sizeof(header), file);
+  const uint32_t tris_num = uint32_t(tris.size());
+  fwrite(&tris_num, sizeof(tris_num), 1, file);
+  for (const TestTriangle &tri : tris) {
+    fwrite(&tri.normal, sizeof(float3), 1, file);
+    fwrite(&tri.v1, sizeof(float3), 1, file);
+    fwrite(&tri.v2, sizeof(float3), 1, file);
+    fwrite(&tri.v3, sizeof(float3), 1, file);
+    const uint16_t attribute_byte_count = 0;
+    fwrite(&attribute_byte_count, sizeof(attribute_byte_count), 1, file);
+  }
+  fclose(file);
+  return filepath;
+}
+
+class stl_importer_test : public BlendfileLoadingBaseTest {
+};
+
+/* The parallel merge of large binary files gives the same mesh as merging the triangles one by
+ * one with #STLMeshHelper. */
+TEST_F(stl_importer_test, binary_parallel_matches_serial)
+{
+  const Vector<TestTriangle> tris = grid_triangles(190, 180);
+  ASSERT_GE(tris.size(), 64 * 1024);
+  const std::string filepath = write_binary_stl("stl_import_parallel.stl", tris);
+
+  for (const bool use_custom_normals : {false, true}) {
+    SCOPED_TRACE(use_custom_normals ? "custom normals" : "no custom normals");
+    Main *bmain = BKE_main_new();
+    char mesh_name[MAX_ID_NAME - 2] = "Mesh";
+
+    FILE *file = BLI_fopen(filepath.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    const Mesh *mesh = read_stl_binary(file, bmain, mesh_name, use_custom_normals);
+    fclose(file);
+    ASSERT_NE(mesh, nullptr);
+
+    STLMeshHelper helper(tris.size(), use_custom_normals);
+    for (const TestTriangle &tri : tris) {
+      if (use_custom_normals) {
+        helper.add_triangle(tri.v1, tri.v2, tri.v3, tri.normal);
+      }
+      else {
+        helper.add_triangle(tri.v1, tri.v2, tri.v3);
+      }
+    }
+    const Mesh *mesh_serial = helper.to_mesh(bmain, mesh_name);
+
+    ASSERT_EQ(mesh->totvert, mesh_serial->totvert);
+    ASSERT_EQ(mesh->totpoly, mesh_serial->totpoly);
+    ASSERT_EQ(mesh->totloop, mesh_serial->totloop);
+    ASSERT_EQ(mesh->totedge, mesh_serial->totedge);
+    EXPECT_LT(mesh->totpoly, tris.size());
+    for (int i = 0; i < mesh->totvert; i++) {
+      EXPECT_EQ(float3(mesh->mvert[i].co), float3(mesh_serial->mvert[i].co)) << "vertex " << i;
+    }
+    for (int i = 0; i < mesh->totloop; i++) {
+      EXPECT_EQ(mesh->mloop[i].v, mesh_serial->mloop[i].v) << "loop " << i;
+    }
+
+    const short(*clnors)[2] = static_cast<const short(*)[2]>(
+        CustomData_get_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL));
+    const short(*clnors_serial)[2] = static_cast<const short(*)[2]>(
+        CustomData_get_layer(&mesh_serial->ldata, CD_CUSTOMLOOPNORMAL));
+    ASSERT_EQ(clnors != nullptr, use_custom_normals);
+    ASSERT_EQ(clnors_serial != nullptr, use_custom_normals);
+    if (use_custom_normals) {
+      for (int i = 0; i < mesh->totloop; i++) {
+        EXPECT_EQ(clnors[i][0], clnors_serial[i][0]) << "loop " << i;
+        EXPECT_EQ(clnors[i][1], clnors_serial[i][1]) << "loop " << i;
+      }
+    }
+
+    BKE_main_free(bmain);
+  }
+
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+}  // namespace blender::io::stl
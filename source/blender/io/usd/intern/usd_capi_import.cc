@@ -227,6 +227,17 @@ static void import_startjob(void *customdata, short *stop, short *do_update, flo
   archive->collect_readers(data->bmain);
 
   *data->progress = 0.2f;
+  *data->do_update = true;
+
+  /* Read the geometry of all prims in parallel, the rest needs #Main and is done serially. */
+  archive->read_geometry(0.0, &G.is_break);
+  if (G.is_break) {
+    data->was_canceled = true;
+    return;
+  }
+
+  *data->progress = 0.6f;
+  *data->do_update = true;
 
   const float size = static_cast<float>(archive->readers().size());
   size_t i = 0;
@@ -252,7 +263,7 @@ static void import_startjob(void *customdata, short *stop, short *do_update, flo
       ob->parent = parent->object();
     }
 
-    *data->progress = 0.2f + 0.8f * (++i / size);
+    *data->progress = 0.6f + 0.4f * (++i / size);
     *data->do_update = true;
 
     if (G.is_break) {
@@ -19,6 +19,7 @@
 #include "BKE_duplilist.h"
 
 #include "BLI_assert.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DEG_depsgraph_query.h"
@@ -35,6 +36,46 @@ USDHierarchyIterator::USDHierarchyIterator(Main *bmain,
                                            const USDExportParams &params)
     : AbstractHierarchyIterator(bmain, depsgraph), stage_(stage), params_(params)
 {
+  task_pool_ = BLI_task_pool_create(nullptr, TASK_PRIORITY_HIGH);
+}
+
+USDHierarchyIterator::~USDHierarchyIterator()
+{
+  BLI_task_pool_work_and_wait(task_pool_);
+  BLI_task_pool_free(task_pool_);
+}
+
+void USDHierarchyIterator::iterate_and_write()
+{
+  AbstractHierarchyIterator::iterate_and_write();
+
+  BLI_task_pool_work_and_wait(task_pool_);
+  std::vector<std::function<void()>> writes;
+  writes.swap(deferred_writes_);
+  for (const std::function<void()> &write : writes) {
+    write();
+  }
+}
+
+static void deferred_extract_run(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  (*static_cast<std::function<void()> *>(taskdata))();
+}
+
+static void deferred_extract_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  delete static_cast<std::function<void()> *>(taskdata);
+}
+
+void USDHierarchyIterator::defer_write(std::function<void()> extract,
+                                       std::function<void()> write)
+{
+  BLI_task_pool_push(task_pool_,
+                     deferred_extract_run,
+                     new std::function<void()>(std::move(extract)),
+                     true,
+                     deferred_extract_free);
+  deferred_writes_.push_back(std::move(write));
 }
 
 bool USDHierarchyIterator::mark_as_weak_export(const Object *object) const
@@ -6,7 +6,9 @@
 #include "usd.h"
 #include "usd_exporter_context.h"
 
+#include <functional>
 #include <string>
+#include <vector>
 
 #include <pxr/usd/usd/common.h>
 #include <pxr/usd/usd/timeCode.h>
@@ -14,6 +16,7 @@
 struct Depsgraph;
 struct Main;
 struct Object;
+struct TaskPool;
 
 namespace blender::io::usd {
 
@@ -27,11 +30,25 @@ class USDHierarchyIterator : public AbstractHierarchyIterator {
   pxr::UsdTimeCode export_time_;
   const USDExportParams &params_;
 
+  /* Data extraction of the current frame runs in this pool while the hierarchy is iterated. */
+  TaskPool *task_pool_;
+  std::vector<std::function<void()>> deferred_writes_;
+
  public:
   USDHierarchyIterator(Main *bmain,
                        Depsgraph *depsgraph,
                        pxr::UsdStageRefPtr stage,
                        const USDExportParams &params);
+  ~USDHierarchyIterator() override;
+
+  virtual void iterate_and_write() override;
+
+  /**
+   * Run `extract` on a worker thread, and `write` on the calling thread once the data of all
+   * objects of the current frame has been extracted. Writes are called in the order in which they
+   * were deferred, as authoring USD data is not thread-safe.
+   */
+  void defer_write(std::function<void()> extract, std::function<void()> write);
 
   void set_export_frame(float frame_nr);
   std::string get_export_file_path() const;
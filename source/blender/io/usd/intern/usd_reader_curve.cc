@@ -36,11 +36,14 @@ void USDCurvesReader::create_object(Main *bmain, const double /* motionSampleTim
   object_->data = curve_;
 }
 
-void USDCurvesReader::read_object_data(Main *bmain, double motionSampleTime)
+void USDCurvesReader::read_geometry(const double motionSampleTime)
 {
   Curve *cu = (Curve *)object_->data;
   read_curve_sample(cu, motionSampleTime);
+}
 
+void USDCurvesReader::read_object_data(Main *bmain, double motionSampleTime)
+{
   if (curve_prim_.GetPointsAttr().ValueMightBeTimeVarying()) {
     add_cache_modifier();
   }
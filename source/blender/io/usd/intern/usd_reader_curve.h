@@ -31,6 +31,7 @@ class USDCurvesReader : public USDGeomReader {
   }
 
   void create_object(Main *bmain, double motionSampleTime) override;
+  void read_geometry(double motionSampleTime) override;
   void read_object_data(Main *bmain, double motionSampleTime) override;
 
   void read_curve_sample(Curve *cu, double motionSampleTime);
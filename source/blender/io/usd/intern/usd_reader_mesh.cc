@@ -7,6 +7,7 @@
 #include "usd_reader_material.h"
 
 #include "BKE_customdata.h"
+#include "BKE_lib_id.h"
 #include "BKE_main.h"
 #include "BKE_material.h"
 #include "BKE_mesh.h"
@@ -216,10 +217,19 @@ USDMeshReader::USDMeshReader(const pxr::UsdPrim &prim,
       is_left_handed_(false),
       has_uvs_(false),
       is_time_varying_(false),
-      is_initial_load_(false)
+      is_initial_load_(false),
+      read_geometry_mesh_(nullptr)
 {
 }
 
+USDMeshReader::~USDMeshReader()
+{
+  /* Not consumed when the import is canceled. */
+  if (read_geometry_mesh_) {
+    BKE_id_free(nullptr, read_geometry_mesh_);
+  }
+}
+
 void USDMeshReader::create_object(Main *bmain, const double /* motionSampleTime */)
 {
   Mesh *mesh = BKE_mesh_add(bmain, name_.c_str());
@@ -228,16 +238,27 @@ void USDMeshReader::create_object(Main *bmain, const double /* motionSampleTime
   object_->data = mesh;
 }
 
-void USDMeshReader::read_object_data(Main *bmain, const double motionSampleTime)
+void USDMeshReader::read_geometry(const double motionSampleTime)
 {
   Mesh *mesh = (Mesh *)object_->data;
 
   is_initial_load_ = true;
   Mesh *read_mesh = this->read_mesh(
       mesh, motionSampleTime, import_params_.mesh_read_flag, nullptr);
+  if (read_mesh != mesh) {
+    read_geometry_mesh_ = read_mesh;
+  }
 
   is_initial_load_ = false;
-  if (read_mesh != mesh) {
+}
+
+void USDMeshReader::read_object_data(Main *bmain, const double motionSampleTime)
+{
+  Mesh *mesh = (Mesh *)object_->data;
+
+  if (read_geometry_mesh_) {
+    Mesh *read_mesh = read_geometry_mesh_;
+    read_geometry_mesh_ = nullptr;
     /* FIXME: after 2.80; `mesh->flag` isn't copied by #BKE_mesh_nomain_to_mesh() */
     /* read_mesh can be freed by BKE_mesh_nomain_to_mesh(), so get the flag before that happens. */
     uint16_t autosmooth = (read_mesh->flag & ME_AUTOSMOOTH);
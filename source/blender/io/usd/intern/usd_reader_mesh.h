@@ -38,14 +38,22 @@ class USDMeshReader : public USDGeomReader {
    * implemented.  Note this will break if faces or positions vary. */
   bool is_initial_load_;
 
+  /**
+   * Mesh created by #read_geometry when the object's mesh couldn't be filled in place,
+   * moved into the object's mesh by #read_object_data.
+   */
+  Mesh *read_geometry_mesh_;
+
  public:
   USDMeshReader(const pxr::UsdPrim &prim,
                 const USDImportParams &import_params,
                 const ImportSettings &settings);
+  ~USDMeshReader() override;
 
   bool valid() const override;
 
   void create_object(Main *bmain, double motionSampleTime) override;
+  void read_geometry(double motionSampleTime) override;
   void read_object_data(Main *bmain, double motionSampleTime) override;
 
   struct Mesh *read_mesh(struct Mesh *existing_mesh,
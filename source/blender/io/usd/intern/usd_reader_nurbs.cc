@@ -53,11 +53,14 @@ void USDNurbsReader::create_object(Main *bmain, const double /* motionSampleTime
   object_->data = curve_;
 }
 
-void USDNurbsReader::read_object_data(Main *bmain, const double motionSampleTime)
+void USDNurbsReader::read_geometry(const double motionSampleTime)
 {
   Curve *cu = (Curve *)object_->data;
   read_curve_sample(cu, motionSampleTime);
+}
 
+void USDNurbsReader::read_object_data(Main *bmain, const double motionSampleTime)
+{
   if (curve_prim_.GetPointsAttr().ValueMightBeTimeVarying()) {
     add_cache_modifier();
   }
@@ -89,6 +89,12 @@ class USDPrimReader {
   virtual bool valid() const;
 
   virtual void create_object(Main *bmain, double motionSampleTime) = 0;
+  /**
+   * Read and convert the prim data that doesn't need #Main, such as geometry, into the data
+   * created by #create_object. Readers are called concurrently from multiple threads,
+   * after #create_object and before #read_object_data.
+   */
+  virtual void read_geometry(double /* motionSampleTime */){};
   virtual void read_object_data(Main * /* bmain */, double /* motionSampleTime */){};
 
   Object *object() const;
@@ -28,6 +28,8 @@
 
 #include <iostream>
 
+#include "BLI_task.hh"
+
 namespace blender::io::usd {
 
 USDStageReader::USDStageReader(pxr::UsdStageRefPtr stage,
@@ -293,6 +295,21 @@ void USDStageReader::collect_readers(Main *bmain)
   collect_readers(bmain, root);
 }
 
+void USDStageReader::read_geometry(const double motionSampleTime, const bool *is_break)
+{
+  /* USD stages can be read concurrently, and each reader only writes to its own data. */
+  threading::parallel_for(IndexRange(readers_.size()), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      if (*is_break) {
+        return;
+      }
+      if (USDPrimReader *reader = readers_[i]) {
+        reader->read_geometry(motionSampleTime);
+      }
+    }
+  });
+}
+
 void USDStageReader::clear_readers()
 {
   for (USDPrimReader *reader : readers_) {
@@ -40,6 +40,12 @@ class USDStageReader {
 
   void collect_readers(struct Main *bmain);
 
+  /**
+   * Call #USDPrimReader::read_geometry for all readers, on multiple threads.
+   * Readers that are not reached because `is_break` became true are skipped.
+   */
+  void read_geometry(double motionSampleTime, const bool *is_break);
+
   bool valid() const;
 
   pxr::UsdStageRefPtr stage()
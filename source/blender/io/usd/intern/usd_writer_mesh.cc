@@ -7,8 +7,11 @@
 #include <pxr/usd/usdShade/material.h>
 #include <pxr/usd/usdShade/materialBindingAPI.h>
 
+#include "BLI_array.hh"
 #include "BLI_assert.h"
 #include "BLI_math_vector.h"
+#include "BLI_span.hh"
+#include "BLI_task.hh"
 
 #include "BKE_attribute.h"
 #include "BKE_customdata.h"
@@ -28,9 +31,46 @@
 #include "DNA_particle_types.h"
 
 #include <iostream>
+#include <memory>
 
 namespace blender::io::usd {
 
+struct USDMeshData {
+  pxr::VtArray<pxr::GfVec3f> points;
+  pxr::VtIntArray face_vertex_counts;
+  pxr::VtIntArray face_indices;
+  std::map<short, pxr::VtIntArray> face_groups;
+
+  /* The length of this array specifies the number of creases on the surface. Each element gives
+   * the number of (must be adjacent) vertices in each crease, whose indices are linearly laid out
+   * in the 'creaseIndices' attribute. Since each crease must be at least one edge long, each
+   * element of this array should be greater than one. */
+  pxr::VtIntArray crease_lengths;
+  /* The indices of all vertices forming creased edges. The size of this array must be equal to the
+   * sum of all elements of the 'creaseLengths' attribute. */
+  pxr::VtIntArray crease_vertex_indices;
+  /* The per-crease or per-edge sharpness for all creases (Usd.Mesh.SHARPNESS_INFINITE for a
+   * perfectly sharp crease). Since 'creaseLengths' encodes the number of vertices in each crease,
+   * the number of elements in this array will be either 'len(creaseLengths)' or the sum over all X
+   * of '(creaseLengths[X] - 1)'. Note that while the RI spec allows each crease to have either a
+   * single sharpness or a value per-edge, USD will encode either a single sharpness per crease on
+   * a mesh, or sharpness's for all edges making up the creases on a mesh. */
+  pxr::VtFloatArray crease_sharpnesses;
+
+  /* The lengths of this array specifies the number of sharp corners (or vertex crease) on the
+   * surface. Each value is the index of a vertex in the mesh's vertex list. */
+  pxr::VtIntArray corner_indices;
+  /* The per-vertex sharpnesses. The lengths of this array must match that of `corner_indices`. */
+  pxr::VtFloatArray corner_sharpnesses;
+
+  /* Face-varying normals, only extracted when normals are exported. */
+  pxr::VtVec3fArray loop_normals;
+  /* Face-varying UV coordinates by primvar name, only extracted when UV maps are exported. */
+  std::vector<std::pair<pxr::TfToken, pxr::VtArray<pxr::GfVec2f>>> uv_maps;
+  /* Per-vertex velocities, empty when the mesh has no velocity attribute. */
+  pxr::VtVec3fArray velocities;
+};
+
 USDGenericMeshWriter::USDGenericMeshWriter(const USDExporterContext &ctx) : USDAbstractWriter(ctx)
 {
 }
@@ -53,19 +93,28 @@ void USDGenericMeshWriter::do_write(HierarchyContext &context)
     return;
   }
 
-  try {
-    write_mesh(context, mesh);
-
-    if (needsfree) {
-      free_export_mesh(mesh);
-    }
-  }
-  catch (...) {
-    if (needsfree) {
-      free_export_mesh(mesh);
-    }
-    throw;
-  }
+  /* The arrays are extracted on a worker thread while the other objects of the frame are visited,
+   * and authored once all of them are extracted. The context is copied, as it is freed at the end
+   * of the iteration. */
+  std::shared_ptr<USDMeshData> usd_mesh_data = std::make_shared<USDMeshData>();
+  const bool is_first_frame = !frame_has_been_written_;
+  usd_export_context_.hierarchy_iterator->defer_write(
+      [this, mesh, usd_mesh_data]() { get_geometry_data(mesh, *usd_mesh_data); },
+      [this, context, mesh, needsfree, usd_mesh_data, is_first_frame]() mutable {
+        try {
+          write_mesh(context, *usd_mesh_data, is_first_frame);
+
+          if (needsfree) {
+            free_export_mesh(mesh);
+          }
+        }
+        catch (...) {
+          if (needsfree) {
+            free_export_mesh(mesh);
+          }
+          throw;
+        }
+      });
 }
 
 void USDGenericMeshWriter::free_export_mesh(Mesh *mesh)
@@ -73,60 +122,18 @@ void USDGenericMeshWriter::free_export_mesh(Mesh *mesh)
   BKE_id_free(nullptr, mesh);
 }
 
-struct USDMeshData {
-  pxr::VtArray<pxr::GfVec3f> points;
-  pxr::VtIntArray face_vertex_counts;
-  pxr::VtIntArray face_indices;
-  std::map<short, pxr::VtIntArray> face_groups;
+/* Elements processed per task when extracting the arrays of large meshes. */
+static const int64_t EXTRACT_GRAIN_SIZE = 4096;
 
-  /* The length of this array specifies the number of creases on the surface. Each element gives
-   * the number of (must be adjacent) vertices in each crease, whose indices are linearly laid out
-   * in the 'creaseIndices' attribute. Since each crease must be at least one edge long, each
-   * element of this array should be greater than one. */
-  pxr::VtIntArray crease_lengths;
-  /* The indices of all vertices forming creased edges. The size of this array must be equal to the
-   * sum of all elements of the 'creaseLengths' attribute. */
-  pxr::VtIntArray crease_vertex_indices;
-  /* The per-crease or per-edge sharpness for all creases (Usd.Mesh.SHARPNESS_INFINITE for a
-   * perfectly sharp crease). Since 'creaseLengths' encodes the number of vertices in each crease,
-   * the number of elements in this array will be either 'len(creaseLengths)' or the sum over all X
-   * of '(creaseLengths[X] - 1)'. Note that while the RI spec allows each crease to have either a
-   * single sharpness or a value per-edge, USD will encode either a single sharpness per crease on
-   * a mesh, or sharpness's for all edges making up the creases on a mesh. */
-  pxr::VtFloatArray crease_sharpnesses;
-
-  /* The lengths of this array specifies the number of sharp corners (or vertex crease) on the
-   * surface. Each value is the index of a vertex in the mesh's vertex list. */
-  pxr::VtIntArray corner_indices;
-  /* The per-vertex sharpnesses. The lengths of this array must match that of `corner_indices`. */
-  pxr::VtFloatArray corner_sharpnesses;
-};
-
-void USDGenericMeshWriter::write_uv_maps(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh)
+void USDGenericMeshWriter::write_uv_maps(const USDMeshData &usd_mesh_data,
+                                         pxr::UsdGeomMesh usd_mesh)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
 
-  const CustomData *ldata = &mesh->ldata;
-  for (int layer_idx = 0; layer_idx < ldata->totlayer; layer_idx++) {
-    const CustomDataLayer *layer = &ldata->layers[layer_idx];
-    if (layer->type != CD_MLOOPUV) {
-      continue;
-    }
-
-    /* UV coordinates are stored in a Primvar on the Mesh, and can be referenced from materials.
-     * The primvar name is the same as the UV Map name. This is to allow the standard name "st"
-     * for texture coordinates by naming the UV Map as such, without having to guess which UV Map
-     * is the "standard" one. */
-    pxr::TfToken primvar_name(pxr::TfMakeValidIdentifier(layer->name));
+  for (const auto &[primvar_name, uv_coords] : usd_mesh_data.uv_maps) {
     pxr::UsdGeomPrimvar uv_coords_primvar = usd_mesh.CreatePrimvar(
         primvar_name, pxr::SdfValueTypeNames->TexCoord2fArray, pxr::UsdGeomTokens->faceVarying);
 
-    MLoopUV *mloopuv = static_cast<MLoopUV *>(layer->data);
-    pxr::VtArray<pxr::GfVec2f> uv_coords;
-    for (int loop_idx = 0; loop_idx < mesh->totloop; loop_idx++) {
-      uv_coords.push_back(pxr::GfVec2f(mloopuv[loop_idx].uv));
-    }
-
     if (!uv_coords_primvar.HasValue()) {
       uv_coords_primvar.Set(uv_coords, pxr::UsdTimeCode::Default());
     }
@@ -135,7 +142,9 @@ void USDGenericMeshWriter::write_uv_maps(const Mesh *mesh, pxr::UsdGeomMesh usd_
   }
 }
 
-void USDGenericMeshWriter::write_mesh(HierarchyContext &context, Mesh *mesh)
+void USDGenericMeshWriter::write_mesh(HierarchyContext &context,
+                                      const USDMeshData &usd_mesh_data,
+                                      const bool is_first_frame)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
   pxr::UsdTimeCode defaultTime = pxr::UsdTimeCode::Default();
@@ -145,9 +154,6 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context, Mesh *mesh)
   pxr::UsdGeomMesh usd_mesh = pxr::UsdGeomMesh::Define(stage, usd_path);
   write_visibility(context, timecode, usd_mesh);
 
-  USDMeshData usd_mesh_data;
-  get_geometry_data(mesh, usd_mesh_data);
-
   if (usd_export_context_.export_params.use_instancing && context.is_instance()) {
     if (!mark_as_instance(context, usd_mesh.GetPrim())) {
       return;
@@ -222,15 +228,15 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context, Mesh *mesh)
   }
 
   if (usd_export_context_.export_params.export_uvmaps) {
-    write_uv_maps(mesh, usd_mesh);
+    write_uv_maps(usd_mesh_data, usd_mesh);
   }
   if (usd_export_context_.export_params.export_normals) {
-    write_normals(mesh, usd_mesh);
+    write_normals(usd_mesh_data, usd_mesh);
   }
-  write_surface_velocity(mesh, usd_mesh);
+  write_surface_velocity(usd_mesh_data, usd_mesh);
 
   /* TODO(Sybren): figure out what happens when the face groups change. */
-  if (frame_has_been_written_) {
+  if (!is_first_frame) {
     return;
   }
 
@@ -243,34 +249,59 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context, Mesh *mesh)
 
 static void get_vertices(const Mesh *mesh, USDMeshData &usd_mesh_data)
 {
-  usd_mesh_data.points.reserve(mesh->totvert);
+  const Span<MVert> verts(mesh->mvert, mesh->totvert);
+  usd_mesh_data.points.resize(verts.size());
+
+  pxr::GfVec3f *points = usd_mesh_data.points.data();
+  threading::parallel_for(verts.index_range(), EXTRACT_GRAIN_SIZE, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      points[i] = pxr::GfVec3f(verts[i].co);
+    }
+  });
+}
 
-  const MVert *verts = mesh->mvert;
-  for (int i = 0; i < mesh->totvert; ++i) {
-    usd_mesh_data.points.push_back(pxr::GfVec3f(verts[i].co));
+/**
+ * Offsets of the polygons in the face-varying arrays, which list the loops in polygon order
+ * (this is not necessarily the order of the mesh loops).
+ */
+static Array<int> get_face_varying_offsets(const Mesh *mesh)
+{
+  const Span<MPoly> polys(mesh->mpoly, mesh->totpoly);
+  Array<int> offsets(polys.size());
+  int offset = 0;
+  for (const int64_t i : polys.index_range()) {
+    offsets[i] = offset;
+    offset += polys[i].totloop;
   }
+  return offsets;
 }
 
-static void get_loops_polys(const Mesh *mesh, USDMeshData &usd_mesh_data)
+static void get_loops_polys(const Mesh *mesh,
+                            const Span<int> face_varying_offsets,
+                            USDMeshData &usd_mesh_data)
 {
-  /* Only construct face groups (a.k.a. geometry subsets) when we need them for material
-   * assignments. */
-  bool construct_face_groups = mesh->totcol > 1;
-
-  usd_mesh_data.face_vertex_counts.reserve(mesh->totpoly);
-  usd_mesh_data.face_indices.reserve(mesh->totloop);
-
-  MLoop *mloop = mesh->mloop;
-  MPoly *mpoly = mesh->mpoly;
-  for (int i = 0; i < mesh->totpoly; ++i, ++mpoly) {
-    MLoop *loop = mloop + mpoly->loopstart;
-    usd_mesh_data.face_vertex_counts.push_back(mpoly->totloop);
-    for (int j = 0; j < mpoly->totloop; ++j, ++loop) {
-      usd_mesh_data.face_indices.push_back(loop->v);
+  const Span<MPoly> polys(mesh->mpoly, mesh->totpoly);
+  const Span<MLoop> loops(mesh->mloop, mesh->totloop);
+  usd_mesh_data.face_vertex_counts.resize(polys.size());
+  usd_mesh_data.face_indices.resize(loops.size());
+
+  int *face_vertex_counts = usd_mesh_data.face_vertex_counts.data();
+  int *face_indices = usd_mesh_data.face_indices.data();
+  threading::parallel_for(polys.index_range(), EXTRACT_GRAIN_SIZE, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const MPoly &poly = polys[i];
+      face_vertex_counts[i] = poly.totloop;
+      for (const int j : IndexRange(poly.totloop)) {
+        face_indices[face_varying_offsets[i] + j] = loops[poly.loopstart + j].v;
+      }
     }
+  });
 
-    if (construct_face_groups) {
-      usd_mesh_data.face_groups[mpoly->mat_nr].push_back(i);
+  /* Only construct face groups (a.k.a. geometry subsets) when we need them for material
+   * assignments. */
+  if (mesh->totcol > 1) {
+    for (const int i : polys.index_range()) {
+      usd_mesh_data.face_groups[polys[i].mat_nr].push_back(i);
     }
   }
 }
@@ -318,12 +349,123 @@ static void get_vert_creases(const Mesh *mesh, USDMeshData &usd_mesh_data)
   }
 }
 
+static void get_uv_maps(const Mesh *mesh, USDMeshData &usd_mesh_data)
+{
+  const CustomData *ldata = &mesh->ldata;
+  for (int layer_idx = 0; layer_idx < ldata->totlayer; layer_idx++) {
+    const CustomDataLayer *layer = &ldata->layers[layer_idx];
+    if (layer->type != CD_MLOOPUV) {
+      continue;
+    }
+
+    /* UV coordinates are stored in a Primvar on the Mesh, and can be referenced from materials.
+     * The primvar name is the same as the UV Map name. This is to allow the standard name "st"
+     * for texture coordinates by naming the UV Map as such, without having to guess which UV Map
+     * is the "standard" one. */
+    pxr::TfToken primvar_name(pxr::TfMakeValidIdentifier(layer->name));
+    usd_mesh_data.uv_maps.emplace_back(primvar_name, pxr::VtArray<pxr::GfVec2f>());
+    pxr::VtArray<pxr::GfVec2f> &uv_coords = usd_mesh_data.uv_maps.back().second;
+
+    const Span<MLoopUV> mloopuv(static_cast<const MLoopUV *>(layer->data), mesh->totloop);
+    uv_coords.resize(mloopuv.size());
+    pxr::GfVec2f *uv_coords_data = uv_coords.data();
+    threading::parallel_for(
+        mloopuv.index_range(), EXTRACT_GRAIN_SIZE, [&](const IndexRange range) {
+          for (const int64_t loop_idx : range) {
+            uv_coords_data[loop_idx] = pxr::GfVec2f(mloopuv[loop_idx].uv);
+          }
+        });
+  }
+}
+
+static void get_loop_normals(const Mesh *mesh,
+                             const Span<int> face_varying_offsets,
+                             USDMeshData &usd_mesh_data)
+{
+  const float(*lnors)[3] = static_cast<float(*)[3]>(CustomData_get_layer(&mesh->ldata, CD_NORMAL));
+
+  usd_mesh_data.loop_normals.resize(mesh->totloop);
+  pxr::GfVec3f *loop_normals = usd_mesh_data.loop_normals.data();
+
+  if (lnors != nullptr) {
+    /* Export custom loop normals. */
+    threading::parallel_for(
+        IndexRange(mesh->totloop), EXTRACT_GRAIN_SIZE, [&](const IndexRange range) {
+          for (const int64_t loop_idx : range) {
+            loop_normals[loop_idx] = pxr::GfVec3f(lnors[loop_idx]);
+          }
+        });
+    return;
+  }
+
+  /* Compute the loop normals based on the 'smooth' flag. */
+  const float(*vert_normals)[3] = BKE_mesh_vertex_normals_ensure(mesh);
+  const float(*face_normals)[3] = BKE_mesh_poly_normals_ensure(mesh);
+  const Span<MPoly> polys(mesh->mpoly, mesh->totpoly);
+  const Span<MLoop> loops(mesh->mloop, mesh->totloop);
+  threading::parallel_for(polys.index_range(), EXTRACT_GRAIN_SIZE, [&](const IndexRange range) {
+    for (const int64_t poly_idx : range) {
+      const MPoly &poly = polys[poly_idx];
+      pxr::GfVec3f *poly_normals = loop_normals + face_varying_offsets[poly_idx];
+
+      if ((poly.flag & ME_SMOOTH) == 0) {
+        /* Flat shaded, use common normal for all verts. */
+        const pxr::GfVec3f pxr_normal(face_normals[poly_idx]);
+        for (const int loop_idx : IndexRange(poly.totloop)) {
+          poly_normals[loop_idx] = pxr_normal;
+        }
+      }
+      else {
+        /* Smooth shaded, use individual vert normals. */
+        for (const int loop_idx : IndexRange(poly.totloop)) {
+          poly_normals[loop_idx] = pxr::GfVec3f(
+              vert_normals[loops[poly.loopstart + loop_idx].v]);
+        }
+      }
+    }
+  });
+}
+
+static void get_velocities(const Mesh *mesh, USDMeshData &usd_mesh_data)
+{
+  /* Export velocity attribute output by fluid sim, sequence cache modifier
+   * and geometry nodes. */
+  const CustomDataLayer *velocity_layer = BKE_id_attribute_find(
+      &mesh->id, "velocity", CD_PROP_FLOAT3, ATTR_DOMAIN_POINT);
+
+  if (velocity_layer == nullptr) {
+    return;
+  }
+
+  const float(*velocities)[3] = reinterpret_cast<float(*)[3]>(velocity_layer->data);
+
+  /* Export per-vertex velocity vectors. */
+  usd_mesh_data.velocities.resize(mesh->totvert);
+  pxr::GfVec3f *usd_velocities = usd_mesh_data.velocities.data();
+  threading::parallel_for(
+      IndexRange(mesh->totvert), EXTRACT_GRAIN_SIZE, [&](const IndexRange range) {
+        for (const int64_t vertex_idx : range) {
+          usd_velocities[vertex_idx] = pxr::GfVec3f(velocities[vertex_idx]);
+        }
+      });
+}
+
 void USDGenericMeshWriter::get_geometry_data(const Mesh *mesh, USDMeshData &usd_mesh_data)
 {
+  const Array<int> face_varying_offsets = get_face_varying_offsets(mesh);
+
   get_vertices(mesh, usd_mesh_data);
-  get_loops_polys(mesh, usd_mesh_data);
+  get_loops_polys(mesh, face_varying_offsets, usd_mesh_data);
   get_edge_creases(mesh, usd_mesh_data);
   get_vert_creases(mesh, usd_mesh_data);
+
+  if (usd_export_context_.export_params.export_uvmaps) {
+    get_uv_maps(mesh, usd_mesh_data);
+  }
+  if (usd_export_context_.export_params.export_normals) {
+    get_loop_normals(mesh, face_varying_offsets, usd_mesh_data);
+  }
+  get_velocities(mesh, usd_mesh_data);
 }
 
 void USDGenericMeshWriter::assign_materials(const HierarchyContext &context,
@@ -388,43 +530,11 @@ void USDGenericMeshWriter::assign_materials(const HierarchyContext &context,
   }
 }
 
-void USDGenericMeshWriter::write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh)
+void USDGenericMeshWriter::write_normals(const USDMeshData &usd_mesh_data,
+                                         pxr::UsdGeomMesh usd_mesh)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
-  const float(*lnors)[3] = static_cast<float(*)[3]>(CustomData_get_layer(&mesh->ldata, CD_NORMAL));
-
-  pxr::VtVec3fArray loop_normals;
-  loop_normals.reserve(mesh->totloop);
-
-  if (lnors != nullptr) {
-    /* Export custom loop normals. */
-    for (int loop_idx = 0, totloop = mesh->totloop; loop_idx < totloop; ++loop_idx) {
-      loop_normals.push_back(pxr::GfVec3f(lnors[loop_idx]));
-    }
-  }
-  else {
-    /* Compute the loop normals based on the 'smooth' flag. */
-    const float(*vert_normals)[3] = BKE_mesh_vertex_normals_ensure(mesh);
-    const float(*face_normals)[3] = BKE_mesh_poly_normals_ensure(mesh);
-    MPoly *mpoly = mesh->mpoly;
-    for (int poly_idx = 0, totpoly = mesh->totpoly; poly_idx < totpoly; ++poly_idx, ++mpoly) {
-      MLoop *mloop = mesh->mloop + mpoly->loopstart;
-
-      if ((mpoly->flag & ME_SMOOTH) == 0) {
-        /* Flat shaded, use common normal for all verts. */
-        pxr::GfVec3f pxr_normal(face_normals[poly_idx]);
-        for (int loop_idx = 0; loop_idx < mpoly->totloop; ++loop_idx) {
-          loop_normals.push_back(pxr_normal);
-        }
-      }
-      else {
-        /* Smooth shaded, use individual vert normals. */
-        for (int loop_idx = 0; loop_idx < mpoly->totloop; ++loop_idx, ++mloop) {
-          loop_normals.push_back(pxr::GfVec3f(vert_normals[mloop->v]));
-        }
-      }
-    }
-  }
+  const pxr::VtVec3fArray &loop_normals = usd_mesh_data.loop_normals;
 
   pxr::UsdAttribute attr_normals = usd_mesh.CreateNormalsAttr(pxr::VtValue(), true);
   if (!attr_normals.HasValue()) {
@@ -434,29 +544,15 @@ void USDGenericMeshWriter::write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_
   usd_mesh.SetNormalsInterpolation(pxr::UsdGeomTokens->faceVarying);
 }
 
-void USDGenericMeshWriter::write_surface_velocity(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh)
+void USDGenericMeshWriter::write_surface_velocity(const USDMeshData &usd_mesh_data,
+                                                  pxr::UsdGeomMesh usd_mesh)
 {
-  /* Export velocity attribute output by fluid sim, sequence cache modifier
-   * and geometry nodes. */
-  CustomDataLayer *velocity_layer = BKE_id_attribute_find(
-      &mesh->id, "velocity", CD_PROP_FLOAT3, ATTR_DOMAIN_POINT);
-
-  if (velocity_layer == nullptr) {
+  if (usd_mesh_data.velocities.empty()) {
     return;
   }
 
-  const float(*velocities)[3] = reinterpret_cast<float(*)[3]>(velocity_layer->data);
-
-  /* Export per-vertex velocity vectors. */
-  pxr::VtVec3fArray usd_velocities;
-  usd_velocities.reserve(mesh->totvert);
-
-  for (int vertex_idx = 0, totvert = mesh->totvert; vertex_idx < totvert; ++vertex_idx) {
-    usd_velocities.push_back(pxr::GfVec3f(velocities[vertex_idx]));
-  }
-
   pxr::UsdTimeCode timecode = get_export_time_code();
-  usd_mesh.CreateVelocitiesAttr().Set(usd_velocities, timecode);
+  usd_mesh.CreateVelocitiesAttr().Set(usd_mesh_data.velocities, timecode);
 }
 
 USDMeshWriter::USDMeshWriter(const USDExporterContext &ctx) : USDGenericMeshWriter(ctx)
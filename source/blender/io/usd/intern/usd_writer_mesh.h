@@ -26,14 +26,19 @@ class USDGenericMeshWriter : public USDAbstractWriter {
   /* Mapping from material slot number to array of face indices with that material. */
   typedef std::map<short, pxr::VtIntArray> MaterialFaceGroups;
 
-  void write_mesh(HierarchyContext &context, Mesh *mesh);
+  /** Author the extracted data. `is_first_frame` is true when nothing was written before. */
+  void write_mesh(HierarchyContext &context,
+                  const struct USDMeshData &usd_mesh_data,
+                  bool is_first_frame);
+  /** Extract the arrays to write from the mesh. Doesn't touch the USD stage. */
   void get_geometry_data(const Mesh *mesh, struct USDMeshData &usd_mesh_data);
   void assign_materials(const HierarchyContext &context,
                         pxr::UsdGeomMesh usd_mesh,
                         const MaterialFaceGroups &usd_face_groups);
-  void write_uv_maps(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh);
-  void write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh);
-  void write_surface_velocity(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh);
+  void write_uv_maps(const struct USDMeshData &usd_mesh_data, pxr::UsdGeomMesh usd_mesh);
+  void write_normals(const struct USDMeshData &usd_mesh_data, pxr::UsdGeomMesh usd_mesh);
+  void write_surface_velocity(const struct USDMeshData &usd_mesh_data,
+                              pxr::UsdGeomMesh usd_mesh);
 };
 
 class USDMeshWriter : public USDGenericMeshWriter {
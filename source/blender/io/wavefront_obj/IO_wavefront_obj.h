@@ -50,6 +50,8 @@ struct OBJExportParams {
   bool export_triangulated_mesh;
   bool export_curves_as_nurbs;
   ePathReferenceMode path_mode;
+  /** Write a zstd compressed `.obj.zst` file. */
+  bool compress_zstd;
 
   /* Grouping options. */
   bool export_object_groups;
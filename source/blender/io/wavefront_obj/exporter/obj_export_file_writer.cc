@@ -165,7 +165,7 @@ void OBJWriter::write_header() const
   FormatHandler<eFileType::OBJ> fh;
   fh.write<eOBJSyntaxElement::string>("# Blender "s + BKE_blender_version_string() + "\n");
   fh.write<eOBJSyntaxElement::string>("# www.blender.org\n");
-  fh.write_to_file(outfile_);
+  fh.write_to_file(*async_writer_);
 }
 
 void OBJWriter::write_mtllib_name(const StringRefNull mtl_filepath) const
@@ -176,7 +176,7 @@ void OBJWriter::write_mtllib_name(const StringRefNull mtl_filepath) const
   BLI_split_dirfile(mtl_filepath.data(), mtl_dir_name, mtl_file_name, FILE_MAXDIR, FILE_MAXFILE);
   FormatHandler<eFileType::OBJ> fh;
   fh.write<eOBJSyntaxElement::mtllib>(mtl_file_name);
-  fh.write_to_file(outfile_);
+  fh.write_to_file(*async_writer_);
 }
 
 void OBJWriter::write_object_name(FormatHandler<eFileType::OBJ> &fh,
@@ -505,6 +505,10 @@ static std::string float3_to_string(const float3 &numbers)
 MTLWriter::MTLWriter(const char *obj_filepath) noexcept(false)
 {
   mtl_filepath_ = obj_filepath;
+  /* Materials of compressed `.obj.zst` files are written uncompressed, next to them. */
+  if (BLI_path_extension_check(obj_filepath, ".zst")) {
+    BLI_path_extension_replace(mtl_filepath_.data(), FILE_MAX, "");
+  }
   const bool ok = BLI_path_extension_replace(mtl_filepath_.data(), FILE_MAX, ".mtl");
   if (!ok) {
     throw std::system_error(ENAMETOOLONG, std::system_category(), "");
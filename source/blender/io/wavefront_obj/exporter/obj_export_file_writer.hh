@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "DNA_meshdata_types.h"
 
 #include "BLI_map.hh"
@@ -38,6 +40,8 @@ class OBJWriter : NonMovable, NonCopyable {
   const OBJExportParams &export_params_;
   std::string outfile_path_;
   FILE *outfile_;
+  /** Writes the formatted text to #outfile_ on a separate thread. */
+  std::unique_ptr<AsyncFileWriter> async_writer_;
 
  public:
   OBJWriter(const char *filepath, const OBJExportParams &export_params) noexcept(false)
@@ -47,18 +51,24 @@ class OBJWriter : NonMovable, NonCopyable {
     if (!outfile_) {
       throw std::system_error(errno, std::system_category(), "Cannot open file " + outfile_path_);
     }
+    async_writer_ = std::make_unique<AsyncFileWriter>(outfile_, export_params.compress_zstd);
   }
   ~OBJWriter()
   {
-    if (outfile_ && std::fclose(outfile_)) {
+    const bool write_ok = async_writer_->finish();
+    if (!write_ok || std::fclose(outfile_)) {
       std::cerr << "Error: could not close the file '" << outfile_path_
                 << "' properly, it may be corrupted." << std::endl;
     }
   }
 
-  FILE *get_outfile() const
+  /**
+   * All writes go through this, they are done in order but may still be in progress after the
+   * call returns. The file is complete once the #OBJWriter is destroyed.
+   */
+  AsyncFileWriter &get_outfile() const
   {
-    return outfile_;
+    return *async_writer_;
   }
 
   void write_header() const;
@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <zstd.h>
+
+#include "BLI_threads.h"
+
+#include "obj_export_io.hh"
+
+namespace blender::io::obj {
+
+/* Amount of formatted text that may wait for the I/O thread before formatting is paused. */
+static const size_t MAX_QUEUED_BYTES = 256 * 1024 * 1024;
+static const int ZSTD_COMPRESSION_LEVEL = 3;
+
+AsyncFileWriter::AsyncFileWriter(FILE *file, const bool compress) : file_(file)
+{
+  if (compress) {
+    zstd_context_ = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(zstd_context_, ZSTD_c_compressionLevel, ZSTD_COMPRESSION_LEVEL);
+    zstd_buffer_.resize(ZSTD_CStreamOutSize());
+  }
+  BLI_threadpool_init(&threads_, io_thread, 1);
+  BLI_threadpool_insert(&threads_, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+  this->finish();
+  if (zstd_context_) {
+    ZSTD_freeCCtx(zstd_context_);
+  }
+}
+
+void AsyncFileWriter::write(Block &&block)
+{
+  if (block.empty()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  /* A single block larger than the limit is still accepted once the queue is empty. */
+  queue_changed_.wait(lock,
+                      [&]() { return queued_bytes_ < MAX_QUEUED_BYTES || queue_.empty(); });
+  queued_bytes_ += block.size();
+  queue_.push_back(std::move(block));
+  lock.unlock();
+  queue_changed_.notify_all();
+}
+
+bool AsyncFileWriter::finish()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finishing_ = true;
+  }
+  queue_changed_.notify_all();
+  /* Waits for the I/O thread, does nothing when it was already stopped. */
+  BLI_threadpool_end(&threads_);
+  return !write_error_;
+}
+
+void *AsyncFileWriter::io_thread(void *userdata)
+{
+  AsyncFileWriter &writer = *static_cast<AsyncFileWriter *>(userdata);
+  std::unique_lock<std::mutex> lock(writer.mutex_);
+  while (true) {
+    writer.queue_changed_.wait(lock,
+                               [&]() { return !writer.queue_.empty() || writer.finishing_; });
+    if (writer.queue_.empty()) {
+      break;
+    }
+    const Block block = std::move(writer.queue_.front());
+    writer.queue_.pop_front();
+    lock.unlock();
+    writer.write_block(block, false);
+    lock.lock();
+    writer.queued_bytes_ -= block.size();
+    writer.queue_changed_.notify_all();
+  }
+  lock.unlock();
+  if (writer.zstd_context_) {
+    writer.write_block({}, true);
+  }
+  return nullptr;
+}
+
+void AsyncFileWriter::write_block(const Block &block, const bool is_last)
+{
+  if (zstd_context_ == nullptr) {
+    if (fwrite(block.data(), 1, block.size(), file_) != block.size()) {
+      write_error_ = true;
+    }
+    return;
+  }
+  ZSTD_inBuffer input = {block.data(), block.size(), 0};
+  const ZSTD_EndDirective mode = is_last ? ZSTD_e_end : ZSTD_e_continue;
+  bool done = false;
+  while (!done) {
+    ZSTD_outBuffer output = {zstd_buffer_.data(), zstd_buffer_.size(), 0};
+    const size_t remaining = ZSTD_compressStream2(zstd_context_, &output, &input, mode);
+    if (ZSTD_isError(remaining)) {
+      write_error_ = true;
+      return;
+    }
+    if (fwrite(zstd_buffer_.data(), 1, output.pos, file_) != output.pos) {
+      write_error_ = true;
+    }
+    /* The end of the stream is only complete when nothing remains to be flushed. */
+    done = is_last ? (remaining == 0) : (input.pos == input.size);
+  }
+}
+
+}  // namespace blender::io::obj
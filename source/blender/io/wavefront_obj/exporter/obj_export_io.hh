@@ -6,7 +6,10 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -16,11 +19,15 @@
 #include "BLI_string_ref.hh"
 #include "BLI_utility_mixins.hh"
 
+#include "DNA_listBase.h"
+
 /* SEP macro from BLI path utils clashes with SEP symbol in fmt headers. */
 #undef SEP
 #define FMT_HEADER_ONLY
 #include <fmt/format.h>
 
+struct ZSTD_CCtx_s;
+
 namespace blender::io::obj {
 
 enum class eFileType {
@@ -271,6 +278,49 @@ constexpr FormattingSyntax syntax_elem_to_formatting(const eMTLSyntaxElement key
 #  pragma GCC diagnostic pop
 #endif
 
+/**
+ * Writes blocks of formatted text to a file on a dedicated I/O thread, in the order they were
+ * queued. This lets formatting of the following data overlap with writing of the previous data.
+ * Optionally the output is compressed into a zstd stream.
+ */
+class AsyncFileWriter : NonCopyable, NonMovable {
+ public:
+  typedef std::vector<char> Block;
+
+ private:
+  FILE *file_;
+  ZSTD_CCtx_s *zstd_context_ = nullptr;
+  std::vector<char> zstd_buffer_;
+  ListBase threads_ = {nullptr, nullptr};
+
+  std::mutex mutex_;
+  std::condition_variable queue_changed_;
+  std::deque<Block> queue_;
+  size_t queued_bytes_ = 0;
+  bool finishing_ = false;
+  bool write_error_ = false;
+
+ public:
+  /** The file is not owned, it has to stay open until #finish returns. */
+  AsyncFileWriter(FILE *file, bool compress);
+  ~AsyncFileWriter();
+
+  /**
+   * Queue a block for writing. Waits while too much data is queued already,
+   * so that formatting cannot run arbitrarily far ahead of the disk.
+   */
+  void write(Block &&block);
+  /**
+   * Write all queued blocks and stop the I/O thread.
+   * \return false if any write failed.
+   */
+  bool finish();
+
+ private:
+  static void *io_thread(void *userdata);
+  void write_block(const Block &block, bool is_last);
+};
+
 /**
  * File format and syntax agnostic file buffer writer.
  * All writes are done into an internal chunked memory buffer
@@ -293,6 +343,15 @@ class FormatHandler : NonCopyable, NonMovable {
     blocks_.clear();
   }
 
+  /* Hand the buffer(s) over to the asynchronous writer, and clear the buffers. */
+  void write_to_file(AsyncFileWriter &writer)
+  {
+    for (auto &b : blocks_) {
+      writer.write(std::move(b));
+    }
+    blocks_.clear();
+  }
+
   std::string get_as_string() const
   {
     std::string s;
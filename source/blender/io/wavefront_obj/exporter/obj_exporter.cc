@@ -7,9 +7,11 @@
 #include <cstdio>
 #include <exception>
 #include <memory>
+#include <mutex>
 
 #include "BKE_scene.h"
 
+#include "BLI_array.hh"
 #include "BLI_path_util.h"
 #include "BLI_task.hh"
 #include "BLI_vector.hh"
@@ -144,6 +146,12 @@ static void write_mesh_objects(Vector<std::unique_ptr<OBJMesh>> exportable_as_me
    * and write them all into the file at the end. */
   size_t count = exportable_as_mesh.size();
   std::vector<FormatHandler<eFileType::OBJ>> buffers(count);
+  /* The buffers are handed to the I/O thread in object order, as soon as all previous objects
+   * are formatted too, so that writing overlaps with formatting the remaining objects. */
+  AsyncFileWriter &outfile = obj_writer.get_outfile();
+  std::mutex submit_mutex;
+  Array<bool> formatted(count, false);
+  size_t next_to_submit = 0;
 
   /* Serial: gather material indices, ensure normals & edges. */
   Vector<Vector<int>> mtlindices;
@@ -226,14 +234,15 @@ static void write_mesh_objects(Vector<std::unique_ptr<OBJMesh>> exportable_as_me
       /* Nothing will need this object's data after this point, release
        * various arrays here. */
       obj.clear();
+
+      std::lock_guard<std::mutex> lock(submit_mutex);
+      formatted[i] = true;
+      while (next_to_submit < count && formatted[next_to_submit]) {
+        buffers[next_to_submit].write_to_file(outfile);
+        next_to_submit++;
+      }
     }
   });
-
-  /* Write all the object text buffers into the output file. */
-  FILE *f = obj_writer.get_outfile();
-  for (auto &b : buffers) {
-    b.write_to_file(f);
-  }
 }
 
 /**
@@ -251,7 +260,9 @@ static void write_nurbs_curve_objects(const Vector<std::unique_ptr<OBJCurve>> &e
   fh.write_to_file(obj_writer.get_outfile());
 }
 
-void export_frame(Depsgraph *depsgraph, const OBJExportParams &export_params, const char *filepath)
+std::unique_ptr<OBJWriter> export_frame(Depsgraph *depsgraph,
+                                        const OBJExportParams &export_params,
+                                        const char *filepath)
 {
   std::unique_ptr<OBJWriter> frame_writer = nullptr;
   try {
@@ -259,11 +270,11 @@ void export_frame(Depsgraph *depsgraph, const OBJExportParams &export_params, co
   }
   catch (const std::system_error &ex) {
     print_exception_error(ex);
-    return;
+    return nullptr;
   }
   if (!frame_writer) {
     BLI_assert(!"File should be writable by now.");
-    return;
+    return nullptr;
   }
   std::unique_ptr<MTLWriter> mtl_writer = nullptr;
   if (export_params.export_materials) {
@@ -296,15 +307,22 @@ void export_frame(Depsgraph *depsgraph, const OBJExportParams &export_params, co
     mtl_writer->write_materials(export_params.blen_filepath, export_params.path_mode, dest_dir);
   }
   write_nurbs_curve_objects(std::move(exportable_as_nurbs), *frame_writer);
+  return frame_writer;
 }
 
 bool append_frame_to_filename(const char *filepath, const int frame, char *r_filepath_with_frames)
 {
   BLI_strncpy(r_filepath_with_frames, filepath, FILE_MAX);
+  /* Compressed files have a double extension. */
+  const bool is_compressed = BLI_path_extension_check(filepath, ".zst");
+  if (is_compressed) {
+    BLI_path_extension_replace(r_filepath_with_frames, FILE_MAX, "");
+  }
   BLI_path_extension_replace(r_filepath_with_frames, FILE_MAX, "");
   const int digits = frame == 0 ? 1 : integer_digits_i(abs(frame));
   BLI_path_frame(r_filepath_with_frames, frame, digits);
-  return BLI_path_extension_replace(r_filepath_with_frames, FILE_MAX, ".obj");
+  return BLI_path_extension_replace(
+      r_filepath_with_frames, FILE_MAX, is_compressed ? ".obj.zst" : ".obj");
 }
 
 void exporter_main(bContext *C, const OBJExportParams &export_params)
@@ -321,6 +339,10 @@ void exporter_main(bContext *C, const OBJExportParams &export_params)
     return;
   }
 
+  /* The previous frame is kept alive until the next one is formatted,
+   * so that its file is written in the background meanwhile. */
+  std::unique_ptr<OBJWriter> previous_frame_writer;
+
   char filepath_with_frames[FILE_MAX];
   /* Used to reset the Scene to its original state. */
   const int original_frame = scene->r.cfra;
@@ -335,8 +357,10 @@ void exporter_main(bContext *C, const OBJExportParams &export_params)
     scene->r.cfra = frame;
     obj_depsgraph.update_for_newframe();
     fprintf(stderr, "Writing to %s\n", filepath_with_frames);
-    export_frame(obj_depsgraph.get(), export_params, filepath_with_frames);
+    previous_frame_writer = export_frame(
+        obj_depsgraph.get(), export_params, filepath_with_frames);
   }
+  previous_frame_writer.reset();
   scene->r.cfra = original_frame;
 }
 }  // namespace blender::io::obj
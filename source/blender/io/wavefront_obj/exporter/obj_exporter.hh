@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "BLI_utility_mixins.hh"
 
 #include "BLI_vector.hh"
@@ -44,6 +46,7 @@ void exporter_main(bContext *C, const OBJExportParams &export_params);
 
 class OBJMesh;
 class OBJCurve;
+class OBJWriter;
 
 /**
  * Export a single frame of a .obj file, according to the given `export_parameters`.
@@ -55,10 +58,11 @@ class OBJCurve;
  * Export a single frame to a .OBJ file.
  *
  * Conditionally write a .MTL file also.
+ * The .OBJ file may still be written in the background until the returned writer is destroyed.
  */
-void export_frame(Depsgraph *depsgraph,
-                  const OBJExportParams &export_params,
-                  const char *filepath);
+std::unique_ptr<OBJWriter> export_frame(Depsgraph *depsgraph,
+                                        const OBJExportParams &export_params,
+                                        const char *filepath);
 
 /**
  * Find the objects to be exported in the `view_layer` of the dependency graph`depsgraph`,
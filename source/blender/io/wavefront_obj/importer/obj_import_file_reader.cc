@@ -7,7 +7,10 @@
 #include "BLI_map.hh"
 #include "BLI_math_color.h"
 #include "BLI_math_vector.h"
+#include "BLI_mmap.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
 #include "BLI_vector.hh"
 
 #include "obj_import_file_reader.hh"
@@ -70,15 +73,11 @@ static Geometry *create_geometry(Geometry *const prev_geometry,
   return new_geometry();
 }
 
-static void geom_add_vertex(Geometry *geom,
-                            const char *p,
-                            const char *end,
-                            GlobalVertices &r_global_vertices)
+static void chunk_add_vertex(const char *p, const char *end, ParsedChunk &r_chunk)
 {
   float3 vert;
   p = parse_floats(p, end, 0.0f, vert, 3);
-  r_global_vertices.vertices.append(vert);
-  geom->vertex_count_++;
+  r_chunk.vertices.append(vert);
   /* OBJ extension: `xyzrgb` vertex colors, when the vertex position
    * is followed by 3 more RGB color components. See
    * http://paulbourke.net/dataformats/obj/colour.html */
@@ -88,10 +87,12 @@ static void geom_add_vertex(Geometry *geom,
     if (srgb.x >= 0 && srgb.y >= 0 && srgb.z >= 0) {
       float3 linear;
       srgb_to_linearrgb_v3_v3(linear, srgb);
-      r_global_vertices.vertex_colors.append(linear);
-      geom->vertex_color_count_++;
+      r_chunk.vertex_colors.append(linear);
+      r_chunk.add_record(eChunkRecord::Vertices, 1);
+      return;
     }
   }
+  r_chunk.add_record(eChunkRecord::Vertices);
 }
 
 static void geom_add_mrgb_colors(Geometry *geom,
@@ -123,10 +124,7 @@ static void geom_add_mrgb_colors(Geometry *geom,
   }
 }
 
-static void geom_add_vertex_normal(Geometry *geom,
-                                   const char *p,
-                                   const char *end,
-                                   GlobalVertices &r_global_vertices)
+static void chunk_add_vertex_normal(const char *p, const char *end, ParsedChunk &r_chunk)
 {
   float3 normal;
   parse_floats(p, end, 0.0f, normal, 3);
@@ -134,15 +132,16 @@ static void geom_add_vertex_normal(Geometry *geom,
    * making them ever-so-slightly non unit length. Make sure they are
    * normalized. */
   normalize_v3(normal);
-  r_global_vertices.vertex_normals.append(normal);
-  geom->has_vertex_normals_ = true;
+  r_chunk.vertex_normals.append(normal);
+  r_chunk.add_record(eChunkRecord::VertexNormals);
 }
 
-static void geom_add_uv_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
+static void chunk_add_uv_vertex(const char *p, const char *end, ParsedChunk &r_chunk)
 {
   float2 uv;
   parse_floats(p, end, 0.0f, uv, 2);
-  r_global_vertices.uv_vertices.append(uv);
+  r_chunk.uv_vertices.append(uv);
+  r_chunk.add_record(eChunkRecord::UVVertices);
 }
 
 static void geom_add_edge(Geometry *geom,
@@ -161,9 +160,46 @@ static void geom_add_edge(Geometry *geom,
   geom->edges_.append({static_cast<uint>(edge_v1), static_cast<uint>(edge_v2)});
 }
 
+static void chunk_add_face(const char *p, const char *end, ParsedChunk &r_chunk)
+{
+  int corner_count = 0;
+  p = drop_whitespace(p, end);
+  while (p < end) {
+    RawCorner raw;
+    PolyCorner &corner = raw.corner;
+    /* Parse vertex index. */
+    p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
+    const bool vert_valid = corner.vert_index != INT32_MAX;
+    if (p < end && *p == '/') {
+      /* Parse UV index. */
+      ++p;
+      if (p < end && *p != '/') {
+        p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
+        raw.got_uv = corner.uv_vert_index != INT32_MAX;
+      }
+      /* Parse normal index. */
+      if (p < end && *p == '/') {
+        ++p;
+        p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
+        raw.got_normal = corner.vertex_normal_index != INT32_MAX;
+      }
+    }
+    r_chunk.face_corners.append(raw);
+    corner_count++;
+    if (!vert_valid) {
+      /* The face is invalid anyway, no need to look at the remaining corners. */
+      break;
+    }
+
+    /* Skip whitespace to get to the next face corner. */
+    p = drop_whitespace(p, end);
+  }
+  r_chunk.face_sizes.append(corner_count);
+  r_chunk.add_record(eChunkRecord::Faces);
+}
+
 static void geom_add_polygon(Geometry *geom,
-                             const char *p,
-                             const char *end,
+                             Span<RawCorner> raw_corners,
                              const GlobalVertices &global_vertices,
                              const VertexIndexOffset &offsets,
                              const int material_index,
@@ -182,27 +218,8 @@ static void geom_add_polygon(Geometry *geom,
   curr_face.start_index_ = orig_corners_size;
 
   bool face_valid = true;
-  p = drop_whitespace(p, end);
-  while (p < end && face_valid) {
-    PolyCorner corner;
-    bool got_uv = false, got_normal = false;
-    /* Parse vertex index. */
-    p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
-    face_valid &= corner.vert_index != INT32_MAX;
-    if (p < end && *p == '/') {
-      /* Parse UV index. */
-      ++p;
-      if (p < end && *p != '/') {
-        p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
-        got_uv = corner.uv_vert_index != INT32_MAX;
-      }
-      /* Parse normal index. */
-      if (p < end && *p == '/') {
-        ++p;
-        p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
-        got_normal = corner.vertex_normal_index != INT32_MAX;
-      }
-    }
+  for (const RawCorner &raw : raw_corners) {
+    PolyCorner corner = raw.corner;
     /* Always keep stored indices non-negative and zero-based. */
     corner.vert_index += corner.vert_index < 0 ? global_vertices.vertices.size() :
                                                  -offsets.get_index_offset() - 1;
@@ -213,7 +230,7 @@ static void geom_add_polygon(Geometry *geom,
               (size_t)global_vertices.vertices.size());
       face_valid = false;
     }
-    if (got_uv) {
+    if (raw.got_uv) {
       corner.uv_vert_index += corner.uv_vert_index < 0 ? global_vertices.uv_vertices.size() : -1;
       if (corner.uv_vert_index < 0 || corner.uv_vert_index >= global_vertices.uv_vertices.size()) {
         fprintf(stderr,
@@ -226,7 +243,7 @@ static void geom_add_polygon(Geometry *geom,
     /* Ignore corner normal index, if the geometry does not have any normals.
      * Some obj files out there do have face definitions that refer to normal indices,
      * without any normals being present (T98782). */
-    if (got_normal && geom->has_vertex_normals_) {
+    if (raw.got_normal && geom->has_vertex_normals_) {
       corner.vertex_normal_index += corner.vertex_normal_index < 0 ?
                                         global_vertices.vertex_normals.size() :
                                         -1;
@@ -239,11 +256,11 @@ static void geom_add_polygon(Geometry *geom,
         face_valid = false;
       }
     }
+    if (!face_valid) {
+      break;
+    }
     geom->face_corners_.append(corner);
     curr_face.corner_count_++;
-
-    /* Skip whitespace to get to the next face corner. */
-    p = drop_whitespace(p, end);
   }
 
   if (face_valid) {
@@ -354,8 +371,14 @@ static void geom_update_smooth_group(const char *p, const char *end, bool &r_sta
   r_state_shaded_smooth = smooth != 0;
 }
 
-OBJParser::OBJParser(const OBJImportParams &import_params, size_t read_buffer_size = 64 * 1024)
-    : import_params_(import_params), read_buffer_size_(read_buffer_size)
+OBJParser::OBJParser(const OBJImportParams &import_params,
+                     size_t read_buffer_size = 64 * 1024,
+                     bool use_threads = true,
+                     bool use_mmap = true)
+    : import_params_(import_params),
+      read_buffer_size_(read_buffer_size),
+      use_threads_(use_threads),
+      use_mmap_(use_mmap)
 {
   obj_file_ = BLI_fopen(import_params_.filepath, "rb");
   if (!obj_file_) {
@@ -390,45 +413,333 @@ static bool parse_keyword(const char *&p, const char *end, StringRef keyword)
   return true;
 }
 
-void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
-                      GlobalVertices &r_global_vertices)
+/* Whether the buffer position is right after a newline that is not a line continuation. */
+static bool is_after_line_end(const char *buffer, const size_t pos)
 {
-  if (!obj_file_) {
-    return;
+  return pos > 0 && buffer[pos - 1] == '\n' && (pos < 2 || buffer[pos - 2] != '\\');
+}
+
+/**
+ * Parse the lines of a chunk. Only the elements that do not depend on any parser state are
+ * parsed here; everything else is kept as-is, to be parsed in #OBJParser::parse_state_line
+ * while stitching the chunks together.
+ */
+static void parse_chunk(StringRef chunk_str, ParsedChunk &r_chunk)
+{
+  r_chunk.clear();
+  while (!chunk_str.is_empty()) {
+    StringRef line = read_next_line(chunk_str);
+    const char *p = line.begin(), *end = line.end();
+    p = drop_whitespace(p, end);
+    ++r_chunk.line_count;
+    if (p == end) {
+      continue;
+    }
+    /* Most common things that start with 'v': vertices, normals, UVs. */
+    if (*p == 'v') {
+      if (parse_keyword(p, end, "v")) {
+        chunk_add_vertex(p, end, r_chunk);
+      }
+      else if (parse_keyword(p, end, "vn")) {
+        chunk_add_vertex_normal(p, end, r_chunk);
+      }
+      else if (parse_keyword(p, end, "vt")) {
+        chunk_add_uv_vertex(p, end, r_chunk);
+      }
+    }
+    /* Faces. */
+    else if (parse_keyword(p, end, "f")) {
+      chunk_add_face(p, end, r_chunk);
+    }
+    /* Comments, except for the MRGB vertex color extension. */
+    else if (*p == '#' && !StringRef(p, end).startswith("#MRGB")) {
+      /* Nothing to do. */
+    }
+    else {
+      r_chunk.add_line(p, end);
+    }
   }
+}
 
-  /* Use the filename as the default name given to the initial object. */
-  char ob_name[FILE_MAXFILE];
-  BLI_strncpy(ob_name, BLI_path_basename(import_params_.filepath), FILE_MAXFILE);
-  BLI_path_extension_replace(ob_name, FILE_MAXFILE, "");
+void OBJParser::parse_state_line(const char *p,
+                                 const char *end,
+                                 ParserState &state,
+                                 Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                                 GlobalVertices &r_global_vertices)
+{
+  /* Edges. */
+  if (parse_keyword(p, end, "l")) {
+    geom_add_edge(state.curr_geom, p, end, state.offsets, r_global_vertices);
+  }
+  /* Objects. */
+  else if (parse_keyword(p, end, "o")) {
+    state.shaded_smooth = false;
+    state.group_name = "";
+    state.material_name = "";
+    state.curr_geom = create_geometry(state.curr_geom,
+                                      GEOM_MESH,
+                                      StringRef(p, end).trim(),
+                                      r_global_vertices,
+                                      r_all_geometries,
+                                      state.offsets);
+  }
+  /* Groups. */
+  else if (parse_keyword(p, end, "g")) {
+    geom_update_group(StringRef(p, end).trim(), state.group_name);
+    int new_index = state.curr_geom->group_indices_.size();
+    state.group_index = state.curr_geom->group_indices_.lookup_or_add(state.group_name,
+                                                                      new_index);
+    if (new_index == state.group_index) {
+      state.curr_geom->group_order_.append(state.group_name);
+    }
+  }
+  /* Smoothing groups. */
+  else if (parse_keyword(p, end, "s")) {
+    geom_update_smooth_group(p, end, state.shaded_smooth);
+  }
+  /* Materials and their libraries. */
+  else if (parse_keyword(p, end, "usemtl")) {
+    state.material_name = StringRef(p, end).trim();
+    int new_mat_index = state.curr_geom->material_indices_.size();
+    state.material_index = state.curr_geom->material_indices_.lookup_or_add(state.material_name,
+                                                                            new_mat_index);
+    if (new_mat_index == state.material_index) {
+      state.curr_geom->material_order_.append(state.material_name);
+    }
+  }
+  else if (parse_keyword(p, end, "mtllib")) {
+    add_mtl_library(StringRef(p, end).trim());
+  }
+  else if (parse_keyword(p, end, "#MRGB")) {
+    geom_add_mrgb_colors(state.curr_geom, p, end, r_global_vertices);
+  }
+  /* Comments. */
+  else if (*p == '#') {
+    /* Nothing to do. */
+  }
+  /* Curve related things. */
+  else if (parse_keyword(p, end, "cstype")) {
+    state.curr_geom = geom_set_curve_type(state.curr_geom,
+                                          p,
+                                          end,
+                                          r_global_vertices,
+                                          state.group_name,
+                                          state.offsets,
+                                          r_all_geometries);
+  }
+  else if (parse_keyword(p, end, "deg")) {
+    geom_set_curve_degree(state.curr_geom, p, end);
+  }
+  else if (parse_keyword(p, end, "curv")) {
+    geom_add_curve_vertex_indices(state.curr_geom, p, end, r_global_vertices);
+  }
+  else if (parse_keyword(p, end, "parm")) {
+    geom_add_curve_parameters(state.curr_geom, p, end);
+  }
+  else if (StringRef(p, end).startswith("end")) {
+    /* End of curve definition, nothing else to do. */
+  }
+  else {
+    std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
+  }
+}
 
-  VertexIndexOffset offsets;
-  Geometry *curr_geom = create_geometry(
-      nullptr, GEOM_MESH, ob_name, r_global_vertices, r_all_geometries, offsets);
+void OBJParser::stitch_chunk(const ParsedChunk &chunk,
+                             ParserState &state,
+                             Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                             GlobalVertices &r_global_vertices)
+{
+  int64_t vertex_pos = 0, color_pos = 0, normal_pos = 0, uv_pos = 0;
+  int64_t face_pos = 0, corner_pos = 0;
+  for (const ChunkRecord &record : chunk.records) {
+    switch (record.type) {
+      case eChunkRecord::Vertices:
+        r_global_vertices.vertices.extend(
+            chunk.vertices.as_span().slice(vertex_pos, record.count));
+        r_global_vertices.vertex_colors.extend(
+            chunk.vertex_colors.as_span().slice(color_pos, record.color_count));
+        state.curr_geom->vertex_count_ += record.count;
+        state.curr_geom->vertex_color_count_ += record.color_count;
+        vertex_pos += record.count;
+        color_pos += record.color_count;
+        break;
+      case eChunkRecord::VertexNormals:
+        r_global_vertices.vertex_normals.extend(
+            chunk.vertex_normals.as_span().slice(normal_pos, record.count));
+        state.curr_geom->has_vertex_normals_ = true;
+        normal_pos += record.count;
+        break;
+      case eChunkRecord::UVVertices:
+        r_global_vertices.uv_vertices.extend(
+            chunk.uv_vertices.as_span().slice(uv_pos, record.count));
+        uv_pos += record.count;
+        break;
+      case eChunkRecord::Faces:
+        for (int i = 0; i < record.count; i++) {
+          const int corner_count = chunk.face_sizes[face_pos];
+          geom_add_polygon(state.curr_geom,
+                           chunk.face_corners.as_span().slice(corner_pos, corner_count),
+                           r_global_vertices,
+                           state.offsets,
+                           state.material_index,
+                           state.group_index,
+                           state.shaded_smooth);
+          face_pos++;
+          corner_pos += corner_count;
+        }
+        break;
+      case eChunkRecord::Line:
+        parse_state_line(
+            record.line.begin(), record.line.end(), state, r_all_geometries, r_global_vertices);
+        break;
+    }
+  }
+  state.line_number += chunk.line_count;
+}
+
+/**
+ * Read-only memory mapping of a whole file, so that it can be parsed in place,
+ * without copying its contents into intermediate buffers.
+ */
+class MappedFile {
+ private:
+  BLI_mmap_file *mmap_file_ = nullptr;
+
+ public:
+  MappedFile(const int file)
+  {
+#ifdef WIN32
+    /* IO errors while reading the mapped memory directly (e.g. on network or removable drives)
+     * can't be handled on Windows, only #BLI_mmap_read is protected against them. Use buffered
+     * reads there instead. */
+    UNUSED_VARS(file);
+#else
+    if (file != -1) {
+      mmap_file_ = BLI_mmap_open(file);
+    }
+#endif
+  }
+  ~MappedFile()
+  {
+    if (mmap_file_) {
+      BLI_mmap_free(mmap_file_);
+    }
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool is_valid() const
+  {
+    return mmap_file_ != nullptr;
+  }
+  StringRef contents() const
+  {
+    return StringRef(static_cast<const char *>(BLI_mmap_get_pointer(mmap_file_)),
+                     int64_t(BLI_mmap_get_length(mmap_file_)));
+  }
+  bool has_io_error() const
+  {
+    return BLI_mmap_any_io_error(mmap_file_);
+  }
+};
+
+void OBJParser::parse_lines(StringRef buffer_str,
+                            ParserState &state,
+                            Vector<ParsedChunk> &parsed_chunks,
+                            Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                            GlobalVertices &r_global_vertices)
+{
+  /* Split the buffer into pieces of roughly the read buffer size, each ending at a line end. */
+  Vector<StringRef, 64> chunk_strs;
+  const char *buffer = buffer_str.data();
+  const size_t buffer_size = buffer_str.size();
+  size_t chunk_start = 0;
+  while (chunk_start < buffer_size) {
+    size_t chunk_end = std::min(chunk_start + read_buffer_size_, buffer_size);
+    while (chunk_end < buffer_size && !is_after_line_end(buffer, chunk_end)) {
+      ++chunk_end;
+    }
+    chunk_strs.append(StringRef(buffer + chunk_start, int64_t(chunk_end - chunk_start)));
+    chunk_start = chunk_end;
+  }
+  if (parsed_chunks.size() < chunk_strs.size()) {
+    parsed_chunks.resize(chunk_strs.size());
+  }
 
-  /* State variables: once set, they remain the same for the remaining
-   * elements in the object. */
-  bool state_shaded_smooth = false;
-  string state_group_name;
-  int state_group_index = -1;
-  string state_material_name;
-  int state_material_index = -1;
+  if (use_threads_) {
+    threading::parallel_for(chunk_strs.index_range(), 1, [&](IndexRange range) {
+      for (const int64_t i : range) {
+        parse_chunk(chunk_strs[i], parsed_chunks[i]);
+      }
+    });
+    for (const int64_t i : chunk_strs.index_range()) {
+      stitch_chunk(parsed_chunks[i], state, r_all_geometries, r_global_vertices);
+    }
+  }
+  else {
+    for (const StringRef chunk_str : chunk_strs) {
+      parse_chunk(chunk_str, parsed_chunks[0]);
+      stitch_chunk(parsed_chunks[0], state, r_all_geometries, r_global_vertices);
+    }
+  }
+}
+
+bool OBJParser::parse_mapped_file(const size_t read_size,
+                                  ParserState &state,
+                                  Vector<ParsedChunk> &parsed_chunks,
+                                  Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                                  GlobalVertices &r_global_vertices)
+{
+  const MappedFile mapped_file(fileno(obj_file_));
+  if (!mapped_file.is_valid()) {
+    return false;
+  }
+
+  /* The tokenizers work directly on the mapped memory. Still go through the file in pieces of
+   * the read size, to limit the memory used for the parsed chunks at any point in time. */
+  const StringRef contents = mapped_file.contents();
+  const char *data = contents.data();
+  const size_t size = contents.size();
+  size_t start = 0;
+  while (start < size) {
+    size_t end = std::min(start + read_size, size);
+    while (end < size && !is_after_line_end(data, end)) {
+      ++end;
+    }
+    parse_lines(StringRef(data + start, int64_t(end - start)),
+                state,
+                parsed_chunks,
+                r_all_geometries,
+                r_global_vertices);
+    start = end;
+  }
+
+  if (mapped_file.has_io_error()) {
+    fprintf(stderr, "Error reading from OBJ file:'%s'.\n", import_params_.filepath);
+  }
+  return true;
+}
 
+void OBJParser::parse_buffered_file(const size_t read_size,
+                                    ParserState &state,
+                                    Vector<ParsedChunk> &parsed_chunks,
+                                    Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                                    GlobalVertices &r_global_vertices)
+{
   /* Read the input file in chunks. We need up to twice the possible chunk size,
    * to possibly store remainder of the previous input line that got broken mid-chunk. */
-  Array<char> buffer(read_buffer_size_ * 2);
+  Array<char> buffer(read_size * 2);
 
   size_t buffer_offset = 0;
-  size_t line_number = 0;
   while (true) {
     /* Read a chunk of input from the file. */
-    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_buffer_size_, obj_file_);
+    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_size, obj_file_);
     if (bytes_read == 0 && buffer_offset == 0) {
       break; /* No more data to read. */
     }
 
     /* Ensure buffer ends in a newline. */
-    if (bytes_read < read_buffer_size_) {
+    if (bytes_read < read_size) {
       if (bytes_read == 0 || buffer[buffer_offset + bytes_read - 1] != '\n') {
         buffer[buffer_offset + bytes_read] = '\n';
         bytes_read++;
@@ -454,123 +765,65 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
       /* Whole line did not fit into our read buffer. Warn and exit. */
       fprintf(stderr,
               "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
-              line_number,
-              read_buffer_size_);
+              state.line_number,
+              read_size);
       break;
     }
     ++last_nl;
 
-    /* Parse the buffer (until last newline) that we have so far,
-     * line by line. */
-    StringRef buffer_str{buffer.data(), (int64_t)last_nl};
-    while (!buffer_str.is_empty()) {
-      StringRef line = read_next_line(buffer_str);
-      const char *p = line.begin(), *end = line.end();
-      p = drop_whitespace(p, end);
-      ++line_number;
-      if (p == end) {
-        continue;
-      }
-      /* Most common things that start with 'v': vertices, normals, UVs. */
-      if (*p == 'v') {
-        if (parse_keyword(p, end, "v")) {
-          geom_add_vertex(curr_geom, p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vn")) {
-          geom_add_vertex_normal(curr_geom, p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vt")) {
-          geom_add_uv_vertex(p, end, r_global_vertices);
-        }
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "f")) {
-        geom_add_polygon(curr_geom,
-                         p,
-                         end,
-                         r_global_vertices,
-                         offsets,
-                         state_material_index,
-                         state_group_index, /* TODO was wrongly material name! */
-                         state_shaded_smooth);
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "l")) {
-        geom_add_edge(curr_geom, p, end, offsets, r_global_vertices);
-      }
-      /* Objects. */
-      else if (parse_keyword(p, end, "o")) {
-        state_shaded_smooth = false;
-        state_group_name = "";
-        state_material_name = "";
-        curr_geom = create_geometry(curr_geom,
-                                    GEOM_MESH,
-                                    StringRef(p, end).trim(),
-                                    r_global_vertices,
-                                    r_all_geometries,
-                                    offsets);
-      }
-      /* Groups. */
-      else if (parse_keyword(p, end, "g")) {
-        geom_update_group(StringRef(p, end).trim(), state_group_name);
-        int new_index = curr_geom->group_indices_.size();
-        state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
-        if (new_index == state_group_index) {
-          curr_geom->group_order_.append(state_group_name);
-        }
-      }
-      /* Smoothing groups. */
-      else if (parse_keyword(p, end, "s")) {
-        geom_update_smooth_group(p, end, state_shaded_smooth);
-      }
-      /* Materials and their libraries. */
-      else if (parse_keyword(p, end, "usemtl")) {
-        state_material_name = StringRef(p, end).trim();
-        int new_mat_index = curr_geom->material_indices_.size();
-        state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
-                                                                          new_mat_index);
-        if (new_mat_index == state_material_index) {
-          curr_geom->material_order_.append(state_material_name);
-        }
-      }
-      else if (parse_keyword(p, end, "mtllib")) {
-        add_mtl_library(StringRef(p, end).trim());
-      }
-      else if (parse_keyword(p, end, "#MRGB")) {
-        geom_add_mrgb_colors(curr_geom, p, end, r_global_vertices);
-      }
-      /* Comments. */
-      else if (*p == '#') {
-        /* Nothing to do. */
-      }
-      /* Curve related things. */
-      else if (parse_keyword(p, end, "cstype")) {
-        curr_geom = geom_set_curve_type(
-            curr_geom, p, end, r_global_vertices, state_group_name, offsets, r_all_geometries);
-      }
-      else if (parse_keyword(p, end, "deg")) {
-        geom_set_curve_degree(curr_geom, p, end);
-      }
-      else if (parse_keyword(p, end, "curv")) {
-        geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
-      }
-      else if (parse_keyword(p, end, "parm")) {
-        geom_add_curve_parameters(curr_geom, p, end);
-      }
-      else if (StringRef(p, end).startswith("end")) {
-        /* End of curve definition, nothing else to do. */
-      }
-      else {
-        std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
-      }
-    }
+    /* Parse the buffer (until last newline) that we have so far. */
+    parse_lines(StringRef(buffer.data(), int64_t(last_nl)),
+                state,
+                parsed_chunks,
+                r_all_geometries,
+                r_global_vertices);
 
     /* We might have a line that was cut in the middle by the previous buffer;
      * copy it over for next chunk reading. */
     size_t left_size = buffer_end - last_nl;
+    if (left_size > read_size) {
+      /* Remainder would not leave space for the next read. */
+      fprintf(stderr,
+              "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
+              state.line_number,
+              read_size);
+      break;
+    }
     memmove(buffer.data(), buffer.data() + last_nl, left_size);
     buffer_offset = left_size;
   }
+}
+
+void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                      GlobalVertices &r_global_vertices)
+{
+  if (!obj_file_) {
+    return;
+  }
+
+  /* Use the filename as the default name given to the initial object. */
+  char ob_name[FILE_MAXFILE];
+  BLI_strncpy(ob_name, BLI_path_basename(import_params_.filepath), FILE_MAXFILE);
+  BLI_path_extension_replace(ob_name, FILE_MAXFILE, "");
+
+  ParserState state;
+  state.curr_geom = create_geometry(
+      nullptr, GEOM_MESH, ob_name, r_global_vertices, r_all_geometries, state.offsets);
+
+  /* When using threads, process enough data for several chunks at once: the chunks get parsed
+   * in parallel, and then stitched together in the order they appear in the file. */
+  const size_t chunks_per_read = use_threads_ ? size_t(BLI_system_thread_count()) * 4 : 1;
+  const size_t read_size = read_buffer_size_ * chunks_per_read;
+  Vector<ParsedChunk> parsed_chunks;
+
+  /* Prefer parsing the memory-mapped file; fall back to buffered reads
+   * when the file can't be mapped. */
+  if (!use_mmap_ ||
+      !parse_mapped_file(read_size, state, parsed_chunks, r_all_geometries, r_global_vertices)) {
+    /* Mapping the file moved the file position to its end. */
+    fseek(obj_file_, 0, SEEK_SET);
+    parse_buffered_file(read_size, state, parsed_chunks, r_all_geometries, r_global_vertices);
+  }
 
   add_default_mtl_library();
 }
@@ -737,16 +990,32 @@ MTLParser::MTLParser(StringRefNull mtl_library, StringRefNull obj_filepath)
 
 void MTLParser::parse_and_store(Map<string, std::unique_ptr<MTLMaterial>> &r_materials)
 {
-  size_t buffer_len;
-  void *buffer = BLI_file_read_text_as_mem(mtl_file_path_, 0, &buffer_len);
-  if (buffer == nullptr) {
+  FILE *mtl_file = BLI_fopen(mtl_file_path_, "rb");
+  if (mtl_file == nullptr) {
     fprintf(stderr, "OBJ import: cannot read from MTL file: '%s'\n", mtl_file_path_);
     return;
   }
 
+  /* Parse the memory-mapped file in place when possible, otherwise read it into memory. */
+  const MappedFile mapped_file(fileno(mtl_file));
+  void *buffer = nullptr;
+  StringRef buffer_str;
+  if (mapped_file.is_valid()) {
+    buffer_str = mapped_file.contents();
+  }
+  else {
+    size_t buffer_len;
+    buffer = BLI_file_read_text_as_mem(mtl_file_path_, 0, &buffer_len);
+    if (buffer == nullptr) {
+      fprintf(stderr, "OBJ import: cannot read from MTL file: '%s'\n", mtl_file_path_);
+      fclose(mtl_file);
+      return;
+    }
+    buffer_str = StringRef((const char *)buffer, (int64_t)buffer_len);
+  }
+
   MTLMaterial *material = nullptr;
 
-  StringRef buffer_str{(const char *)buffer, (int64_t)buffer_len};
   while (!buffer_str.is_empty()) {
     const StringRef line = read_next_line(buffer_str);
     const char *p = line.begin(), *end = line.end();
@@ -799,6 +1068,10 @@ void MTLParser::parse_and_store(Map<string, std::unique_ptr<MTLMaterial>> &r_mat
     }
   }
 
-  MEM_freeN(buffer);
+  if (mapped_file.is_valid() && mapped_file.has_io_error()) {
+    fprintf(stderr, "OBJ import: error reading from MTL file: '%s'\n", mtl_file_path_);
+  }
+  MEM_SAFE_FREE(buffer);
+  fclose(mtl_file);
 }
 }  // namespace blender::io::obj
@@ -13,6 +13,81 @@
 
 namespace blender::io::obj {
 
+/**
+ * Face corner as written in the file: indices are not yet made relative to the
+ * global vertex lists, since that depends on elements that come before the face.
+ */
+struct RawCorner {
+  PolyCorner corner;
+  bool got_uv = false;
+  bool got_normal = false;
+};
+
+enum class eChunkRecord {
+  Vertices,
+  VertexNormals,
+  UVVertices,
+  Faces,
+  /** Any other line, parsed when the chunk gets stitched. */
+  Line,
+};
+
+/**
+ * A run of consecutive elements of the same type within a chunk,
+ * or a single line of other type.
+ */
+struct ChunkRecord {
+  eChunkRecord type;
+  int count;
+  int color_count;
+  StringRef line;
+};
+
+/**
+ * Result of parsing one line-aligned piece of the OBJ file. Vertex positions, normals, UVs and
+ * faces do not depend on any parser state, so chunks can be parsed independently of each other.
+ * The records keep the order of the elements in the file, and are used to merge the chunk into
+ * the global lists afterwards.
+ */
+struct ParsedChunk {
+  Vector<ChunkRecord> records;
+  Vector<float3> vertices;
+  Vector<float3> vertex_colors;
+  Vector<float3> vertex_normals;
+  Vector<float2> uv_vertices;
+  Vector<RawCorner> face_corners;
+  Vector<int> face_sizes;
+  size_t line_count = 0;
+
+  void add_record(const eChunkRecord type, const int color_count = 0)
+  {
+    if (!records.is_empty() && records.last().type == type) {
+      ChunkRecord &run = records.last();
+      run.count++;
+      run.color_count += color_count;
+      return;
+    }
+    records.append({type, 1, color_count, {}});
+  }
+
+  void add_line(const char *p, const char *end)
+  {
+    records.append({eChunkRecord::Line, 1, 0, StringRef(p, end)});
+  }
+
+  void clear()
+  {
+    records.clear();
+    vertices.clear();
+    vertex_colors.clear();
+    vertex_normals.clear();
+    uv_vertices.clear();
+    face_corners.clear();
+    face_sizes.clear();
+    line_count = 0;
+  }
+};
+
 /* NOTE: the OBJ parser implementation is planned to get fairly large changes "soon",
  * so don't read too much into current implementation... */
 class OBJParser {
@@ -21,12 +96,39 @@ class OBJParser {
   FILE *obj_file_;
   Vector<std::string> mtl_libraries_;
   size_t read_buffer_size_;
+  bool use_threads_;
+  bool use_mmap_;
+
+  /**
+   * State variables: once set, they remain the same for the remaining
+   * elements in the object.
+   */
+  struct ParserState {
+    Geometry *curr_geom = nullptr;
+    VertexIndexOffset offsets;
+    bool shaded_smooth = false;
+    std::string group_name;
+    int group_index = -1;
+    std::string material_name;
+    int material_index = -1;
+    size_t line_number = 0;
+  };
 
  public:
   /**
    * Open OBJ file at the path given in import parameters.
+   *
+   * The file is read in pieces of `read_buffer_size` bytes. With `use_threads`, several such
+   * line-aligned pieces are read at once and parsed concurrently, the result is identical to
+   * the single threaded parsing.
+   *
+   * Without `use_mmap`, the file is always read into buffers instead of being parsed
+   * memory-mapped (which is also done when the file can't be mapped).
    */
-  OBJParser(const OBJImportParams &import_params, size_t read_buffer_size);
+  OBJParser(const OBJImportParams &import_params,
+            size_t read_buffer_size,
+            bool use_threads,
+            bool use_mmap);
   ~OBJParser();
 
   /**
@@ -43,6 +145,50 @@ class OBJParser {
  private:
   void add_mtl_library(StringRef path);
   void add_default_mtl_library();
+
+  /**
+   * Parse the file memory-mapped, without copying its contents.
+   * Returns false if the file could not be mapped.
+   */
+  bool parse_mapped_file(size_t read_size,
+                         ParserState &state,
+                         Vector<ParsedChunk> &parsed_chunks,
+                         Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                         GlobalVertices &r_global_vertices);
+  /**
+   * Parse the file by reading it piece by piece into a buffer.
+   */
+  void parse_buffered_file(size_t read_size,
+                           ParserState &state,
+                           Vector<ParsedChunk> &parsed_chunks,
+                           Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                           GlobalVertices &r_global_vertices);
+  /**
+   * Split a buffer of whole lines into chunks, parse them (in parallel when using threads)
+   * and stitch them together.
+   */
+  void parse_lines(StringRef buffer_str,
+                   ParserState &state,
+                   Vector<ParsedChunk> &parsed_chunks,
+                   Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                   GlobalVertices &r_global_vertices);
+  /**
+   * Merge the data of an already parsed chunk into the global vertex lists and geometries,
+   * in the order the elements were written in the file.
+   */
+  void stitch_chunk(const ParsedChunk &chunk,
+                    ParserState &state,
+                    Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                    GlobalVertices &r_global_vertices);
+  /**
+   * Parse a line that changes parser state or depends on it (objects, groups, materials,
+   * curves etc.). Only called serially, in the file order.
+   */
+  void parse_state_line(const char *p,
+                        const char *end,
+                        ParserState &state,
+                        Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                        GlobalVertices &r_global_vertices);
 };
 
 class MTLParser {
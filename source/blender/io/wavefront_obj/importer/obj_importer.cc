@@ -94,7 +94,9 @@ void importer_main(Main *bmain,
                    Scene *scene,
                    ViewLayer *view_layer,
                    const OBJImportParams &import_params,
-                   size_t read_buffer_size)
+                   size_t read_buffer_size,
+                   bool use_threads,
+                   bool use_mmap)
 {
   /* List of Geometry instances to be parsed from OBJ file. */
   Vector<std::unique_ptr<Geometry>> all_geometries;
@@ -104,7 +106,7 @@ void importer_main(Main *bmain,
   Map<std::string, std::unique_ptr<MTLMaterial>> materials;
   Map<std::string, Material *> created_materials;
 
-  OBJParser obj_parser{import_params, read_buffer_size};
+  OBJParser obj_parser{import_params, read_buffer_size, use_threads, use_mmap};
   obj_parser.parse(all_geometries, global_vertices);
 
   for (StringRefNull mtl_library : obj_parser.mtl_libraries()) {
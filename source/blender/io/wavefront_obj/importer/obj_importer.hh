@@ -18,6 +18,8 @@ void importer_main(Main *bmain,
                    Scene *scene,
                    ViewLayer *view_layer,
                    const OBJImportParams &import_params,
-                   size_t read_buffer_size = 64 * 1024);
+                   size_t read_buffer_size = 64 * 1024,
+                   bool use_threads = true,
+                   bool use_mmap = true);
 
 }  // namespace blender::io::obj
@@ -5,6 +5,8 @@
 #include <memory>
 #include <string>
 #include <system_error>
+#include <vector>
+#include <zstd.h>
 
 #include "testing/testing.h"
 #include "tests/blendfile_loading_base_test.h"
@@ -214,6 +216,83 @@ parm u 0.0
   ASSERT_EQ(got_string, expected);
 }
 
+static std::string zstd_decompress(const std::string &compressed)
+{
+  std::string result;
+  ZSTD_DCtx *context = ZSTD_createDCtx();
+  std::vector<char> buffer(ZSTD_DStreamOutSize());
+  ZSTD_inBuffer input = {compressed.data(), compressed.size(), 0};
+  while (input.pos < input.size) {
+    ZSTD_outBuffer output = {buffer.data(), buffer.size(), 0};
+    const size_t ret = ZSTD_decompressStream(context, &output, &input);
+    if (ZSTD_isError(ret)) {
+      ADD_FAILURE() << "zstd: " << ZSTD_getErrorName(ret);
+      break;
+    }
+    result.append(buffer.data(), output.pos);
+  }
+  ZSTD_freeDCtx(context);
+  return result;
+}
+
+/**
+ * Many small blocks of varying size, and one larger than the compression output buffer, so that
+ * the I/O thread falls behind and the queue holds several blocks at once.
+ */
+static void fill_test_blocks(FormatHandler<eFileType::OBJ, 64> &fh)
+{
+  for (int i = 0; i < 20000; i++) {
+    fh.write<eOBJSyntaxElement::vertex_coords>(i * 0.5f, i * -0.25f, float(i % 7));
+    if (i % 1000 == 0) {
+      fh.write<eOBJSyntaxElement::object_name>(std::to_string(i) + std::string(i % 3000, 'x'));
+    }
+    if (i == 10000) {
+      fh.write<eOBJSyntaxElement::string>(std::string(ZSTD_CStreamOutSize() * 3, 'y') + "\n");
+    }
+  }
+}
+
+TEST(obj_exporter_writer, async_writer_matches_sync_writer)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string tempdir = BKE_tempdir_base();
+  const std::string sync_path = tempdir + "obj_export_sync.obj";
+  FormatHandler<eFileType::OBJ, 64> sync_fh;
+  fill_test_blocks(sync_fh);
+  ASSERT_GT(sync_fh.get_block_count(), 1000);
+  FILE *sync_file = BLI_fopen(sync_path.c_str(), "wb");
+  ASSERT_NE(sync_file, nullptr);
+  sync_fh.write_to_file(sync_file);
+  fclose(sync_file);
+  const std::string expected = read_temp_file_in_string(sync_path);
+  BLI_delete(sync_path.c_str(), false, false);
+
+  for (const bool compress : {false, true}) {
+    SCOPED_TRACE(compress ? "compressed" : "uncompressed");
+    const std::string async_path = tempdir + (compress ? "obj_export_async.obj.zst" :
+                                                         "obj_export_async.obj");
+    FILE *async_file = BLI_fopen(async_path.c_str(), "wb");
+    ASSERT_NE(async_file, nullptr);
+    {
+      AsyncFileWriter writer(async_file, compress);
+      FormatHandler<eFileType::OBJ, 64> async_fh;
+      fill_test_blocks(async_fh);
+      async_fh.write_to_file(writer);
+      EXPECT_TRUE(writer.finish());
+    }
+    fclose(async_file);
+    const std::string written = read_temp_file_in_string(async_path);
+    BLI_delete(async_path.c_str(), false, false);
+    if (compress) {
+      EXPECT_LT(written.size(), expected.size());
+      EXPECT_TRUE(zstd_decompress(written) == expected);
+    }
+    else {
+      EXPECT_TRUE(written == expected);
+    }
+  }
+}
+
 /* Return true if string #a and string #b are equal after their first newline. */
 static bool strings_equal_after_first_lines(const std::string &a, const std::string &b)
 {
@@ -527,4 +606,38 @@ TEST_F(obj_exporter_regression_test, all_objects_mat_groups)
                                _export.params);
 }
 
+/* A compressed export decompresses to the same text as an uncompressed one, with the materials
+ * written uncompressed next to it. */
+TEST_F(obj_exporter_regression_test, all_objects_compressed)
+{
+  if (!load_file_and_depsgraph(all_objects_file)) {
+    return;
+  }
+  BKE_tempdir_init(nullptr);
+  const std::string tempdir = std::string(BKE_tempdir_base());
+  const std::string mtl_path = tempdir + "obj_export_compressed.mtl";
+  OBJExportParamsDefault _export;
+  _export.params.blen_filepath = bfile->main->filepath;
+
+  const std::string obj_path = tempdir + "obj_export_compressed.obj";
+  strncpy(_export.params.filepath, obj_path.c_str(), FILE_MAX - 1);
+  export_frame(depsgraph, _export.params, obj_path.c_str());
+  const std::string expected = read_temp_file_in_string(obj_path);
+  const std::string expected_mtl = read_temp_file_in_string(mtl_path);
+  BLI_delete(obj_path.c_str(), false, false);
+  BLI_delete(mtl_path.c_str(), false, false);
+  ASSERT_FALSE(expected.empty());
+
+  const std::string zst_path = obj_path + ".zst";
+  strncpy(_export.params.filepath, zst_path.c_str(), FILE_MAX - 1);
+  _export.params.compress_zstd = true;
+  export_frame(depsgraph, _export.params, zst_path.c_str());
+  const std::string compressed = read_temp_file_in_string(zst_path);
+  EXPECT_LT(compressed.size(), expected.size());
+  EXPECT_TRUE(zstd_decompress(compressed) == expected);
+  EXPECT_EQ(read_temp_file_in_string(mtl_path), expected_mtl);
+  BLI_delete(zst_path.c_str(), false, false);
+  BLI_delete(mtl_path.c_str(), false, false);
+}
+
 }  // namespace blender::io::obj
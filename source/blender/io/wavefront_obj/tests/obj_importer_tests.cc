@@ -48,6 +48,27 @@ class obj_importer_test : public BlendfileLoadingBaseTest {
                         const Expectation *expect,
                         size_t expect_count,
                         int expect_mat_count)
+  {
+    /* Single and multi-threaded parsing, of the memory-mapped file or of buffered reads, should
+     * give identical results. */
+    for (const bool use_mmap : {true, false}) {
+      SCOPED_TRACE(use_mmap ? "memory-mapped file" : "buffered reads");
+      for (const bool use_threads : {false, true}) {
+        SCOPED_TRACE(use_threads ? "multi-threaded parsing" : "single-threaded parsing");
+        import_and_check_mode(
+            path, expect, expect_count, expect_mat_count, use_threads, use_mmap);
+        depsgraph_free();
+        blendfile_free();
+      }
+    }
+  }
+
+  void import_and_check_mode(const char *path,
+                             const Expectation *expect,
+                             size_t expect_count,
+                             int expect_mat_count,
+                             bool use_threads,
+                             bool use_mmap)
   {
     if (!blendfile_load("io_tests/blend_geometry/all_quads.blend")) {
       ADD_FAILURE();
@@ -64,7 +85,13 @@ class obj_importer_test : public BlendfileLoadingBaseTest {
     std::string obj_path = blender::tests::flags_test_asset_dir() + "/io_tests/obj/" + path;
     strncpy(params.filepath, obj_path.c_str(), FILE_MAX - 1);
     const size_t read_buffer_size = 650;
-    importer_main(bfile->main, bfile->curscene, bfile->cur_view_layer, params, read_buffer_size);
+    importer_main(bfile->main,
+                  bfile->curscene,
+                  bfile->cur_view_layer,
+                  params,
+                  read_buffer_size,
+                  use_threads,
+                  use_mmap);
 
     depsgraph_create(DAG_EVAL_VIEWPORT);
 
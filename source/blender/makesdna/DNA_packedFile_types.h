@@ -14,7 +14,13 @@ extern "C" {
 typedef struct PackedFile {
   int size;
   int seek;
+  /** Can be NULL when the data was not read from the blend file yet, see #deferred. */
   void *data;
+  /**
+   * Runtime: location of the data in the blend file, while it is not read
+   * (#BlendDeferredData, see #BKE_packedfile_data_ensure).
+   */
+  struct BlendDeferredData *deferred;
 } PackedFile;
 
 #ifdef __cplusplus
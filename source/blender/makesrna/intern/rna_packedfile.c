@@ -31,7 +31,13 @@ const EnumPropertyItem rna_enum_unpack_method_items[] = {
 static void rna_PackedImage_data_get(PointerRNA *ptr, char *value)
 {
   PackedFile *pf = (PackedFile *)ptr->data;
-  memcpy(value, pf->data, (size_t)pf->size);
+  const void *data = BKE_packedfile_data_ensure(pf, NULL);
+  if (data) {
+    memcpy(value, data, (size_t)pf->size);
+  }
+  else {
+    memset(value, 0, (size_t)pf->size);
+  }
   value[pf->size] = '\0';
 }
 
@@ -259,6 +259,41 @@ static void rna_SequenceEditor_update_cache(Main *UNUSED(bmain),
   SEQ_cache_cleanup(scene);
 }
 
+static int rna_SequenceEditor_cache_hits_get(PointerRNA *ptr)
+{
+  SeqCacheStatistics stats;
+  SEQ_cache_statistics_get((Scene *)ptr->owner_id, &stats);
+  return (int)MIN2(stats.hits, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_disk_hits_get(PointerRNA *ptr)
+{
+  SeqCacheStatistics stats;
+  SEQ_cache_statistics_get((Scene *)ptr->owner_id, &stats);
+  return (int)MIN2(stats.disk_hits, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_misses_get(PointerRNA *ptr)
+{
+  SeqCacheStatistics stats;
+  SEQ_cache_statistics_get((Scene *)ptr->owner_id, &stats);
+  return (int)MIN2(stats.misses, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_frames_recycled_get(PointerRNA *ptr)
+{
+  SeqCacheStatistics stats;
+  SEQ_cache_statistics_get((Scene *)ptr->owner_id, &stats);
+  return (int)MIN2(stats.frames_recycled, INT_MAX);
+}
+
+static float rna_SequenceEditor_cache_time_saved_get(PointerRNA *ptr)
+{
+  SeqCacheStatistics stats;
+  SEQ_cache_statistics_get((Scene *)ptr->owner_id, &stats);
+  return (float)stats.time_saved;
+}
+
 /* internal use */
 static int rna_SequenceEditor_elements_length(PointerRNA *ptr)
 {
@@ -2314,6 +2349,43 @@ static void rna_def_editor(BlenderRNA *brna)
       "Render frames ahead of current frame in the background for faster playback");
   RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, NULL);
 
+  /* cache statistics */
+
+  prop = RNA_def_property(srna, "cache_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_hits_get", NULL, NULL);
+  RNA_def_property_ui_text(prop, "Cache Hits", "Number of images found in the memory cache");
+
+  prop = RNA_def_property(srna, "cache_disk_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_disk_hits_get", NULL, NULL);
+  RNA_def_property_ui_text(
+      prop, "Disk Cache Hits", "Number of images not in memory that were read from disk cache");
+
+  prop = RNA_def_property(srna, "cache_misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_misses_get", NULL, NULL);
+  RNA_def_property_ui_text(prop,
+                           "Cache Misses",
+                           "Number of images that were not cached and had to be rendered. Counted "
+                           "per stored image: a frame counts once for each of its raw, "
+                           "preprocessed, composite and final images that are rendered");
+
+  prop = RNA_def_property(srna, "cache_frames_recycled", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_frames_recycled_get", NULL, NULL);
+  RNA_def_property_ui_text(prop,
+                           "Recycled Cache Frames",
+                           "Number of frames freed from the memory cache to make room for new "
+                           "images");
+
+  prop = RNA_def_property(srna, "cache_time_saved", PROP_FLOAT, PROP_TIME_ABSOLUTE);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_float_funcs(prop, "rna_SequenceEditor_cache_time_saved_get", NULL, NULL);
+  RNA_def_property_ui_text(prop,
+                           "Cache Time Saved",
+                           "Render time of the images found in the memory cache, in seconds");
+
   /* functions */
 
   func = RNA_def_function(srna, "display_stack", "rna_SequenceEditor_display_stack");
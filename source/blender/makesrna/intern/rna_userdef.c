@@ -180,6 +180,8 @@ static const EnumPropertyItem rna_enum_userdef_viewport_aa_items[] = {
 #  include "GPU_select.h"
 #  include "GPU_texture.h"
 
+#  include "IMB_colormanagement.h"
+
 #  include "BLF_api.h"
 
 #  include "BLI_path_util.h"
@@ -375,6 +377,12 @@ static void rna_userdef_anisotropic_update(Main *bmain, Scene *scene, PointerRNA
   rna_userdef_update(bmain, scene, ptr);
 }
 
+static void rna_userdef_display_lut_update(Main *bmain, Scene *scene, PointerRNA *ptr)
+{
+  IMB_colormanagement_display_lut_set_enabled((U.gpu_flag & USER_GPU_FLAG_DISPLAY_LUT) != 0);
+  rna_userdef_update(bmain, scene, ptr);
+}
+
 static void rna_userdef_gl_texture_limit_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
   BKE_image_free_all_gputextures(bmain);
@@ -5070,6 +5078,14 @@ static void rna_def_userdef_edit(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Undo Memory Size", "Maximum memory usage in megabytes (0 means unlimited)");
 
+  prop = RNA_def_property(srna, "undo_uncompressed_steps", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "undo_uncompressed_steps");
+  RNA_def_property_range(prop, 0, 256);
+  RNA_def_property_ui_text(prop,
+                           "Uncompressed Undo Steps",
+                           "Number of recent global undo steps kept uncompressed in memory, older "
+                           "steps are compressed in the background (0 disables compression)");
+
   prop = RNA_def_property(srna, "use_global_undo", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "uiflag", USER_GLOBALUNDO);
   RNA_def_property_ui_text(
@@ -5608,6 +5624,15 @@ static void rna_def_userdef_system(BlenderRNA *brna)
       prop, "Image Display Method", "Method used for displaying images on the screen");
   RNA_def_property_update(prop, 0, "rna_userdef_update");
 
+  prop = RNA_def_property(srna, "use_image_display_lut", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "gpu_flag", USER_GPU_FLAG_DISPLAY_LUT);
+  RNA_def_property_ui_text(prop,
+                           "Approximate Display Transform",
+                           "Display byte images on the CPU through a baked look-up table of the "
+                           "display transform, faster but colors can differ slightly from the "
+                           "exact transform");
+  RNA_def_property_update(prop, 0, "rna_userdef_display_lut_update");
+
   prop = RNA_def_property(srna, "anisotropic_filter", PROP_ENUM, PROP_NONE);
   RNA_def_property_enum_sdna(prop, NULL, "anisotropic_filter");
   RNA_def_property_enum_items(prop, anisotropic_items);
@@ -6295,6 +6320,20 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Animation Player Preset", "Preset configs for external animation players");
 
+  prop = RNA_def_property(srna, "use_save_background", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", USER_SAVE_BACKGROUND);
+  RNA_def_property_ui_text(prop,
+                           "Save in Background",
+                           "Write blend files and auto-saves to disk in the background, "
+                           "after storing their content in memory");
+
+  prop = RNA_def_property(srna, "use_load_packed_on_demand", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", USER_LOAD_PACKED_ON_DEMAND);
+  RNA_def_property_ui_text(prop,
+                           "Load Packed Files on Demand",
+                           "Leave large packed files in uncompressed blend files when opening "
+                           "them, reading them only once they are used");
+
   /* Autosave. */
 
   prop = RNA_def_property(srna, "save_version", PROP_INT, PROP_NONE);
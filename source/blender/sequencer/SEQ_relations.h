@@ -18,6 +18,21 @@ struct ReportList;
 struct Scene;
 struct Sequence;
 
+typedef struct SeqCacheStatistics {
+  /**
+   * Images found in memory, images read from disk cache instead, and images which were not
+   * cached and had to be rendered. Counted per image, not per frame: a frame has raw,
+   * preprocessed, composite and final images, depending on the stored types.
+   */
+  uint64_t hits;
+  uint64_t disk_hits;
+  uint64_t misses;
+  /** Frames freed to make room for new images. */
+  uint64_t frames_recycled;
+  /** Render time in seconds of the images found in memory. */
+  double time_saved;
+} SeqCacheStatistics;
+
 /**
  * Check if one sequence is input to the other.
  */
@@ -57,6 +72,10 @@ void SEQ_relations_check_uuids_unique_and_report(const struct Scene *scene);
 void SEQ_relations_session_uuid_generate(struct Sequence *sequence);
 
 void SEQ_cache_cleanup(struct Scene *scene);
+/**
+ * Get statistics of the cache of \a scene since it was created, zeroed if it has no cache.
+ */
+void SEQ_cache_statistics_get(struct Scene *scene, SeqCacheStatistics *r_stats);
 void SEQ_cache_iterate(
     struct Scene *scene,
     void *userdata,
@@ -21,6 +21,7 @@ struct rctf;
 
 typedef enum eSeqTaskId {
   SEQ_TASK_MAIN_RENDER,
+  /* Prefetch workers use consecutive IDs, starting with this one. */
   SEQ_TASK_PREFETCH_RENDER,
 } eSeqTaskId;
 
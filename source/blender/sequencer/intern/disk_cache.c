@@ -9,6 +9,8 @@
 #include <stddef.h>
 #include <time.h>
 
+#include <zstd.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
@@ -26,8 +28,11 @@
 #include "BLI_fileops_types.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_mmap.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_main.h"
@@ -52,8 +57,14 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * Zlib compression with user definable level can be used to compress image data(per image)
- * Images are written in order in which they are rendered.
+ * Zstd compression with user definable level can be used to compress image data(per image).
+ * Image data is split into blocks of DCACHE_BLOCK_SIZE bytes which are compressed in parallel as
+ * independent frames, preceded by a table of their compressed sizes, so that they can be
+ * decompressed in parallel as well.
+ * Images are written in order in which they are rendered, by a separate I/O thread: rendering
+ * only queues them. When the queue is full, images are not written at all rather than making
+ * rendering wait for the disk. Queued images are still written when the cache is freed.
+ * Files are memory-mapped for reading when possible.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
@@ -65,11 +76,21 @@
  * `<cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf`. */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 2
+#define DCACHE_CURRENT_VERSION 3
+#define DCACHE_BLOCK_SIZE (1 << 20)
+#define DCACHE_BLOCKS_NUM(size_raw) (int)(((size_raw) + DCACHE_BLOCK_SIZE - 1) / DCACHE_BLOCK_SIZE)
+/* Memory used by the images waiting to be written, in bytes. */
+#define DCACHE_WRITE_QUEUE_SIZE_MAX ((size_t)512 << 20)
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in IMB intern. */
 
+enum {
+  DCACHE_COMPRESSION_NONE = 0,
+  DCACHE_COMPRESSION_ZSTD_BLOCKS = 1,
+};
+
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char compression;
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -87,8 +108,42 @@ typedef struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+
+  /** #DiskCacheWriteTask of images waiting for the I/O thread. */
+  ListBase write_queue;
+  /** Memory used by the images of #write_queue, see #DCACHE_WRITE_QUEUE_SIZE_MAX. */
+  size_t write_queue_size;
+  /** Task the I/O thread is working on, it is not in #write_queue anymore. */
+  struct DiskCacheWriteTask *write_task_active;
+  /** Protects the queue, never held while accessing files. */
+  ThreadMutex write_queue_mutex;
+  ThreadCondition write_queue_cond;
+  ListBase io_thread;
+  bool io_thread_running;
+  bool io_thread_stop;
 } SeqDiskCache;
 
+typedef struct DiskCacheWriteTask {
+  struct DiskCacheWriteTask *next, *prev;
+  char path[FILE_MAX];
+  uint64_t frameno;
+  int cache_type;
+  ImBuf *ibuf;
+  size_t ibuf_size;
+  /** Image was invalidated while the I/O thread was compressing it, don't write it. */
+  bool is_cancelled;
+} DiskCacheWriteTask;
+
+typedef struct DiskCacheBlocks {
+  const char *data_raw;
+  size_t size_raw;
+  int level;
+  int blocks_num;
+  /** Compressed blocks, each one is an independent zstd frame. */
+  void **blocks;
+  uint64_t *blocks_size;
+} DiskCacheBlocks;
+
 typedef struct DiskCacheFile {
   struct DiskCacheFile *next, *prev;
   char path[FILE_MAX];
@@ -401,6 +456,65 @@ static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
   }
 }
 
+static bool seq_disk_cache_write_task_is_invalid(DiskCacheWriteTask *task,
+                                                 const char *cache_dir,
+                                                 Sequence *seq,
+                                                 int invalidate_types,
+                                                 int range_start,
+                                                 int range_end)
+{
+  if ((task->cache_type & invalidate_types) == 0) {
+    return false;
+  }
+
+  char dir[FILE_MAXDIR];
+  BLI_split_dir_part(task->path, dir, sizeof(dir));
+  if (!STREQ(cache_dir, dir)) {
+    return false;
+  }
+
+  /* Match #seq_disk_cache_delete_invalid_files, which deletes whole files. */
+  const int start_frame = (int)task->frameno / DCACHE_IMAGES_PER_FILE * DCACHE_IMAGES_PER_FILE;
+  int timeline_frame_start = seq_cache_frame_index_to_timeline_frame(seq, start_frame);
+  return timeline_frame_start > range_start && timeline_frame_start <= range_end;
+}
+
+static void seq_disk_cache_write_task_free(DiskCacheWriteTask *task)
+{
+  IMB_freeImBuf(task->ibuf);
+  MEM_freeN(task);
+}
+
+/* Drop queued images which would be deleted from disk if they were already written. */
+static void seq_disk_cache_cancel_invalid_writes(SeqDiskCache *disk_cache,
+                                                 Scene *scene,
+                                                 Sequence *seq,
+                                                 int invalidate_types,
+                                                 int range_start,
+                                                 int range_end)
+{
+  char cache_dir[FILE_MAX];
+  seq_disk_cache_get_dir(disk_cache, scene, seq, cache_dir, sizeof(cache_dir));
+  BLI_path_slash_ensure(cache_dir);
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  LISTBASE_FOREACH_MUTABLE (DiskCacheWriteTask *, task, &disk_cache->write_queue) {
+    if (seq_disk_cache_write_task_is_invalid(
+            task, cache_dir, seq, invalidate_types, range_start, range_end)) {
+      BLI_remlink(&disk_cache->write_queue, task);
+      disk_cache->write_queue_size -= task->ibuf_size;
+      seq_disk_cache_write_task_free(task);
+    }
+  }
+
+  DiskCacheWriteTask *task = disk_cache->write_task_active;
+  if (task != NULL && seq_disk_cache_write_task_is_invalid(
+                          task, cache_dir, seq, invalidate_types, range_start, range_end)) {
+    task->is_cancelled = true;
+  }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+}
+
 void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
                                Scene *scene,
                                Sequence *seq,
@@ -415,55 +529,241 @@ void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
   start = SEQ_time_left_handle_frame_get(scene, seq_changed) - DCACHE_IMAGES_PER_FILE;
   end = SEQ_time_right_handle_frame_get(scene, seq_changed);
 
+  seq_disk_cache_cancel_invalid_writes(disk_cache, scene, seq, invalidate_types, start, end);
   seq_disk_cache_delete_invalid_files(disk_cache, scene, seq, invalidate_types, start, end);
 
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
+static size_t seq_disk_cache_imbuf_size_raw(ImBuf *ibuf)
+{
+  if (ibuf->rect) {
+    return (size_t)ibuf->x * ibuf->y * ibuf->channels;
+  }
+  return (size_t)ibuf->x * ibuf->y * ibuf->channels * 4;
+}
+
+static void seq_disk_cache_compress_block(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DiskCacheBlocks *data = (DiskCacheBlocks *)userdata;
+  const size_t offset = (size_t)i * DCACHE_BLOCK_SIZE;
+  const size_t size = min_zz(DCACHE_BLOCK_SIZE, data->size_raw - offset);
+  const size_t size_bound = ZSTD_compressBound(size);
+
+  data->blocks[i] = MEM_mallocN(size_bound, __func__);
+  const size_t size_compressed = ZSTD_compress(
+      data->blocks[i], size_bound, data->data_raw + offset, size, data->level);
+  data->blocks_size[i] = ZSTD_isError(size_compressed) ? 0 : size_compressed;
+}
+
+/* Compress image data in parallel, before the file is locked for writing. */
+static void seq_disk_cache_compress(ImBuf *ibuf, int level, DiskCacheBlocks *r_blocks)
+{
+  memset(r_blocks, 0, sizeof(*r_blocks));
+  if (level <= 0) {
+    return;
+  }
+
+  r_blocks->data_raw = (ibuf->rect != NULL) ? (const char *)ibuf->rect :
+                                              (const char *)ibuf->rect_float;
+  r_blocks->size_raw = seq_disk_cache_imbuf_size_raw(ibuf);
+  r_blocks->level = level;
+  r_blocks->blocks_num = DCACHE_BLOCKS_NUM(r_blocks->size_raw);
+  r_blocks->blocks = MEM_calloc_arrayN(r_blocks->blocks_num, sizeof(void *), __func__);
+  r_blocks->blocks_size = MEM_calloc_arrayN(r_blocks->blocks_num, sizeof(uint64_t), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0, r_blocks->blocks_num, r_blocks, seq_disk_cache_compress_block, &settings);
+}
+
+static void seq_disk_cache_blocks_free(DiskCacheBlocks *blocks)
+{
+  for (int i = 0; i < blocks->blocks_num; i++) {
+    MEM_SAFE_FREE(blocks->blocks[i]);
+  }
+  MEM_SAFE_FREE(blocks->blocks);
+  MEM_SAFE_FREE(blocks->blocks_size);
+}
+
 static size_t deflate_imbuf_to_file(ImBuf *ibuf,
                                     FILE *file,
-                                    int level,
+                                    DiskCacheBlocks *blocks,
                                     DiskCacheHeaderEntry *header_entry)
 {
   void *data = (ibuf->rect != NULL) ? (void *)ibuf->rect : (void *)ibuf->rect_float;
 
-  /* Apply compression if wanted, otherwise just write directly to the file. */
-  if (level > 0) {
-    return BLI_file_zstd_from_mem_at_pos(
-        data, header_entry->size_raw, file, header_entry->offset, level);
+  BLI_fseek(file, header_entry->offset, SEEK_SET);
+
+  /* Write compressed blocks if wanted, otherwise just write directly to the file. */
+  if (blocks->blocks_num == 0) {
+    header_entry->compression = DCACHE_COMPRESSION_NONE;
+    return fwrite(data, 1, header_entry->size_raw, file);
+  }
+
+  header_entry->compression = DCACHE_COMPRESSION_ZSTD_BLOCKS;
+  size_t size_table = sizeof(uint64_t) * blocks->blocks_num;
+  if (fwrite(blocks->blocks_size, 1, size_table, file) != size_table) {
+    return 0;
+  }
+
+  size_t total_written = size_table;
+  for (int i = 0; i < blocks->blocks_num; i++) {
+    if (blocks->blocks_size[i] == 0 ||
+        fwrite(blocks->blocks[i], 1, blocks->blocks_size[i], file) != blocks->blocks_size[i]) {
+      return 0;
+    }
+    total_written += blocks->blocks_size[i];
   }
 
-  fseek(file, header_entry->offset, SEEK_SET);
-  return fwrite(data, 1, header_entry->size_raw, file);
+  return total_written;
 }
 
-static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+typedef struct DiskCacheInflateData {
+  const char *data_compressed;
+  const uint64_t *blocks_offset;
+  const uint64_t *blocks_size;
+  char *data_raw;
+  size_t size_raw;
+  bool is_error;
+} DiskCacheInflateData;
+
+static void seq_disk_cache_decompress_block(void *__restrict userdata,
+                                            const int i,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DiskCacheInflateData *data = (DiskCacheInflateData *)userdata;
+  const size_t offset = (size_t)i * DCACHE_BLOCK_SIZE;
+  const size_t size = min_zz(DCACHE_BLOCK_SIZE, data->size_raw - offset);
+
+  const size_t size_decompressed = ZSTD_decompress(data->data_raw + offset,
+                                                   size,
+                                                   data->data_compressed + data->blocks_offset[i],
+                                                   data->blocks_size[i]);
+  if (ZSTD_isError(size_decompressed) || size_decompressed != size) {
+    data->is_error = true;
+  }
+}
+
+static size_t inflate_file_to_imbuf(ImBuf *ibuf,
+                                    const char *data_compressed,
+                                    const DiskCacheHeaderEntry *header_entry)
 {
   void *data = (ibuf->rect != NULL) ? (void *)ibuf->rect : (void *)ibuf->rect_float;
-  char header[4];
-  fseek(file, header_entry->offset, SEEK_SET);
-  if (fread(header, 1, sizeof(header), file) != sizeof(header)) {
+  const size_t size_raw = header_entry->size_raw;
+
+  /* Check if the data is compressed or raw. */
+  if (header_entry->compression == DCACHE_COMPRESSION_NONE) {
+    if (header_entry->size_compressed != size_raw) {
+      return 0;
+    }
+    memcpy(data, data_compressed, size_raw);
+    return size_raw;
+  }
+
+  if (header_entry->compression != DCACHE_COMPRESSION_ZSTD_BLOCKS) {
     return 0;
   }
 
-  /* Check if the data is compressed or raw. */
-  if (BLI_file_magic_is_zstd(header)) {
-    return BLI_file_unzstd_to_mem_at_pos(data, header_entry->size_raw, file, header_entry->offset);
+  const int blocks_num = DCACHE_BLOCKS_NUM(size_raw);
+  const size_t size_table = sizeof(uint64_t) * blocks_num;
+  if (header_entry->size_compressed < size_table) {
+    return 0;
   }
 
-  fseek(file, header_entry->offset, SEEK_SET);
-  return fread(data, 1, header_entry->size_raw, file);
+  /* Copy the table, mapped memory is not aligned. */
+  uint64_t *blocks_size = MEM_mallocN(size_table, __func__);
+  uint64_t *blocks_offset = MEM_mallocN(size_table, __func__);
+  memcpy(blocks_size, data_compressed, size_table);
+
+  uint64_t offset = size_table;
+  for (int i = 0; i < blocks_num; i++) {
+    if ((ENDIAN_ORDER == B_ENDIAN) && header_entry->encoding == 0) {
+      BLI_endian_switch_uint64(&blocks_size[i]);
+    }
+    blocks_offset[i] = offset;
+    offset += blocks_size[i];
+  }
+
+  DiskCacheInflateData inflate_data = {
+      .data_compressed = data_compressed,
+      .blocks_offset = blocks_offset,
+      .blocks_size = blocks_size,
+      .data_raw = data,
+      .size_raw = size_raw,
+      .is_error = offset > header_entry->size_compressed,
+  };
+
+  if (!inflate_data.is_error) {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(
+        0, blocks_num, &inflate_data, seq_disk_cache_decompress_block, &settings);
+  }
+
+  MEM_freeN(blocks_size);
+  MEM_freeN(blocks_offset);
+
+  return inflate_data.is_error ? 0 : size_raw;
 }
 
-static bool seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
+/**
+ * Get \a size bytes of the file at \a offset. They are read straight from the mapped memory when
+ * \a mmap_file is given, otherwise into \a r_buffer which the caller has to free.
+ */
+static const char *seq_disk_cache_read_range(
+    FILE *file, BLI_mmap_file *mmap_file, uint64_t offset, uint64_t size, void **r_buffer)
 {
-  BLI_fseek(file, 0LL, SEEK_SET);
-  const size_t num_items_read = fread(header, sizeof(*header), 1, file);
-  if (num_items_read < 1) {
+  *r_buffer = NULL;
+
+  if (mmap_file != NULL) {
+    if (offset + size > BLI_mmap_get_length(mmap_file)) {
+      return NULL;
+    }
+#ifdef WIN32
+    /* Only #BLI_mmap_read is protected against IO errors on Windows, reading the mapped memory
+     * directly would crash. */
+    void *buffer = MEM_mallocN(size, __func__);
+    if (!BLI_mmap_read(mmap_file, buffer, offset, size)) {
+      MEM_freeN(buffer);
+      return NULL;
+    }
+    *r_buffer = buffer;
+    return buffer;
+#else
+    return (const char *)BLI_mmap_get_pointer(mmap_file) + offset;
+#endif
+  }
+
+  void *buffer = MEM_mallocN(size, __func__);
+  BLI_fseek(file, offset, SEEK_SET);
+  if (fread(buffer, 1, size, file) != size) {
+    MEM_freeN(buffer);
+    return NULL;
+  }
+
+  *r_buffer = buffer;
+  return buffer;
+}
+
+static bool seq_disk_cache_read_header(FILE *file,
+                                       BLI_mmap_file *mmap_file,
+                                       DiskCacheHeader *header)
+{
+  void *buffer;
+  const char *data = seq_disk_cache_read_range(file, mmap_file, 0, sizeof(*header), &buffer);
+  if (data == NULL) {
     BLI_assert_msg(0, "unable to read disk cache header");
     perror("unable to read disk cache header");
     return false;
   }
+  memcpy(header, data, sizeof(*header));
+  MEM_SAFE_FREE(buffer);
 
   for (int i = 0; i < DCACHE_IMAGES_PER_FILE; i++) {
     if ((ENDIAN_ORDER == B_ENDIAN) && header->entry[i].encoding == 0) {
@@ -483,7 +783,7 @@ static size_t seq_disk_cache_write_header(FILE *file, DiskCacheHeader *header)
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(uint64_t frameno, ImBuf *ibuf, DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -516,16 +816,15 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
   }
 
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->frame_index;
+  header->entry[i].frameno = frameno;
+  header->entry[i].size_raw = seq_disk_cache_imbuf_size_raw(ibuf);
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
   if (ibuf->rect) {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels;
     colorspace_name = IMB_colormanagement_get_rect_colorspace(ibuf);
   }
   else {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels * 4;
     colorspace_name = IMB_colormanagement_get_float_colorspace(ibuf);
   }
   BLI_strncpy(
@@ -545,20 +844,19 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
-bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+/* Called from the I/O thread with `read_write_mutex` locked. */
+static bool seq_disk_cache_write_file_ex(SeqDiskCache *disk_cache,
+                                         DiskCacheWriteTask *task,
+                                         DiskCacheBlocks *blocks)
 {
-  BLI_mutex_lock(&disk_cache->read_write_mutex);
-
-  char filepath[FILE_MAX];
+  char *filepath = task->path;
 
-  seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
   BLI_make_existing_file(filepath);
 
   FILE *file = BLI_fopen(filepath, "rb+");
   if (!file) {
     file = BLI_fopen(filepath, "wb+");
     if (!file) {
-      BLI_mutex_unlock(&disk_cache->read_write_mutex);
       return false;
     }
     seq_disk_cache_add_file_to_list(disk_cache, filepath);
@@ -569,16 +867,15 @@ bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf
   memset(&header, 0, sizeof(header));
   /* #BLI_make_existing_file() above may create an empty file. This is fine, don't attempt reading
    * the header in that case. */
-  if (cache_file->fstat.st_size != 0 && !seq_disk_cache_read_header(file, &header)) {
+  if (cache_file->fstat.st_size != 0 && !seq_disk_cache_read_header(file, NULL, &header)) {
     fclose(file);
     seq_disk_cache_delete_file(disk_cache, cache_file);
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return false;
   }
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
+  int entry_index = seq_disk_cache_add_header_entry(task->frameno, task->ibuf, &header);
 
   size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+      task->ibuf, file, blocks, &header.entry[entry_index]);
 
   if (bytes_written != 0) {
     /* Last step is writing header, as image data can be overwritten,
@@ -588,77 +885,209 @@ bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf
     seq_disk_cache_write_header(file, &header);
     seq_disk_cache_update_file(disk_cache, filepath);
     fclose(file);
-
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return true;
   }
 
-  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  fclose(file);
   return false;
 }
 
-ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
+static void seq_disk_cache_write_task_run(SeqDiskCache *disk_cache, DiskCacheWriteTask *task)
 {
+  DiskCacheBlocks blocks;
+  seq_disk_cache_compress(task->ibuf, seq_disk_cache_compression_level(), &blocks);
+
   BLI_mutex_lock(&disk_cache->read_write_mutex);
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  const bool is_cancelled = task->is_cancelled;
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
 
-  char filepath[FILE_MAX];
-  DiskCacheHeader header;
+  if (!is_cancelled) {
+    seq_disk_cache_write_file_ex(disk_cache, task, &blocks);
+  }
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
 
-  seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
-  BLI_make_existing_file(filepath);
+  seq_disk_cache_blocks_free(&blocks);
+}
 
-  FILE *file = BLI_fopen(filepath, "rb");
-  if (!file) {
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
-    return NULL;
+static void *seq_disk_cache_io_thread(void *disk_cache_v)
+{
+  SeqDiskCache *disk_cache = (SeqDiskCache *)disk_cache_v;
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  while (true) {
+    DiskCacheWriteTask *task = BLI_pophead(&disk_cache->write_queue);
+    if (task == NULL) {
+      /* Stop once all queued images are written. */
+      if (disk_cache->io_thread_stop) {
+        break;
+      }
+      BLI_condition_wait(&disk_cache->write_queue_cond, &disk_cache->write_queue_mutex);
+      continue;
+    }
+
+    disk_cache->write_queue_size -= task->ibuf_size;
+    disk_cache->write_task_active = task;
+    BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+    seq_disk_cache_write_task_run(disk_cache, task);
+    seq_disk_cache_enforce_limits(disk_cache);
+
+    BLI_mutex_lock(&disk_cache->write_queue_mutex);
+    disk_cache->write_task_active = NULL;
+    seq_disk_cache_write_task_free(task);
   }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
 
-  if (!seq_disk_cache_read_header(file, &header)) {
-    fclose(file);
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  return NULL;
+}
+
+bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+{
+  DiskCacheWriteTask *task = MEM_callocN(sizeof(DiskCacheWriteTask), "DiskCacheWriteTask");
+  seq_disk_cache_get_file_path(disk_cache, key, task->path, sizeof(task->path));
+  task->frameno = key->frame_index;
+  task->cache_type = key->type;
+  task->ibuf_size = IMB_get_size_in_memory(ibuf);
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+
+  /* Rather not cache the image than make rendering wait for the disk. An image larger than the
+   * limit is still written when nothing else is queued. */
+  if ((disk_cache->write_queue.first != NULL &&
+       disk_cache->write_queue_size + task->ibuf_size > DCACHE_WRITE_QUEUE_SIZE_MAX) ||
+      disk_cache->io_thread_stop) {
+    BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+    MEM_freeN(task);
+    return false;
+  }
+
+  IMB_refImBuf(ibuf);
+  task->ibuf = ibuf;
+  BLI_addtail(&disk_cache->write_queue, task);
+  disk_cache->write_queue_size += task->ibuf_size;
+
+  if (!disk_cache->io_thread_running) {
+    disk_cache->io_thread_running = true;
+    BLI_threadpool_insert(&disk_cache->io_thread, disk_cache);
+  }
+  BLI_condition_notify_one(&disk_cache->write_queue_cond);
+
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+  return true;
+}
+
+/* Image which is still waiting to be written, or NULL. */
+static ImBuf *seq_disk_cache_write_queue_find(SeqDiskCache *disk_cache,
+                                              const char *filepath,
+                                              uint64_t frameno)
+{
+  ImBuf *ibuf = NULL;
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  DiskCacheWriteTask *task = disk_cache->write_task_active;
+  if (task == NULL || task->frameno != frameno || !STREQ(task->path, filepath)) {
+    for (task = disk_cache->write_queue.first; task; task = task->next) {
+      if (task->frameno == frameno && STREQ(task->path, filepath)) {
+        break;
+      }
+    }
+  }
+  if (task != NULL && !task->is_cancelled) {
+    ibuf = task->ibuf;
+    IMB_refImBuf(ibuf);
+  }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+  return ibuf;
+}
+
+static ImBuf *seq_disk_cache_read_ibuf(FILE *file, BLI_mmap_file *mmap_file, SeqCacheKey *key)
+{
+  DiskCacheHeader header;
+
+  if (!seq_disk_cache_read_header(file, mmap_file, &header)) {
     return NULL;
   }
   int entry_index = seq_disk_cache_get_header_entry(key, &header);
 
   /* Item not found. */
   if (entry_index < 0) {
-    fclose(file);
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return NULL;
   }
 
   ImBuf *ibuf;
+  DiskCacheHeaderEntry *header_entry = &header.entry[entry_index];
   uint64_t size_char = (uint64_t)key->context.rectx * key->context.recty * 4;
   uint64_t size_float = (uint64_t)key->context.rectx * key->context.recty * 16;
   size_t expected_size;
 
-  if (header.entry[entry_index].size_raw == size_char) {
+  if (header_entry->size_raw == size_char) {
     expected_size = size_char;
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rect);
-    IMB_colormanagement_assign_rect_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_rect_colorspace(ibuf, header_entry->colorspace_name);
   }
-  else if (header.entry[entry_index].size_raw == size_float) {
+  else if (header_entry->size_raw == size_float) {
     expected_size = size_float;
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rectfloat);
-    IMB_colormanagement_assign_float_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_float_colorspace(ibuf, header_entry->colorspace_name);
   }
   else {
-    fclose(file);
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return NULL;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
+  void *buffer;
+  const char *data = seq_disk_cache_read_range(
+      file, mmap_file, header_entry->offset, header_entry->size_compressed, &buffer);
+  size_t bytes_read = (data != NULL) ? inflate_file_to_imbuf(ibuf, data, header_entry) : 0;
+  MEM_SAFE_FREE(buffer);
+
+  /* Failed reads of mapped memory are replaced with zeroes. */
+  if (mmap_file != NULL && BLI_mmap_any_io_error(mmap_file)) {
+    bytes_read = 0;
+  }
 
   /* Sanity check. */
   if (bytes_read != expected_size) {
-    fclose(file);
     IMB_freeImBuf(ibuf);
+    return NULL;
+  }
+
+  return ibuf;
+}
+
+ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
+{
+  char filepath[FILE_MAX];
+
+  seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
+
+  ImBuf *ibuf = seq_disk_cache_write_queue_find(disk_cache, filepath, key->frame_index);
+  if (ibuf != NULL) {
+    return ibuf;
+  }
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+
+  BLI_make_existing_file(filepath);
+
+  FILE *file = BLI_fopen(filepath, "rb");
+  if (!file) {
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return NULL;
   }
-  BLI_file_touch(filepath);
-  seq_disk_cache_update_file(disk_cache, filepath);
+
+  /* Decompress straight from the mapped file when possible, instead of copying it first. */
+  BLI_mmap_file *mmap_file = BLI_mmap_open(fileno(file));
+  ibuf = seq_disk_cache_read_ibuf(file, mmap_file, key);
+  if (mmap_file != NULL) {
+    BLI_mmap_free(mmap_file);
+  }
+
+  if (ibuf != NULL) {
+    BLI_file_touch(filepath);
+    seq_disk_cache_update_file(disk_cache, filepath);
+  }
   fclose(file);
 
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
@@ -670,6 +1099,9 @@ SeqDiskCache *seq_disk_cache_create(Main *bmain, Scene *scene)
   SeqDiskCache *disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
   disk_cache->bmain = bmain;
   BLI_mutex_init(&disk_cache->read_write_mutex);
+  BLI_mutex_init(&disk_cache->write_queue_mutex);
+  BLI_condition_init(&disk_cache->write_queue_cond);
+  BLI_threadpool_init(&disk_cache->io_thread, seq_disk_cache_io_thread, 1);
   seq_disk_cache_handle_versioning(disk_cache);
   seq_disk_cache_get_files(disk_cache, seq_disk_cache_base_dir());
   disk_cache->timestamp = scene->ed->disk_cache_timestamp;
@@ -679,7 +1111,17 @@ SeqDiskCache *seq_disk_cache_create(Main *bmain, Scene *scene)
 
 void seq_disk_cache_free(SeqDiskCache *disk_cache)
 {
+  /* Wait until all queued images are written, no more images are queued meanwhile. */
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  disk_cache->io_thread_stop = true;
+  BLI_condition_notify_all(&disk_cache->write_queue_cond);
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+  BLI_threadpool_end(&disk_cache->io_thread);
+  BLI_assert(BLI_listbase_is_empty(&disk_cache->write_queue));
+
   BLI_freelistN(&disk_cache->files);
+  BLI_condition_end(&disk_cache->write_queue_cond);
+  BLI_mutex_end(&disk_cache->write_queue_mutex);
   BLI_mutex_end(&disk_cache->read_write_mutex);
   MEM_freeN(disk_cache);
 }
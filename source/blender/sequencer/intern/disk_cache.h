@@ -26,6 +26,10 @@ struct SeqDiskCache *seq_disk_cache_create(struct Main *bmain, struct Scene *sce
 void seq_disk_cache_free(struct SeqDiskCache *disk_cache);
 bool seq_disk_cache_is_enabled(struct Main *bmain);
 struct ImBuf *seq_disk_cache_read_file(struct SeqDiskCache *disk_cache, struct SeqCacheKey *key);
+/**
+ * Queue \a ibuf to be written by the I/O thread of the disk cache.
+ * \return false when the queue is full and the image won't be cached.
+ */
 bool seq_disk_cache_write_file(struct SeqDiskCache *disk_cache,
                                struct SeqCacheKey *key,
                                struct ImBuf *ibuf);
@@ -17,6 +17,7 @@
 #include "BLI_math.h" /* windows needs for M_PI */
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_simd.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
@@ -31,6 +32,7 @@
 #include "BKE_fcurve.h"
 #include "BKE_lib_id.h"
 #include "BKE_main.h"
+#include "BKE_packedFile.h"
 
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
@@ -115,6 +117,150 @@ static void slice_get_float_buffers(const SeqRenderData *context,
   }
 }
 
+/* Pixel of premultiplied float color, processed at once when SIMD is available. The results are
+ * the same as the per channel code. */
+#ifdef BLI_HAVE_SSE2
+typedef __m128 EffectPixel;
+#else
+typedef struct EffectPixel {
+  float v[4];
+} EffectPixel;
+#endif
+
+BLI_INLINE EffectPixel effect_pixel_load(const float *src)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_loadu_ps(src);
+#else
+  EffectPixel r = {{src[0], src[1], src[2], src[3]}};
+  return r;
+#endif
+}
+
+BLI_INLINE void effect_pixel_store(float *dst, EffectPixel a)
+{
+#ifdef BLI_HAVE_SSE2
+  _mm_storeu_ps(dst, a);
+#else
+  copy_v4_v4(dst, a.v);
+#endif
+}
+
+/* Same as #straight_uchar_to_premul_float. */
+BLI_INLINE EffectPixel effect_pixel_load_byte(const unsigned char *src)
+{
+  const float fac = src[3] * (1.0f / 255.0f) * (1.0f / 255.0f);
+#ifdef BLI_HAVE_SSE2
+  int packed;
+  memcpy(&packed, src, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i src_i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero),
+                                           zero);
+  return _mm_mul_ps(_mm_cvtepi32_ps(src_i), _mm_set_ps(1.0f / 255.0f, fac, fac, fac));
+#else
+  EffectPixel r = {{src[0] * fac, src[1] * fac, src[2] * fac, src[3] * (1.0f / 255.0f)}};
+  return r;
+#endif
+}
+
+/* Same as #premul_float_to_straight_uchar. */
+BLI_INLINE void effect_pixel_store_byte(unsigned char *dst, EffectPixel a)
+{
+#ifdef BLI_HAVE_SSE2
+  const float alpha = _mm_cvtss_f32(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)));
+  if (alpha != 0.0f && alpha != 1.0f) {
+    const float alpha_inv = 1.0f / alpha;
+    a = _mm_mul_ps(a, _mm_set_ps(1.0f, alpha_inv, alpha_inv, alpha_inv));
+  }
+  /* Matches #unit_float_to_uchar_clamp, including values close to the limits. */
+  __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+  const __m128i is_high = _mm_castps_si128(_mm_cmpgt_ps(a, _mm_set1_ps(1.0f - 0.5f / 255.0f)));
+  const __m128i is_low = _mm_castps_si128(_mm_cmple_ps(a, _mm_setzero_ps()));
+  r = _mm_or_si128(_mm_andnot_si128(is_high, r), _mm_and_si128(is_high, _mm_set1_epi32(255)));
+  r = _mm_andnot_si128(is_low, r);
+  r = _mm_packus_epi16(_mm_packs_epi32(r, r), r);
+  const int packed = _mm_cvtsi128_si32(r);
+  memcpy(dst, &packed, sizeof(packed));
+#else
+  premul_float_to_straight_uchar(dst, a.v);
+#endif
+}
+
+/* `fac_a * a + fac_b * b` */
+BLI_INLINE EffectPixel effect_pixel_mix(EffectPixel a, float fac_a, EffectPixel b, float fac_b)
+{
+#ifdef BLI_HAVE_SSE2
+  return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac_a), a), _mm_mul_ps(_mm_set1_ps(fac_b), b));
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] = fac_a * a.v[i] + fac_b * b.v[i];
+  }
+  return a;
+#endif
+}
+
+/* `a + fac * b`, keeping the alpha of `a`. */
+BLI_INLINE EffectPixel effect_pixel_add_color(EffectPixel a, float fac, EffectPixel b)
+{
+#ifdef BLI_HAVE_SSE2
+  const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  const __m128 r = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(fac), b));
+  return _mm_or_ps(_mm_and_ps(alpha_mask, a), _mm_andnot_ps(alpha_mask, r));
+#else
+  for (int i = 0; i < 3; i++) {
+    a.v[i] = a.v[i] + fac * b.v[i];
+  }
+  return a;
+#endif
+}
+
+/* `max(a - fac * b, 0)`, keeping the alpha of `a`. */
+BLI_INLINE EffectPixel effect_pixel_sub_color(EffectPixel a, float fac, EffectPixel b)
+{
+#ifdef BLI_HAVE_SSE2
+  const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  const __m128 r = _mm_max_ps(_mm_sub_ps(a, _mm_mul_ps(_mm_set1_ps(fac), b)), _mm_setzero_ps());
+  return _mm_or_ps(_mm_and_ps(alpha_mask, a), _mm_andnot_ps(alpha_mask, r));
+#else
+  for (int i = 0; i < 3; i++) {
+    a.v[i] = max_ff(a.v[i] - fac * b.v[i], 0.0f);
+  }
+  return a;
+#endif
+}
+
+/* `a + fac * a * (b - 1)` */
+BLI_INLINE EffectPixel effect_pixel_mul(EffectPixel a, float fac, EffectPixel b)
+{
+#ifdef BLI_HAVE_SSE2
+  const __m128 b_minus_one = _mm_sub_ps(b, _mm_set1_ps(1.0f));
+  return _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(fac), a), b_minus_one));
+#else
+  for (int i = 0; i < 4; i++) {
+    a.v[i] = a.v[i] + fac * a.v[i] * (b.v[i] - 1.0f);
+  }
+  return a;
+#endif
+}
+
+#ifdef BLI_HAVE_SSE2
+/* Byte channels of 4 pixels, as 16 bit integers. */
+BLI_INLINE void effect_byte_unpack_sse(const unsigned char *src, __m128i *r_lo, __m128i *r_hi)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i v = _mm_loadu_si128((const __m128i *)src);
+  *r_lo = _mm_unpacklo_epi8(v, zero);
+  *r_hi = _mm_unpackhi_epi8(v, zero);
+}
+
+/* Alpha of pixels unpacked by #effect_byte_unpack_sse, in all their channels. */
+BLI_INLINE __m128i effect_byte_alpha_sse(__m128i v)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)),
+                             _MM_SHUFFLE(3, 3, 3, 3));
+}
+#endif
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -215,11 +361,7 @@ static void do_alphaover_effect_byte(
     for (int j = 0; j < x; j++) {
       /* rt = rt1 over rt2  (alpha from rt1) */
 
-      float tempc[4], rt1[4], rt2[4];
-      straight_uchar_to_premul_float(rt1, cp1);
-      straight_uchar_to_premul_float(rt2, cp2);
-
-      float mfac = 1.0f - fac * rt1[3];
+      float mfac = 1.0f - fac * (cp1[3] * (1.0f / 255.0f));
 
       if (fac <= 0.0f) {
         *((unsigned int *)rt) = *((unsigned int *)cp2);
@@ -228,12 +370,9 @@ static void do_alphaover_effect_byte(
         *((unsigned int *)rt) = *((unsigned int *)cp1);
       }
       else {
-        tempc[0] = fac * rt1[0] + mfac * rt2[0];
-        tempc[1] = fac * rt1[1] + mfac * rt2[1];
-        tempc[2] = fac * rt1[2] + mfac * rt2[2];
-        tempc[3] = fac * rt1[3] + mfac * rt2[3];
-
-        premul_float_to_straight_uchar(rt, tempc);
+        const EffectPixel rt1 = effect_pixel_load_byte(cp1);
+        const EffectPixel rt2 = effect_pixel_load_byte(cp2);
+        effect_pixel_store_byte(rt, effect_pixel_mix(rt1, fac, rt2, mfac));
       }
       cp1 += 4;
       cp2 += 4;
@@ -262,10 +401,8 @@ static void do_alphaover_effect_float(
         memcpy(rt, rt1, sizeof(float[4]));
       }
       else {
-        rt[0] = fac * rt1[0] + mfac * rt2[0];
-        rt[1] = fac * rt1[1] + mfac * rt2[1];
-        rt[2] = fac * rt1[2] + mfac * rt2[2];
-        rt[3] = fac * rt1[3] + mfac * rt2[3];
+        effect_pixel_store(
+            rt, effect_pixel_mix(effect_pixel_load(rt1), fac, effect_pixel_load(rt2), mfac));
       }
       rt1 += 4;
       rt2 += 4;
@@ -320,32 +457,27 @@ static void do_alphaunder_effect_byte(
     for (int j = 0; j < x; j++) {
       /* rt = rt1 under rt2  (alpha from rt2) */
 
-      float tempc[4], rt1[4], rt2[4];
-      straight_uchar_to_premul_float(rt1, cp1);
-      straight_uchar_to_premul_float(rt2, cp2);
+      const float alpha2 = cp2[3] * (1.0f / 255.0f);
 
       /* this complex optimization is because the
        * 'skybuf' can be crossed in
        */
-      if (rt2[3] <= 0.0f && fac >= 1.0f) {
+      if (alpha2 <= 0.0f && fac >= 1.0f) {
         *((unsigned int *)rt) = *((unsigned int *)cp1);
       }
-      else if (rt2[3] >= 1.0f) {
+      else if (alpha2 >= 1.0f) {
         *((unsigned int *)rt) = *((unsigned int *)cp2);
       }
       else {
-        float temp_fac = (fac * (1.0f - rt2[3]));
+        float temp_fac = (fac * (1.0f - alpha2));
 
         if (fac <= 0) {
           *((unsigned int *)rt) = *((unsigned int *)cp2);
         }
         else {
-          tempc[0] = (temp_fac * rt1[0] + rt2[0]);
-          tempc[1] = (temp_fac * rt1[1] + rt2[1]);
-          tempc[2] = (temp_fac * rt1[2] + rt2[2]);
-          tempc[3] = (temp_fac * rt1[3] + rt2[3]);
-
-          premul_float_to_straight_uchar(rt, tempc);
+          const EffectPixel rt1 = effect_pixel_load_byte(cp1);
+          const EffectPixel rt2 = effect_pixel_load_byte(cp2);
+          effect_pixel_store_byte(rt, effect_pixel_mix(rt1, temp_fac, rt2, 1.0f));
         }
       }
       cp1 += 4;
@@ -382,10 +514,8 @@ static void do_alphaunder_effect_float(
           memcpy(rt, rt2, sizeof(float[4]));
         }
         else {
-          rt[0] = temp_fac * rt1[0] + rt2[0];
-          rt[1] = temp_fac * rt1[1] + rt2[1];
-          rt[2] = temp_fac * rt1[2] + rt2[2];
-          rt[3] = temp_fac * rt1[3] + rt2[3];
+          const EffectPixel c1 = effect_pixel_load(rt1);
+          effect_pixel_store(rt, effect_pixel_mix(c1, temp_fac, effect_pixel_load(rt2), 1.0f));
         }
       }
       rt1 += 4;
@@ -440,18 +570,43 @@ static void do_cross_effect_byte(
   int temp_fac = (int)(256.0f * fac);
   int temp_mfac = 256 - temp_fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = (temp_mfac * rt1[0] + temp_fac * rt2[0]) >> 8;
-      rt[1] = (temp_mfac * rt1[1] + temp_fac * rt2[1]) >> 8;
-      rt[2] = (temp_mfac * rt1[2] + temp_fac * rt2[2]) >> 8;
-      rt[3] = (temp_mfac * rt1[3] + temp_fac * rt2[3]) >> 8;
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+  const int pixels_num = x * y;
+  int i = 0;
+
+#ifdef BLI_HAVE_SSE2
+  /* 4 pixels at once, products fit in 16 bits for factors in the 0..1 range. */
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i fac_v = _mm_set1_epi16((short)temp_fac);
+    const __m128i mfac_v = _mm_set1_epi16((short)temp_mfac);
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      __m128i a_lo, a_hi, b_lo, b_hi;
+      effect_byte_unpack_sse(rt1, &a_lo, &a_hi);
+      effect_byte_unpack_sse(rt2, &b_lo, &b_hi);
+
+      const __m128i lo = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(a_lo, mfac_v), _mm_mullo_epi16(b_lo, fac_v)), 8);
+      const __m128i hi = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(a_hi, mfac_v), _mm_mullo_epi16(b_hi, fac_v)), 8);
+      _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+
+      rt1 += 16;
+      rt2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    rt[0] = (temp_mfac * rt1[0] + temp_fac * rt2[0]) >> 8;
+    rt[1] = (temp_mfac * rt1[1] + temp_fac * rt2[1]) >> 8;
+    rt[2] = (temp_mfac * rt1[2] + temp_fac * rt2[2]) >> 8;
+    rt[3] = (temp_mfac * rt1[3] + temp_fac * rt2[3]) >> 8;
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_cross_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -464,10 +619,8 @@ static void do_cross_effect_float(float fac, int x, int y, float *rect1, float *
 
   for (int i = 0; i < y; i++) {
     for (int j = 0; j < x; j++) {
-      rt[0] = mfac * rt1[0] + fac * rt2[0];
-      rt[1] = mfac * rt1[1] + fac * rt2[1];
-      rt[2] = mfac * rt1[2] + fac * rt2[2];
-      rt[3] = mfac * rt1[3] + fac * rt2[3];
+      effect_pixel_store(
+          rt, effect_pixel_mix(effect_pixel_load(rt1), mfac, effect_pixel_load(rt2), fac));
 
       rt1 += 4;
       rt2 += 4;
@@ -768,19 +921,46 @@ static void do_add_effect_byte(
 
   int temp_fac = (int)(256.0f * fac);
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const int temp_fac2 = temp_fac * (int)cp2[3];
-      rt[0] = min_ii(cp1[0] + ((temp_fac2 * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((temp_fac2 * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((temp_fac2 * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
+  const int pixels_num = x * y;
+  int i = 0;
+
+#ifdef BLI_HAVE_SSE2
+  /* 4 pixels at once, `(temp_fac2 * cp2) >> 16` is the high half of a 16 bit product. */
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i fac_v = _mm_set1_epi16((short)temp_fac);
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      __m128i b_lo, b_hi;
+      effect_byte_unpack_sse(cp2, &b_lo, &b_hi);
+
+      const __m128i fac2_lo = _mm_mullo_epi16(effect_byte_alpha_sse(b_lo), fac_v);
+      const __m128i lo = _mm_mulhi_epu16(fac2_lo, b_lo);
+      const __m128i fac2_hi = _mm_mullo_epi16(effect_byte_alpha_sse(b_hi), fac_v);
+      const __m128i hi = _mm_mulhi_epu16(fac2_hi, b_hi);
+      const __m128i a = _mm_loadu_si128((const __m128i *)cp1);
+      const __m128i r = _mm_adds_epu8(a, _mm_packus_epi16(lo, hi));
+      const __m128i alpha = _mm_and_si128(alpha_mask, a);
+      _mm_storeu_si128((__m128i *)rt, _mm_or_si128(_mm_andnot_si128(alpha_mask, r), alpha));
+
+      cp1 += 16;
+      cp2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    const int temp_fac2 = temp_fac * (int)cp2[3];
+    rt[0] = min_ii(cp1[0] + ((temp_fac2 * cp2[0]) >> 16), 255);
+    rt[1] = min_ii(cp1[1] + ((temp_fac2 * cp2[1]) >> 16), 255);
+    rt[2] = min_ii(cp1[2] + ((temp_fac2 * cp2[2]) >> 16), 255);
+    rt[3] = cp1[3];
+
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_add_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -792,10 +972,8 @@ static void do_add_effect_float(float fac, int x, int y, float *rect1, float *re
   for (int i = 0; i < y; i++) {
     for (int j = 0; j < x; j++) {
       const float temp_fac = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
-      rt[0] = rt1[0] + temp_fac * rt2[0];
-      rt[1] = rt1[1] + temp_fac * rt2[1];
-      rt[2] = rt1[2] + temp_fac * rt2[2];
-      rt[3] = rt1[3];
+      effect_pixel_store(
+          rt, effect_pixel_add_color(effect_pixel_load(rt1), temp_fac, effect_pixel_load(rt2)));
 
       rt1 += 4;
       rt2 += 4;
@@ -848,19 +1026,46 @@ static void do_sub_effect_byte(
 
   int temp_fac = (int)(256.0f * fac);
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const int temp_fac2 = temp_fac * (int)cp2[3];
-      rt[0] = max_ii(cp1[0] - ((temp_fac2 * cp2[0]) >> 16), 0);
-      rt[1] = max_ii(cp1[1] - ((temp_fac2 * cp2[1]) >> 16), 0);
-      rt[2] = max_ii(cp1[2] - ((temp_fac2 * cp2[2]) >> 16), 0);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
+  const int pixels_num = x * y;
+  int i = 0;
+
+#ifdef BLI_HAVE_SSE2
+  /* 4 pixels at once, `(temp_fac2 * cp2) >> 16` is the high half of a 16 bit product. */
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i fac_v = _mm_set1_epi16((short)temp_fac);
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      __m128i b_lo, b_hi;
+      effect_byte_unpack_sse(cp2, &b_lo, &b_hi);
+
+      const __m128i fac2_lo = _mm_mullo_epi16(effect_byte_alpha_sse(b_lo), fac_v);
+      const __m128i lo = _mm_mulhi_epu16(fac2_lo, b_lo);
+      const __m128i fac2_hi = _mm_mullo_epi16(effect_byte_alpha_sse(b_hi), fac_v);
+      const __m128i hi = _mm_mulhi_epu16(fac2_hi, b_hi);
+      const __m128i a = _mm_loadu_si128((const __m128i *)cp1);
+      const __m128i r = _mm_subs_epu8(a, _mm_packus_epi16(lo, hi));
+      const __m128i alpha = _mm_and_si128(alpha_mask, a);
+      _mm_storeu_si128((__m128i *)rt, _mm_or_si128(_mm_andnot_si128(alpha_mask, r), alpha));
+
+      cp1 += 16;
+      cp2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    const int temp_fac2 = temp_fac * (int)cp2[3];
+    rt[0] = max_ii(cp1[0] - ((temp_fac2 * cp2[0]) >> 16), 0);
+    rt[1] = max_ii(cp1[1] - ((temp_fac2 * cp2[1]) >> 16), 0);
+    rt[2] = max_ii(cp1[2] - ((temp_fac2 * cp2[2]) >> 16), 0);
+    rt[3] = cp1[3];
+
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_sub_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -874,10 +1079,8 @@ static void do_sub_effect_float(float fac, int x, int y, float *rect1, float *re
   for (int i = 0; i < y; i++) {
     for (int j = 0; j < x; j++) {
       const float temp_fac = (1.0f - (rt1[3] * mfac)) * rt2[3];
-      rt[0] = max_ff(rt1[0] - temp_fac * rt2[0], 0.0f);
-      rt[1] = max_ff(rt1[1] - temp_fac * rt2[1], 0.0f);
-      rt[2] = max_ff(rt1[2] - temp_fac * rt2[2], 0.0f);
-      rt[3] = rt1[3];
+      effect_pixel_store(
+          rt, effect_pixel_sub_color(effect_pixel_load(rt1), temp_fac, effect_pixel_load(rt2)));
 
       rt1 += 4;
       rt2 += 4;
@@ -1012,18 +1215,50 @@ static void do_mul_effect_byte(
    * `fac * (a * b) + (1 - fac) * a => fac * a * (b - 1) + axaux = c * px + py * s;` // + centx
    * `yaux = -s * px + c * py;` // + centy */
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = rt1[0] + ((temp_fac * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((temp_fac * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((temp_fac * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((temp_fac * rt1[3] * (rt2[3] - 255)) >> 16);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+  const int pixels_num = x * y;
+  int i = 0;
+
+#ifdef BLI_HAVE_SSE2
+  /* 4 pixels at once. The negative product is shifted towards minus infinity, so this subtracts
+   * the rounded up `(temp_fac * a * (255 - b)) >> 16`, from the high and low halves of the
+   * 16 bit product. */
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i v255 = _mm_set1_epi16(255);
+    const __m128i fac_v = _mm_set1_epi16((short)temp_fac);
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      __m128i a[2], b[2];
+      effect_byte_unpack_sse(rt1, &a[0], &a[1]);
+      effect_byte_unpack_sse(rt2, &b[0], &b[1]);
+
+      for (int k = 0; k < 2; k++) {
+        const __m128i p = _mm_mullo_epi16(a[k], fac_v);
+        const __m128i q = _mm_sub_epi16(v255, b[k]);
+        const __m128i is_exact = _mm_cmpeq_epi16(_mm_mullo_epi16(p, q), zero);
+        const __m128i sub = _mm_add_epi16(_mm_add_epi16(_mm_mulhi_epu16(p, q), one), is_exact);
+        a[k] = _mm_sub_epi16(a[k], sub);
+      }
+      _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(a[0], a[1]));
+
+      rt1 += 16;
+      rt2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    rt[0] = rt1[0] + ((temp_fac * rt1[0] * (rt2[0] - 255)) >> 16);
+    rt[1] = rt1[1] + ((temp_fac * rt1[1] * (rt2[1] - 255)) >> 16);
+    rt[2] = rt1[2] + ((temp_fac * rt1[2] * (rt2[2] - 255)) >> 16);
+    rt[3] = rt1[3] + ((temp_fac * rt1[3] * (rt2[3] - 255)) >> 16);
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_mul_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -1037,10 +1272,8 @@ static void do_mul_effect_float(float fac, int x, int y, float *rect1, float *re
 
   for (int i = 0; i < y; i++) {
     for (int j = 0; j < x; j++) {
-      rt[0] = rt1[0] + fac * rt1[0] * (rt2[0] - 1.0f);
-      rt[1] = rt1[1] + fac * rt1[1] * (rt2[1] - 1.0f);
-      rt[2] = rt1[2] + fac * rt1[2] * (rt2[2] - 1.0f);
-      rt[3] = rt1[3] + fac * rt1[3] * (rt2[3] - 1.0f);
+      effect_pixel_store(
+          rt, effect_pixel_mul(effect_pixel_load(rt1), fac, effect_pixel_load(rt2)));
 
       rt1 += 4;
       rt2 += 4;
@@ -3272,7 +3505,8 @@ void SEQ_effect_text_font_load(TextVars *data, const bool do_id_user)
     char name[MAX_ID_FULL_NAME];
     BKE_id_full_name_get(name, &vfont->id, 0);
 
-    data->text_blf_id = BLF_load_mem(name, pf->data, pf->size);
+    unsigned char *mem = BKE_packedfile_data_ensure(pf, NULL);
+    data->text_blf_id = mem ? BLF_load_mem(name, mem, pf->size) : SEQ_FONT_NOT_LOADED;
   }
   else {
     char path[FILE_MAX];
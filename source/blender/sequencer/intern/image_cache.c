@@ -5,6 +5,7 @@
  * \ingroup bke
  */
 
+#include <limits.h>
 #include <memory.h>
 #include <stddef.h>
 #include <time.h>
@@ -18,6 +19,7 @@
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
@@ -26,10 +28,13 @@
 #include "BLI_fileops_types.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_path_util.h"
 #include "BLI_threads.h"
 
+#include "PIL_time.h"
+
 #include "BKE_main.h"
 #include "BKE_scene.h"
 
@@ -66,10 +71,18 @@
  * Once again, this is to reduce number of iterations, but also more controllable than removing
  * entries one by one in reverse order to their creation.
  *
+ * Each entry records the time it took to render its image and its size. The frame freed first is
+ * the one with the lowest render time per byte, weighted by its distance to the playhead. This
+ * way, frames of heavy composites stay cached while frames which only show cheap source images
+ * are recycled.
+ *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
  */
 
 #define THUMB_CACHE_LIMIT 5000
+/* Render time of images which were (almost) free to get, so that their size and distance to the
+ * playhead still matter. */
+#define SEQ_CACHE_COST_MIN 0.001f
 
 typedef struct SeqCache {
   Main *bmain;
@@ -80,13 +93,27 @@ typedef struct SeqCache {
   struct SeqCacheKey *last_key;
   struct SeqDiskCache *disk_cache;
   int thumbnail_count;
+  SeqCacheStatistics statistics;
 } SeqCache;
 
 typedef struct SeqCacheItem {
   struct SeqCache *cache_owner;
   struct ImBuf *ibuf;
+  /* Last time the item was put in or taken from the cache, see #PIL_check_seconds_timer. */
+  double last_access;
+  /* Time it took to get the image in seconds, including its inputs which were not cached. */
+  float cost;
+  size_t size;
 } SeqCacheItem;
 
+typedef struct SeqCacheFrameInfo {
+  /* Time it took to render the frame, which is the cost of its most expensive image. */
+  float cost;
+  /* Memory used by all images of the frame. */
+  size_t size;
+  double last_access;
+} SeqCacheFrameInfo;
+
 static ThreadMutex cache_create_lock = BLI_MUTEX_INITIALIZER;
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
@@ -218,25 +245,32 @@ static int get_stored_types_flag(Scene *scene, SeqCacheKey *key)
   return flag;
 }
 
-static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
+static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf, float cost)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheItem *item;
   item = BLI_mempool_alloc(cache->items_pool);
   item->cache_owner = cache;
   item->ibuf = ibuf;
+  item->last_access = PIL_check_seconds_timer();
+  item->cost = cost;
+  item->size = IMB_get_size_in_memory(ibuf);
 
   const int stored_types_flag = get_stored_types_flag(scene, key);
 
+  /* Store pointer to last cached key. Prefetching renders several frames at the same time, only
+   * link items of the same frame. */
+  SeqCacheKey *temp_last_key = cache->last_key;
+  if (temp_last_key && temp_last_key->timeline_frame != key->timeline_frame) {
+    temp_last_key = NULL;
+  }
+
   /* Item stored for later use. */
   if (stored_types_flag & key->type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = temp_last_key;
   }
 
-  /* Store pointer to last cached key. */
-  SeqCacheKey *temp_last_key = cache->last_key;
-
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
 
@@ -258,12 +292,18 @@ static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
   }
 }
 
-static ImBuf *seq_cache_get_ex(SeqCache *cache, SeqCacheKey *key)
+static ImBuf *seq_cache_get_ex(SeqCache *cache, SeqCacheKey *key, const bool update_statistics)
 {
   SeqCacheItem *item = BLI_ghash_lookup(cache->hash, key);
 
   if (item && item->ibuf) {
     IMB_refImBuf(item->ibuf);
+    item->last_access = PIL_check_seconds_timer();
+
+    if (update_statistics) {
+      cache->statistics.hits++;
+      cache->statistics.time_saved += item->cost;
+    }
 
     return item->ibuf;
   }
@@ -281,69 +321,6 @@ static void seq_cache_relink_keys(SeqCacheKey *link_next, SeqCacheKey *link_prev
   }
 }
 
-/* Choose a key out of 2 candidates(leftmost and rightmost items)
- * to recycle based on currently used strategy */
-static SeqCacheKey *seq_cache_choose_key(Scene *scene, SeqCacheKey *lkey, SeqCacheKey *rkey)
-{
-  SeqCacheKey *finalkey = NULL;
-
-  /* Ideally, cache would not need to check the state of prefetching task
-   * that is tricky to do however, because prefetch would need to know,
-   * if a key, that is about to be created would be removed by itself.
-   *
-   * This can happen because only FINAL_OUT item insertion will trigger recycling
-   * but that is also the point, where prefetch can be suspended.
-   *
-   * We could use temp cache as a shield and later make it a non-temporary entry,
-   * but it is not worth of increasing system complexity.
-   */
-  if (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && seq_prefetch_job_is_running(scene)) {
-    int pfjob_start, pfjob_end;
-    seq_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
-
-    if (lkey) {
-      if (lkey->timeline_frame < pfjob_start || lkey->timeline_frame > pfjob_end) {
-        return lkey;
-      }
-    }
-
-    if (rkey) {
-      if (rkey->timeline_frame < pfjob_start || rkey->timeline_frame > pfjob_end) {
-        return rkey;
-      }
-    }
-
-    return NULL;
-  }
-
-  if (rkey && lkey) {
-    if (lkey->timeline_frame > rkey->timeline_frame) {
-      SeqCacheKey *swapkey = lkey;
-      lkey = rkey;
-      rkey = swapkey;
-    }
-
-    int l_diff = scene->r.cfra - lkey->timeline_frame;
-    int r_diff = rkey->timeline_frame - scene->r.cfra;
-
-    if (l_diff > r_diff) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  else {
-    if (lkey) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  return finalkey;
-}
-
 static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -387,19 +364,66 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
-static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
+/* Gather the images of the frame which \a base is the last image of, the same way as
+ * #seq_cache_recycle_linked frees them. */
+static void seq_cache_frame_info_get(SeqCache *cache, SeqCacheKey *base, SeqCacheFrameInfo *r_info)
+{
+  memset(r_info, 0, sizeof(*r_info));
+
+  while (base) {
+    SeqCacheItem *item = BLI_ghash_lookup(cache->hash, base);
+    if (item == NULL) {
+      break; /* Key has already been removed from cache. */
+    }
+
+    r_info->cost = max_ff(r_info->cost, item->cost);
+    r_info->size += item->size;
+    r_info->last_access = max_dd(r_info->last_access, item->last_access);
+
+    SeqCacheKey *prev = base->link_prev;
+    if (prev != NULL && prev->link_next != base) {
+      break; /* Key doesn't belong to this chain anymore. */
+    }
+    base = prev;
+  }
+}
+
+/* Render time per byte of the frame, lower the further it is from the playhead. Frames behind the
+ * playhead count as twice as far, as playback moves forward. */
+static float seq_cache_frame_value(Scene *scene, SeqCacheKey *base, const SeqCacheFrameInfo *info)
+{
+  float distance = base->timeline_frame - scene->r.cfra;
+  if (distance < 0.0f) {
+    distance *= -2.0f;
+  }
+
+  return (info->cost + SEQ_CACHE_COST_MIN) / (float)max_zz(info->size, 1) / (1.0f + distance);
+}
+
+SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *finalkey = NULL;
-  /* Leftmost key. */
-  SeqCacheKey *lkey = NULL;
-  /* Rightmost key. */
-  SeqCacheKey *rkey = NULL;
+  float finalkey_value = FLT_MAX;
   SeqCacheKey *key = NULL;
 
+  /* Ideally, cache would not need to check the state of prefetching task
+   * that is tricky to do however, because prefetch would need to know,
+   * if a key, that is about to be created would be removed by itself.
+   *
+   * This can happen because only FINAL_OUT item insertion will trigger recycling
+   * but that is also the point, where prefetch can be suspended.
+   *
+   * We could use temp cache as a shield and later make it a non-temporary entry,
+   * but it is not worth of increasing system complexity.
+   */
+  int pfjob_start = 0, pfjob_end = -1;
+  if (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && seq_prefetch_job_is_running(scene)) {
+    seq_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
+  }
+
   GHashIterator gh_iter;
   BLI_ghashIterator_init(&gh_iter, cache->hash);
-  int total_count = 0;
 
   while (!BLI_ghashIterator_done(&gh_iter)) {
     key = BLI_ghashIterator_getKey(&gh_iter);
@@ -411,6 +435,8 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
       seq_cache_recycle_linked(scene, key);
       /* Can not continue iterating after linked remove. */
       BLI_ghashIterator_init(&gh_iter, cache->hash);
+      finalkey = NULL;
+      finalkey_value = FLT_MAX;
       continue;
     }
 
@@ -418,31 +444,36 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
       continue;
     }
 
-    total_count++;
-
-    if (lkey) {
-      if (key->timeline_frame < lkey->timeline_frame) {
-        lkey = key;
-      }
-    }
-    else {
-      lkey = key;
-    }
-    if (rkey) {
-      if (key->timeline_frame > rkey->timeline_frame) {
-        rkey = key;
-      }
+    if (key->timeline_frame >= pfjob_start && key->timeline_frame <= pfjob_end) {
+      continue;
     }
-    else {
-      rkey = key;
+
+    SeqCacheFrameInfo info;
+    seq_cache_frame_info_get(cache, key, &info);
+    const float value = seq_cache_frame_value(scene, key, &info);
+
+    if (value < finalkey_value) {
+      finalkey = key;
+      finalkey_value = value;
     }
   }
 
-  finalkey = seq_cache_choose_key(scene, lkey, rkey);
-
   return finalkey;
 }
 
+/* Value of keeping the frame in memory, compared to frames of the image and movie caches which
+ * share the same memory budget. */
+static float seq_cache_key_value(SeqCache *cache, SeqCacheKey *key)
+{
+  SeqCacheFrameInfo info;
+  seq_cache_frame_info_get(cache, key, &info);
+  if (info.size == 0) {
+    return 0.0f;
+  }
+  return IMB_moviecache_frame_value(
+      info.cost + SEQ_CACHE_COST_MIN, info.size, info.last_access);
+}
+
 bool seq_cache_recycle_item(Scene *scene)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -452,11 +483,24 @@ bool seq_cache_recycle_item(Scene *scene)
 
   seq_cache_lock(scene);
 
-  while (seq_cache_is_full()) {
+  while (true) {
+    /* Memory in use is read once, it can change on other threads between two reads. */
+    const size_t mem_in_use = MEM_get_memory_in_use();
+    const size_t mem_total = seq_cache_get_mem_total();
+    if (mem_in_use <= mem_total) {
+      break;
+    }
+    const size_t mem_over_budget = mem_in_use - mem_total;
     SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
 
     if (finalkey) {
-      seq_cache_recycle_linked(scene, finalkey);
+      /* Images, movie clips and display buffers are cached in the same memory budget, free their
+       * frames first when they are cheaper to get back than the sequencer frame. */
+      if (IMB_moviecache_free_less_valuable(seq_cache_key_value(cache, finalkey),
+                                            mem_over_budget) == 0) {
+        seq_cache_recycle_linked(scene, finalkey);
+        cache->statistics.frames_recycled++;
+      }
     }
     else {
       seq_cache_unlock(scene);
@@ -566,6 +610,9 @@ void seq_cache_free_temp_cache(Scene *scene, short id, int timeline_frame)
       if (frame_index != key->frame_index ||
           timeline_frame > SEQ_time_right_handle_frame_get(scene, key->seq) ||
           timeline_frame < SEQ_time_left_handle_frame_get(scene, key->seq)) {
+        if (key == cache->last_key) {
+          cache->last_key = NULL;
+        }
         BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
       }
     }
@@ -723,10 +770,11 @@ void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area_safe)
   cache->last_key = NULL;
 }
 
-struct ImBuf *seq_cache_get(const SeqRenderData *context,
-                            Sequence *seq,
-                            float timeline_frame,
-                            int type)
+static ImBuf *seq_cache_get_impl(const SeqRenderData *context,
+                                  Sequence *seq,
+                                  float timeline_frame,
+                                  int type,
+                                  const bool update_statistics)
 {
 
   if (context->skip_cache || context->is_proxy_render || !seq) {
@@ -757,7 +805,7 @@ struct ImBuf *seq_cache_get(const SeqRenderData *context,
   /* Try RAM cache: */
   if (cache && seq) {
     seq_cache_populate_key(&key, context, seq, timeline_frame, type);
-    ibuf = seq_cache_get_ex(cache, &key);
+    ibuf = seq_cache_get_ex(cache, &key, update_statistics);
   }
   seq_cache_unlock(scene);
 
@@ -771,24 +819,66 @@ struct ImBuf *seq_cache_get(const SeqRenderData *context,
       cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
     }
 
+    const double start_time = PIL_check_seconds_timer();
     ibuf = seq_disk_cache_read_file(cache->disk_cache, &key);
 
     if (ibuf == NULL) {
       return NULL;
     }
 
-    /* Store read image in RAM. Only recycle item for final type. */
+    if (update_statistics) {
+      seq_cache_lock(scene);
+      cache->statistics.disk_hits++;
+      seq_cache_unlock(scene);
+    }
+
+    /* Store read image in RAM. Only recycle item for final type. Once it is on disk, the image
+     * costs the time it takes to read it. */
     if (key.type != SEQ_CACHE_STORE_FINAL_OUT || seq_cache_recycle_item(scene)) {
       SeqCacheKey *new_key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
-      seq_cache_put_ex(scene, new_key, ibuf);
+      seq_cache_put_ex(scene, new_key, ibuf, PIL_check_seconds_timer() - start_time);
     }
   }
 
   return ibuf;
 }
 
-bool seq_cache_put_if_possible(
-    const SeqRenderData *context, Sequence *seq, float timeline_frame, int type, ImBuf *ibuf)
+struct ImBuf *seq_cache_get(const SeqRenderData *context,
+                            Sequence *seq,
+                            float timeline_frame,
+                            int type)
+{
+  return seq_cache_get_impl(
+      context, seq, timeline_frame, type, type != SEQ_CACHE_STORE_THUMBNAIL);
+}
+
+struct ImBuf *seq_cache_probe(const SeqRenderData *context,
+                              Sequence *seq,
+                              float timeline_frame,
+                              int type)
+{
+  return seq_cache_get_impl(context, seq, timeline_frame, type, false);
+}
+
+/* Misses are counted when the rendered image is stored rather than when the lookup fails, so
+ * lookups that are followed by a read from disk cache, or that only check whether an image is
+ * cached, are not counted. */
+static void seq_cache_statistics_add_miss(Scene *scene)
+{
+  seq_cache_lock(scene);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (cache) {
+    cache->statistics.misses++;
+  }
+  seq_cache_unlock(scene);
+}
+
+bool seq_cache_put_if_possible(const SeqRenderData *context,
+                               Sequence *seq,
+                               float timeline_frame,
+                               int type,
+                               ImBuf *ibuf,
+                               float cost)
 {
   Scene *scene = context->scene;
 
@@ -803,10 +893,14 @@ bool seq_cache_put_if_possible(
   }
 
   if (seq_cache_recycle_item(scene)) {
-    seq_cache_put(context, seq, timeline_frame, type, ibuf);
+    seq_cache_put(context, seq, timeline_frame, type, ibuf, cost);
     return true;
   }
 
+  if (ibuf && !context->skip_cache && !context->is_proxy_render) {
+    seq_cache_statistics_add_miss(scene);
+  }
+
   seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
   scene->ed->cache->last_key = NULL;
   return false;
@@ -838,13 +932,17 @@ void seq_cache_thumbnail_put(
     seq_cache_thumbnail_cleanup(scene, &view_area_safe);
   }
 
-  seq_cache_put_ex(scene, key, i);
+  seq_cache_put_ex(scene, key, i, 0.0f);
   cache->thumbnail_count++;
   seq_cache_unlock(scene);
 }
 
-void seq_cache_put(
-    const SeqRenderData *context, Sequence *seq, float timeline_frame, int type, ImBuf *i)
+void seq_cache_put(const SeqRenderData *context,
+                   Sequence *seq,
+                   float timeline_frame,
+                   int type,
+                   ImBuf *i,
+                   float cost)
 {
   if (i == NULL || context->skip_cache || context->is_proxy_render || !seq) {
     return;
@@ -860,7 +958,7 @@ void seq_cache_put(
   }
 
   /* Prevent reinserting, it breaks cache key linking. */
-  ImBuf *test = seq_cache_get(context, seq, timeline_frame, type);
+  ImBuf *test = seq_cache_get_impl(context, seq, timeline_frame, type, false);
   if (test) {
     IMB_freeImBuf(test);
     return;
@@ -873,21 +971,35 @@ void seq_cache_put(
   seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
-  seq_cache_put_ex(scene, key, i);
+  seq_cache_put_ex(scene, key, i, cost);
+  cache->statistics.misses++;
   seq_cache_unlock(scene);
 
   if (!key->is_temp_cache) {
     if (seq_disk_cache_is_enabled(context->bmain)) {
       if (cache->disk_cache == NULL) {
-        seq_disk_cache_create(context->bmain, context->scene);
+        cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
       }
 
+      /* Limits are enforced by the I/O thread once the image is written. */
       seq_disk_cache_write_file(cache->disk_cache, key, i);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
     }
   }
 }
 
+void SEQ_cache_statistics_get(Scene *scene, SeqCacheStatistics *r_stats)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    memset(r_stats, 0, sizeof(*r_stats));
+    return;
+  }
+
+  seq_cache_lock(scene);
+  *r_stats = cache->statistics;
+  seq_cache_unlock(scene);
+}
+
 void SEQ_cache_iterate(
     struct Scene *scene,
     void *userdata,
@@ -916,6 +1028,16 @@ void SEQ_cache_iterate(
   seq_cache_unlock(scene);
 }
 
+int seq_cache_frames_in_flight_max(size_t frame_size)
+{
+  if (frame_size == 0) {
+    return INT_MAX;
+  }
+  /* Frames being rendered also hold intermediate images, count them twice. */
+  const size_t frames_num = seq_cache_get_mem_total() / 4 / (frame_size * 2);
+  return (int)min_zz(frames_num, INT_MAX);
+}
+
 bool seq_cache_is_full(void)
 {
   return seq_cache_get_mem_total() < MEM_get_memory_in_use();
@@ -28,7 +28,6 @@ typedef struct SeqCacheKey {
   struct SeqRenderData context;
   float frame_index;    /* Usually same as timeline_frame. Mapped to media for RAW entries. */
   float timeline_frame; /* Only for reference - used for freeing when cache is full. */
-  float cost;           /* In short: render time(s) divided by playback frame duration(s) */
   bool is_temp_cache;   /* this cache entry will be freed before rendering next frame */
   /* ID of task for assigning temp cache entries to particular task(thread, etc.) */
   eSeqTaskId task_id;
@@ -39,11 +38,20 @@ struct ImBuf *seq_cache_get(const struct SeqRenderData *context,
                             struct Sequence *seq,
                             float timeline_frame,
                             int type);
+/**
+ * Same as #seq_cache_get, but the lookup is not counted in the cache statistics. Used to check
+ * whether an image is cached before deciding what to render.
+ */
+struct ImBuf *seq_cache_probe(const struct SeqRenderData *context,
+                              struct Sequence *seq,
+                              float timeline_frame,
+                              int type);
 void seq_cache_put(const struct SeqRenderData *context,
                    struct Sequence *seq,
                    float timeline_frame,
                    int type,
-                   struct ImBuf *i);
+                   struct ImBuf *i,
+                   float cost);
 void seq_cache_thumbnail_put(const struct SeqRenderData *context,
                              struct Sequence *seq,
                              float timeline_frame,
@@ -53,7 +61,13 @@ bool seq_cache_put_if_possible(const struct SeqRenderData *context,
                                struct Sequence *seq,
                                float timeline_frame,
                                int type,
-                               struct ImBuf *nval);
+                               struct ImBuf *nval,
+                               float cost);
+/**
+ * Last key of the frame which is freed first when the cache is full: the one with the lowest
+ * render time per byte, lowered further from the playhead. NULL when no frame can be freed.
+ */
+struct SeqCacheKey *seq_cache_get_item_for_removal(struct Scene *scene);
 /**
  * Find only "base" keys.
  * Sources(other types) for a frame must be freed all at once.
@@ -69,6 +83,11 @@ void seq_cache_cleanup_sequence(struct Scene *scene,
                                 bool force_seq_changed_range);
 void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area);
 bool seq_cache_is_full(void);
+/**
+ * Number of frames of \a frame_size which can be rendered at the same time, without using more
+ * than a quarter of the memory budget of the cache (which is left to frames already cached).
+ */
+int seq_cache_frames_in_flight_max(size_t frame_size);
 float seq_cache_frame_index_to_timeline_frame(struct Sequence *seq, float frame_index);
 
 #ifdef __cplusplus
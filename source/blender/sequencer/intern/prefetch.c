@@ -5,6 +5,7 @@
  * \ingroup bke
  */
 
+#include <math.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,6 +19,7 @@
 #include "DNA_windowmanager_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_threads.h"
 
 #include "IMB_imbuf.h"
@@ -32,6 +34,8 @@
 #include "BKE_main.h"
 #include "BKE_scene.h"
 
+#include "PIL_time.h"
+
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_build.h"
 #include "DEG_depsgraph_debug.h"
@@ -48,33 +52,66 @@
 #include "prefetch.h"
 #include "render.h"
 
+/* Maximum number of frames rendered at the same time. Rendering a frame is multi-threaded already
+ * (decoding, effects), frames are rendered concurrently to hide the parts which are not. */
+#define PREFETCH_WORKERS_MAX 8
+/* Maximum number of workers decoding frames of the same movie strip at the same time. Each of
+ * them opens the movie with its own decoder, which has to seek when frames are not decoded in
+ * order. */
+#define PREFETCH_WORKERS_PER_MOVIE_MAX 2
+
+/* Renders frames in its own thread, on its own copy of the scene. */
+typedef struct PrefetchWorker {
+  struct PrefetchJob *pfjob;
+  int index;
+
+  struct Main *bmain_eval;
+  struct Scene *scene_eval;
+  struct Depsgraph *depsgraph;
+
+  /* context */
+  struct SeqRenderData context;
+  struct SeqRenderData context_cpy;
+
+  /* Frame being rendered. */
+  float cfra;
+
+  /* Names of the movie strips shown in the frame, see #seq_prefetch_movie_strips_acquire. */
+  const char *movie_strips[MAXSEQ + 1];
+  int num_movie_strips;
+  /* Whether the frame showing the movie strips is being rendered, protected by the mutex. */
+  bool use_movie_strips;
+} PrefetchWorker;
+
 typedef struct PrefetchJob {
   struct PrefetchJob *next, *prev;
 
   struct Main *bmain;
-  struct Main *bmain_eval;
   struct Scene *scene;
-  struct Scene *scene_eval;
-  struct Depsgraph *depsgraph;
 
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
 
   ListBase threads;
 
-  /* context */
-  struct SeqRenderData context;
-  struct SeqRenderData context_cpy;
-  struct ListBase *seqbasep;
-  struct ListBase *seqbasep_cpy;
+  PrefetchWorker workers[PREFETCH_WORKERS_MAX];
+  /* Workers started by the last #seq_prefetch_start_ex. */
+  int num_workers;
+  int num_workers_running;
+  int num_workers_waiting;
 
   /* prefetch area */
   float cfra;
+  /* Frames given to workers so far, counted from #cfra. */
   int num_frames_prefetched;
 
+  /* Running averages of the time it takes to render a frame (seconds) and of its size, used to
+   * choose the number of frames rendered at the same time. */
+  double render_time;
+  size_t frame_size;
+
   /* control */
   bool running;
-  bool waiting;
   bool stop;
 } PrefetchJob;
 
@@ -126,7 +163,11 @@ static bool seq_prefetch_job_is_waiting(Scene *scene)
     return false;
   }
 
-  return pfjob->waiting;
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  const bool waiting = pfjob->num_workers_waiting == pfjob->num_workers_running;
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  return waiting;
 }
 
 static Sequence *sequencer_prefetch_get_original_sequence(Sequence *seq, ListBase *seqbase)
@@ -157,7 +198,14 @@ SeqRenderData *seq_prefetch_get_original_context(const SeqRenderData *context)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
 
-  return &pfjob->context;
+  /* Each worker has its own context, to keep track of its temporary cache entries. */
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    if (pfjob->workers[i].scene_eval == context->scene) {
+      return &pfjob->workers[i].context;
+    }
+  }
+
+  return &pfjob->workers[0].context;
 }
 
 static bool seq_prefetch_is_cache_full(Scene *scene)
@@ -175,9 +223,9 @@ static float seq_prefetch_cfra(PrefetchJob *pfjob)
 {
   return pfjob->cfra + pfjob->num_frames_prefetched;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
+static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchWorker *worker)
 {
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  return BKE_animsys_eval_context_construct(worker->depsgraph, worker->cfra);
 }
 
 void seq_prefetch_get_time_range(Scene *scene, int *start, int *end)
@@ -188,37 +236,48 @@ void seq_prefetch_get_time_range(Scene *scene, int *start, int *end)
   *end = seq_prefetch_cfra(pfjob);
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchWorker *worker)
 {
-  if (pfjob->depsgraph != NULL) {
-    DEG_graph_free(pfjob->depsgraph);
+  if (worker->depsgraph != NULL) {
+    DEG_graph_free(worker->depsgraph);
   }
-  pfjob->depsgraph = NULL;
-  pfjob->scene_eval = NULL;
+  worker->depsgraph = NULL;
+  worker->scene_eval = NULL;
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_update_depsgraph(PrefetchWorker *worker)
 {
-  DEG_evaluate_on_framechange(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  DEG_evaluate_on_framechange(worker->depsgraph, worker->cfra);
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchWorker *worker)
 {
-  Main *bmain = pfjob->bmain_eval;
-  Scene *scene = pfjob->scene;
+  Main *bmain = worker->bmain_eval;
+  Scene *scene = worker->pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  worker->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(worker->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph);
+  DEG_graph_build_for_render_pipeline(worker->depsgraph);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  worker->cfra = seq_prefetch_cfra(worker->pfjob);
+  seq_prefetch_update_depsgraph(worker);
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  worker->scene_eval = DEG_get_evaluated_scene(worker->depsgraph);
+  worker->scene_eval->ed->cache_flag = 0;
+}
+
+static void seq_prefetch_free_worker(PrefetchWorker *worker)
+{
+  if (worker->bmain_eval == NULL) {
+    return;
+  }
+  seq_prefetch_free_depsgraph(worker);
+  BKE_main_free(worker->bmain_eval);
+  worker->bmain_eval = NULL;
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -263,63 +322,57 @@ void SEQ_prefetch_stop(Scene *scene)
   pfjob->stop = true;
 
   while (pfjob->running) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
-static void seq_prefetch_update_context(const SeqRenderData *context)
+static void seq_prefetch_update_context(const SeqRenderData *context, PrefetchWorker *worker)
 {
-  PrefetchJob *pfjob;
-  pfjob = seq_prefetch_job_get(context->scene);
+  PrefetchJob *pfjob = worker->pfjob;
 
-  SEQ_render_new_render_data(pfjob->bmain_eval,
-                             pfjob->depsgraph,
-                             pfjob->scene_eval,
+  SEQ_render_new_render_data(worker->bmain_eval,
+                             worker->depsgraph,
+                             worker->scene_eval,
                              context->rectx,
                              context->recty,
                              context->preview_render_size,
                              false,
-                             &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+                             &worker->context_cpy);
+  worker->context_cpy.is_prefetch_render = true;
+  /* Workers use consecutive IDs, so each of them only frees its own temporary cache entries. */
+  worker->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER + worker->index;
 
   SEQ_render_new_render_data(pfjob->bmain,
-                             pfjob->depsgraph,
+                             worker->depsgraph,
                              pfjob->scene,
                              context->rectx,
                              context->recty,
                              context->preview_render_size,
                              false,
-                             &pfjob->context);
-  pfjob->context.is_prefetch_render = false;
+                             &worker->context);
+  worker->context.is_prefetch_render = false;
 
   /* Same ID as prefetch context, because context will be swapped, but we still
    * want to assign this ID to cache entries created in this thread.
    * This is to allow "temp cache" work correctly for both threads.
    */
-  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+  worker->context.task_id = worker->context_cpy.task_id;
 }
 
-static void seq_prefetch_update_scene(Scene *scene)
+static void seq_prefetch_update_scene(PrefetchWorker *worker)
 {
-  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
-
-  if (!pfjob) {
-    return;
-  }
-
-  pfjob->scene = scene;
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  seq_prefetch_free_depsgraph(worker);
+  seq_prefetch_init_depsgraph(worker);
 }
 
-static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob)
+static void seq_prefetch_update_active_seqbase(PrefetchWorker *worker)
 {
-  MetaStack *ms_orig = SEQ_meta_stack_active_get(SEQ_editing_get(pfjob->scene));
-  Editing *ed_eval = SEQ_editing_get(pfjob->scene_eval);
+  MetaStack *ms_orig = SEQ_meta_stack_active_get(SEQ_editing_get(worker->pfjob->scene));
+  Editing *ed_eval = SEQ_editing_get(worker->scene_eval);
 
   if (ms_orig != NULL) {
-    Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq, pfjob->scene_eval);
+    Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq,
+                                                             worker->scene_eval);
     SEQ_seqbase_active_set(ed_eval, &meta_eval->seqbase);
   }
   else {
@@ -331,8 +384,12 @@ static void seq_prefetch_resume(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
-  if (pfjob && pfjob->waiting) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  if (pfjob) {
+    BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+    if (pfjob->num_workers_waiting > 0) {
+      BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
+    }
+    BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
   }
 }
 
@@ -345,30 +402,33 @@ void seq_prefetch_free(Scene *scene)
 
   SEQ_prefetch_stop(scene);
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
+  for (int i = 0; i < PREFETCH_WORKERS_MAX; i++) {
+    BLI_threadpool_remove(&pfjob->threads, &pfjob->workers[i]);
+  }
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
-  BKE_main_free(pfjob->bmain_eval);
+  for (int i = 0; i < PREFETCH_WORKERS_MAX; i++) {
+    seq_prefetch_free_worker(&pfjob->workers[i]);
+  }
   MEM_freeN(pfjob);
   scene->ed->prefetch_job = NULL;
 }
 
-static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
+static bool seq_prefetch_seq_has_disk_cache(PrefetchWorker *worker,
                                             Sequence *seq,
                                             bool can_have_final_image)
 {
-  SeqRenderData *ctx = &pfjob->context_cpy;
-  float cfra = seq_prefetch_cfra(pfjob);
+  SeqRenderData *ctx = &worker->context_cpy;
+  float cfra = worker->cfra;
 
-  ImBuf *ibuf = seq_cache_get(ctx, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED);
+  ImBuf *ibuf = seq_cache_probe(ctx, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED);
   if (ibuf != NULL) {
     IMB_freeImBuf(ibuf);
     return true;
   }
 
-  ibuf = seq_cache_get(ctx, seq, cfra, SEQ_CACHE_STORE_RAW);
+  ibuf = seq_cache_probe(ctx, seq, cfra, SEQ_CACHE_STORE_RAW);
   if (ibuf != NULL) {
     IMB_freeImBuf(ibuf);
     return true;
@@ -378,7 +438,7 @@ static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
     return false;
   }
 
-  ibuf = seq_cache_get(ctx, seq, cfra, SEQ_CACHE_STORE_FINAL_OUT);
+  ibuf = seq_cache_probe(ctx, seq, cfra, SEQ_CACHE_STORE_FINAL_OUT);
   if (ibuf != NULL) {
     IMB_freeImBuf(ibuf);
     return true;
@@ -387,27 +447,28 @@ static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
   return false;
 }
 
-static bool seq_prefetch_scene_strip_is_rendered(PrefetchJob *pfjob,
+static bool seq_prefetch_scene_strip_is_rendered(PrefetchWorker *worker,
                                                  ListBase *channels,
                                                  ListBase *seqbase,
                                                  SeqCollection *scene_strips,
                                                  bool is_recursive_check)
 {
-  float cfra = seq_prefetch_cfra(pfjob);
+  float cfra = worker->cfra;
   Sequence *seq_arr[MAXSEQ + 1];
-  int count = seq_get_shown_sequences(pfjob->scene_eval, channels, seqbase, cfra, 0, seq_arr);
+  int count = seq_get_shown_sequences(worker->scene_eval, channels, seqbase, cfra, 0, seq_arr);
 
   /* Iterate over rendered strips. */
   for (int i = 0; i < count; i++) {
     Sequence *seq = seq_arr[i];
     if (seq->type == SEQ_TYPE_META &&
-        seq_prefetch_scene_strip_is_rendered(pfjob, channels, &seq->seqbase, scene_strips, true)) {
+        seq_prefetch_scene_strip_is_rendered(
+            worker, channels, &seq->seqbase, scene_strips, true)) {
       return true;
     }
 
     /* Disable prefetching 3D scene strips, but check for disk cache. */
     if (seq->type == SEQ_TYPE_SCENE && (seq->flag & SEQ_SCENE_STRIPS) == 0 &&
-        !seq_prefetch_seq_has_disk_cache(pfjob, seq, !is_recursive_check)) {
+        !seq_prefetch_seq_has_disk_cache(worker, seq, !is_recursive_check)) {
       return true;
     }
 
@@ -435,10 +496,12 @@ static SeqCollection *query_scene_strips(ListBase *seqbase)
 
 /* Prefetch must avoid rendering scene strips, because rendering in background locks UI and can
  * make it unresponsive for long time periods. */
-static bool seq_prefetch_must_skip_frame(PrefetchJob *pfjob, ListBase *channels, ListBase *seqbase)
+static bool seq_prefetch_must_skip_frame(PrefetchWorker *worker,
+                                         ListBase *channels,
+                                         ListBase *seqbase)
 {
   SeqCollection *scene_strips = query_scene_strips(seqbase);
-  if (seq_prefetch_scene_strip_is_rendered(pfjob, channels, seqbase, scene_strips, false)) {
+  if (seq_prefetch_scene_strip_is_rendered(worker, channels, seqbase, scene_strips, false)) {
     SEQ_collection_free(scene_strips);
     return true;
   }
@@ -446,37 +509,175 @@ static bool seq_prefetch_must_skip_frame(PrefetchJob *pfjob, ListBase *channels,
   return false;
 }
 
-static bool seq_prefetch_need_suspend(PrefetchJob *pfjob)
+/* Number of frames to render at the same time: enough to keep up with playback when rendering a
+ * frame takes longer than displaying it, as long as the frames fit in the cache budget. */
+static int seq_prefetch_num_workers_wanted(PrefetchJob *pfjob)
+{
+  const Scene *scene = pfjob->scene;
+  const int num_workers_max = min_ii(PREFETCH_WORKERS_MAX,
+                                     max_ii(BLI_system_thread_count() / 4, 1));
+
+  if (pfjob->render_time <= 0.0 || pfjob->frame_size == 0 || scene->r.frs_sec == 0) {
+    return 1;
+  }
+
+  const double frame_duration = (double)scene->r.frs_sec_base / (double)scene->r.frs_sec;
+  int num_workers = (int)ceil(min_dd(pfjob->render_time / frame_duration, num_workers_max));
+  num_workers = min_ii(num_workers, seq_cache_frames_in_flight_max(pfjob->frame_size));
+
+  return clamp_i(num_workers, 1, num_workers_max);
+}
+
+static void seq_prefetch_update_statistics(PrefetchJob *pfjob, ImBuf *ibuf, double render_time)
+{
+  if (ibuf == NULL) {
+    return;
+  }
+
+  const size_t frame_size = IMB_get_size_in_memory(ibuf);
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  if (pfjob->frame_size == 0) {
+    pfjob->render_time = render_time;
+    pfjob->frame_size = frame_size;
+  }
+  else {
+    pfjob->render_time += (render_time - pfjob->render_time) * 0.25;
+    pfjob->frame_size = (pfjob->frame_size * 3 + frame_size) / 4;
+  }
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+}
+
+static bool seq_prefetch_need_suspend(PrefetchWorker *worker)
 {
+  PrefetchJob *pfjob = worker->pfjob;
   return seq_prefetch_is_cache_full(pfjob->scene) || seq_prefetch_is_scrubbing(pfjob->bmain) ||
-         (seq_prefetch_cfra(pfjob) >= pfjob->scene->r.efra);
+         (seq_prefetch_cfra(pfjob) >= pfjob->scene->r.efra) ||
+         (worker->index >= seq_prefetch_num_workers_wanted(pfjob));
 }
 
-static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
+static void seq_prefetch_do_suspend(PrefetchWorker *worker)
 {
+  PrefetchJob *pfjob = worker->pfjob;
+
   BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
-  while (seq_prefetch_need_suspend(pfjob) &&
+  while (seq_prefetch_need_suspend(worker) &&
          (pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) && !pfjob->stop) {
-    pfjob->waiting = true;
+    pfjob->num_workers_waiting++;
     BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+    pfjob->num_workers_waiting--;
     seq_prefetch_update_area(pfjob);
   }
-  pfjob->waiting = false;
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 }
 
-static void *seq_prefetch_frames(void *job)
+static void seq_prefetch_movie_strips_collect(PrefetchWorker *worker,
+                                              ListBase *channels,
+                                              ListBase *seqbase)
+{
+  SeqCollection *strips = SEQ_query_rendered_strips(
+      worker->scene_eval, channels, seqbase, worker->cfra, 0);
+  Sequence *seq;
+  SEQ_ITERATOR_FOREACH (seq, strips) {
+    if (seq->type == SEQ_TYPE_MOVIE && worker->num_movie_strips < MAXSEQ + 1) {
+      worker->movie_strips[worker->num_movie_strips++] = seq->name;
+    }
+    else if (seq->type == SEQ_TYPE_META) {
+      seq_prefetch_movie_strips_collect(worker, &seq->channels, &seq->seqbase);
+    }
+  }
+  SEQ_collection_free(strips);
+}
+
+/* Whether few enough other workers render frames of the movie strips of \a worker. Strips are
+ * compared by name, workers have their own copies of them. The mutex must be locked. */
+static bool seq_prefetch_movie_strips_available(PrefetchWorker *worker)
+{
+  PrefetchJob *pfjob = worker->pfjob;
+
+  for (int i = 0; i < worker->num_movie_strips; i++) {
+    int num_users = 0;
+    for (int w = 0; w < pfjob->num_workers; w++) {
+      PrefetchWorker *other = &pfjob->workers[w];
+      if (other == worker || !other->use_movie_strips) {
+        continue;
+      }
+      for (int j = 0; j < other->num_movie_strips; j++) {
+        if (STREQ(other->movie_strips[j], worker->movie_strips[i])) {
+          num_users++;
+          break;
+        }
+      }
+    }
+    if (num_users >= PREFETCH_WORKERS_PER_MOVIE_MAX) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Wait until the movie strips shown in the frame of \a worker can be decoded by it, see
+ * #PREFETCH_WORKERS_PER_MOVIE_MAX. Returns false when prefetching stops in the meantime. */
+static bool seq_prefetch_movie_strips_acquire(PrefetchWorker *worker,
+                                              ListBase *channels,
+                                              ListBase *seqbase)
+{
+  PrefetchJob *pfjob = worker->pfjob;
+
+  worker->num_movie_strips = 0;
+  seq_prefetch_movie_strips_collect(worker, channels, seqbase);
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  while (!seq_prefetch_movie_strips_available(worker) && !pfjob->stop) {
+    BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+  }
+  const bool stop = pfjob->stop;
+  worker->use_movie_strips = !stop;
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  return !stop;
+}
+
+static void seq_prefetch_movie_strips_release(PrefetchWorker *worker)
+{
+  PrefetchJob *pfjob = worker->pfjob;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  worker->use_movie_strips = false;
+  if (worker->num_movie_strips > 0) {
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
+  }
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+}
+
+/* Give the next frame after the ones given to other workers to the worker. */
+static bool seq_prefetch_claim_frame(PrefetchWorker *worker)
 {
-  PrefetchJob *pfjob = (PrefetchJob *)job;
+  PrefetchJob *pfjob = worker->pfjob;
 
-  while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = NULL;
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  seq_prefetch_update_area(pfjob);
+  worker->cfra = seq_prefetch_cfra(pfjob);
+  pfjob->num_frames_prefetched++;
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  return worker->cfra <= pfjob->scene->r.efra;
+}
 
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
+static void *seq_prefetch_frames(void *worker_v)
+{
+  PrefetchWorker *worker = (PrefetchWorker *)worker_v;
+  PrefetchJob *pfjob = worker->pfjob;
+
+  while (seq_prefetch_claim_frame(worker)) {
+    worker->scene_eval->ed->prefetch_job = NULL;
+
+    seq_prefetch_update_depsgraph(worker);
+    AnimData *adt = BKE_animdata_from_id(&worker->context_cpy.scene->id);
+    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(worker);
     BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
+        &worker->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
 
     /* This is quite hacky solution:
      * We need cross-reference original scene with copy for cache.
@@ -484,21 +685,27 @@ static void *seq_prefetch_frames(void *job)
      * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
      * Set to NULL before return!
      */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
+    worker->scene_eval->ed->prefetch_job = pfjob;
 
-    ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(pfjob->scene_eval));
-    ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(pfjob->scene_eval));
-    if (seq_prefetch_must_skip_frame(pfjob, channels, seqbase)) {
-      pfjob->num_frames_prefetched++;
+    ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(worker->scene_eval));
+    ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(worker->scene_eval));
+    if (seq_prefetch_must_skip_frame(worker, channels, seqbase)) {
       continue;
     }
 
-    ImBuf *ibuf = SEQ_render_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
+    if (!seq_prefetch_movie_strips_acquire(worker, channels, seqbase)) {
+      break;
+    }
+
+    const double start_time = PIL_check_seconds_timer();
+    ImBuf *ibuf = SEQ_render_give_ibuf(&worker->context_cpy, worker->cfra, 0);
+    seq_prefetch_movie_strips_release(worker);
+    seq_cache_free_temp_cache(pfjob->scene, worker->context.task_id, worker->cfra);
+    seq_prefetch_update_statistics(pfjob, ibuf, PIL_check_seconds_timer() - start_time);
     IMB_freeImBuf(ibuf);
 
     /* Suspend thread if there is nothing to be prefetched. */
-    seq_prefetch_do_suspend(pfjob);
+    seq_prefetch_do_suspend(worker);
 
     /* Avoid "collision" with main thread, but make sure to fetch at least few frames */
     if (pfjob->num_frames_prefetched > 5 &&
@@ -509,14 +716,15 @@ static void *seq_prefetch_frames(void *job)
     if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
       break;
     }
-
-    seq_prefetch_update_area(pfjob);
-    pfjob->num_frames_prefetched++;
   }
 
-  seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
-  pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = NULL;
+  seq_cache_free_temp_cache(pfjob->scene, worker->context.task_id, worker->cfra);
+  worker->scene_eval->ed->prefetch_job = NULL;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  pfjob->num_workers_running--;
+  pfjob->running = pfjob->num_workers_running > 0;
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 
   return NULL;
 }
@@ -530,30 +738,54 @@ static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cf
       pfjob = (PrefetchJob *)MEM_callocN(sizeof(PrefetchJob), "PrefetchJob");
       context->scene->ed->prefetch_job = pfjob;
 
-      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, 1);
+      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, PREFETCH_WORKERS_MAX);
       BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
-      pfjob->bmain_eval = BKE_main_new();
-      pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
+      for (int i = 0; i < PREFETCH_WORKERS_MAX; i++) {
+        pfjob->workers[i].pfjob = pfjob;
+        pfjob->workers[i].index = i;
+      }
     }
   }
   pfjob->bmain = context->bmain;
+  pfjob->scene = context->scene;
 
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
 
-  pfjob->waiting = false;
+  pfjob->num_workers_waiting = 0;
   pfjob->stop = false;
   pfjob->running = true;
 
-  seq_prefetch_update_scene(context->scene);
-  seq_prefetch_update_context(context);
-  seq_prefetch_update_active_seqbase(pfjob);
+  for (int i = 0; i < PREFETCH_WORKERS_MAX; i++) {
+    BLI_threadpool_remove(&pfjob->threads, &pfjob->workers[i]);
+  }
+
+  /* Workers have their own copy of the scene, so they are only added when the render time measured
+   * so far shows they are needed, and freed when they are not anymore. */
+  pfjob->num_workers = seq_prefetch_num_workers_wanted(pfjob);
+
+  for (int i = 0; i < PREFETCH_WORKERS_MAX; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
-  BLI_threadpool_insert(&pfjob->threads, pfjob);
+    if (i >= pfjob->num_workers) {
+      seq_prefetch_free_worker(worker);
+      continue;
+    }
+
+    if (worker->bmain_eval == NULL) {
+      worker->bmain_eval = BKE_main_new();
+    }
+    seq_prefetch_update_scene(worker);
+    seq_prefetch_update_context(context, worker);
+    seq_prefetch_update_active_seqbase(worker);
+  }
+
+  pfjob->num_workers_running = pfjob->num_workers;
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    BLI_threadpool_insert(&pfjob->threads, &pfjob->workers[i]);
+  }
 
   return pfjob;
 }
@@ -22,6 +22,7 @@
 #include "BLI_listbase.h"
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_task.h"
 
 #include "BKE_anim_data.h"
 #include "BKE_animsys.h"
@@ -47,6 +48,8 @@
 #include "RNA_access.h"
 #include "RNA_prototypes.h"
 
+#include "PIL_time.h"
+
 #include "RE_engine.h"
 #include "RE_pipeline.h"
 
@@ -651,12 +654,17 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
   return preprocessed_ibuf;
 }
 
+/**
+ * \param start_time: Time at which rendering of \a ibuf started, used to get the cost of the
+ * cached images (see #PIL_check_seconds_timer).
+ */
 static ImBuf *seq_render_preprocess_ibuf(const SeqRenderData *context,
                                          Sequence *seq,
                                          ImBuf *ibuf,
                                          float timeline_frame,
                                          bool use_preprocess,
-                                         const bool is_proxy_image)
+                                         const bool is_proxy_image,
+                                         const double start_time)
 {
   if (context->is_proxy_render == false &&
       (ibuf->x != context->rectx || ibuf->y != context->recty)) {
@@ -665,14 +673,24 @@ static ImBuf *seq_render_preprocess_ibuf(const SeqRenderData *context,
 
   /* Proxies and effect strips are not stored in cache. */
   if (!is_proxy_image && (seq->type & SEQ_TYPE_EFFECT) == 0) {
-    seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_RAW, ibuf);
+    seq_cache_put(context,
+                  seq,
+                  timeline_frame,
+                  SEQ_CACHE_STORE_RAW,
+                  ibuf,
+                  PIL_check_seconds_timer() - start_time);
   }
 
   if (use_preprocess) {
     ibuf = input_preprocess(context, seq, timeline_frame, ibuf, is_proxy_image);
   }
 
-  seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_PREPROCESSED, ibuf);
+  seq_cache_put(context,
+                seq,
+                timeline_frame,
+                SEQ_CACHE_STORE_PREPROCESSED,
+                ibuf,
+                PIL_check_seconds_timer() - start_time);
   return ibuf;
 }
 
@@ -932,6 +950,7 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
                                      float timeline_frame,
                                      bool *r_is_proxy_image)
 {
+  const double start_time = PIL_check_seconds_timer();
   char name[FILE_MAX];
   const char *ext = NULL;
   char prefix[FILE_MAX];
@@ -979,7 +998,7 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
 
       if (view_id != context->view_id) {
         ibufs_arr[view_id] = seq_render_preprocess_ibuf(
-            &localcontext, seq, ibufs_arr[view_id], timeline_frame, true, false);
+            &localcontext, seq, ibufs_arr[view_id], timeline_frame, true, false, start_time);
       }
     }
 
@@ -1089,6 +1108,8 @@ static ImBuf *seq_render_movie_strip(const SeqRenderData *context,
                                      float timeline_frame,
                                      bool *r_is_proxy_image)
 {
+  const double start_time = PIL_check_seconds_timer();
+
   /* Load all the videos. */
   seq_open_anim_file(context->scene, seq, false);
 
@@ -1128,7 +1149,7 @@ static ImBuf *seq_render_movie_strip(const SeqRenderData *context,
 
       if (view_id != context->view_id) {
         ibuf_arr[view_id] = seq_render_preprocess_ibuf(
-            &localcontext, seq, ibuf_arr[view_id], timeline_frame, true, false);
+            &localcontext, seq, ibuf_arr[view_id], timeline_frame, true, false, start_time);
       }
     }
 
@@ -1331,6 +1352,7 @@ static ImBuf *seq_render_scene_strip(const SeqRenderData *context,
                                      float frame_index,
                                      float timeline_frame)
 {
+  const double start_time = PIL_check_seconds_timer();
   ImBuf *ibuf = NULL;
   double frame;
   Object *camera;
@@ -1542,7 +1564,12 @@ static ImBuf *seq_render_scene_strip(const SeqRenderData *context,
       }
 
       if (view_id != context->view_id) {
-        seq_cache_put(&localcontext, seq, timeline_frame, SEQ_CACHE_STORE_RAW, ibufs_arr[view_id]);
+        seq_cache_put(&localcontext,
+                      seq,
+                      timeline_frame,
+                      SEQ_CACHE_STORE_RAW,
+                      ibufs_arr[view_id],
+                      PIL_check_seconds_timer() - start_time);
       }
 
       RE_ReleaseResultImage(re);
@@ -1717,6 +1744,7 @@ ImBuf *seq_render_strip(const SeqRenderData *context,
                         Sequence *seq,
                         float timeline_frame)
 {
+  const double start_time = PIL_check_seconds_timer();
   ImBuf *ibuf = NULL;
   bool use_preprocess = false;
   bool is_proxy_image = false;
@@ -1739,7 +1767,7 @@ ImBuf *seq_render_strip(const SeqRenderData *context,
   if (ibuf) {
     use_preprocess = seq_input_have_to_preprocess(context, seq, timeline_frame);
     ibuf = seq_render_preprocess_ibuf(
-        context, seq, ibuf, timeline_frame, use_preprocess, is_proxy_image);
+        context, seq, ibuf, timeline_frame, use_preprocess, is_proxy_image, start_time);
   }
 
   if (ibuf == NULL) {
@@ -1815,6 +1843,159 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Concurrent Rendering of Stack Inputs
+ *
+ * Blending the strips of the stack has to happen in order, but the images of the strips are
+ * independent of each other. Those which are needed are rendered concurrently before blending.
+ * \{ */
+
+/* Whether rendering the strip only reads its own media, so it can be done in any thread. */
+static bool seq_render_strip_is_independent(Sequence *seq)
+{
+  if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+    return false;
+  }
+
+  LISTBASE_FOREACH (SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_sequence != NULL) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Find strips of the stack whose image is needed for blending, from the top of the first \a count
+ * strips until a strip which hides those below it. Whether an alpha over strip is opaque is only
+ * known once it is rendered, so the search stops at it as well: strips below it are only rendered
+ * in advance once it turns out to be transparent, see #seq_render_strip_stack. */
+static int seq_render_strip_stack_needed_inputs(const SeqRenderData *context,
+                                                Sequence **seq_arr,
+                                                int count,
+                                                float timeline_frame,
+                                                bool *r_needed)
+{
+  int needed_count = 0;
+
+  for (int i = count - 1; i >= 0; i--) {
+    Sequence *seq = seq_arr[i];
+
+    ImBuf *composite = seq_cache_probe(context, seq, timeline_frame, SEQ_CACHE_STORE_COMPOSITE);
+    if (composite) {
+      IMB_freeImBuf(composite);
+      break;
+    }
+
+    if (seq->blend_mode == SEQ_BLEND_REPLACE) {
+      r_needed[i] = true;
+      needed_count++;
+      break;
+    }
+
+    if (seq->blend_mode == SEQ_TYPE_ALPHAOVER && seq->blend_opacity == 100.0f) {
+      r_needed[i] = true;
+      needed_count++;
+      break;
+    }
+
+    const int early_out = seq_get_early_out_for_blend_mode(seq);
+    if (early_out == EARLY_USE_INPUT_1) {
+      continue;
+    }
+
+    r_needed[i] = true;
+    needed_count++;
+
+    if (early_out != EARLY_DO_EFFECT) {
+      break;
+    }
+  }
+
+  return needed_count;
+}
+
+typedef struct RenderStackInputsData {
+  const SeqRenderData *context;
+  Sequence **seq_arr;
+  int *input_index;
+  ImBuf **r_ibuf_arr;
+  float timeline_frame;
+} RenderStackInputsData;
+
+static void seq_render_strip_stack_input_task(void *__restrict userdata,
+                                              const int iter,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RenderStackInputsData *data = (RenderStackInputsData *)userdata;
+  const int i = data->input_index[iter];
+  SeqRenderState state;
+  seq_render_state_init(&state);
+
+  data->r_ibuf_arr[i] = seq_render_strip(
+      data->context, &state, data->seq_arr[i], data->timeline_frame);
+}
+
+/* Render the independent strips among the first \a count of the stack which are needed for
+ * blending concurrently, the others are rendered when blending. */
+static void seq_render_strip_stack_inputs(const SeqRenderData *context,
+                                          Sequence **seq_arr,
+                                          int count,
+                                          float timeline_frame,
+                                          ImBuf **r_ibuf_arr)
+{
+  bool needed[MAXSEQ + 1] = {false};
+  int input_index[MAXSEQ + 1];
+  int input_count = 0;
+
+  if (seq_render_strip_stack_needed_inputs(context, seq_arr, count, timeline_frame, needed) < 2) {
+    return;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (needed[i] && seq_render_strip_is_independent(seq_arr[i])) {
+      input_index[input_count++] = i;
+    }
+  }
+
+  if (input_count < 2) {
+    return;
+  }
+
+  RenderStackInputsData data = {
+      .context = context,
+      .seq_arr = seq_arr,
+      .input_index = input_index,
+      .r_ibuf_arr = r_ibuf_arr,
+      .timeline_frame = timeline_frame,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, input_count, &data, seq_render_strip_stack_input_task, &settings);
+}
+
+/* Image of the strip at \a index of the stack, rendered now unless it already was. */
+static ImBuf *seq_render_strip_stack_input(const SeqRenderData *context,
+                                           SeqRenderState *state,
+                                           Sequence **seq_arr,
+                                           ImBuf **ibuf_arr,
+                                           int index,
+                                           float timeline_frame)
+{
+  ImBuf *ibuf = ibuf_arr[index];
+
+  if (ibuf == NULL) {
+    return seq_render_strip(context, state, seq_arr[index], timeline_frame);
+  }
+
+  ibuf_arr[index] = NULL;
+  return ibuf;
+}
+
+/** \} */
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *channels,
@@ -1822,7 +2003,9 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      float timeline_frame,
                                      int chanshown)
 {
+  const double start_time = PIL_check_seconds_timer();
   Sequence *seq_arr[MAXSEQ + 1];
+  ImBuf *ibuf_arr[MAXSEQ + 1] = {NULL};
   int count;
   int i;
   ImBuf *out = NULL;
@@ -1834,6 +2017,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  seq_render_strip_stack_inputs(context, seq_arr, count, timeline_frame, ibuf_arr);
+
   for (i = count - 1; i >= 0; i--) {
     int early_out;
     Sequence *seq = seq_arr[i];
@@ -1844,7 +2029,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       break;
     }
     if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-      out = seq_render_strip(context, state, seq, timeline_frame);
+      out = seq_render_strip_stack_input(context, state, seq_arr, ibuf_arr, i, timeline_frame);
       break;
     }
 
@@ -1853,21 +2038,24 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     /* Early out for alpha over. It requires image to be rendered, so it can't use
      * `seq_get_early_out_for_blend_mode`. */
     if (out == NULL && seq->blend_mode == SEQ_TYPE_ALPHAOVER && seq->blend_opacity == 100.0f) {
-      ImBuf *test = seq_render_strip(context, state, seq, timeline_frame);
+      ImBuf *test = seq_render_strip_stack_input(
+          context, state, seq_arr, ibuf_arr, i, timeline_frame);
       if (ELEM(test->planes, R_IMF_PLANES_BW, R_IMF_PLANES_RGB)) {
         early_out = EARLY_USE_INPUT_2;
       }
       else {
         early_out = EARLY_DO_EFFECT;
+        /* The strips below are visible through this one. */
+        seq_render_strip_stack_inputs(context, seq_arr, i, timeline_frame, ibuf_arr);
       }
-      /* Free the image. It is stored in cache, so this doesn't affect performance. */
-      IMB_freeImBuf(test);
+      /* Keep the image for blending. */
+      ibuf_arr[i] = test;
     }
 
     switch (early_out) {
       case EARLY_NO_INPUT:
       case EARLY_USE_INPUT_2:
-        out = seq_render_strip(context, state, seq, timeline_frame);
+        out = seq_render_strip_stack_input(context, state, seq_arr, ibuf_arr, i, timeline_frame);
         break;
       case EARLY_USE_INPUT_1:
         if (i == 0) {
@@ -1877,11 +2065,17 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       case EARLY_DO_EFFECT:
         if (i == 0) {
           ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-          ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
+          ImBuf *ibuf2 = seq_render_strip_stack_input(
+              context, state, seq_arr, ibuf_arr, i, timeline_frame);
 
           out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
-          seq_cache_put(context, seq_arr[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out);
+          seq_cache_put(context,
+                        seq_arr[i],
+                        timeline_frame,
+                        SEQ_CACHE_STORE_COMPOSITE,
+                        out,
+                        PIL_check_seconds_timer() - start_time);
 
           IMB_freeImBuf(ibuf1);
           IMB_freeImBuf(ibuf2);
@@ -1900,7 +2094,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
     if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
+      ImBuf *ibuf2 = seq_render_strip_stack_input(
+          context, state, seq_arr, ibuf_arr, i, timeline_frame);
 
       out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
@@ -1908,12 +2103,79 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       IMB_freeImBuf(ibuf2);
     }
 
-    seq_cache_put(context, seq_arr[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out);
+    seq_cache_put(context,
+                  seq_arr[i],
+                  timeline_frame,
+                  SEQ_CACHE_STORE_COMPOSITE,
+                  out,
+                  PIL_check_seconds_timer() - start_time);
+  }
+
+  /* Images rendered in advance but not used, when the composite image of a strip above them was
+   * cached in the meantime (by another thread prefetching frames). */
+  for (i = 0; i < count; i++) {
+    if (ibuf_arr[i]) {
+      IMB_freeImBuf(ibuf_arr[i]);
+    }
   }
 
   return out;
 }
 
+/* Whether the strip can be rendered without #seq_render_mutex, while other frames are rendered
+ * from other copies of the scene (see prefetching). */
+static bool seq_render_strip_is_thread_safe(Sequence *seq)
+{
+  LISTBASE_FOREACH (SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_sequence != NULL || smd->mask_id != NULL) {
+      return false;
+    }
+  }
+
+  switch (seq->type) {
+    case SEQ_TYPE_IMAGE:
+    case SEQ_TYPE_MOVIE:
+    case SEQ_TYPE_COLOR:
+      return true;
+    case SEQ_TYPE_META:
+      LISTBASE_FOREACH (Sequence *, seq_meta, &seq->seqbase) {
+        if (!seq_render_strip_is_thread_safe(seq_meta)) {
+          return false;
+        }
+      }
+      return true;
+    /* Text uses shared fonts, gamma cross initializes shared tables, multi-cam and adjustment
+     * render other parts of the stack. */
+    case SEQ_TYPE_TEXT:
+    case SEQ_TYPE_GAMCROSS:
+    case SEQ_TYPE_MULTICAM:
+    case SEQ_TYPE_ADJUSTMENT:
+      return false;
+  }
+
+  if ((seq->type & SEQ_TYPE_EFFECT) == 0) {
+    return false;
+  }
+
+  Sequence *inputs[3] = {seq->seq1, seq->seq2, seq->seq3};
+  for (int i = 0; i < ARRAY_SIZE(inputs); i++) {
+    if (inputs[i] && !seq_render_strip_is_thread_safe(inputs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool seq_render_strips_are_thread_safe(Sequence **seq_arr, int count)
+{
+  for (int i = 0; i < count; i++) {
+    if (!seq_render_strip_is_thread_safe(seq_arr[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame, int chanshown)
 {
   Scene *scene = context->scene;
@@ -1953,17 +2215,28 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
   SEQ_relations_free_all_anim_ibufs(context->scene, timeline_frame);
 
   if (count && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    /* Prefetch threads render different frames from their own copy of the scene at the same
+     * time, which is only safe for some strips. */
+    const bool use_lock = !(context->is_prefetch_render &&
+                            seq_render_strips_are_thread_safe(seq_arr, count));
+    if (use_lock) {
+      BLI_mutex_lock(&seq_render_mutex);
+    }
+    const double start_time = PIL_check_seconds_timer();
     out = seq_render_strip_stack(context, &state, channels, seqbasep, timeline_frame, chanshown);
+    const float cost = PIL_check_seconds_timer() - start_time;
 
     if (context->is_prefetch_render) {
-      seq_cache_put(context, seq_arr[count - 1], timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
+      seq_cache_put(
+          context, seq_arr[count - 1], timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out, cost);
     }
     else {
       seq_cache_put_if_possible(
-          context, seq_arr[count - 1], timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
+          context, seq_arr[count - 1], timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out, cost);
+    }
+    if (use_lock) {
+      BLI_mutex_unlock(&seq_render_mutex);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
   }
 
   seq_prefetch_start(context, timeline_frame);
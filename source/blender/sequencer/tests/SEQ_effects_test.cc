@@ -0,0 +1,288 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "BLI_math.h"
+
+#include "DNA_sequence_types.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_test_utils.hh"
+
+#include "SEQ_effects.h"
+#include "SEQ_render.h"
+
+namespace blender::seq::tests {
+
+using imbuf::tests::compiler_may_fuse_multiply_add;
+using imbuf::tests::create_test_image;
+using imbuf::tests::expect_images_equal;
+using imbuf::tests::ImageTolerance;
+
+/**
+ * Per pixel implementations of the blend effects, as they were before pixels were blended with
+ * SIMD. Inputs are in the order of #SeqEffectHandle.execute_slice.
+ */
+
+static void alphaover_byte_reference(const float fac, const uchar *a, const uchar *b, uchar *r)
+{
+  float rt1[4], rt2[4], tempc[4];
+  straight_uchar_to_premul_float(rt1, a);
+  straight_uchar_to_premul_float(rt2, b);
+  const float mfac = 1.0f - fac * rt1[3];
+  if (fac <= 0.0f) {
+    memcpy(r, b, 4);
+  }
+  else if (mfac <= 0.0f) {
+    memcpy(r, a, 4);
+  }
+  else {
+    for (int c = 0; c < 4; c++) {
+      tempc[c] = fac * rt1[c] + mfac * rt2[c];
+    }
+    premul_float_to_straight_uchar(r, tempc);
+  }
+}
+
+static void alphaover_float_reference(const float fac, const float *a, const float *b, float *r)
+{
+  const float mfac = 1.0f - fac * a[3];
+  if (fac <= 0.0f) {
+    memcpy(r, b, sizeof(float[4]));
+  }
+  else if (mfac <= 0.0f) {
+    memcpy(r, a, sizeof(float[4]));
+  }
+  else {
+    for (int c = 0; c < 4; c++) {
+      r[c] = fac * a[c] + mfac * b[c];
+    }
+  }
+}
+
+static void alphaunder_byte_reference(const float fac, const uchar *a, const uchar *b, uchar *r)
+{
+  float rt1[4], rt2[4], tempc[4];
+  straight_uchar_to_premul_float(rt1, a);
+  straight_uchar_to_premul_float(rt2, b);
+  if (rt2[3] <= 0.0f && fac >= 1.0f) {
+    memcpy(r, a, 4);
+  }
+  else if (rt2[3] >= 1.0f || fac <= 0.0f) {
+    memcpy(r, b, 4);
+  }
+  else {
+    const float temp_fac = fac * (1.0f - rt2[3]);
+    for (int c = 0; c < 4; c++) {
+      tempc[c] = temp_fac * rt1[c] + rt2[c];
+    }
+    premul_float_to_straight_uchar(r, tempc);
+  }
+}
+
+static void alphaunder_float_reference(const float fac, const float *a, const float *b, float *r)
+{
+  if (b[3] <= 0.0f && fac >= 1.0f) {
+    memcpy(r, a, sizeof(float[4]));
+  }
+  else if (b[3] >= 1.0f || fac == 0.0f) {
+    memcpy(r, b, sizeof(float[4]));
+  }
+  else {
+    const float temp_fac = fac * (1.0f - b[3]);
+    for (int c = 0; c < 4; c++) {
+      r[c] = temp_fac * a[c] + b[c];
+    }
+  }
+}
+
+static void cross_byte_reference(const float fac, const uchar *a, const uchar *b, uchar *r)
+{
+  const int temp_fac = int(256.0f * fac);
+  const int temp_mfac = 256 - temp_fac;
+  for (int c = 0; c < 4; c++) {
+    r[c] = uchar((temp_mfac * a[c] + temp_fac * b[c]) >> 8);
+  }
+}
+
+static void cross_float_reference(const float fac, const float *a, const float *b, float *r)
+{
+  const float mfac = 1.0f - fac;
+  for (int c = 0; c < 4; c++) {
+    r[c] = mfac * a[c] + fac * b[c];
+  }
+}
+
+static void add_byte_reference(const float fac, const uchar *a, const uchar *b, uchar *r)
+{
+  const int temp_fac2 = int(256.0f * fac) * int(b[3]);
+  for (int c = 0; c < 3; c++) {
+    r[c] = uchar(min_ii(a[c] + ((temp_fac2 * b[c]) >> 16), 255));
+  }
+  r[3] = a[3];
+}
+
+static void add_float_reference(const float fac, const float *a, const float *b, float *r)
+{
+  const float temp_fac = (1.0f - (a[3] * (1.0f - fac))) * b[3];
+  for (int c = 0; c < 3; c++) {
+    r[c] = a[c] + temp_fac * b[c];
+  }
+  r[3] = a[3];
+}
+
+static void sub_byte_reference(const float fac, const uchar *a, const uchar *b, uchar *r)
+{
+  const int temp_fac2 = int(256.0f * fac) * int(b[3]);
+  for (int c = 0; c < 3; c++) {
+    r[c] = uchar(max_ii(a[c] - ((temp_fac2 * b[c]) >> 16), 0));
+  }
+  r[3] = a[3];
+}
+
+static void sub_float_reference(const float fac, const float *a, const float *b, float *r)
+{
+  const float temp_fac = (1.0f - (a[3] * (1.0f - fac))) * b[3];
+  for (int c = 0; c < 3; c++) {
+    r[c] = max_ff(a[c] - temp_fac * b[c], 0.0f);
+  }
+  r[3] = a[3];
+}
+
+static void mul_byte_reference(const float fac, const uchar *a, const uchar *b, uchar *r)
+{
+  const int temp_fac = int(256.0f * fac);
+  for (int c = 0; c < 4; c++) {
+    r[c] = uchar(a[c] + ((temp_fac * a[c] * (b[c] - 255)) >> 16));
+  }
+}
+
+static void mul_float_reference(const float fac, const float *a, const float *b, float *r)
+{
+  for (int c = 0; c < 4; c++) {
+    r[c] = a[c] + fac * a[c] * (b[c] - 1.0f);
+  }
+}
+
+using ByteReferenceFn = void (*)(float fac, const uchar *a, const uchar *b, uchar *r);
+using FloatReferenceFn = void (*)(float fac, const float *a, const float *b, float *r);
+
+/**
+ * The SIMD kernels do the same operations in the same order as the scalar code, except that the
+ * compiler may fuse the multiply-adds of scalar code (the references, and the factors and
+ * remaining pixels of the kernels). Then floats differ by the rounding of a product of terms up to
+ * about 3, a few epsilons relative to the result.
+ */
+static ImageTolerance effect_tolerance(const bool byte_via_float)
+{
+  ImageTolerance tolerance;
+  if (compiler_may_fuse_multiply_add) {
+    tolerance.float_epsilons = 8.0f;
+    /* Mixed in float, where `255 * value + 0.5` can round to the other side of a byte value.
+     * The integer kernels of the other effects are always exact. */
+    if (byte_via_float) {
+      tolerance.byte = 1;
+    }
+  }
+  return tolerance;
+}
+
+static void test_effect(const int seq_type,
+                        const ByteReferenceFn byte_reference,
+                        const FloatReferenceFn float_reference,
+                        const ImageTolerance tolerance)
+{
+  Sequence seq = {nullptr};
+  seq.type = seq_type;
+  const SeqEffectHandle sh = SEQ_effect_handle_get(&seq);
+  ASSERT_NE(sh.execute_slice, nullptr);
+
+  /* Pixel counts that are not multiples of 4, to cover the scalar loops after the SIMD ones. */
+  const int sizes[][2] = {{7, 3}, {13, 1}, {5, 5}, {1, 1}, {33, 2}};
+  for (const bool is_float : {false, true}) {
+    const int flags = is_float ? IB_rectfloat : IB_rect;
+    for (const auto &size : sizes) {
+      for (const float fac : {0.0f, 1.0f, 0.37f, 1.6f}) {
+        const int x = size[0], y = size[1];
+        SCOPED_TRACE(testing::Message() << (is_float ? "float " : "byte ") << x << "x" << y
+                                        << ", factor " << fac);
+        ImBuf *ibuf1 = create_test_image(x, y, flags, uint32_t(x * 100 + y));
+        ImBuf *ibuf2 = create_test_image(x, y, flags, uint32_t(x * 100 + y + 1));
+        ImBuf *out = IMB_allocImBuf(x, y, 32, flags);
+        ImBuf *expected = IMB_allocImBuf(x, y, 32, flags);
+
+        SeqRenderData context{};
+        context.rectx = x;
+        context.recty = y;
+        /* Two slices, as done when rendering with multiple threads. */
+        const int first_lines = y / 2;
+        sh.execute_slice(&context, &seq, 0.0f, fac, ibuf1, ibuf2, nullptr, 0, first_lines, out);
+        sh.execute_slice(
+            &context, &seq, 0.0f, fac, ibuf1, ibuf2, nullptr, first_lines, y - first_lines, out);
+
+        for (size_t i = 0; i < size_t(x) * y * 4; i += 4) {
+          if (is_float) {
+            float_reference(
+                fac, ibuf1->rect_float + i, ibuf2->rect_float + i, expected->rect_float + i);
+          }
+          else {
+            byte_reference(fac,
+                           reinterpret_cast<const uchar *>(ibuf1->rect) + i,
+                           reinterpret_cast<const uchar *>(ibuf2->rect) + i,
+                           reinterpret_cast<uchar *>(expected->rect) + i);
+          }
+        }
+        expect_images_equal(out, expected, tolerance);
+
+        IMB_freeImBuf(ibuf1);
+        IMB_freeImBuf(ibuf2);
+        IMB_freeImBuf(out);
+        IMB_freeImBuf(expected);
+      }
+    }
+  }
+}
+
+TEST(sequencer_effects, alpha_over)
+{
+  test_effect(SEQ_TYPE_ALPHAOVER,
+              alphaover_byte_reference,
+              alphaover_float_reference,
+              effect_tolerance(true));
+}
+
+TEST(sequencer_effects, alpha_under)
+{
+  test_effect(SEQ_TYPE_ALPHAUNDER,
+              alphaunder_byte_reference,
+              alphaunder_float_reference,
+              effect_tolerance(true));
+}
+
+TEST(sequencer_effects, cross)
+{
+  test_effect(SEQ_TYPE_CROSS,
+              cross_byte_reference,
+              cross_float_reference,
+              effect_tolerance(false));
+}
+
+TEST(sequencer_effects, add)
+{
+  test_effect(SEQ_TYPE_ADD, add_byte_reference, add_float_reference, effect_tolerance(false));
+}
+
+TEST(sequencer_effects, sub)
+{
+  test_effect(SEQ_TYPE_SUB, sub_byte_reference, sub_float_reference, effect_tolerance(false));
+}
+
+TEST(sequencer_effects, mul)
+{
+  test_effect(SEQ_TYPE_MUL, mul_byte_reference, mul_float_reference, effect_tolerance(false));
+}
+
+}  // namespace blender::seq::tests
@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_main.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_space_types.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "SEQ_relations.h"
+#include "SEQ_render.h"
+#include "SEQ_sequencer.h"
+
+#include "intern/image_cache.h"
+
+namespace blender::seq::tests {
+
+class SequencerImageCacheTest : public testing::Test {
+ protected:
+  Main *bmain_;
+  Scene *scene_;
+  Sequence *seq_;
+  SeqRenderData context_;
+
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    scene_ = MEM_cnew<Scene>(__func__);
+    scene_->r.cfra = 10;
+    Editing *ed = SEQ_editing_ensure(scene_);
+    ed->cache_flag = SEQ_CACHE_STORE_PREPROCESSED | SEQ_CACHE_STORE_FINAL_OUT;
+    seq_ = MEM_cnew<Sequence>(__func__);
+
+    SEQ_render_new_render_data(
+        bmain_, nullptr, scene_, 16, 16, SEQ_RENDER_SIZE_SCENE, false, &context_);
+  }
+
+  void TearDown() override
+  {
+    SEQ_editing_free(scene_, false);
+    MEM_freeN(seq_);
+    MEM_freeN(scene_);
+    BKE_main_free(bmain_);
+  }
+
+  /** Put an image of the frame which took \a cost seconds to render. */
+  void put_image(const int timeline_frame, const int type, const float cost)
+  {
+    ImBuf *ibuf = IMB_allocImBuf(16, 16, 32, IB_rect);
+    seq_cache_put(&context_, seq_, timeline_frame, type, ibuf, cost);
+    IMB_freeImBuf(ibuf);
+  }
+
+  /** Frame which would be freed first, -1 when none can be freed. */
+  int frame_for_removal()
+  {
+    const SeqCacheKey *key = seq_cache_get_item_for_removal(scene_);
+    if (key == nullptr) {
+      return -1;
+    }
+    EXPECT_EQ(key->type, SEQ_CACHE_STORE_FINAL_OUT);
+    return int(key->timeline_frame);
+  }
+};
+
+TEST_F(SequencerImageCacheTest, cheap_frame_freed_first)
+{
+  /* Frame 12 is further from the playhead, but took a hundred times longer to render. */
+  put_image(11, SEQ_CACHE_STORE_FINAL_OUT, 0.01f);
+  put_image(12, SEQ_CACHE_STORE_FINAL_OUT, 1.0f);
+  EXPECT_EQ(frame_for_removal(), 11);
+}
+
+TEST_F(SequencerImageCacheTest, far_frame_freed_first)
+{
+  put_image(11, SEQ_CACHE_STORE_FINAL_OUT, 0.1f);
+  put_image(30, SEQ_CACHE_STORE_FINAL_OUT, 0.1f);
+  EXPECT_EQ(frame_for_removal(), 30);
+}
+
+TEST_F(SequencerImageCacheTest, frame_behind_playhead_counts_twice_as_far)
+{
+  /* Frame 7 is closer to the playhead than frame 15, but behind it. */
+  put_image(7, SEQ_CACHE_STORE_FINAL_OUT, 0.1f);
+  put_image(15, SEQ_CACHE_STORE_FINAL_OUT, 0.1f);
+  EXPECT_EQ(frame_for_removal(), 7);
+}
+
+TEST_F(SequencerImageCacheTest, frame_cost_is_its_most_expensive_image)
+{
+  /* The final image of frame 11 is cheap to composite, but its preprocessed image isn't. */
+  put_image(11, SEQ_CACHE_STORE_PREPROCESSED, 1.0f);
+  put_image(11, SEQ_CACHE_STORE_FINAL_OUT, 0.01f);
+  put_image(12, SEQ_CACHE_STORE_FINAL_OUT, 0.1f);
+  EXPECT_EQ(frame_for_removal(), 12);
+
+  /* Misses are counted per image, not per frame. */
+  SeqCacheStatistics stats;
+  SEQ_cache_statistics_get(scene_, &stats);
+  EXPECT_EQ(stats.misses, uint64_t(3));
+}
+
+TEST_F(SequencerImageCacheTest, temporary_images_not_freed)
+{
+  /* Composite images are not stored, they are freed once the frame is rendered. */
+  put_image(11, SEQ_CACHE_STORE_COMPOSITE, 1.0f);
+  EXPECT_EQ(frame_for_removal(), -1);
+}
+
+}  // namespace blender::seq::tests
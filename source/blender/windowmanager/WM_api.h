@@ -1357,6 +1357,8 @@ enum {
   WM_JOB_TYPE_LINEART,
   WM_JOB_TYPE_SEQ_DRAW_THUMBNAIL,
   WM_JOB_TYPE_SEQ_DRAG_DROP_PREVIEW,
+  WM_JOB_TYPE_FILE_SAVE,
+  WM_JOB_TYPE_FILE_AUTOSAVE,
   /* add as needed, bake, seq proxy build
    * if having hard coded values is a problem */
 };
@@ -86,6 +86,7 @@
 #include "RNA_access.h"
 #include "RNA_define.h"
 
+#include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 #include "IMB_thumbs.h"
@@ -452,6 +453,8 @@ static void wm_init_userdef(Main *bmain)
   MEM_CacheLimiter_set_maximum(((size_t)U.memcachelimit) * 1024 * 1024);
   BKE_sound_init(bmain);
 
+  IMB_colormanagement_display_lut_set_enabled((U.gpu_flag & USER_GPU_FLAG_DISPLAY_LUT) != 0);
+
   /* Update the temporary directory from the preferences or fallback to the system default. */
   BKE_tempdir_init(U.tempdir);
 
@@ -916,7 +919,8 @@ bool WM_file_read(bContext *C, const char *filepath, ReportList *reports)
         /* Loading preferences when the user intended to load a regular file is a security
          * risk, because the excluded path list is also loaded. Further it's just confusing
          * if a user loads a file and various preferences change. */
-        .skip_flags = BLO_READ_SKIP_USERDEF,
+        .skip_flags = BLO_READ_SKIP_USERDEF |
+                      ((U.flag & USER_LOAD_PACKED_ON_DEMAND) ? BLO_READ_SKIP_LARGE_DATA : 0),
     };
 
     BlendFileReadReport bf_reports = {.reports = reports,
@@ -1693,6 +1697,158 @@ static ImBuf *blend_file_thumb_from_camera(const bContext *C,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Write Blend-File in Background
+ *
+ * The file is serialized in memory on the main thread (see #BLO_write_file_snapshot),
+ * then written to disk and compressed by a job.
+ * \{ */
+
+typedef struct FileSaveJob {
+  char filepath[FILE_MAX];
+  BlendFileWriteSnapshot *snapshot;
+  /** Thumbnail written once the file exists, can be NULL. */
+  ImBuf *ibuf_thumb;
+  ReportList reports;
+  /** The saved file, only used while it is still the current one. */
+  Main *bmain;
+  /** #Main.filepath before saving, restored when writing fails. */
+  char filepath_prev[FILE_MAX];
+  bool use_save_as_copy;
+  bool do_history_file_update;
+  bool is_autosave;
+  bool is_stored;
+  bool success;
+} FileSaveJob;
+
+static void wm_file_save_job_store(FileSaveJob *job, float *progress)
+{
+  job->success = BLO_write_file_snapshot_store(job->snapshot, progress, &job->reports);
+  job->is_stored = true;
+
+  if (job->success && job->ibuf_thumb) {
+    IMB_thumb_delete(job->filepath, THB_FAIL); /* without this a failed thumb overrides */
+    job->ibuf_thumb = IMB_thumb_create(
+        job->filepath, THB_LARGE, THB_SOURCE_BLEND, job->ibuf_thumb);
+  }
+}
+
+static void wm_file_save_job_finish(FileSaveJob *job)
+{
+  if (job->is_autosave) {
+    /* Error reporting into console, like regular auto-save. */
+    BKE_reports_print(&job->reports, RPT_ERROR);
+    return;
+  }
+
+  LISTBASE_FOREACH (Report *, report, &job->reports.list) {
+    WM_report(report->type, report->message);
+  }
+  if (job->success) {
+    /* Without this there is no feedback the file was saved. */
+    WM_reportf(RPT_INFO, "Saved \"%s\"", BLI_path_basename(job->filepath));
+  }
+
+  Main *bmain = G_MAIN;
+  if (bmain != job->bmain) {
+    /* Another file was loaded since. */
+    return;
+  }
+
+  if (job->success) {
+    /* Done here instead of #wm_file_write, once the file exists. */
+    if (job->do_history_file_update) {
+      wm_history_file_update();
+    }
+    BKE_callback_exec_null(bmain, BKE_CB_EVT_SAVE_POST);
+  }
+  else {
+    /* The file was tagged as saved (under its new path) when the snapshot was made. */
+    if (!job->use_save_as_copy && STREQ(bmain->filepath, job->filepath)) {
+      STRNCPY(bmain->filepath, job->filepath_prev);
+    }
+    WM_file_tag_modified();
+  }
+}
+
+static void wm_file_save_job_startjob(void *customdata,
+                                      short *UNUSED(stop),
+                                      short *do_update,
+                                      float *progress)
+{
+  /* Stopping is ignored: a newer save waits for this one, and so does exiting. */
+  wm_file_save_job_store(customdata, progress);
+  *do_update = true;
+}
+
+static void wm_file_save_job_endjob(void *customdata)
+{
+  wm_file_save_job_finish(customdata);
+}
+
+static void wm_file_save_job_free(void *customdata)
+{
+  FileSaveJob *job = customdata;
+
+  if (!job->is_stored) {
+    /* Replaced by a newer save, or killed (e.g. on exit or file load) before it started,
+     * the file must still be written. */
+    wm_file_save_job_store(job, NULL);
+    wm_file_save_job_finish(job);
+  }
+
+  BLO_write_file_snapshot_free(job->snapshot);
+  if (job->ibuf_thumb) {
+    IMB_freeImBuf(job->ibuf_thumb);
+  }
+  BKE_reports_clear(&job->reports);
+  MEM_freeN(job);
+}
+
+/**
+ * Write the snapshot to disk in a job, taking ownership of \a snapshot and \a ibuf_thumb.
+ *
+ * \param bmain: The saved file, NULL for auto-save. Its #BKE_CB_EVT_SAVE_POST callbacks run once
+ * the file is written, when writing fails its file path is reset to \a filepath_prev.
+ */
+static void wm_file_save_job_start(wmWindowManager *wm,
+                                   wmWindow *win,
+                                   BlendFileWriteSnapshot *snapshot,
+                                   const char *filepath,
+                                   ImBuf *ibuf_thumb,
+                                   Main *bmain,
+                                   const char *filepath_prev,
+                                   const bool use_save_as_copy,
+                                   const bool do_history_file_update)
+{
+  FileSaveJob *job = MEM_callocN(sizeof(*job), __func__);
+  const bool is_autosave = (bmain == NULL);
+  STRNCPY(job->filepath, filepath);
+  job->snapshot = snapshot;
+  job->ibuf_thumb = ibuf_thumb;
+  job->bmain = bmain;
+  if (filepath_prev) {
+    STRNCPY(job->filepath_prev, filepath_prev);
+  }
+  job->use_save_as_copy = use_save_as_copy;
+  job->do_history_file_update = do_history_file_update;
+  job->is_autosave = is_autosave;
+  BKE_reports_init(&job->reports, RPT_STORE);
+
+  wmJob *wm_job = WM_jobs_get(wm,
+                              win,
+                              wm,
+                              is_autosave ? "Auto-Saving" : "Saving",
+                              WM_JOB_PROGRESS,
+                              is_autosave ? WM_JOB_TYPE_FILE_AUTOSAVE : WM_JOB_TYPE_FILE_SAVE);
+  WM_jobs_customdata_set(wm_job, job, wm_file_save_job_free);
+  WM_jobs_timer(wm_job, 0.1, 0, 0);
+  WM_jobs_callbacks(wm_job, wm_file_save_job_startjob, NULL, NULL, wm_file_save_job_endjob);
+  WM_jobs_start(wm, wm_job);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Write Main Blend-File (internal)
  * \{ */
@@ -1713,12 +1869,16 @@ bool write_crash_blend(void)
 
 /**
  * \see #wm_homefile_write_exec wraps #BLO_write_file in a similar way.
+ *
+ * \param use_background: Only serialize the file, and write it to disk in a job
+ * (see #wm_file_save_job_start).
  */
 static bool wm_file_write(bContext *C,
                           const char *filepath,
                           int fileflags,
                           eBLO_WritePathRemap remap_mode,
                           bool use_save_as_copy,
+                          bool use_background,
                           ReportList *reports)
 {
   Main *bmain = CTX_data_main(C);
@@ -1823,18 +1983,27 @@ static bool wm_file_write(bContext *C,
   /* XXX(ton): temp solution to solve bug, real fix coming. */
   bmain->recovered = 0;
 
-  if (BLO_write_file(bmain,
-                     filepath,
-                     fileflags,
-                     &(const struct BlendFileWriteParams){
-                         .remap_mode = remap_mode,
-                         .use_save_versions = true,
-                         .use_save_as_copy = use_save_as_copy,
-                         .thumb = thumb,
-                     },
-                     reports)) {
+  const struct BlendFileWriteParams params = {
+      .remap_mode = remap_mode,
+      .use_save_versions = true,
+      .use_save_as_copy = use_save_as_copy,
+      .thumb = thumb,
+  };
+  BlendFileWriteSnapshot *snapshot = NULL;
+  bool write_ok;
+  if (use_background) {
+    snapshot = BLO_write_file_snapshot(bmain, filepath, fileflags, &params, reports);
+    write_ok = (snapshot != NULL);
+  }
+  else {
+    write_ok = BLO_write_file(bmain, filepath, fileflags, &params, reports);
+  }
+
+  if (write_ok) {
     const bool do_history_file_update = (G.background == false) &&
                                         (CTX_wm_manager(C)->op_undo_depth == 0);
+    char filepath_prev[FILE_MAX];
+    STRNCPY(filepath_prev, bmain->filepath);
 
     if (use_save_as_copy == false) {
       STRNCPY(bmain->filepath, filepath); /* is guaranteed current file */
@@ -1842,21 +2011,37 @@ static bool wm_file_write(bContext *C,
 
     SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
 
-    /* prevent background mode scripts from clobbering history */
-    if (do_history_file_update) {
-      wm_history_file_update();
+    if (snapshot) {
+      /* The thumbnail, history, post-save callbacks and the "Saved" report are handled by the
+       * job, once the file is written. */
+      wm_file_save_job_start(CTX_wm_manager(C),
+                             CTX_wm_window(C),
+                             snapshot,
+                             filepath,
+                             ibuf_thumb,
+                             bmain,
+                             filepath_prev,
+                             use_save_as_copy,
+                             do_history_file_update);
+      ibuf_thumb = NULL;
     }
+    else {
+      /* prevent background mode scripts from clobbering history */
+      if (do_history_file_update) {
+        wm_history_file_update();
+      }
 
-    BKE_callback_exec_null(bmain, BKE_CB_EVT_SAVE_POST);
+      BKE_callback_exec_null(bmain, BKE_CB_EVT_SAVE_POST);
 
-    /* run this function after because the file can't be written before the blend is */
-    if (ibuf_thumb) {
-      IMB_thumb_delete(filepath, THB_FAIL); /* without this a failed thumb overrides */
-      ibuf_thumb = IMB_thumb_create(filepath, THB_LARGE, THB_SOURCE_BLEND, ibuf_thumb);
-    }
+      /* run this function after because the file can't be written before the blend is */
+      if (ibuf_thumb) {
+        IMB_thumb_delete(filepath, THB_FAIL); /* without this a failed thumb overrides */
+        ibuf_thumb = IMB_thumb_create(filepath, THB_LARGE, THB_SOURCE_BLEND, ibuf_thumb);
+      }
 
-    /* Without this there is no feedback the file was saved. */
-    BKE_reportf(reports, RPT_INFO, "Saved \"%s\"", BLI_path_basename(filepath));
+      /* Without this there is no feedback the file was saved. */
+      BKE_reportf(reports, RPT_INFO, "Saved \"%s\"", BLI_path_basename(filepath));
+    }
 
     /* Success. */
     ok = true;
@@ -1927,14 +2112,21 @@ static void wm_autosave_write(Main *bmain, wmWindowManager *wm)
 
   wm_autosave_location(filepath);
 
+  /* Write to disk in a job, so interaction isn't blocked by large files. */
+  const bool use_background = (U.flag & USER_SAVE_BACKGROUND) && !G.background;
+
   /* Fast save of last undo-buffer, now with UI. */
   const bool use_memfile = (U.uiflag & USER_GLOBALUNDO) != 0;
   MemFile *memfile = use_memfile ? ED_undosys_stack_memfile_get_active(wm->undo_stack) : NULL;
-  if (memfile != NULL) {
-    BLO_memfile_write_file(memfile, filepath);
-  }
-  else {
-    if (use_memfile) {
+  if (memfile != NULL && use_background) {
+    /* Copied, as the undo step may be freed while writing. */
+    BlendFileWriteSnapshot *snapshot = BLO_write_file_snapshot_from_memfile(memfile, filepath);
+    wm_file_save_job_start(wm, NULL, snapshot, filepath, NULL, NULL, NULL, false, false);
+  }
+  /* Fails when packed data the undo step references can't be read anymore
+   * (see #BLO_READ_SKIP_LARGE_DATA), the regular write below leaves it out. */
+  else if (memfile == NULL || !BLO_memfile_write_file(memfile, filepath)) {
+    if (use_memfile && memfile == NULL) {
       /* This is very unlikely, alert developers of this unexpected case. */
       CLOG_WARN(&LOG, "undo-data not found for writing, fallback to regular file write!");
     }
@@ -1944,8 +2136,17 @@ static void wm_autosave_write(Main *bmain, wmWindowManager *wm)
 
     ED_editors_flush_edits(bmain);
 
-    /* Error reporting into console. */
-    BLO_write_file(bmain, filepath, fileflags, &(const struct BlendFileWriteParams){0}, NULL);
+    if (use_background) {
+      BlendFileWriteSnapshot *snapshot = BLO_write_file_snapshot(
+          bmain, filepath, fileflags, &(const struct BlendFileWriteParams){0}, NULL);
+      if (snapshot != NULL) {
+        wm_file_save_job_start(wm, NULL, snapshot, filepath, NULL, NULL, NULL, false, false);
+      }
+    }
+    else {
+      /* Error reporting into console. */
+      BLO_write_file(bmain, filepath, fileflags, &(const struct BlendFileWriteParams){0}, NULL);
+    }
   }
 }
 
@@ -3107,7 +3308,12 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
   /* set compression flag */
   SET_FLAG_FROM_TEST(fileflags, RNA_boolean_get(op->ptr, "compress"), G_FILE_COMPRESS);
 
-  const bool ok = wm_file_write(C, path, fileflags, remap_mode, use_save_as_copy, op->reports);
+  /* Scripts expect the file to be written when the operator returns. */
+  const bool use_background = (U.flag & USER_SAVE_BACKGROUND) && !G.background &&
+                              (op->flag & OP_IS_INVOKE);
+
+  const bool ok = wm_file_write(
+      C, path, fileflags, remap_mode, use_save_as_copy, use_background, op->reports);
 
   if ((op->flag & OP_IS_INVOKE) == 0) {
     /* OP_IS_INVOKE is set when the operator is called from the GUI.
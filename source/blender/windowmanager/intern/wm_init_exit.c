@@ -33,6 +33,7 @@
 #include "BLI_timer.h"
 #include "BLI_utildefines.h"
 
+#include "BLO_readfile.h"
 #include "BLO_undofile.h"
 #include "BLO_writefile.h"
 
@@ -633,6 +634,7 @@ void WM_exit_ex(bContext *C, const bool do_python)
 
   wm_autosave_delete();
 
+  BLO_deferred_data_files_free();
   BKE_tempdir_session_purge();
 }
 
@@ -0,0 +1,82 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+import os
+
+
+def _run(args):
+    import bpy
+    import tempfile
+    import time
+
+    # Render a multilayer image with many passes, small render time is enough.
+    scene = bpy.context.scene
+    scene.render.engine = 'CYCLES'
+    scene.cycles.samples = 1
+    scene.render.resolution_x = 1920
+    scene.render.resolution_y = 1080
+    scene.render.resolution_percentage = 100
+
+    view_layer = scene.view_layers[0]
+    for settings in (view_layer, view_layer.cycles):
+        for prop in dir(settings):
+            if prop.startswith('use_pass_') and isinstance(getattr(settings, prop), bool):
+                setattr(settings, prop, True)
+
+    bpy.ops.render.render()
+    render_result = bpy.data.images['Render Result']
+
+    image_settings = scene.render.image_settings
+    image_settings.file_format = 'OPEN_EXR_MULTILAYER'
+    image_settings.color_depth = '16'
+    image_settings.exr_codec = args['codec']
+
+    with tempfile.TemporaryDirectory() as dirpath:
+        filepath = os.path.join(dirpath, 'passes.exr')
+        render_result.save_render(filepath, scene=scene)
+
+        # Load once to ensure it's cached by OS. The file has a single part with all passes,
+        # its scan-lines are read by multiple threads when loading it as multilayer image.
+        image = bpy.data.images.load(filepath)
+        image.update()
+        if image.type != 'MULTILAYER':
+            raise Exception("Expected a multilayer image, got " + image.type)
+        bpy.data.images.remove(image)
+
+        # Measure reading all passes.
+        num_loads = 0
+        start_time = time.time()
+        elapsed_time = 0.0
+        while elapsed_time < 5.0 or num_loads < 3:
+            image = bpy.data.images.load(filepath)
+            image.update()
+            bpy.data.images.remove(image)
+            num_loads += 1
+            elapsed_time = time.time() - start_time
+
+        file_size = os.path.getsize(filepath)
+
+    time_per_load = elapsed_time / num_loads
+    result = {'time': time_per_load, 'throughput': file_size / time_per_load}
+    return result
+
+
+class ExrLoadTest(api.Test):
+    def __init__(self, codec):
+        self.codec = codec
+
+    def name(self):
+        return self.codec.lower()
+
+    def category(self):
+        return "exr_load"
+
+    def run(self, env, device_id):
+        args = {'codec': self.codec}
+        result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    # Codecs compressing scan-lines in blocks of different sizes.
+    return [ExrLoadTest(codec) for codec in ('DWAA', 'DWAB', 'ZIP', 'ZIPS', 'PIZ')]